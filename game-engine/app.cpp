@@ -1,42 +1,581 @@
 #include "app.hpp"
+#include "engine_allocation_counter.hpp"
+#include "engine_log.hpp"
+#include "engine_mesh_generator.hpp"
 
 
 // std
 #include <stdexcept>
 #include <array>
 #include <iostream>
+#include <sstream>
+#include <cstring>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <cstdio>
+#include <filesystem>
 
 namespace engine {
+    struct Material {
+        glm::vec4 tint;
+        // bindless texture slot, only read by the TEXTURE permutation
+        uint32_t textureIndex;
+        uint32_t padding[3];
+    };
+
+    struct SimplePushConstantData {
+        glm::mat2 camera{1.0f};
+        // read by the CLUSTERED_LIGHTING permutation of the fragment shader
+        EngineLightClusterer::Parameters lighting{};
+        glm::vec2 viewportSize{0.0f};
+        // bindless index of EngineShadowMap::ShadowData, read by the SHADOWS permutation
+        uint32_t shadowBufferIndex = 0;
+    };
+
+    // push constants of shaders/sierpinski.comp
+    struct SierpinskiParameters {
+        glm::vec4 positions[3];
+        glm::vec4 colors[3];
+        uint32_t depth;
+        uint32_t triangleCount;
+    };
+
+    static const EngineMeshGenerator::Corner SIERPINSKI_LEFT = {{-0.5f, 0.5f}, {0.0f, 0.0f, 1.0f}};
+    static const EngineMeshGenerator::Corner SIERPINSKI_TOP = {{0.0f, -0.5f}, {1.0f, 0.0f, 0.0f}};
+    static const EngineMeshGenerator::Corner SIERPINSKI_RIGHT = {{0.5f, 0.5f}, {0.0f, 1.0f, 0.0f}};
+    // generated meshes never reach the CPU, so their bounds come from the corners
+    static const EngineModel::Bounds SIERPINSKI_BOUNDS = {{-0.5f, -0.5f}, {0.5f, 0.5f}};
+    // imported models fitted to the unit square fill the same bounds
+    static const EngineModel::Bounds FITTED_MODEL_BOUNDS = SIERPINSKI_BOUNDS;
+    static constexpr const char *DECOMPRESSION_BENCHMARK_ARCHIVE = "engine_decompression_benchmark.pak";
+    // sorted draws carry the pass's pipeline above the instance index
+    static constexpr uint32_t SORTED_DRAW_PIPELINE_SHIFT = 16;
+    static constexpr uint32_t SORTED_DRAW_INSTANCE_MASK = (1u << SORTED_DRAW_PIPELINE_SHIFT) - 1;
+
+    // occlusion test scene: a quad in front, the copies on a grid behind it
+    static constexpr float OCCLUDER_SCALE = 0.6f;
+    static constexpr float OCCLUDER_DEPTH = 0.1f;
+    static constexpr float OCCLUDEE_NEAREST_DEPTH = 0.2f;
+    static constexpr float OCCLUDEE_FARTHEST_DEPTH = 0.9f;
+    // the grid covers this much of normalised device space
+    static constexpr float OCCLUSION_TEST_EXTENT = 1.8f;
+
+    static SierpinskiParameters buildSierpinskiParameters(uint32_t depth){
+        SierpinskiParameters parameters = {};
+        const EngineMeshGenerator::Corner *corners[3] = {&SIERPINSKI_LEFT, &SIERPINSKI_TOP, &SIERPINSKI_RIGHT};
+        for(uint32_t i = 0; i < 3; i++){
+            parameters.positions[i] = glm::vec4{corners[i]->first, 0.0f, 1.0f};
+            parameters.colors[i] = glm::vec4{corners[i]->second, 1.0f};
+        }
+        parameters.depth = depth;
+        parameters.triangleCount = static_cast<uint32_t>(EngineMeshGenerator::sierpinskiVertexCount(depth) / 3);
+        return parameters;
+    }
+
+    // radians per second
+    static constexpr float ROTATION_SPEED = 0.5f;
+    static constexpr float LIGHT_ROTATION_SPEED = -0.25f;
+
+    // radii shrink as lights are added so a froxel sees about the same number whatever the count
+    static constexpr float LIGHT_RADIUS_SCALE = 0.6f;
+    static constexpr float LIGHT_INTENSITY = 1.5f;
+    static constexpr uint32_t LIGHT_SEED = 1234;
+
+    // world space, towards higher depth so nearer instances shade the ones behind them
+    static const glm::vec3 SHADOW_LIGHT_DIRECTION = {0.4f, 0.6f, 1.0f};
+
+    // fountains on a ring, spraying upwards
+    static constexpr uint32_t EMITTER_COUNT = 8;
+    static constexpr float TAU = 6.28318531f;
+    static constexpr float EMITTER_RING_RADIUS = 0.5f;
+    static constexpr float PARTICLE_LIFE_SECONDS = 2.0f;
+    static constexpr float PARTICLE_SIZE = 0.004f;
+    // sprite test grid, in pixels
+    static constexpr float SPRITE_SIZE = 6.0f;
+    static constexpr float SPRITE_SPACING = 8.0f;
+    // longer than any frame should take, so a stall does not fire one huge burst
+    static constexpr float MAX_PARTICLE_DELTA_SECONDS = 0.1f;
+    // debug overlay, in pixels from the top left corner
+    static const glm::vec2 HUD_POSITION = {8.0f, 8.0f};
+    static const glm::vec2 HUD_PADDING = {4.0f, 4.0f};
+    static constexpr float HUD_TEXT_SCALE = 2.0f;
+    static const glm::vec4 HUD_TEXT_COLOR = {1.0f, 1.0f, 1.0f, 1.0f};
+    static const glm::vec4 HUD_BACKGROUND_COLOR = {0.0f, 0.0f, 0.0f, 0.6f};
+    static const glm::vec4 HUD_BOUNDS_COLOR = {0.2f, 1.0f, 0.2f, 1.0f};
+    // weight of the newest frame in the HUD's running averages
+    static constexpr double HUD_SMOOTHING = 0.1;
+
+    static double millisecondsSince(std::chrono::steady_clock::time_point start){
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
     // Publics
-    App::App(){
+    App::App(const AppSettings &settings): settings{settings}{
+        if(!this->settings.archivePath.empty()){
+            this->shaderArchive = std::make_unique<EngineArchive>(this->settings.archivePath);
+            EnginePipeline::setShaderArchive(this->shaderArchive.get());
+            this->settings.isShaderHotReloadEnabled = false;
+        }
+        if(this->settings.isGpuMeshGenerationEnabled){
+            this->meshGenerator = std::make_unique<EngineComputeMeshGenerator>(
+                this->engineDevice,
+                SIERPINSKI_COMPUTE_SHADER_PATH,
+                sizeof(SierpinskiParameters),
+                EngineSwapChain::MAX_FRAMES_IN_FLIGHT
+            );
+        }
+        if(this->settings.isOcclusionCullingEnabled){
+            this->occlusionCuller = std::make_unique<EngineOcclusionCuller>(this->engineDevice, this->engineSwapChain, EngineSwapChain::MAX_FRAMES_IN_FLIGHT);
+        }
+        if(this->settings.lightCount > 0){
+            this->lightClusterer = std::make_unique<EngineLightClusterer>(this->engineDevice, this->bindlessTable, EngineSwapChain::MAX_FRAMES_IN_FLIGHT);
+        }
+        if(this->settings.particleCount > 0){
+            // room for the overshoot of random lifetimes
+            uint32_t capacity = this->settings.particleCount + this->settings.particleCount / 4;
+            this->particleSystem = std::make_unique<EngineParticleSystem>(
+                this->engineDevice,
+                this->bindlessTable,
+                this->pipelineCache,
+                this->engineSwapChain,
+                capacity,
+                EngineSwapChain::MAX_FRAMES_IN_FLIGHT
+            );
+        }
+        if(this->settings.spriteCount > 0){
+            this->spriteBatch = std::make_unique<EngineSpriteBatch>(
+                this->engineDevice,
+                this->bindlessTable,
+                this->pipelineCache,
+                this->engineSwapChain,
+                EngineSwapChain::MAX_FRAMES_IN_FLIGHT
+            );
+        }
+#if ENGINE_DEBUG_DRAW
+        if(this->settings.isHudEnabled){
+            this->debugDraw = std::make_unique<EngineDebugDraw>(
+                this->engineDevice,
+                this->bindlessTable,
+                this->pipelineCache,
+                this->engineSwapChain,
+                EngineSwapChain::MAX_FRAMES_IN_FLIGHT
+            );
+        }
+#else
+        if(this->settings.isHudEnabled) ENGINE_LOG_WARNING("App: The HUD is compiled out of this build");
+#endif
+        if(this->settings.isShadowEnabled){
+            this->shadowMap = std::make_unique<EngineShadowMap>(
+                this->engineDevice,
+                this->bindlessTable,
+                this->pipelineCache,
+                this->workerPool,
+                EngineSwapChain::MAX_FRAMES_IN_FLIGHT
+            );
+        }
         this->loadModels();
+        if(!this->settings.modelPath.empty()){
+            this->assetManager = std::make_unique<EngineAssetManager>(this->engineDevice, this->deletionQueue);
+            EngineAssetImporter::Options options = {};
+            options.isFittedToUnitSquare = true;
+            this->importedModel = this->assetManager->loadModel(this->settings.modelPath, options);
+        }
+        if(!this->settings.texturePath.empty()) this->sceneTexture = this->textureStreamer.loadTexture(this->settings.texturePath);
+        this->createMaterials();
+        this->createLights();
+        this->createEmitters();
+        this->createTimestampQueryPool();
         this->createPipelineLayout();
         this->createPipeline();
         this->createCommandBuffers();
+        if(this->settings.isShaderHotReloadEnabled) this->shaderHotReloader = std::make_unique<EngineShaderHotReloader>(SHADER_DIRECTORY);
+
+        double simulationLoadMs = this->settings.simulationLoadMs;
+        this->simulation = std::make_unique<EngineFixedStepSimulation<SimulationState>>(
+            SimulationState{},
+            this->settings.simulationTickSeconds,
+            [simulationLoadMs](SimulationState &state, double deltaSeconds){
+                state.rotation += ROTATION_SPEED * static_cast<float>(deltaSeconds);
+                auto start = std::chrono::steady_clock::now();
+                while(millisecondsSince(start) < simulationLoadMs){}
+            }
+        );
     }
 
     App::~App(){
+        if(this->renderThread.joinable()){
+            this->isRenderThreadRunning = false;
+            this->frameQueue.wake();
+            this->renderThread.join();
+            vkDeviceWaitIdle(this->engineDevice.device());
+        }
+        if(this->importedModel.isValid()) this->assetManager->release(this->importedModel);
         vkDestroyPipelineLayout(this->engineDevice.device(), this->pipelineLayout, nullptr);
-
+        if(this->timestampQueryPool != VK_NULL_HANDLE) vkDestroyQueryPool(this->engineDevice.device(), this->timestampQueryPool, nullptr);
+        this->bindlessTable.releaseStorageBuffer(this->materialIndex);
+        if(this->sceneTexture != EngineTextureStreamer::INVALID_HANDLE){
+            for(uint32_t index:this->texturedMaterialIndices) this->bindlessTable.releaseStorageBuffer(index);
+        }
+        vkUnmapMemory(this->engineDevice.device(), this->materialBufferMemory);
+        vkDestroyBuffer(this->engineDevice.device(), this->materialBuffer, nullptr);
+        vkFreeMemory(this->engineDevice.device(), this->materialBufferMemory, nullptr);
+        if(this->shaderArchive) EnginePipeline::setShaderArchive(nullptr);
     }
     
     void App::run(){
-        while (!engineWindow.shouldClose()){
+        // every Vulkan call from here on happens on the render thread, GLFW events stay on this one
+        this->isRenderThreadRunning = true;
+        this->renderThread = std::thread(&App::renderLoop, this);
+
+        auto lastReport = std::chrono::steady_clock::now();
+        while (!engineWindow.shouldClose() && this->isRenderThreadRunning){
+            auto eventsStart = std::chrono::steady_clock::now();
+            glfwPollEvents();
+            this->gameTimings.eventsMs += millisecondsSince(eventsStart);
+            this->handleInput();
+            this->updateModel();
+
+            if(this->frameQueue.isFull()){
+                // the render thread is a full queue behind, wait for input instead of spinning
+                auto waitStart = std::chrono::steady_clock::now();
+                glfwWaitEventsTimeout(0.001);
+                this->gameTimings.eventsMs += millisecondsSince(waitStart);
+            }else{
+                // built only when there is room, so the packet carries the freshest state
+                auto packetStart = std::chrono::steady_clock::now();
+                uint64_t allocationsBefore = threadAllocationCount();
+                this->frameQueue.tryPush(this->buildFramePacket());
+                this->gameTimings.allocationCount += threadAllocationCount() - allocationsBefore;
+                this->gameTimings.packetMs += millisecondsSince(packetStart);
+                this->gameTimings.packetCount++;
+            }
+
+            if(this->settings.isTimingReportEnabled && millisecondsSince(lastReport) >= 1000.0){
+                this->reportTimings();
+                lastReport = std::chrono::steady_clock::now();
+            }
+        }
+
+        this->isRenderThreadRunning = false;
+        this->frameQueue.wake();
+        this->renderThread.join();
+        vkDeviceWaitIdle(this->engineDevice.device());
+        if(this->renderThreadError) std::rethrow_exception(this->renderThreadError);
+    }
+
+    FrameStatistics App::benchmark(uint32_t frameCount){
+        // warm up so pipeline creation and first-use allocations are not measured
+        for(uint32_t i = 0; i < this->engineSwapChain.imageCount(); i++) this->drawFrame(this->buildFramePacket());
+        vkDeviceWaitIdle(this->engineDevice.device());
+        this->renderTimings = {};
+
+        auto start = std::chrono::steady_clock::now();
+        uint64_t allocationsBefore = threadAllocationCount();
+        uint32_t renderedFrames = 0;
+        for(; renderedFrames < frameCount && !this->engineWindow.shouldClose(); renderedFrames++){
             glfwPollEvents();
-            this->drawFrame();
+            this->drawFrame(this->buildFramePacket());
         }
+        uint64_t allocations = threadAllocationCount() - allocationsBefore;
         vkDeviceWaitIdle(this->engineDevice.device());
+        auto end = std::chrono::steady_clock::now();
+
+        FrameStatistics statistics = {};
+        statistics.frameCount = renderedFrames;
+        if(renderedFrames > 0){
+            statistics.averageCpuFrameMs = std::chrono::duration<double, std::milli>(end - start).count() / renderedFrames;
+            statistics.averageAllocationsPerFrame = static_cast<double>(allocations) / renderedFrames;
+        }
+        if(this->renderTimings.gpuFrameCount > 0) statistics.averageGpuFrameMs = this->renderTimings.gpuMs / this->renderTimings.gpuFrameCount;
+        uint32_t cullFrameCount = this->renderTimings.cullFrameCount;
+        if(cullFrameCount > 0){
+            statistics.averageFrustumCulled = static_cast<double>(this->renderTimings.frustumCulled) / cullFrameCount;
+            statistics.averageOccluded = static_cast<double>(this->renderTimings.occluded) / cullFrameCount;
+            statistics.averageFirstPhaseDrawn = static_cast<double>(this->renderTimings.firstPhaseDrawn) / cullFrameCount;
+            statistics.averageSecondPhaseDrawn = static_cast<double>(this->renderTimings.secondPhaseDrawn) / cullFrameCount;
+        }
+        if(this->renderTimings.frameCount > 0){
+            statistics.averageRecordMs = this->renderTimings.recordMs / this->renderTimings.frameCount;
+            statistics.averageShadowDraws = static_cast<double>(this->renderTimings.shadowDraws) / this->renderTimings.frameCount;
+            statistics.averageIssuedBinds = static_cast<double>(this->renderTimings.issuedBinds) / this->renderTimings.frameCount;
+            statistics.averageEliminatedBinds = static_cast<double>(this->renderTimings.eliminatedBinds) / this->renderTimings.frameCount;
+        }
+        uint32_t particleFrameCount = this->renderTimings.particleFrameCount;
+        if(particleFrameCount > 0){
+            statistics.averageAliveParticles = static_cast<double>(this->renderTimings.aliveParticles) / particleFrameCount;
+            statistics.averageParticleUploadBytes = static_cast<double>(this->renderTimings.particleUploadBytes) / particleFrameCount;
+        }
+        if(this->renderTimings.frameCount > 0) statistics.averageSpriteDraws = static_cast<double>(this->renderTimings.spriteDraws) / this->renderTimings.frameCount;
+        return statistics;
+    }
+
+    MeshGenerationStatistics App::benchmarkMeshGeneration(uint32_t depth){
+        MeshGenerationStatistics statistics = {};
+        statistics.depth = depth;
+        statistics.vertexCount = EngineMeshGenerator::sierpinskiVertexCount(depth);
+        VkDeviceSize vertexBytes = statistics.vertexCount * sizeof(EngineModel::Vertex);
+
+        auto cpuStart = std::chrono::steady_clock::now();
+        std::vector<EngineModel::Vertex> vertices = EngineMeshGenerator::sierpinski(depth, SIERPINSKI_LEFT, SIERPINSKI_TOP, SIERPINSKI_RIGHT, this->meshWorkerPool);
+        statistics.cpuGenerateMs = millisecondsSince(cpuStart);
+        auto uploadStart = std::chrono::steady_clock::now();
+        {
+            EngineModel model{this->engineDevice, vertices};
+        }
+        statistics.cpuUploadMs = millisecondsSince(uploadStart);
+        statistics.cpuUploadBytes = vertexBytes;
+
+        EngineComputeMeshGenerator generator{
+            this->engineDevice,
+            SIERPINSKI_COMPUTE_SHADER_PATH,
+            sizeof(SierpinskiParameters),
+            EngineSwapChain::MAX_FRAMES_IN_FLIGHT
+        };
+        EngineModel model{this->engineDevice, static_cast<uint32_t>(statistics.vertexCount), SIERPINSKI_BOUNDS};
+        SierpinskiParameters parameters = buildSierpinskiParameters(depth);
+        // the first dispatch pays for pipeline warm up
+        generator.generateNow(model, &parameters, parameters.triangleCount);
+        auto gpuStart = std::chrono::steady_clock::now();
+        statistics.gpuGenerateMs = std::max(generator.generateNow(model, &parameters, parameters.triangleCount), 0.0);
+        statistics.gpuSubmitMs = millisecondsSince(gpuStart);
+        statistics.gpuUploadBytes = sizeof(SierpinskiParameters);
+        statistics.gpuWrittenBytes = vertexBytes + sizeof(VkDrawIndirectCommand);
+        return statistics;
+    }
+
+    ImportStatistics App::benchmarkImport(const std::string &filePath){
+        EngineAssetImporter importer{this->engineDevice};
+        EngineAssetImporter::Options options = {};
+        options.isFittedToUnitSquare = true;
+        ImportStatistics statistics;
+        importer.importModel(filePath, options, statistics);
+        importer.importModel(filePath, options, statistics);
+        return statistics;
+    }
+
+    DecompressionStatistics App::benchmarkDecompression(const std::string &filePath, uint32_t chunkSize){
+        DecompressionStatistics statistics = {};
+        statistics.chunkSize = chunkSize;
+
+        EngineAssetImporter importer{this->engineDevice};
+        EngineAssetImporter::Options options = {};
+        options.isFittedToUnitSquare = true;
+        ImportStatistics importStatistics;
+        std::vector<EngineModel::Vertex> vertices = importer.importVertices(filePath, options, importStatistics);
+        std::vector<char> vertexBytes(vertices.size() * sizeof(EngineModel::Vertex));
+        memcpy(vertexBytes.data(), vertices.data(), vertexBytes.size());
+
+        // both paths read from a mapped file, like they would at runtime
+        std::string archivePath = (std::filesystem::temp_directory_path() / DECOMPRESSION_BENCHMARK_ARCHIVE).string();
+        {
+            EngineArchiveWriter writer{chunkSize};
+            writer.add(filePath, vertexBytes);
+            writer.write(archivePath);
+        }
+        EngineArchive archive{archivePath};
+
+        auto cpuStart = std::chrono::steady_clock::now();
+        std::vector<char> decoded = archive.read(filePath);
+        std::vector<EngineModel::Vertex> decodedVertices(decoded.size() / sizeof(EngineModel::Vertex));
+        memcpy(decodedVertices.data(), decoded.data(), decoded.size());
+        statistics.cpuDecodeMs = millisecondsSince(cpuStart);
+        // staged into device local memory like the GPU path's vertices end up, a host visible
+        // EngineModel would skip the copy and make the CPU path look cheaper than it is
+        auto uploadStart = std::chrono::steady_clock::now();
+        {
+            VkDeviceSize bufferSize = decoded.size();
+            VkBuffer stagingBuffer;
+            VkDeviceMemory stagingBufferMemory;
+            this->engineDevice.createBuffer(
+                bufferSize,
+                VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                stagingBuffer,
+                stagingBufferMemory
+            );
+            void *data;
+            vkMapMemory(this->engineDevice.device(), stagingBufferMemory, 0, bufferSize, 0, &data);
+            memcpy(data, decodedVertices.data(), static_cast<size_t>(bufferSize));
+            vkUnmapMemory(this->engineDevice.device(), stagingBufferMemory);
+
+            VkBuffer vertexBuffer;
+            VkDeviceMemory vertexBufferMemory;
+            this->engineDevice.createBuffer(
+                bufferSize,
+                VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                vertexBuffer,
+                vertexBufferMemory
+            );
+            // waits for the queue, so the copy is inside the measurement
+            this->engineDevice.copyBuffer(stagingBuffer, vertexBuffer, bufferSize);
+
+            vkDestroyBuffer(this->engineDevice.device(), stagingBuffer, nullptr);
+            vkFreeMemory(this->engineDevice.device(), stagingBufferMemory, nullptr);
+            vkDestroyBuffer(this->engineDevice.device(), vertexBuffer, nullptr);
+            vkFreeMemory(this->engineDevice.device(), vertexBufferMemory, nullptr);
+        }
+        statistics.cpuUploadMs = millisecondsSince(uploadStart);
+
+        EngineGpuDecompressor decompressor{this->engineDevice};
+        // the first dispatch pays for pipeline warm up
+        decompressor.decompressModel(archive, filePath, FITTED_MODEL_BOUNDS, statistics.gpu);
+        auto gpuStart = std::chrono::steady_clock::now();
+        std::unique_ptr<EngineModel> model = decompressor.decompressModel(archive, filePath, FITTED_MODEL_BOUNDS, statistics.gpu);
+        statistics.gpuTotalMs = millisecondsSince(gpuStart);
+
+        VkBuffer readbackBuffer;
+        VkDeviceMemory readbackBufferMemory;
+        this->engineDevice.createBuffer(
+            vertexBytes.size(),
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            readbackBuffer,
+            readbackBufferMemory
+        );
+        this->engineDevice.copyBuffer(model->getVertexBuffer(), readbackBuffer, vertexBytes.size());
+        void *data;
+        vkMapMemory(this->engineDevice.device(), readbackBufferMemory, 0, vertexBytes.size(), 0, &data);
+        statistics.isMatching = memcmp(data, vertexBytes.data(), vertexBytes.size()) == 0;
+        vkUnmapMemory(this->engineDevice.device(), readbackBufferMemory);
+        vkDestroyBuffer(this->engineDevice.device(), readbackBuffer, nullptr);
+        vkFreeMemory(this->engineDevice.device(), readbackBufferMemory, nullptr);
+
+        std::filesystem::remove(archivePath);
+        return statistics;
+    }
+
+    bool App::isSampleShadingEnabled(){
+        return this->settings.isSampleShadingEnabled
+            && this->engineSwapChain.isMultisampled()
+            && this->engineDevice.supportedFeatures.sampleRateShading;
     }
     
 
     // Privates
+    void App::createMaterials(){
+        Material material = {};
+        material.tint = {1.0f, 1.0f, 1.0f, 1.0f};
+        material.textureIndex = EngineBindlessTable::INVALID_INDEX;
+
+        // the plain material, then the textured copies, each at an offset storage buffers can be bound at
+        bool isTextured = this->sceneTexture != EngineTextureStreamer::INVALID_HANDLE;
+        uint32_t materialCount = isTextured ? 1 + EngineSwapChain::MAX_FRAMES_IN_FLIGHT : 1;
+        VkDeviceSize alignment = std::max<VkDeviceSize>(this->engineDevice.properties.limits.minStorageBufferOffsetAlignment, 1);
+        this->materialStride = (sizeof(Material) + alignment - 1) / alignment * alignment;
+        VkDeviceSize bufferSize = this->materialStride * materialCount;
+        this->engineDevice.createBuffer(
+            bufferSize,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            this->materialBuffer,
+            this->materialBufferMemory
+        );
+
+        // kept mapped, the textured copies are rewritten every frame
+        void *data;
+        vkMapMemory(this->engineDevice.device(), this->materialBufferMemory, 0, bufferSize, 0, &data);
+        this->mappedMaterials = static_cast<uint8_t *>(data);
+        for(uint32_t i = 0; i < materialCount; i++) memcpy(this->mappedMaterials + i * this->materialStride, &material, sizeof(Material));
+
+        this->materialIndex = this->bindlessTable.registerStorageBuffer(this->materialBuffer, 0, sizeof(Material));
+        this->sceneMaterialIndex = this->materialIndex;
+        if(!isTextured) return;
+        for(uint32_t i = 0; i < EngineSwapChain::MAX_FRAMES_IN_FLIGHT; i++){
+            this->texturedMaterialIndices[i] = this->bindlessTable.registerStorageBuffer(this->materialBuffer, (1 + i) * this->materialStride, sizeof(Material));
+        }
+        this->sceneMaterialIndex = this->texturedMaterialIndices[0];
+    }
+
+    void App::createLights(){
+        if(!this->lightClusterer) return;
+        uint32_t lightCount = std::min(this->settings.lightCount, EngineLightClusterer::MAX_LIGHTS);
+        float radius = LIGHT_RADIUS_SCALE / std::cbrt(static_cast<float>(lightCount));
+
+        // seeded so every run and every benchmark configuration lights the same scene
+        std::mt19937 generator{LIGHT_SEED};
+        std::uniform_real_distribution<float> position{-1.0f, 1.0f};
+        std::uniform_real_distribution<float> depth{0.0f, 1.0f};
+        std::uniform_real_distribution<float> channel{0.2f, 1.0f};
+        this->lights.resize(lightCount);
+        for(EngineLightClusterer::Light &light:this->lights){
+            light.positionRadius = {position(generator), position(generator), depth(generator), radius};
+            light.color = {channel(generator), channel(generator), channel(generator), LIGHT_INTENSITY};
+        }
+        ENGINE_LOG_INFO("App: %u lights of radius %.3f", lightCount, radius);
+    }
+
+    void App::createEmitters(){
+        if(!this->particleSystem) return;
+        // particles live three quarters of PARTICLE_LIFE_SECONDS on average
+        float particlesPerSecond = this->settings.particleCount / (PARTICLE_LIFE_SECONDS * 0.75f) / EMITTER_COUNT;
+        this->emitters.resize(EMITTER_COUNT);
+        for(uint32_t i = 0; i < EMITTER_COUNT; i++){
+            float angle = TAU * i / EMITTER_COUNT;
+            EngineParticleSystem::Emitter &emitter = this->emitters[i];
+            emitter.position = glm::vec2{glm::cos(angle), glm::sin(angle)} * EMITTER_RING_RADIUS;
+            emitter.velocity = {0.0f, -0.6f};
+            emitter.color = {0.5f + 0.5f * glm::cos(angle), 0.5f + 0.5f * glm::sin(angle), 1.0f - 0.5f * glm::cos(angle), 1.0f};
+            emitter.depth = 0.05f;
+            emitter.speedSpread = 0.3f;
+            emitter.lifeSeconds = PARTICLE_LIFE_SECONDS;
+            emitter.size = PARTICLE_SIZE;
+            emitter.particlesPerSecond = particlesPerSecond;
+        }
+        ENGINE_LOG_INFO("App: %u emitters of %.1f particles per second", EMITTER_COUNT, particlesPerSecond);
+    }
+
+    void App::createTimestampQueryPool(){
+        if(!this->engineDevice.properties.limits.timestampComputeAndGraphics) return;
+
+        VkQueryPoolCreateInfo queryPoolCreateInfo = {};
+        queryPoolCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryPoolCreateInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        queryPoolCreateInfo.queryCount = EngineSwapChain::MAX_FRAMES_IN_FLIGHT * 2;
+
+        bool isCreateQueryPoolSuccess = vkCreateQueryPool(this->engineDevice.device(), &queryPoolCreateInfo, nullptr, &this->timestampQueryPool) == VK_SUCCESS;
+        if(!isCreateQueryPoolSuccess) throw std::runtime_error("Failed to create timestamp query pool");
+        this->hasTimestamps.resize(EngineSwapChain::MAX_FRAMES_IN_FLIGHT, false);
+    }
+
+    double App::collectTimestamps(size_t frameIndex){
+        if(this->timestampQueryPool == VK_NULL_HANDLE || !this->hasTimestamps[frameIndex]) return -1.0;
+
+        // the previous submission of this frame slot has completed, the wait never blocks
+        uint64_t timestamps[2];
+        bool isGetQueryResultsSuccess = vkGetQueryPoolResults(
+            this->engineDevice.device(),
+            this->timestampQueryPool,
+            static_cast<uint32_t>(frameIndex * 2),
+            2,
+            sizeof(timestamps),
+            timestamps,
+            sizeof(uint64_t),
+            VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT
+        ) == VK_SUCCESS;
+        if(!isGetQueryResultsSuccess) return -1.0;
+
+        double nanoseconds = static_cast<double>(timestamps[1] - timestamps[0]) * this->engineDevice.properties.limits.timestampPeriod;
+        return nanoseconds / 1000000.0;
+    }
+
     void App::createPipelineLayout(){
+        VkPushConstantRange pushConstantRange = {};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(SimplePushConstantData);
+
+        VkDescriptorSetLayout descriptorSetLayout = this->bindlessTable.getDescriptorSetLayout();
+
         VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
         pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-        pipelineLayoutCreateInfo.setLayoutCount = 0;
-        pipelineLayoutCreateInfo.pSetLayouts = nullptr;
-        pipelineLayoutCreateInfo.pushConstantRangeCount = 0;
-        pipelineLayoutCreateInfo.pPushConstantRanges = nullptr;
+        pipelineLayoutCreateInfo.setLayoutCount = 1;
+        pipelineLayoutCreateInfo.pSetLayouts = &descriptorSetLayout;
+        pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+        pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
 
         bool isCreatePipelineLayoutSuccess = vkCreatePipelineLayout(this->engineDevice.device(), &pipelineLayoutCreateInfo, nullptr, &this->pipelineLayout) == VK_SUCCESS;
         if(!isCreatePipelineLayoutSuccess) throw std::runtime_error("Failed to create pipeline layout");
@@ -46,18 +585,43 @@ namespace engine {
         auto pipelineConfig = EnginePipeline::defaultPipelineConfig(this->engineSwapChain.width(), this->engineSwapChain.height());
         pipelineConfig.renderPass = this->engineSwapChain.getRenderPass();
         pipelineConfig.pipelineLayout = this->pipelineLayout;
+        pipelineConfig.pipelineMultiSampleStateCreateInfo.rasterizationSamples = this->engineSwapChain.getSampleCount();
+        if(this->isSampleShadingEnabled()){
+            pipelineConfig.pipelineMultiSampleStateCreateInfo.sampleShadingEnable = VK_TRUE;
+            pipelineConfig.pipelineMultiSampleStateCreateInfo.minSampleShading = this->settings.minSampleShading;
+        }
+        // the sierpinski model is coloured per vertex, the scene texture multiplies the colours
+        pipelineConfig.permutation = ShaderPermutation{}
+            .with(ShaderFeature::VERTEX_COLOR)
+            .with(ShaderFeature::TEXTURE, this->sceneTexture != EngineTextureStreamer::INVALID_HANDLE)
+            .with(ShaderFeature::MULTISAMPLING, this->engineSwapChain.isMultisampled())
+            .with(ShaderFeature::CLUSTERED_LIGHTING, this->lightClusterer != nullptr)
+            .with(ShaderFeature::SHADOWS, this->shadowMap != nullptr);
+
+        // both are compatible with the continue render pass of occlusion culling
+        this->depthPrePassPipeline = nullptr;
+        if(this->settings.isDepthPrePassEnabled){
+            PipelineConfigInfo prePassConfig = pipelineConfig;
+            prePassConfig.pipelineColorBlendAttachmentState.colorWriteMask = 0;
+            this->depthPrePassPipeline = &this->pipelineCache.getPipeline(VERTEX_SHADER_PATH, FRAGMENT_SHADER_PATH, prePassConfig);
+            // depth is final after the pre-pass, only the fragments that wrote it pass
+            pipelineConfig.pipelineDepthStencilStateCreateInfo.depthWriteEnable = VK_FALSE;
+            pipelineConfig.pipelineDepthStencilStateCreateInfo.depthCompareOp = VK_COMPARE_OP_EQUAL;
+        }
 
         // read compiled shader vertext and fragment file code
-        this->enginePipeline = std::make_unique<EnginePipeline>(
-            this->engineDevice,
-            "shaders/simple_shader.vert.spv", 
-            "shaders/simple_shader.frag.spv",
-            pipelineConfig
-        );
+        this->enginePipeline = &this->pipelineCache.getPipeline(VERTEX_SHADER_PATH, FRAGMENT_SHADER_PATH, pipelineConfig);
+        if(this->shadowMap) this->shadowMap->createPipeline();
+        if(this->particleSystem) this->particleSystem->createPipeline();
+        if(this->spriteBatch) this->spriteBatch->createPipeline();
+#if ENGINE_DEBUG_DRAW
+        if(this->debugDraw) this->debugDraw->createPipelines();
+#endif
     }
 
     void App::createCommandBuffers(){
-        this->commandBuffers.resize(this->engineSwapChain.imageCount());
+        // one per frame in flight, re-recorded every frame with the latest interpolated state
+        this->commandBuffers.resize(EngineSwapChain::MAX_FRAMES_IN_FLIGHT);
 
         VkCommandBufferAllocateInfo commandBufferAllocateInfo = {};
         commandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -68,94 +632,688 @@ namespace engine {
 
         bool isAllocateCommandBufferSuccess = vkAllocateCommandBuffers(this->engineDevice.device(), &commandBufferAllocateInfo, this->commandBuffers.data()) == VK_SUCCESS;
         if(!isAllocateCommandBufferSuccess) throw std::runtime_error("Failed to allocate command buffer");
-        
-        // Record command for each buffer
-        for(int i = 0; i < this->commandBuffers.size(); i++){
-            VkCommandBufferBeginInfo commandBufferBeginInfo = {};
-            commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-            bool isBeginCommandBufferSuccess = vkBeginCommandBuffer(this->commandBuffers[i], &commandBufferBeginInfo) == VK_SUCCESS;
-            if(!isBeginCommandBufferSuccess) throw std::runtime_error("Failed to begin recording command buffer!");
-
-            VkRenderPassBeginInfo renderPassBeginInfo = {};
-            renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-            renderPassBeginInfo.renderPass = this->engineSwapChain.getRenderPass();
-            renderPassBeginInfo.framebuffer = this->engineSwapChain.getFrameBuffer(i);
-    
-            renderPassBeginInfo.renderArea.offset = {0,0};
-            renderPassBeginInfo.renderArea.extent = this->engineSwapChain.getSwapChainExtent();
+    }
+
+    void App::recordCommandBuffer(size_t frameIndex, uint32_t imageIndex, const FramePacket &packet){
+        VkCommandBuffer commandBuffer = this->commandBuffers[frameIndex];
+        uint32_t firstQuery = static_cast<uint32_t>(frameIndex * 2);
+        this->recordedDrawCount = 0;
+
+        // beginning implicitly resets the buffer recorded for this slot before
+        VkCommandBufferBeginInfo commandBufferBeginInfo = {};
+        commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        bool isBeginCommandBufferSuccess = vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo) == VK_SUCCESS;
+        if(!isBeginCommandBufferSuccess) throw std::runtime_error("Failed to begin recording command buffer!");
+        this->commandEncoder.begin(commandBuffer);
+
+        if(this->timestampQueryPool != VK_NULL_HANDLE){
+            vkCmdResetQueryPool(commandBuffer, this->timestampQueryPool, firstQuery, 2);
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, this->timestampQueryPool, firstQuery);
+        }
+
+        VkRenderPassBeginInfo renderPassBeginInfo = {};
+        renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassBeginInfo.renderPass = this->engineSwapChain.getRenderPass();
+        renderPassBeginInfo.framebuffer = this->engineSwapChain.getFrameBuffer(imageIndex);
 
-            std::array<VkClearValue, 2> clearValues{};
-            clearValues[0].color = {0.1f, 0.1f, 0.1f, 1.0f};
-            clearValues[1].depthStencil = {1.0f, 0};
+        renderPassBeginInfo.renderArea.offset = {0,0};
+        renderPassBeginInfo.renderArea.extent = this->engineSwapChain.getSwapChainExtent();
 
-            renderPassBeginInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-            renderPassBeginInfo.pClearValues = clearValues.data();
+        std::array<VkClearValue, 2> clearValues{};
+        clearValues[0].color = {0.1f, 0.1f, 0.1f, 1.0f};
+        clearValues[1].depthStencil = {1.0f, 0};
 
-            vkCmdBeginRenderPass(this->commandBuffers[i], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+        renderPassBeginInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+        renderPassBeginInfo.pClearValues = clearValues.data();
 
-            this->enginePipeline->bind(this->commandBuffers[i]);
-            this->engineModel->bind(this->commandBuffers[i]);
-            this->engineModel->draw(this->commandBuffers[i]);
+        // the streamer's copies have to happen outside the render pass, before the draws sample them
+        this->updateSceneTexture(commandBuffer, frameIndex, packet);
+        // mesh generation has to happen outside the render pass, its barrier makes the results visible to the draws
+        if(this->meshGenerator) this->meshGenerator->recordRequests(commandBuffer, frameIndex);
 
-            vkCmdEndRenderPass(this->commandBuffers[i]);
-            bool isEndCommandBufferSuccess = vkEndCommandBuffer(this->commandBuffers[i]) == VK_SUCCESS;
-            if(!isEndCommandBufferSuccess) throw std::runtime_error("Failed to record command buffer");
+        // every instance of the frame in one pass over mapped memory, drawn by firstInstance
+        VkDeviceSize instanceOffset = 0;
+        if(packet.instanceCount > 0){
+            EngineModel::Instance *instances = this->dynamicBuffer.allocateArray<EngineModel::Instance>(packet.instanceCount, instanceOffset);
+            bool isTextured = this->sceneTexture != EngineTextureStreamer::INVALID_HANDLE;
+            for(uint32_t i = 0; i < packet.instanceCount; i++){
+                uint32_t materialIndex = packet.instances[i].materialIndex;
+                // the frame's own copy of the textured material
+                if(isTextured && materialIndex == this->texturedMaterialIndices[0]) materialIndex = this->texturedMaterialIndices[frameIndex];
+                instances[i].transform = packet.instances[i].transform;
+                instances[i].materialIndex = materialIndex;
+                instances[i].depth = packet.instances[i].depth;
+                instances[i].translation = packet.instances[i].translation;
+            }
         }
 
+        bool isCulled = this->occlusionCuller && packet.instanceCount > 0;
+        if(isCulled){
+            // screen space boxes of the model bounds, the cull shader only ever sees these
+            VkDeviceSize cullOffset;
+            EngineOcclusionCuller::CullInstance *cullInstances = this->dynamicBuffer.allocateArray<EngineOcclusionCuller::CullInstance>(packet.instanceCount, cullOffset);
+            for(uint32_t i = 0; i < packet.instanceCount; i++){
+                const FrameInstance &instance = packet.instances[i];
+                const EngineModel::Bounds &bounds = instance.model->getBounds();
+                glm::vec2 corners[4] = {bounds.min, {bounds.max.x, bounds.min.y}, {bounds.min.x, bounds.max.y}, bounds.max};
+                glm::vec2 screenMin{std::numeric_limits<float>::max()};
+                glm::vec2 screenMax{std::numeric_limits<float>::lowest()};
+                for(const glm::vec2 &corner:corners){
+                    glm::vec2 position = packet.camera * (instance.transform * corner + instance.translation);
+                    screenMin = glm::min(screenMin, position);
+                    screenMax = glm::max(screenMax, position);
+                }
+                cullInstances[i].bounds = glm::vec4{screenMin, screenMax};
+                cullInstances[i].depth = instance.depth;
+                cullInstances[i].vertexCount = instance.model->getVertexCount();
+            }
+            this->occlusionCuller->recordFirstPhase(commandBuffer, frameIndex, this->dynamicBuffer.getBuffer(), cullOffset, packet.instanceCount);
+        }
+
+        if(this->lightClusterer){
+            // light space is normalised device space with x stretched by the aspect ratio
+            float aspect = this->engineSwapChain.extentAspectRatio();
+            float cosine = glm::cos(packet.lightRotation);
+            float sine = glm::sin(packet.lightRotation);
+            glm::mat2 orbit = packet.camera * glm::mat2{{cosine, sine}, {-sine, cosine}};
+            EngineLightClusterer::Light *lights = this->lightClusterer->mapLights(frameIndex);
+            for(size_t i = 0; i < this->lights.size(); i++){
+                const EngineLightClusterer::Light &light = this->lights[i];
+                glm::vec2 position = orbit * glm::vec2{light.positionRadius.x, light.positionRadius.y};
+                lights[i].positionRadius = {position.x * aspect, position.y, light.positionRadius.z, light.positionRadius.w};
+                lights[i].color = light.color;
+            }
+            this->lightClusterer->recordClustering(commandBuffer, frameIndex, static_cast<uint32_t>(this->lights.size()), aspect);
+        }
+
+        if(this->particleSystem){
+            uint32_t emitterCount = static_cast<uint32_t>(this->emitters.size());
+            this->particleSystem->recordSimulation(commandBuffer, frameIndex, this->emitters.data(), emitterCount, packet.deltaSeconds);
+        }
+
+        if(this->shadowMap && packet.instanceCount > 0){
+            this->shadowMap->update(frameIndex, packet.camera, SHADOW_LIGHT_DIRECTION);
+            // a single pointer capture keeps std::function from allocating
+            struct ShadowJob {
+                App *app;
+                size_t frameIndex;
+                const FramePacket *packet;
+                VkDeviceSize instanceOffset;
+            } job = {this, frameIndex, &packet, instanceOffset};
+            this->shadowMap->record(commandBuffer, frameIndex, [&job](VkCommandBuffer cascadeCommandBuffer, uint32_t cascade){
+                job.app->recordShadowCasters(cascadeCommandBuffer, job.frameIndex, cascade, *job.packet, job.instanceOffset);
+            });
+            uint32_t shadowDraws = 0;
+            for(uint32_t drawCount:this->shadowDrawCounts) shadowDraws += drawCount;
+            this->recordedDrawCount += shadowDraws;
+            std::lock_guard<std::mutex> lock(this->renderTimingsMutex);
+            this->renderTimings.shadowDraws += shadowDraws;
+            for(const CommandEncoderStatistics &bindStatistics:this->shadowBindStatistics){
+                this->renderTimings.issuedBinds += bindStatistics.issuedBinds;
+                this->renderTimings.eliminatedBinds += bindStatistics.eliminatedBinds;
+            }
+        }
+
+        // once for both passes when culling, the draw order does not change between them
+        this->sortDraws(packet);
+
+        vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+        this->recordDraws(this->commandEncoder, frameIndex, packet, instanceOffset);
+        // after all the opaque geometry, which only the continue pass completes when culling
+        if(this->particleSystem && !isCulled){
+            this->particleSystem->recordDraw(commandBuffer, packet.camera);
+            this->recordedDrawCount++;
+        }
+        if(!isCulled) this->recordSprites(commandBuffer, frameIndex, packet);
+#if ENGINE_DEBUG_DRAW
+        if(!isCulled) this->recordDebugOverlay(commandBuffer, frameIndex, packet);
+#endif
+        vkCmdEndRenderPass(commandBuffer);
+
+        if(isCulled){
+            // the pyramid is rebuilt from the depth just drawn, what was culled against last frame's gets another chance
+            this->occlusionCuller->recordSecondPhase(commandBuffer, frameIndex, imageIndex);
+            renderPassBeginInfo.renderPass = this->engineSwapChain.getContinueRenderPass();
+            vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+            this->recordDraws(this->commandEncoder, frameIndex, packet, instanceOffset);
+            if(this->particleSystem){
+                this->particleSystem->recordDraw(commandBuffer, packet.camera);
+                this->recordedDrawCount++;
+            }
+            this->recordSprites(commandBuffer, frameIndex, packet);
+#if ENGINE_DEBUG_DRAW
+            this->recordDebugOverlay(commandBuffer, frameIndex, packet);
+#endif
+            vkCmdEndRenderPass(commandBuffer);
+        }
+
+        if(this->timestampQueryPool != VK_NULL_HANDLE){
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, this->timestampQueryPool, firstQuery + 1);
+        }
+        bool isEndCommandBufferSuccess = vkEndCommandBuffer(commandBuffer) == VK_SUCCESS;
+        if(!isEndCommandBufferSuccess) throw std::runtime_error("Failed to record command buffer");
+
+        const CommandEncoderStatistics &bindStatistics = this->commandEncoder.getStatistics();
+        std::lock_guard<std::mutex> lock(this->renderTimingsMutex);
+        this->renderTimings.issuedBinds += bindStatistics.issuedBinds;
+        this->renderTimings.eliminatedBinds += bindStatistics.eliminatedBinds;
+    }
+
+    void App::updateSceneTexture(VkCommandBuffer commandBuffer, size_t frameIndex, const FramePacket &packet){
+        bool isTextured = this->sceneTexture != EngineTextureStreamer::INVALID_HANDLE;
+        if(isTextured){
+            // the texture spans the model's [-1, 1] square, see simple_shader.vert
+            static const glm::vec2 corners[4] = {{-1.0f, -1.0f}, {1.0f, -1.0f}, {-1.0f, 1.0f}, {1.0f, 1.0f}};
+            glm::vec2 halfExtent = glm::vec2{static_cast<float>(this->engineSwapChain.width()), static_cast<float>(this->engineSwapChain.height())} * 0.5f;
+            for(uint32_t i = 0; i < packet.instanceCount; i++){
+                const FrameInstance &instance = packet.instances[i];
+                if(instance.materialIndex != this->texturedMaterialIndices[0]) continue;
+                glm::vec2 screenMin{std::numeric_limits<float>::max()};
+                glm::vec2 screenMax{std::numeric_limits<float>::lowest()};
+                for(const glm::vec2 &corner:corners){
+                    glm::vec2 position = packet.camera * (instance.transform * corner + instance.translation);
+                    screenMin = glm::min(screenMin, position);
+                    screenMax = glm::max(screenMax, position);
+                }
+                glm::vec2 screenPixels = (screenMax - screenMin) * halfExtent;
+                this->textureStreamer.reportScreenCoverage(this->sceneTexture, std::max(screenPixels.x, screenPixels.y));
+            }
+        }
+
+        // this frame's coverage already counts for the loads scheduled now
+        this->textureStreamer.update(commandBuffer, packet.frameNumber, this->frameArena.resource(frameIndex));
+        if(!isTextured) return;
+
+        // the previous submission of this slot has completed, nothing reads its copy any more
+        Material *material = reinterpret_cast<Material *>(this->mappedMaterials + (1 + frameIndex) * this->materialStride);
+        material->textureIndex = this->textureStreamer.bindlessIndex(this->sceneTexture);
+    }
+
+    void App::sortDraws(const FramePacket &packet){
+        // models numbered in order of first appearance, a packet holds far fewer than the key's 16 bits
+        std::array<EngineModel *, FramePacket::MAX_INSTANCES> meshes;
+        std::array<uint32_t, FramePacket::MAX_INSTANCES> meshIndices;
+        uint32_t meshCount = 0;
+        for(uint32_t i = 0; i < packet.instanceCount; i++){
+            EngineModel *model = packet.instances[i].model;
+            uint32_t mesh = 0;
+            while(mesh < meshCount && meshes[mesh] != model) mesh++;
+            if(mesh == meshCount) meshes[meshCount++] = model;
+            meshIndices[i] = mesh;
+        }
+
+        // the pipeline leads the key, so the whole depth pre-pass is drawn before any shading
+        std::array<EnginePipeline *, 2> pipelines = {this->depthPrePassPipeline, this->enginePipeline};
+        this->drawSorter.clear();
+        for(uint32_t pipeline = 0; pipeline < pipelines.size(); pipeline++){
+            if(pipelines[pipeline] == nullptr) continue;
+            for(uint32_t i = 0; i < packet.instanceCount; i++){
+                const FrameInstance &instance = packet.instances[i];
+                uint64_t key = EngineDrawSorter::makeKey(pipeline, instance.materialIndex, meshIndices[i], instance.depth);
+                this->drawSorter.add(key, pipeline << SORTED_DRAW_PIPELINE_SHIFT | i);
+            }
+        }
+        this->drawSorter.sort();
+    }
+
+    void App::recordDraws(EngineCommandEncoder &encoder, size_t frameIndex, const FramePacket &packet, VkDeviceSize instanceOffset){
+        SimplePushConstantData push = {};
+        push.camera = packet.camera;
+        if(this->lightClusterer){
+            push.lighting = this->lightClusterer->getParameters(frameIndex);
+            push.viewportSize = {static_cast<float>(this->engineSwapChain.width()), static_cast<float>(this->engineSwapChain.height())};
+        }
+        if(this->shadowMap) push.shadowBufferIndex = this->shadowMap->getDataIndex(frameIndex);
+        VkBuffer instanceBuffer = this->dynamicBuffer.getBuffer();
+
+        // the cull dispatches between the render passes and the subsystems drawing without the
+        // encoder may have disturbed the graphics state
+        encoder.invalidate();
+
+        // every draw asks for all of its state, only the changes between sorted neighbours are recorded
+        std::array<EnginePipeline *, 2> pipelines = {this->depthPrePassPipeline, this->enginePipeline};
+        for(uint32_t draw:this->drawSorter.getDraws()){
+            uint32_t i = draw & SORTED_DRAW_INSTANCE_MASK;
+            EngineModel *model = packet.instances[i].model;
+            pipelines[draw >> SORTED_DRAW_PIPELINE_SHIFT]->bind(encoder);
+            this->bindlessTable.bind(encoder, this->pipelineLayout);
+            encoder.pushConstants(
+                this->pipelineLayout,
+                VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+                0,
+                sizeof(SimplePushConstantData),
+                &push
+            );
+            model->bind(encoder);
+            if(!this->occlusionCuller && !model->isGenerated()){
+                encoder.bindVertexBuffer(EngineModel::INSTANCE_BINDING, instanceBuffer, instanceOffset);
+                model->draw(encoder, 1, i);
+                continue;
+            }
+            // indirect commands always start at instance 0, so point the instance binding at this one for the draw
+            encoder.bindVertexBuffer(EngineModel::INSTANCE_BINDING, instanceBuffer, instanceOffset + i * sizeof(EngineModel::Instance));
+            if(this->occlusionCuller) encoder.drawIndirect(this->occlusionCuller->getDrawBuffer(frameIndex), i * sizeof(VkDrawIndirectCommand));
+            else model->draw(encoder);
+        }
+        this->recordedDrawCount += static_cast<uint32_t>(this->drawSorter.getDraws().size());
+    }
+
+    void App::recordSprites(VkCommandBuffer commandBuffer, size_t frameIndex, const FramePacket &packet){
+        if(!this->spriteBatch) return;
+        this->spriteBatch->begin(frameIndex);
+
+        // a grid from the top left, alternating layers so the sort has something to reorder
+        uint32_t columns = std::max(static_cast<uint32_t>(this->engineSwapChain.width() / SPRITE_SPACING), 1u);
+        uint32_t spriteCount = std::min(this->settings.spriteCount, EngineSpriteBatch::MAX_SPRITES);
+        EngineSpriteBatch::Sprite sprite = {};
+        sprite.size = glm::vec2{SPRITE_SIZE};
+        sprite.rotation = packet.spriteRotation;
+        for(uint32_t i = 0; i < spriteCount; i++){
+            uint32_t column = i % columns;
+            uint32_t row = i / columns;
+            sprite.position = (glm::vec2{static_cast<float>(column), static_cast<float>(row)} + 0.5f) * SPRITE_SPACING;
+            sprite.layer = static_cast<int16_t>(i & 1);
+            sprite.color = {static_cast<float>(column) / columns, 1.0f - static_cast<float>(column) / columns, (i & 1) ? 1.0f : 0.25f, 0.6f};
+            this->spriteBatch->draw(sprite);
+        }
+        uint32_t drawCount = this->spriteBatch->flush(commandBuffer);
+        this->recordedDrawCount += drawCount;
+
+        std::lock_guard<std::mutex> lock(this->renderTimingsMutex);
+        this->renderTimings.spriteDraws += drawCount;
+    }
+
+#if ENGINE_DEBUG_DRAW
+    void App::recordDebugOverlay(VkCommandBuffer commandBuffer, size_t frameIndex, const FramePacket &packet){
+        if(!this->debugDraw) return;
+        this->debugDraw->begin(frameIndex);
+
+        for(uint32_t i = 0; i < packet.instanceCount; i++){
+            const FrameInstance &instance = packet.instances[i];
+            this->debugDraw->bounds(instance.model->getBounds(), instance.transform, instance.translation, packet.camera, HUD_BOUNDS_COLOR);
+        }
+
+        // a fixed buffer keeps the overlay from allocating on the render thread
+        FrameArenaStatistics arenaStatistics = this->frameArena.getStatistics();
+        TextureStreamingStatistics textureStatistics = this->textureStreamer.getStatistics();
+        // the frame's binds so far, the overlay itself draws without the encoder
+        CommandEncoderStatistics bindStatistics = this->commandEncoder.getStatistics();
+        if(this->shadowMap && packet.instanceCount > 0){
+            for(const CommandEncoderStatistics &cascadeStatistics:this->shadowBindStatistics){
+                bindStatistics.issuedBinds += cascadeStatistics.issuedBinds;
+                bindStatistics.eliminatedBinds += cascadeStatistics.eliminatedBinds;
+            }
+        }
+        double fps = this->hudValues.frameMs > 0.0 ? 1000.0 / this->hudValues.frameMs : 0.0;
+        char hud[256];
+        int length = snprintf(
+            hud,
+            sizeof(hud),
+            "frame %.2f ms (%.0f fps) | gpu %.2f ms\ndraws %u | instances %u | binds %u, %u eliminated\nallocs %llu | arena %zu kib | textures %llu kib",
+            this->hudValues.frameMs,
+            fps,
+            this->hudValues.gpuMs,
+            this->recordedDrawCount,
+            packet.instanceCount,
+            bindStatistics.issuedBinds,
+            bindStatistics.eliminatedBinds,
+            static_cast<unsigned long long>(this->hudValues.allocations),
+            arenaStatistics.reservedBytes / 1024,
+            static_cast<unsigned long long>(textureStatistics.residentBytes / 1024)
+        );
+
+        // the backdrop fits the longest line
+        uint32_t columns = 0, lines = 1, column = 0;
+        for(int i = 0; i < length && i < static_cast<int>(sizeof(hud)) - 1; i++){
+            column = hud[i] == '\n' ? 0 : column + 1;
+            if(hud[i] == '\n') lines++;
+            columns = std::max(columns, column);
+        }
+        glm::vec2 textSize = glm::vec2{static_cast<float>(columns * EngineDebugDraw::GLYPH_ADVANCE), static_cast<float>(lines * EngineDebugDraw::LINE_ADVANCE)} * HUD_TEXT_SCALE;
+        this->debugDraw->filledBox(HUD_POSITION - HUD_PADDING, HUD_POSITION + textSize + HUD_PADDING, HUD_BACKGROUND_COLOR);
+        this->debugDraw->text(HUD_POSITION, hud, HUD_TEXT_COLOR, HUD_TEXT_SCALE);
+        this->recordedDrawCount += this->debugDraw->flush(commandBuffer);
+    }
+#endif
+
+    void App::recordShadowCasters(VkCommandBuffer commandBuffer, size_t frameIndex, uint32_t cascade, const FramePacket &packet, VkDeviceSize instanceOffset){
+        // the shadow map bound the pipeline and the descriptor sets, only vertex buffers go through the encoder
+        EngineCommandEncoder encoder{commandBuffer};
+        VkBuffer instanceBuffer = this->dynamicBuffer.getBuffer();
+
+        uint32_t drawCount = 0;
+        for(uint32_t i = 0; i < packet.instanceCount; i++){
+            const FrameInstance &instance = packet.instances[i];
+            const EngineModel::Bounds &bounds = instance.model->getBounds();
+            glm::vec2 corners[4] = {bounds.min, {bounds.max.x, bounds.min.y}, {bounds.min.x, bounds.max.y}, bounds.max};
+            glm::vec3 worldCorners[4];
+            for(uint32_t c = 0; c < 4; c++) worldCorners[c] = glm::vec3{instance.transform * corners[c] + instance.translation, instance.depth};
+            if(!this->shadowMap->isInCascade(frameIndex, cascade, worldCorners, 4)) continue;
+
+            drawCount++;
+            instance.model->bind(encoder);
+            if(!instance.model->isGenerated()){
+                encoder.bindVertexBuffer(EngineModel::INSTANCE_BINDING, instanceBuffer, instanceOffset);
+                instance.model->draw(encoder, 1, i);
+                continue;
+            }
+            // generated models draw from their own indirect command, which starts at instance 0
+            encoder.bindVertexBuffer(EngineModel::INSTANCE_BINDING, instanceBuffer, instanceOffset + i * sizeof(EngineModel::Instance));
+            instance.model->draw(encoder);
+        }
+        this->shadowDrawCounts[cascade] = drawCount;
+        this->shadowBindStatistics[cascade] = encoder.getStatistics();
+    }
+
+    void App::reloadShaders(uint64_t frameNumber){
+        if(!this->shaderHotReloader) return;
+        std::vector<std::string> reloadedShaders = this->shaderHotReloader->takeReloadedShaders();
+        bool isPipelineAffected = std::any_of(reloadedShaders.begin(), reloadedShaders.end(), [this](const std::string &path){
+            return this->pipelineCache.usesShader(path);
+        });
+        if(!isPipelineAffected) return;
+
+        // the command buffers of in-flight frames still reference the current pipelines, so they are
+        // retired instead of waited on. This frame already records with the new ones, its number is
+        // one later than needed but never underflows. Pipelines failing to build keep their previous version.
+        bool isReloadSuccess = this->pipelineCache.reloadShaders(reloadedShaders, this->deletionQueue, frameNumber);
+        this->createPipeline();
+        if(isReloadSuccess) ENGINE_LOG_INFO("App: Reloaded pipelines");
     }
 
-    void App::drawFrame(){        
+    void App::drawFrame(const FramePacket &packet){
+        uint64_t allocationsBefore = threadAllocationCount();
+        auto acquireStart = std::chrono::steady_clock::now();
+#if ENGINE_DEBUG_DRAW
+        if(packet.frameNumber > 0){
+            double frameMs = std::chrono::duration<double, std::milli>(acquireStart - this->hudValues.lastFrameStart).count();
+            this->hudValues.frameMs += (frameMs - this->hudValues.frameMs) * HUD_SMOOTHING;
+        }
+        this->hudValues.lastFrameStart = acquireStart;
+#endif
         uint32_t imageIndex;
         auto result = this->engineSwapChain.acquireNextImage(&imageIndex);
 
         bool isSuccess = result == VK_SUCCESS;
         bool isSuboptimal = result == VK_SUBOPTIMAL_KHR;
         if(!isSuccess && isSuboptimal) throw std::runtime_error("Failed to acquire swap chain image!");
+        size_t frameIndex = this->engineSwapChain.currentFrameIndex();
+        // the fence just waited on belonged to the packet drawn MAX_FRAMES_IN_FLIGHT frames ago
+        size_t deletedCount = 0;
+        if(packet.frameNumber >= EngineSwapChain::MAX_FRAMES_IN_FLIGHT){
+            deletedCount = this->deletionQueue.collect(packet.frameNumber - EngineSwapChain::MAX_FRAMES_IN_FLIGHT + 1);
+        }
+        double gpuMs = this->collectTimestamps(frameIndex);
+        EngineOcclusionCuller::Statistics cullStatistics = {};
+        bool hasCullStatistics = this->occlusionCuller && this->occlusionCuller->collectStatistics(frameIndex, cullStatistics);
+        EngineParticleSystem::Statistics particleStatistics = {};
+        bool hasParticleStatistics = this->particleSystem && this->particleSystem->collectStatistics(frameIndex, particleStatistics);
+        double acquireMs = millisecondsSince(acquireStart);
+#if ENGINE_DEBUG_DRAW
+        if(gpuMs >= 0.0) this->hudValues.gpuMs += (gpuMs - this->hudValues.gpuMs) * HUD_SMOOTHING;
+#endif
+
+        // the acquire waited on this slot's fence, whatever the slot allocated last time is retired
+        this->frameArena.resetFrame(frameIndex);
+        this->reloadShaders(packet.frameNumber);
+        this->dynamicBuffer.beginFrame(static_cast<uint32_t>(frameIndex));
+
+        auto recordStart = std::chrono::steady_clock::now();
+        this->recordCommandBuffer(frameIndex, imageIndex, packet);
+        this->dynamicBuffer.flush();
+        double recordMs = millisecondsSince(recordStart);
+        TextureStreamingStatistics textureStatistics = this->textureStreamer.getStatistics();
 
         // Send command to the device graphics queue while handling CPU and GPU synchronisation
-        result = this->engineSwapChain.submitCommandBuffers(&this->commandBuffers[imageIndex], &imageIndex);
+        auto submitStart = std::chrono::steady_clock::now();
+        result = this->engineSwapChain.submitCommandBuffers(&this->commandBuffers[frameIndex], &imageIndex);
         bool isSubmitSuccess = result == VK_SUCCESS;
         if(!isSubmitSuccess) throw std::runtime_error("Failed to submit command buffer to device graphics queue");
+        if(this->timestampQueryPool != VK_NULL_HANDLE) this->hasTimestamps[frameIndex] = true;
+        double submitMs = millisecondsSince(submitStart);
+        uint64_t allocations = threadAllocationCount() - allocationsBefore;
+#if ENGINE_DEBUG_DRAW
+        this->hudValues.allocations = allocations;
+#endif
+
+        std::lock_guard<std::mutex> lock(this->renderTimingsMutex);
+        this->renderTimings.frameCount++;
+        this->renderTimings.allocationCount += allocations;
+        this->renderTimings.acquireMs += acquireMs;
+        this->renderTimings.recordMs += recordMs;
+        this->renderTimings.submitMs += submitMs;
+        this->renderTimings.deletedObjects += deletedCount;
+        this->renderTimings.textureStatistics = textureStatistics;
+        if(gpuMs >= 0.0){
+            this->renderTimings.gpuMs += gpuMs;
+            this->renderTimings.gpuFrameCount++;
+        }
+        if(hasCullStatistics){
+            this->renderTimings.cullFrameCount++;
+            this->renderTimings.frustumCulled += cullStatistics.frustumCulled;
+            this->renderTimings.occluded += cullStatistics.occluded;
+            this->renderTimings.firstPhaseDrawn += cullStatistics.firstPhaseDrawn;
+            this->renderTimings.secondPhaseDrawn += cullStatistics.secondPhaseDrawn;
+        }
+        if(hasParticleStatistics){
+            this->renderTimings.particleFrameCount++;
+            this->renderTimings.aliveParticles += particleStatistics.aliveCount;
+            this->renderTimings.particleUploadBytes += particleStatistics.uploadedBytes;
+        }
+    }
+
+    FramePacket App::buildFramePacket(){
+        // render between the two latest simulation ticks, so motion stays smooth whatever the present rate
+        SimulationState previous, current;
+        float alpha;
+        this->simulation->sample(previous, current, alpha);
+        float rotation = glm::mix(previous.rotation, current.rotation, alpha);
+
+        FramePacket packet = {};
+        packet.frameNumber = this->producedFrameCount++;
+        auto now = std::chrono::steady_clock::now();
+        if(packet.frameNumber > 0){
+            float deltaSeconds = std::chrono::duration<float>(now - this->lastPacketTime).count();
+            packet.deltaSeconds = std::min(deltaSeconds, MAX_PARTICLE_DELTA_SECONDS);
+        }
+        this->lastPacketTime = now;
+        packet.lightRotation = rotation * LIGHT_ROTATION_SPEED / ROTATION_SPEED;
+        packet.spriteRotation = -rotation;
+        glm::mat2 rotationTransform{{glm::cos(rotation), glm::sin(rotation)}, {-glm::sin(rotation), glm::cos(rotation)}};
+        // the imported model or its placeholder, a failed import falls back to the Sierpinski model
+        EngineModel *sceneModel = this->engineModel.get();
+        if(this->isImportedModelShown()) sceneModel = this->assetManager->getModel(this->importedModel);
+
+        if(!this->occluderModel){
+            FrameInstance &instance = packet.instances[packet.instanceCount++];
+            instance.model = sceneModel;
+            instance.transform = rotationTransform;
+            instance.materialIndex = this->sceneMaterialIndex;
+            return packet;
+        }
+
+        FrameInstance &occluder = packet.instances[packet.instanceCount++];
+        occluder.model = this->occluderModel.get();
+        occluder.transform = glm::mat2{OCCLUDER_SCALE};
+        occluder.depth = OCCLUDER_DEPTH;
+        occluder.materialIndex = this->sceneMaterialIndex;
+
+        // nearer copies first, so they are behind the occluder but in front of each other
+        uint32_t copyCount = std::min(this->settings.occlusionTestInstanceCount, FramePacket::MAX_INSTANCES - 1);
+        uint32_t side = static_cast<uint32_t>(glm::ceil(glm::sqrt(static_cast<float>(copyCount))));
+        float cellSize = OCCLUSION_TEST_EXTENT / side;
+        for(uint32_t i = 0; i < copyCount; i++){
+            FrameInstance &instance = packet.instances[packet.instanceCount++];
+            instance.model = sceneModel;
+            instance.transform = rotationTransform * cellSize;
+            instance.translation = glm::vec2{(i % side) + 0.5f, (i / side) + 0.5f} * cellSize - OCCLUSION_TEST_EXTENT * 0.5f;
+            instance.depth = glm::mix(OCCLUDEE_NEAREST_DEPTH, OCCLUDEE_FARTHEST_DEPTH, static_cast<float>(i) / copyCount);
+            instance.materialIndex = this->sceneMaterialIndex;
+        }
+        return packet;
+    }
+
+    void App::renderLoop(){
+        try {
+            FramePacket packet;
+            while(this->isRenderThreadRunning){
+                auto waitStart = std::chrono::steady_clock::now();
+                // sleeps once the queue stays empty, woken by the next packet or by shutdown
+                bool isPopped = this->frameQueue.waitPop(packet);
+                if(!this->isRenderThreadRunning) break;
+                if(!isPopped) continue;
+                double waitMs = millisecondsSince(waitStart);
+                {
+                    std::lock_guard<std::mutex> lock(this->renderTimingsMutex);
+                    this->renderTimings.waitMs += waitMs;
+                }
+                this->drawFrame(packet);
+            }
+        } catch(...){
+            this->renderThreadError = std::current_exception();
+            this->isRenderThreadRunning = false;
+        }
+    }
+
+    void App::reportTimings(){
+        RenderTimings renderTimings;
+        {
+            std::lock_guard<std::mutex> lock(this->renderTimingsMutex);
+            renderTimings = this->renderTimings;
+            this->renderTimings = {};
+        }
+        GameTimings gameTimings = this->gameTimings;
+        this->gameTimings = {};
+        SimulationTimings simulationTimings = this->simulation->takeTimings();
+        double packets = std::max(gameTimings.packetCount, 1u);
+        double frames = std::max(renderTimings.frameCount, 1u);
+        double gpuMs = renderTimings.gpuFrameCount > 0 ? renderTimings.gpuMs / renderTimings.gpuFrameCount : 0.0;
+
+        // built whole and written at once, so log lines of other threads cannot land inside it
+        std::ostringstream report;
+        report << "App: game " << gameTimings.packetCount << " packets"
+            << ", events " << gameTimings.eventsMs / packets << " ms"
+            << ", packet " << gameTimings.packetMs / packets << " ms"
+            << ", " << gameTimings.allocationCount / packets << " allocs"
+            << " | render " << renderTimings.frameCount << " frames"
+            << ", wait " << renderTimings.waitMs / frames << " ms"
+            << ", acquire " << renderTimings.acquireMs / frames << " ms"
+            << ", record " << renderTimings.recordMs / frames << " ms"
+            << ", submit " << renderTimings.submitMs / frames << " ms"
+            << ", gpu " << gpuMs << " ms"
+            << ", " << renderTimings.allocationCount / frames << " allocs"
+            << " | binds " << renderTimings.issuedBinds / frames << " issued"
+            << ", " << renderTimings.eliminatedBinds / frames << " eliminated";
+        if(renderTimings.cullFrameCount > 0){
+            double cullFrames = renderTimings.cullFrameCount;
+            report << " | cull " << renderTimings.firstPhaseDrawn / cullFrames << " + " << renderTimings.secondPhaseDrawn / cullFrames << " drawn"
+                << ", " << renderTimings.occluded / cullFrames << " occluded"
+                << ", " << renderTimings.frustumCulled / cullFrames << " outside the frustum";
+        }
+        if(this->shadowMap) report << " | shadows " << renderTimings.shadowDraws / frames << " draws";
+        if(renderTimings.particleFrameCount > 0){
+            double particleFrames = renderTimings.particleFrameCount;
+            report << " | particles " << renderTimings.aliveParticles / particleFrames << " alive"
+                << ", " << renderTimings.particleUploadBytes / particleFrames << " bytes uploaded";
+        }
+        if(this->spriteBatch) report << " | sprites " << renderTimings.spriteDraws / frames << " draws";
+        const TextureStreamingStatistics &textureStatistics = renderTimings.textureStatistics;
+        if(textureStatistics.textureCount > 0){
+            constexpr double MEGABYTE = 1024.0 * 1024.0;
+            report << " | textures " << textureStatistics.fullyResidentCount << "/" << textureStatistics.textureCount << " fully resident"
+                << ", " << textureStatistics.residentBytes / MEGABYTE << "/" << textureStatistics.budgetBytes / MEGABYTE << " MB"
+                << ", " << textureStatistics.uploadBandwidth / MEGABYTE << " MB/s uploaded"
+                << ", " << textureStatistics.evictedLevels << " levels evicted";
+        }
+        if(renderTimings.deletedObjects > 0) report << " | deleted " << renderTimings.deletedObjects << " objects";
+        report
+            << " | simulation " << simulationTimings.tickCount << " ticks"
+            << ", " << simulationTimings.averageTickMs << " ms avg"
+            << ", " << simulationTimings.maxTickMs << " ms max"
+            << ", " << simulationTimings.droppedTicks << " dropped";
+        std::cout << report.str() << std::endl;
     }
 
     void App::loadModels(){
-        std::vector<EngineModel::Vertex> vertices{};
-        this->sierpinski(vertices, 1, 
-            {{-0.5f, 0.5f}, {0.0f, 0.0f,1.0f}}, 
-            {{0.0f, -0.5f}, {1.0f, 0.0f,0.0f}},
-            {{0.5f, 0.5f}, {0.0f, 1.0f,0.0f}}
-        );
-        this->engineModel = std::make_unique<EngineModel>(
-            this->engineDevice,
-            vertices
-        );
+        this->sierpinskiDepth = std::min(this->settings.sierpinskiDepth, MAX_SIERPINSKI_DEPTH);
+        this->requestedSierpinskiDepth = this->sierpinskiDepth;
+        this->engineModel = this->createSierpinskiModel(this->sierpinskiDepth, true);
+
+        if(this->settings.occlusionTestInstanceCount > 0){
+            glm::vec3 grey{0.5f, 0.5f, 0.5f};
+            std::vector<EngineModel::Vertex> vertices = {
+                {{-1.0f, -1.0f}, grey}, {{1.0f, -1.0f}, grey}, {{1.0f, 1.0f}, grey},
+                {{-1.0f, -1.0f}, grey}, {{1.0f, 1.0f}, grey}, {{-1.0f, 1.0f}, grey},
+            };
+            this->occluderModel = std::make_unique<EngineModel>(this->engineDevice, vertices);
+        }
     }
 
-    
-    void App::sierpinski(
-        std::vector<EngineModel::Vertex> &vertices, 
-        uint32_t depth, 
-        std::pair<glm::vec2, glm::vec3> left,
-        std::pair<glm::vec2, glm::vec3>  top, 
-        std::pair<glm::vec2, glm::vec3>  right
-    ){
-        if(depth <= 0 ){
-            vertices.push_back({top.first, top.second});
-            vertices.push_back({right.first, right.second});
-            vertices.push_back({left.first, left.second});
-            return;
-        }
-        glm::vec2 leftTopMidVector = (left.first + top.first) / 2.0f;
-        glm::vec2 topRightMidVector = (top.first + right.first) / 2.0f;
-        glm::vec2 rightLeftMidVector = (right.first + left.first) /2.0f;
-
-        // bottom left triangle
-        this->sierpinski(vertices, depth-1, left, {leftTopMidVector, top.second}, {rightLeftMidVector, right.second});
-
-        // top triangle
-        this->sierpinski(vertices, depth-1, {leftTopMidVector, left.second}, top, {topRightMidVector, right.second});
-
-        // bottom right triangle
-        this->sierpinski(vertices, depth-1, {rightLeftMidVector, left.second}, {topRightMidVector, top.second}, right);
-    }
-}
+    std::unique_ptr<EngineModel> App::createSierpinskiModel(uint32_t depth, bool isImmediate){
+        size_t vertexCount = EngineMeshGenerator::sierpinskiVertexCount(depth);
+        auto generateStart = std::chrono::steady_clock::now();
+        if(this->meshGenerator){
+            auto model = std::make_unique<EngineModel>(this->engineDevice, static_cast<uint32_t>(vertexCount), SIERPINSKI_BOUNDS);
+            SierpinskiParameters parameters = buildSierpinskiParameters(depth);
+            uint32_t triangleCount = parameters.triangleCount;
+            if(isImmediate) this->meshGenerator->generateNow(*model, &parameters, triangleCount);
+            // the model may only be drawn once the dispatch has completed
+            else this->meshGenerator->request(*model, &parameters, triangleCount).get();
+            ENGINE_LOG_INFO("App: Sierpinski depth %u, %zu vertices, generated on the GPU in %.3f ms", depth, vertexCount, millisecondsSince(generateStart));
+            return model;
+        }
+
+        std::vector<EngineModel::Vertex> vertices = EngineMeshGenerator::sierpinski(depth, SIERPINSKI_LEFT, SIERPINSKI_TOP, SIERPINSKI_RIGHT, this->meshWorkerPool);
+        double generateMs = millisecondsSince(generateStart);
+
+        auto uploadStart = std::chrono::steady_clock::now();
+        auto model = std::make_unique<EngineModel>(this->engineDevice, vertices);
+        ENGINE_LOG_INFO("App: Sierpinski depth %u, %zu vertices, generated in %.3f ms, uploaded in %.3f ms", depth, vertexCount, generateMs, millisecondsSince(uploadStart));
+        return model;
+    }
+
+    void App::handleInput(){
+        bool isIncreasePressed = this->engineWindow.isKeyPressed(GLFW_KEY_EQUAL);
+        bool isDecreasePressed = this->engineWindow.isKeyPressed(GLFW_KEY_MINUS);
+        bool isDepthKeyPressed = isIncreasePressed || isDecreasePressed;
+        // one step per key press, not per frame the key is held
+        if(isDepthKeyPressed && !this->wasDepthKeyPressed){
+            if(isIncreasePressed && this->requestedSierpinskiDepth < MAX_SIERPINSKI_DEPTH) this->requestedSierpinskiDepth++;
+            if(isDecreasePressed && this->requestedSierpinskiDepth > 0) this->requestedSierpinskiDepth--;
+        }
+        this->wasDepthKeyPressed = isDepthKeyPressed;
+    }
+
+    bool App::isImportedModelShown(){
+        return this->importedModel.isValid() && this->assetManager->getState(this->importedModel) != AssetState::Failed;
+    }
+
+    void App::updateModel(){
+        if(this->assetManager) this->assetManager->update(this->producedFrameCount);
+
+        bool isPendingModelReady = this->pendingModel.valid()
+            && this->pendingModel.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        if(isPendingModelReady){
+            // the swap is just a pointer, generation and upload already happened on the builder thread
+            std::unique_ptr<EngineModel> model = this->pendingModel.get();
+            // the imported model wins, the build was never drawn and goes right away
+            if(!this->isImportedModelShown()){
+                // packets already built may still draw it
+                if(this->producedFrameCount > 0) this->deletionQueue.retire(this->producedFrameCount - 1, std::move(this->engineModel));
+                this->engineModel = std::move(model);
+                this->sierpinskiDepth = this->pendingSierpinskiDepth;
+            }
+        }
+
+        // depth changes made while building are picked up once the current build lands
+        bool isRebuildNeeded = !this->pendingModel.valid() && !this->isImportedModelShown() && this->requestedSierpinskiDepth != this->sierpinskiDepth;
+        if(isRebuildNeeded){
+            uint32_t depth = this->requestedSierpinskiDepth;
+            this->pendingSierpinskiDepth = depth;
+            this->pendingModel = std::async(std::launch::async, [this, depth](){
+                return this->createSierpinskiModel(depth, false);
+            });
+        }
+    }
+}
\ No newline at end of file
@@ -1,53 +1,423 @@
 #pragma once
 #include "engine_window.hpp"
 #include "engine_pipeline.hpp"
+#include "engine_pipeline_cache.hpp"
 #include "engine_device.hpp"
 #include "engine_swap_chain.hpp"
 #include "engine_model.hpp"
+#include "engine_bindless_table.hpp"
+#include "engine_texture_streamer.hpp"
+#include "engine_shader_hot_reloader.hpp"
+#include "engine_fixed_step_simulation.hpp"
+#include "engine_spsc_ring.hpp"
+#include "engine_frame_arena.hpp"
+#include "engine_dynamic_buffer.hpp"
+#include "engine_deletion_queue.hpp"
+#include "engine_command_encoder.hpp"
+#include "engine_draw_sorter.hpp"
+#include "engine_mesh_generator.hpp"
+#include "engine_compute_mesh_generator.hpp"
+#include "engine_occlusion_culler.hpp"
+#include "engine_light_clusterer.hpp"
+#include "engine_shadow_map.hpp"
+#include "engine_particle_system.hpp"
+#include "engine_sprite_batch.hpp"
+#include "engine_debug_draw.hpp"
+#include "engine_worker_pool.hpp"
+#include "engine_asset_importer.hpp"
+#include "engine_asset_manager.hpp"
+#include "engine_archive.hpp"
+#include "engine_gpu_decompressor.hpp"
 
 // std
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <future>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <vector>
 
 namespace engine {
+    struct AppSettings {
+        // clamped to the highest count the device supports for colour and depth
+        VkSampleCountFlagBits sampleCount = VK_SAMPLE_COUNT_1_BIT;
+        // shade per sample instead of per pixel, ignored without MSAA or the sampleRateShading feature
+        bool isSampleShadingEnabled = false;
+        float minSampleShading = 1.0f;
+        // changed at runtime with + and -, up to MAX_SIERPINSKI_DEPTH
+        uint32_t sierpinskiDepth = 1;
+        // write the mesh with a compute shader into device local memory instead of generating it on the CPU
+        bool isGpuMeshGenerationEnabled = false;
+        // recompile edited shaders in the background and rebuild the pipelines using them
+        bool isShaderHotReloadEnabled = true;
+        double simulationTickSeconds = 1.0 / 60.0;
+        // artificial work per tick, to watch the catch-up clamp under load
+        double simulationLoadMs = 0.0;
+        // print per-phase timings once a second
+        bool isTimingReportEnabled = false;
+        // Khronos validation layers, on by default only in debug builds
+        bool isValidationEnabled = EngineDevice::DEFAULT_VALIDATION_ENABLED;
+        // two-phase Hi-Z culling on the GPU, every instance is drawn indirectly
+        bool isOcclusionCullingEnabled = false;
+        // write depth for every instance first so the shading pass only runs for visible fragments
+        bool isDepthPrePassEnabled = false;
+        // draw this many Sierpinski copies behind an occluder instead of the single one, 0 for the normal scene
+        uint32_t occlusionTestInstanceCount = 0;
+        // point lights binned by the clustered forward path, 0 leaves the scene unlit
+        uint32_t lightCount = 0;
+        // cascaded shadows from one directional light
+        bool isShadowEnabled = false;
+        // threads helping the render thread record, 0 records every shadow cascade on the render thread
+        uint32_t workerThreadCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+        // particles the emitters keep alive once they have filled up, 0 disables the particle system
+        uint32_t particleCount = 0;
+        // spinning quads drawn over the scene through the sprite batch, 0 for none
+        uint32_t spriteCount = 0;
+        // frame time, draw counts, memory and instance bounds over the frame, ignored in builds
+        // without ENGINE_DEBUG_DRAW
+        bool isHudEnabled = false;
+        // glTF or OBJ file drawn instead of the Sierpinski model, loaded in the background by the
+        // asset manager while its placeholder is drawn, empty for none
+        std::string modelPath;
+        // KTX2 or DDS file every instance is textured with, its mips streamed in as the instances
+        // grow on screen. Empty for none.
+        std::string texturePath;
+        // packed archive the shaders are read from instead of the loose files, see
+        // tools/archive_builder.cpp. Turns shader hot reload off, edits to the loose files would
+        // never be seen. Empty for none.
+        std::string archivePath;
+    };
+
+    struct SimulationState {
+        float rotation = 0.0f;
+    };
+
+    struct FrameInstance {
+        EngineModel *model;
+        glm::mat2 transform{1.0f};
+        glm::vec2 translation{0.0f};
+        // lower is nearer
+        float depth = 0.0f;
+        uint32_t materialIndex;
+    };
+
+    // Everything the render thread needs to draw one frame, built by the game thread and copied
+    // through the frame queue, so the render thread never reads game state directly
+    struct FramePacket {
+        static constexpr uint32_t MAX_INSTANCES = 256;
+
+        uint64_t frameNumber = 0;
+        // 2D view transform applied to every instance
+        glm::mat2 camera{1.0f};
+        // the lights orbit the origin by this many radians
+        float lightRotation = 0.0f;
+        // since the previous packet, what the particles advance by
+        float deltaSeconds = 0.0f;
+        // radians, the sprites spin by it
+        float spriteRotation = 0.0f;
+        uint32_t instanceCount = 0;
+        std::array<FrameInstance, MAX_INSTANCES> instances;
+
+        FramePacket() = default;
+        FramePacket(const FramePacket &) = default;
+        // Only the instances in use are copied, packets go through the frame queue every frame and
+        // rarely fill the array. Every other member has to be listed here.
+        FramePacket &operator = (const FramePacket &other){
+            this->frameNumber = other.frameNumber;
+            this->camera = other.camera;
+            this->lightRotation = other.lightRotation;
+            this->deltaSeconds = other.deltaSeconds;
+            this->spriteRotation = other.spriteRotation;
+            this->instanceCount = other.instanceCount;
+            std::copy_n(other.instances.begin(), other.instanceCount, this->instances.begin());
+            return *this;
+        }
+    };
+
+    struct MeshGenerationStatistics {
+        uint32_t depth = 0;
+        size_t vertexCount = 0;
+        double cpuGenerateMs = 0.0;
+        // copying the generated vertices into host visible memory
+        double cpuUploadMs = 0.0;
+        uint64_t cpuUploadBytes = 0;
+        // dispatch time from timestamps, zero when the queue does not support them
+        double gpuGenerateMs = 0.0;
+        // recording, submitting and waiting for the dispatch
+        double gpuSubmitMs = 0.0;
+        // only the parameters cross the bus, the vertices are written in device local memory
+        uint64_t gpuUploadBytes = 0;
+        uint64_t gpuWrittenBytes = 0;
+    };
+
+    struct DecompressionStatistics {
+        uint32_t chunkSize = 0;
+        // decoding on the archive's workers, then every vertex staged into device local memory
+        double cpuDecodeMs = 0.0;
+        double cpuUploadMs = 0.0;
+        // only the compressed chunks are uploaded, the vertices are decoded in device local memory
+        GpuDecompressionStatistics gpu;
+        double gpuTotalMs = 0.0;
+        // the vertices read back from the GPU path equal the ones decoded on the CPU
+        bool isMatching = false;
+    };
+
+    struct FrameStatistics {
+        uint32_t frameCount = 0;
+        double averageCpuFrameMs = 0.0;
+        // zero when the graphics queue does not support timestamps
+        double averageGpuFrameMs = 0.0;
+        // operator new calls on the rendering thread, zero once every container has reached its size
+        double averageAllocationsPerFrame = 0.0;
+        // instances per frame, zero without occlusion culling
+        double averageFrustumCulled = 0.0;
+        double averageOccluded = 0.0;
+        double averageFirstPhaseDrawn = 0.0;
+        double averageSecondPhaseDrawn = 0.0;
+        // command buffer recording on the render thread
+        double averageRecordMs = 0.0;
+        // instance draws summed over every cascade, zero without shadows
+        double averageShadowDraws = 0.0;
+        // state binds of the instance draws, recorded and dropped as redundant by the command encoder
+        double averageIssuedBinds = 0.0;
+        double averageEliminatedBinds = 0.0;
+        // zero without particles
+        double averageAliveParticles = 0.0;
+        double averageParticleUploadBytes = 0.0;
+        // zero without sprites
+        double averageSpriteDraws = 0.0;
+    };
 
     class App {
         public:
             static constexpr int WIDTH = 800;
             static constexpr int HEIGHT = 600;
+            static constexpr const char *SHADER_DIRECTORY = "shaders";
+            static constexpr const char *VERTEX_SHADER_PATH = "shaders/simple_shader.vert.spv";
+            static constexpr const char *FRAGMENT_SHADER_PATH = "shaders/simple_shader.frag.spv";
+            static constexpr const char *SIERPINSKI_COMPUTE_SHADER_PATH = "shaders/sierpinski.comp.spv";
+            // per frame in flight, for instance data and other per-frame uploads
+            static constexpr VkDeviceSize DYNAMIC_BUFFER_FRAME_SIZE = 1024 * 1024;
+            // 3^12 triangles, about 32 MiB of vertices
+            static constexpr uint32_t MAX_SIERPINSKI_DEPTH = 12;
+            // packets the game thread may run ahead of the render thread
+            static constexpr size_t FRAME_QUEUE_SIZE = 2;
             
-            App();
+            App(const AppSettings &settings = AppSettings{});
             ~App();
             
             App(const App &) = delete;
             App &operator=(const App &)=delete;
 
+            // Polls window events and produces frame packets on the calling thread while a render thread draws them
             void run();
+            // Renders a fixed number of frames as fast as possible on the calling thread and reports the average frame times
+            FrameStatistics benchmark(uint32_t frameCount);
+            // Builds the mesh once on the CPU and once with the compute shader, nothing may be rendering
+            MeshGenerationStatistics benchmarkMeshGeneration(uint32_t depth);
+            // Imports the file once to warm the file cache, then once more to measure, nothing may be rendering
+            ImportStatistics benchmarkImport(const std::string &filePath);
+            // Packs the vertices of a glTF or OBJ file into a temporary archive, then loads them into
+            // a model once decoded on the CPU and once on the GPU
+            DecompressionStatistics benchmarkDecompression(const std::string &filePath, uint32_t chunkSize);
 
+            VkSampleCountFlagBits sampleCount(){
+                return this->engineSwapChain.getSampleCount();
+            }
+            bool isSampleShadingEnabled();
 
         private:
+            AppSettings settings;
             EngineWindow engineWindow{WIDTH, HEIGHT, "Application Vulkan!"};
-            EngineDevice engineDevice{engineWindow};
-            EngineSwapChain engineSwapChain{engineDevice, this->engineWindow.getExtent()};
+            EngineDevice engineDevice{engineWindow, this->settings.isValidationEnabled};
+            EngineSwapChain engineSwapChain{engineDevice, this->engineWindow.getExtent(), this->settings.sampleCount, this->settings.isOcclusionCullingEnabled};
+            EngineBindlessTable bindlessTable{engineDevice};
+            // replaced models, pipelines and textures, freed by the render thread once the last frame
+            // packet referencing them has completed, declared early so it outlives everything queueing to it
+            EngineDeletionQueue deletionQueue;
+            EngineTextureStreamer textureStreamer{engineDevice, bindlessTable, deletionQueue};
+            // settings.texturePath, drawn through the textured material
+            EngineTextureStreamer::TextureHandle sceneTexture = EngineTextureStreamer::INVALID_HANDLE;
 
-            std::unique_ptr<EnginePipeline> enginePipeline;
+            // mounted for EnginePipeline::readFile until the App is destroyed, null for loose files
+            std::unique_ptr<EngineArchive> shaderArchive;
+            EnginePipelineCache pipelineCache{engineDevice};
+            // owned by the cache, refreshed by createPipeline whenever the permutation is rebuilt
+            EnginePipeline *enginePipeline = nullptr;
+            // depth only permutation drawn before enginePipeline, null without a depth pre-pass
+            EnginePipeline *depthPrePassPipeline = nullptr;
             VkPipelineLayout pipelineLayout;
             std::vector<VkCommandBuffer> commandBuffers;
+            // transient CPU memory of the render thread, reset when a frame slot's fence has been waited on
+            EngineFrameArena frameArena{EngineSwapChain::MAX_FRAMES_IN_FLIGHT};
+            EngineDynamicBuffer dynamicBuffer{
+                engineDevice,
+                DYNAMIC_BUFFER_FRAME_SIZE,
+                VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                EngineSwapChain::MAX_FRAMES_IN_FLIGHT
+            };
 
             std::unique_ptr<EngineModel> engineModel;
+            // grey quad in front of the occlusion test scene
+            std::unique_ptr<EngineModel> occluderModel;
+            uint32_t sierpinskiDepth;
+            // the Sierpinski builds, which run on the builder thread while the render thread records
+            // its shadow cascades on workerPool, and a pool runs one job at a time. Declared before
+            // pendingModel, whose destruction waits for a build still using it.
+            EngineWorkerPool meshWorkerPool;
+            // generated and uploaded in the background, swapped in by the game thread once ready
+            std::future<std::unique_ptr<EngineModel>> pendingModel;
+            uint32_t pendingSierpinskiDepth = 0;
+            uint32_t requestedSierpinskiDepth;
+            bool wasDepthKeyPressed = false;
+            std::unique_ptr<EngineAssetManager> assetManager;
+            // settings.modelPath, the Sierpinski depth keys do nothing while it is drawn
+            ModelHandle importedModel;
+
+            // declared after pendingModel so it is destroyed first, which fails a build still waiting on it
+            std::unique_ptr<EngineComputeMeshGenerator> meshGenerator;
+            std::unique_ptr<EngineOcclusionCuller> occlusionCuller;
+            std::unique_ptr<EngineLightClusterer> lightClusterer;
+            EngineWorkerPool workerPool{this->settings.workerThreadCount};
+            std::unique_ptr<EngineShadowMap> shadowMap;
+            // written by the worker recording each cascade, summed once every cascade has finished
+            std::array<uint32_t, EngineShadowMap::CASCADE_COUNT> shadowDrawCounts;
+            std::array<CommandEncoderStatistics, EngineShadowMap::CASCADE_COUNT> shadowBindStatistics;
+            std::unique_ptr<EngineParticleSystem> particleSystem;
+            std::vector<EngineParticleSystem::Emitter> emitters;
+            std::unique_ptr<EngineSpriteBatch> spriteBatch;
+#if ENGINE_DEBUG_DRAW
+            std::unique_ptr<EngineDebugDraw> debugDraw;
+            // render thread only, measured by drawFrame for the HUD of the next frame
+            struct HudValues {
+                std::chrono::steady_clock::time_point lastFrameStart;
+                // smoothed so the numbers stay readable
+                double frameMs = 0.0;
+                double gpuMs = 0.0;
+                uint64_t allocations = 0;
+            };
+            HudValues hudValues;
+#endif
+            // render thread only, reset by every recordCommandBuffer
+            uint32_t recordedDrawCount = 0;
+            // render thread only, tracks the frame's command buffer while it is recorded
+            EngineCommandEncoder commandEncoder;
+            // the instance draws of every pass, sorted once per frame by sortDraws
+            EngineDrawSorter drawSorter{FramePacket::MAX_INSTANCES * 2};
+            // before the orbit and the camera, built once and only read afterwards
+            std::vector<EngineLightClusterer::Light> lights;
+            std::unique_ptr<EngineShaderHotReloader> shaderHotReloader;
+            std::unique_ptr<EngineFixedStepSimulation<SimulationState>> simulation;
+
+            // the game thread produces, the render thread consumes
+            EngineSpscRing<FramePacket, FRAME_QUEUE_SIZE> frameQueue;
+            uint64_t producedFrameCount = 0;
+            std::chrono::steady_clock::time_point lastPacketTime;
+            std::thread renderThread;
+            std::atomic<bool> isRenderThreadRunning{false};
+            // rethrown on the game thread once the render thread has stopped
+            std::exception_ptr renderThreadError;
 
+            // game thread phases, accumulated between timing reports
+            struct GameTimings {
+                uint32_t packetCount = 0;
+                uint64_t allocationCount = 0;
+                double eventsMs = 0.0;
+                double packetMs = 0.0;
+            };
+            GameTimings gameTimings;
+
+            // render thread phases, read by the game thread for reports and by benchmark
+            struct RenderTimings {
+                uint32_t frameCount = 0;
+                uint64_t allocationCount = 0;
+                double waitMs = 0.0;
+                double acquireMs = 0.0;
+                double recordMs = 0.0;
+                double submitMs = 0.0;
+                double gpuMs = 0.0;
+                uint32_t gpuFrameCount = 0;
+                // summed EngineOcclusionCuller::Statistics
+                uint32_t cullFrameCount = 0;
+                uint64_t frustumCulled = 0;
+                uint64_t occluded = 0;
+                uint64_t firstPhaseDrawn = 0;
+                uint64_t secondPhaseDrawn = 0;
+                uint64_t shadowDraws = 0;
+                // summed EngineParticleSystem::Statistics
+                uint32_t particleFrameCount = 0;
+                uint64_t aliveParticles = 0;
+                uint64_t particleUploadBytes = 0;
+                uint64_t spriteDraws = 0;
+                // run by the deletion queue
+                uint64_t deletedObjects = 0;
+                // summed CommandEncoderStatistics of the frame and its shadow cascades
+                uint64_t issuedBinds = 0;
+                uint64_t eliminatedBinds = 0;
+                // as of the last frame, the streamer is only read on the render thread
+                TextureStreamingStatistics textureStatistics;
+            };
+            std::mutex renderTimingsMutex;
+            RenderTimings renderTimings;
+
+            // materials live in the bindless storage buffer array and are selected per instance
+            VkBuffer materialBuffer;
+            VkDeviceMemory materialBufferMemory;
+            uint8_t *mappedMaterials = nullptr;
+            VkDeviceSize materialStride = 0;
+            uint32_t materialIndex = EngineBindlessTable::INVALID_INDEX;
+            // with a scene texture, one copy per frame in flight, since the texture's bindless slot
+            // changes whenever the streamer rebuilds it. Packets name it by the first copy.
+            std::array<uint32_t, EngineSwapChain::MAX_FRAMES_IN_FLIGHT> texturedMaterialIndices;
+            // what the packets draw every instance with, read by the game thread
+            uint32_t sceneMaterialIndex = EngineBindlessTable::INVALID_INDEX;
+
+            // two timestamps per frame in flight, bracketing its command buffer
+            VkQueryPool timestampQueryPool = VK_NULL_HANDLE;
+            std::vector<bool> hasTimestamps;
+
+            void createMaterials();
+            void createLights();
+            void createEmitters();
+            void createTimestampQueryPool();
+            // returns the GPU time of the previous submission of this frame slot, negative when unavailable
+            double collectTimestamps(size_t frameIndex);
             void createPipelineLayout();
             void createPipeline();
             void createCommandBuffers();
-            void drawFrame();
+            void recordCommandBuffer(size_t frameIndex, uint32_t imageIndex, const FramePacket &packet);
+            // Reports how large the textured instances are on screen, records the streamer's uploads
+            // and points the frame's textured material at the texture's current slot
+            void updateSceneTexture(VkCommandBuffer commandBuffer, size_t frameIndex, const FramePacket &packet);
+            // Orders the instance draws of every pass by pipeline, material, mesh and depth
+            void sortDraws(const FramePacket &packet);
+            // Every instance of the packet inside a render pass in sortDraws' order, through the culler's indirect draws when culling
+            void recordDraws(EngineCommandEncoder &encoder, size_t frameIndex, const FramePacket &packet, VkDeviceSize instanceOffset);
+            // The sprites of the packet through the sprite batch, inside the last render pass of the frame
+            void recordSprites(VkCommandBuffer commandBuffer, size_t frameIndex, const FramePacket &packet);
+#if ENGINE_DEBUG_DRAW
+            // The HUD and the instance bounds through the debug draw layer, last in the frame
+            void recordDebugOverlay(VkCommandBuffer commandBuffer, size_t frameIndex, const FramePacket &packet);
+#endif
+            // The instances of the packet inside one shadow cascade, called from worker threads
+            void recordShadowCasters(VkCommandBuffer commandBuffer, size_t frameIndex, uint32_t cascade, const FramePacket &packet, VkDeviceSize instanceOffset);
+            void reloadShaders(uint64_t frameNumber);
+            void reportTimings();
+            FramePacket buildFramePacket();
+            void renderLoop();
+            void drawFrame(const FramePacket &packet);
             void loadModels();
-
-            void sierpinski(
-                std::vector<EngineModel::Vertex> &vertices, 
-                uint32_t depth, 
-                std::pair<glm::vec2, glm::vec3> left,
-                std::pair<glm::vec2, glm::vec3>  top, 
-                std::pair<glm::vec2, glm::vec3>  right);
+            // On the GPU path a render thread must be running to record the dispatch, unless isImmediate
+            std::unique_ptr<EngineModel> createSierpinskiModel(uint32_t depth, bool isImmediate);
+            void handleInput();
+            void updateModel();
+            // Loading or loaded, the placeholder counts as the imported model
+            bool isImportedModelShown();
 
     };
 }
@@ -0,0 +1,68 @@
+#include "engine_allocation_counter.hpp"
+
+// std
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace engine {
+    static std::atomic<uint64_t> totalAllocations{0};
+    static thread_local uint64_t threadAllocations = 0;
+
+    static void countAllocation(){
+        threadAllocations++;
+        totalAllocations.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint64_t threadAllocationCount(){
+        return threadAllocations;
+    }
+
+    uint64_t totalAllocationCount(){
+        return totalAllocations.load(std::memory_order_relaxed);
+    }
+}
+
+// the array and nothrow forms of the standard library forward to these two
+void *operator new(std::size_t size){
+    engine::countAllocation();
+    if(size == 0) size = 1;
+    while(true){
+        void *pointer = std::malloc(size);
+        if(pointer) return pointer;
+        std::new_handler handler = std::get_new_handler();
+        if(!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment){
+    engine::countAllocation();
+    std::size_t alignmentBytes = static_cast<std::size_t>(alignment);
+    // aligned_alloc wants a size that is a multiple of the alignment
+    size = (size + alignmentBytes - 1) & ~(alignmentBytes - 1);
+    if(size == 0) size = alignmentBytes;
+    while(true){
+        void *pointer = std::aligned_alloc(alignmentBytes, size);
+        if(pointer) return pointer;
+        std::new_handler handler = std::get_new_handler();
+        if(!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+void operator delete(void *pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t, std::align_val_t) noexcept {
+    std::free(pointer);
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+// std
+#include <cstdint>
+
+namespace engine {
+    // Counts of global operator new calls, the replacements live in engine_allocation_counter.cpp.
+    // Compare two reads around a piece of code to see how often it hits the heap, steady state
+    // frames are expected to report zero. Allocations made through malloc by C libraries are not seen.
+    uint64_t threadAllocationCount();
+    uint64_t totalAllocationCount();
+}
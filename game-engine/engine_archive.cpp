@@ -0,0 +1,211 @@
+#include "engine_archive.hpp"
+#include "engine_log.hpp"
+#include "engine_hash.hpp"
+#include "engine_lz4.hpp"
+
+// std
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+// posix
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace engine {
+    static constexpr uint64_t TABLE_ALIGNMENT = 8;
+
+    static bool isEntryBefore(const ArchiveEntry &entry, uint64_t pathHash){
+        return entry.pathHash < pathHash;
+    }
+
+    // Publics
+    EngineArchive::EngineArchive(const std::string &filePath, uint32_t threadCount): workerPool{threadCount}{
+        int file = open(filePath.c_str(), O_RDONLY);
+        if(file < 0) throw std::runtime_error("Failed to open archive: " + filePath);
+        struct stat status;
+        bool isStatSuccess = fstat(file, &status) == 0;
+        if(!isStatSuccess || static_cast<size_t>(status.st_size) < sizeof(ArchiveHeader)){
+            close(file);
+            throw std::runtime_error("Failed to read archive: " + filePath);
+        }
+        this->mappingSize = static_cast<size_t>(status.st_size);
+        void *mapping = mmap(nullptr, this->mappingSize, PROT_READ, MAP_PRIVATE, file, 0);
+        // the mapping keeps the file alive on its own
+        close(file);
+        if(mapping == MAP_FAILED) throw std::runtime_error("Failed to map archive: " + filePath);
+        this->bytes = static_cast<const char *>(mapping);
+
+        // everything below is read in place, so check it all once here rather than on every read
+        this->header = reinterpret_cast<const ArchiveHeader *>(this->bytes);
+        uint64_t entryBytes = uint64_t{this->header->entryCount} * sizeof(ArchiveEntry);
+        uint64_t chunkBytes = uint64_t{this->header->chunkCount} * sizeof(ArchiveChunk);
+        bool isHeaderValid = this->header->magic == MAGIC && this->header->version == VERSION
+            && this->header->tableOffset % TABLE_ALIGNMENT == 0
+            && this->header->tableOffset <= this->mappingSize
+            && entryBytes + chunkBytes + this->header->pathBytes <= this->mappingSize - this->header->tableOffset;
+        if(!isHeaderValid){
+            munmap(mapping, this->mappingSize);
+            throw std::runtime_error("Not a valid archive: " + filePath);
+        }
+        this->entries = reinterpret_cast<const ArchiveEntry *>(this->bytes + this->header->tableOffset);
+        this->chunks = reinterpret_cast<const ArchiveChunk *>(this->bytes + this->header->tableOffset + entryBytes);
+        this->paths = this->bytes + this->header->tableOffset + entryBytes + chunkBytes;
+
+        bool isTableValid = true;
+        for(uint32_t i = 0; i < this->header->chunkCount && isTableValid; i++){
+            const ArchiveChunk &chunk = this->chunks[i];
+            isTableValid = chunk.offset <= this->header->tableOffset && chunk.compressedSize <= this->header->tableOffset - chunk.offset;
+        }
+        for(uint32_t i = 0; i < this->header->entryCount && isTableValid; i++){
+            const ArchiveEntry &entry = this->entries[i];
+            isTableValid = entry.firstChunk <= this->header->chunkCount && entry.chunkCount <= this->header->chunkCount - entry.firstChunk
+                && entry.pathOffset <= this->header->pathBytes && entry.pathLength <= this->header->pathBytes - entry.pathOffset
+                && (i == 0 || this->entries[i - 1].pathHash <= entry.pathHash);
+        }
+        if(!isTableValid){
+            munmap(mapping, this->mappingSize);
+            throw std::runtime_error("Archive table out of range: " + filePath);
+        }
+        ENGINE_LOG_INFO("EngineArchive: Mapped %s, %u entries in %u chunks", filePath.c_str(), this->header->entryCount, this->header->chunkCount);
+    }
+
+    EngineArchive::~EngineArchive(){
+        munmap(const_cast<char *>(this->bytes), this->mappingSize);
+    }
+
+    const ArchiveEntry *EngineArchive::find(const std::string &path) const {
+        uint64_t pathHash = hashString(path);
+        const ArchiveEntry *end = this->entries + this->header->entryCount;
+        // colliding hashes sit next to each other, the path decides between them
+        for(const ArchiveEntry *entry = std::lower_bound(this->entries, end, pathHash, isEntryBefore); entry != end && entry->pathHash == pathHash; entry++){
+            bool isPathEqual = entry->pathLength == path.size() && memcmp(this->paths + entry->pathOffset, path.data(), path.size()) == 0;
+            if(isPathEqual) return entry;
+        }
+        return nullptr;
+    }
+
+    std::vector<char> EngineArchive::read(const std::string &path){
+        const ArchiveEntry *entry = this->find(path);
+        if(entry == nullptr) throw std::runtime_error("File not in archive: " + path);
+
+        std::vector<char> data(entry->size);
+        // the chunks of an entry cover it back to back, all but the last one chunkSize long
+        uint64_t totalSize = 0;
+        bool isLayoutValid = true;
+        for(uint32_t i = 0; i < entry->chunkCount; i++){
+            const ArchiveChunk &chunk = this->chunks[entry->firstChunk + i];
+            totalSize += chunk.size;
+            isLayoutValid = isLayoutValid && (i + 1 == entry->chunkCount ? chunk.size <= this->header->chunkSize : chunk.size == this->header->chunkSize);
+        }
+        if(!isLayoutValid || totalSize != entry->size) throw std::runtime_error("Archive chunks do not match entry size: " + path);
+
+        if(entry->chunkCount == 1){
+            this->decompressChunk(this->chunks[entry->firstChunk], data.data());
+            return data;
+        }
+        std::lock_guard<std::mutex> lock{this->readMutex};
+        this->workerPool.parallelFor(entry->chunkCount, [this, entry, &data](uint32_t chunkIndex){
+            uint64_t offset = uint64_t{chunkIndex} * this->header->chunkSize;
+            this->decompressChunk(this->chunks[entry->firstChunk + chunkIndex], data.data() + offset);
+        });
+        return data;
+    }
+
+    // Privates
+    void EngineArchive::decompressChunk(const ArchiveChunk &chunk, char *destination) const {
+        const char *source = this->getChunkData(chunk);
+        switch(chunk.compression){
+            case ArchiveCompression::None:
+                if(chunk.compressedSize != chunk.size) throw std::runtime_error("Stored archive chunk has the wrong size");
+                memcpy(destination, source, chunk.size);
+                return;
+            case ArchiveCompression::Lz4:
+                lz4Decompress(source, chunk.compressedSize, destination, chunk.size);
+                return;
+        }
+        throw std::runtime_error("Unsupported archive compression: " + std::to_string(static_cast<uint32_t>(chunk.compression)));
+    }
+
+    EngineArchiveWriter::EngineArchiveWriter(uint32_t chunkSize): chunkSize{chunkSize}{
+        if(chunkSize == 0) throw std::runtime_error("Archive chunk size must not be 0");
+    }
+
+    void EngineArchiveWriter::add(const std::string &path, const std::vector<char> &bytes, ArchiveCompression compression){
+        uint64_t pathHash = hashString(path);
+        for(const PendingEntry &pending:this->pendingEntries){
+            if(pending.entry.pathHash == pathHash && pending.path == path) throw std::runtime_error("File added to archive twice: " + path);
+        }
+
+        ArchiveEntry entry = {};
+        entry.pathHash = pathHash;
+        entry.size = bytes.size();
+        entry.firstChunk = static_cast<uint32_t>(this->chunks.size());
+        // an empty file still gets its one empty chunk
+        size_t offset = 0;
+        do {
+            size_t size = std::min<size_t>(this->chunkSize, bytes.size() - offset);
+            ArchiveChunk chunk = {};
+            chunk.offset = this->chunkData.size();
+            chunk.size = static_cast<uint32_t>(size);
+            chunk.compression = compression;
+            if(compression == ArchiveCompression::Lz4){
+                chunk.compressedSize = static_cast<uint32_t>(lz4Compress(bytes.data() + offset, size, this->chunkData));
+                if(chunk.compressedSize >= size){
+                    this->chunkData.resize(chunk.offset);
+                    chunk.compression = ArchiveCompression::None;
+                }
+            }
+            if(chunk.compression == ArchiveCompression::None){
+                chunk.compressedSize = chunk.size;
+                this->chunkData.insert(this->chunkData.end(), bytes.begin() + offset, bytes.begin() + offset + size);
+            }
+            this->chunks.push_back(chunk);
+            offset += size;
+        } while(offset < bytes.size());
+        entry.chunkCount = static_cast<uint32_t>(this->chunks.size()) - entry.firstChunk;
+
+        this->pendingEntries.push_back(PendingEntry{path, entry});
+        this->uncompressedBytes += bytes.size();
+    }
+
+    void EngineArchiveWriter::write(const std::string &filePath){
+        std::sort(this->pendingEntries.begin(), this->pendingEntries.end(), [](const PendingEntry &a, const PendingEntry &b){
+            return a.entry.pathHash < b.entry.pathHash;
+        });
+        std::vector<ArchiveEntry> entries;
+        std::string paths;
+        for(PendingEntry &pending:this->pendingEntries){
+            pending.entry.pathOffset = static_cast<uint32_t>(paths.size());
+            pending.entry.pathLength = static_cast<uint32_t>(pending.path.size());
+            paths += pending.path;
+            entries.push_back(pending.entry);
+        }
+
+        uint64_t dataOffset = sizeof(ArchiveHeader);
+        uint64_t dataEnd = dataOffset + this->chunkData.size();
+        ArchiveHeader header = {};
+        header.magic = EngineArchive::MAGIC;
+        header.version = EngineArchive::VERSION;
+        header.entryCount = static_cast<uint32_t>(entries.size());
+        header.chunkCount = static_cast<uint32_t>(this->chunks.size());
+        header.chunkSize = this->chunkSize;
+        header.pathBytes = static_cast<uint32_t>(paths.size());
+        header.tableOffset = (dataEnd + TABLE_ALIGNMENT - 1) / TABLE_ALIGNMENT * TABLE_ALIGNMENT;
+        std::vector<ArchiveChunk> chunks = this->chunks;
+        for(ArchiveChunk &chunk:chunks) chunk.offset += dataOffset;
+
+        std::ofstream file{filePath, std::ios::binary | std::ios::trunc};
+        if(!file.is_open()) throw std::runtime_error("Failed to create archive: " + filePath);
+        const char padding[TABLE_ALIGNMENT] = {};
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(this->chunkData.data(), static_cast<std::streamsize>(this->chunkData.size()));
+        file.write(padding, static_cast<std::streamsize>(header.tableOffset - dataEnd));
+        file.write(reinterpret_cast<const char *>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(ArchiveEntry)));
+        file.write(reinterpret_cast<const char *>(chunks.data()), static_cast<std::streamsize>(chunks.size() * sizeof(ArchiveChunk)));
+        file.write(paths.data(), static_cast<std::streamsize>(paths.size()));
+        if(!file) throw std::runtime_error("Failed to write archive: " + filePath);
+    }
+}
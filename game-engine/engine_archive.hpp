@@ -0,0 +1,153 @@
+#pragma once
+#include "engine_worker_pool.hpp"
+
+// std
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace engine {
+    enum class ArchiveCompression : uint32_t {
+        None = 0,
+        // LZ4 block, see engine_lz4.hpp
+        Lz4 = 1,
+    };
+
+    // An archive file is laid out as, little endian:
+    //  - an ArchiveHeader
+    //  - the chunk data, every chunk compressed on its own so any one can be decoded without the rest
+    //  - at tableOffset, 8 byte aligned: ArchiveEntry[entryCount] sorted by path hash,
+    //    ArchiveChunk[chunkCount] with the chunks of every entry next to each other, and the
+    //    pathBytes of all entry paths without terminators
+    struct ArchiveHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t entryCount;
+        uint32_t chunkCount;
+        // uncompressed bytes of every chunk but the last of an entry
+        uint32_t chunkSize;
+        uint32_t pathBytes;
+        uint64_t tableOffset;
+    };
+
+    struct ArchiveEntry {
+        // hashString of the path
+        uint64_t pathHash;
+        uint64_t size;
+        uint32_t firstChunk;
+        uint32_t chunkCount;
+        uint32_t pathOffset;
+        uint32_t pathLength;
+    };
+
+    struct ArchiveChunk {
+        // from the start of the file
+        uint64_t offset;
+        uint32_t compressedSize;
+        uint32_t size;
+        ArchiveCompression compression;
+        uint32_t padding;
+    };
+
+    static_assert(sizeof(ArchiveHeader) == 32 && sizeof(ArchiveEntry) == 32 && sizeof(ArchiveChunk) == 24, "Archive tables are read straight from the file");
+
+    // Read only view of an archive file mapped into memory. Opening it costs one open and one
+    // mmap however many files it holds, and the OS pages in only the chunks that are read. Lookups
+    // binary search the path hash in the table of contents. Entries of more than one chunk are
+    // decompressed in parallel by the archive's workers straight into the returned buffer.
+    //
+    // Every method may be called from any thread.
+    class EngineArchive {
+        public:
+            // "GPAK"
+            static constexpr uint32_t MAGIC = 0x4b415047;
+            static constexpr uint32_t VERSION = 1;
+
+            // Maps the file, throws when it cannot be opened or its tables point outside of it
+            EngineArchive(const std::string &filePath, uint32_t threadCount = std::max(std::thread::hardware_concurrency(), 2u) - 1);
+            ~EngineArchive();
+
+            EngineArchive(const EngineArchive &) = delete;
+            EngineArchive &operator = (const EngineArchive &) = delete;
+
+            // The entry stored under exactly this path, or null
+            const ArchiveEntry *find(const std::string &path) const;
+            bool contains(const std::string &path) const {
+                return this->find(path) != nullptr;
+            }
+            // The whole entry decompressed, throws when it is missing or a chunk is malformed
+            std::vector<char> read(const std::string &path);
+
+            // Raw access for decoders of their own, such as the GPU path
+            const ArchiveChunk &getChunk(uint32_t index) const {
+                return this->chunks[index];
+            }
+            const char *getChunkData(const ArchiveChunk &chunk) const {
+                return this->bytes + chunk.offset;
+            }
+            uint32_t getChunkSize() const {
+                return this->header->chunkSize;
+            }
+            uint32_t getEntryCount() const {
+                return this->header->entryCount;
+            }
+            size_t getFileSize() const {
+                return this->mappingSize;
+            }
+
+        private:
+            void decompressChunk(const ArchiveChunk &chunk, char *destination) const;
+
+            const char *bytes = nullptr;
+            size_t mappingSize = 0;
+            const ArchiveHeader *header = nullptr;
+            const ArchiveEntry *entries = nullptr;
+            const ArchiveChunk *chunks = nullptr;
+            const char *paths = nullptr;
+
+            EngineWorkerPool workerPool;
+            // parallelFor allows one caller at a time
+            std::mutex readMutex;
+    };
+
+    // Collects files in memory and writes them out as one archive, for the archive builder tool
+    class EngineArchiveWriter {
+        public:
+            // LZ4 only looks 64 KiB back, larger chunks would compress little better and split
+            // large entries over fewer workers
+            static constexpr uint32_t DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+            explicit EngineArchiveWriter(uint32_t chunkSize = DEFAULT_CHUNK_SIZE);
+
+            EngineArchiveWriter(const EngineArchiveWriter &) = delete;
+            EngineArchiveWriter &operator = (const EngineArchiveWriter &) = delete;
+
+            // Splits the bytes into chunks and compresses every one of them, chunks that would not
+            // shrink are stored as they are. Throws when the path was added before.
+            void add(const std::string &path, const std::vector<char> &bytes, ArchiveCompression compression = ArchiveCompression::Lz4);
+            void write(const std::string &filePath);
+
+            uint64_t getUncompressedBytes() const {
+                return this->uncompressedBytes;
+            }
+            uint64_t getCompressedBytes() const {
+                return this->chunkData.size();
+            }
+
+        private:
+            struct PendingEntry {
+                std::string path;
+                ArchiveEntry entry;
+            };
+
+            uint32_t chunkSize;
+            std::vector<PendingEntry> pendingEntries;
+            // chunk offsets are relative to the data here until write places it after the header
+            std::vector<ArchiveChunk> chunks;
+            std::vector<char> chunkData;
+            uint64_t uncompressedBytes = 0;
+    };
+}
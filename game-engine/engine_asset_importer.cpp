@@ -0,0 +1,776 @@
+#include "engine_asset_importer.hpp"
+#include "engine_log.hpp"
+
+// std
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+namespace engine {
+    static const glm::vec3 WHITE = {1.0f, 1.0f, 1.0f};
+
+    static double millisecondsSince(std::chrono::steady_clock::time_point start){
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    static bool hasExtension(const std::string &filePath, const char *extension){
+        size_t length = strlen(extension);
+        if(filePath.size() < length) return false;
+        for(size_t i = 0; i < length; i++){
+            char character = filePath[filePath.size() - length + i];
+            if(character >= 'A' && character <= 'Z') character = static_cast<char>(character - 'A' + 'a');
+            if(character != extension[i]) return false;
+        }
+        return true;
+    }
+
+    static std::vector<char> readFileBytes(const std::string &filePath){
+        std::ifstream file{filePath, std::ios::ate | std::ios::binary};
+        if(!file.is_open()) throw std::runtime_error("Failed to open file: " + filePath);
+        size_t fileSize = static_cast<size_t>(file.tellg());
+        std::vector<char> bytes(fileSize);
+        file.seekg(0);
+        file.read(bytes.data(), fileSize);
+        return bytes;
+    }
+
+    // Just enough JSON for glTF: the whole document becomes a tree of values, objects keep their
+    // keys in order and are searched linearly since glTF objects only have a handful of them
+    struct JsonValue {
+        enum class Type {
+            Null,
+            Boolean,
+            Number,
+            String,
+            Array,
+            Object,
+        };
+
+        Type type = Type::Null;
+        bool boolean = false;
+        double number = 0.0;
+        std::string string;
+        // array elements, or object values next to their keys
+        std::vector<JsonValue> values;
+        std::vector<std::string> keys;
+
+        const JsonValue *find(const char *key) const {
+            if(this->type != Type::Object) return nullptr;
+            for(size_t i = 0; i < this->keys.size(); i++){
+                if(this->keys[i] == key) return &this->values[i];
+            }
+            return nullptr;
+        }
+        double numberOr(const char *key, double fallback) const {
+            const JsonValue *value = this->find(key);
+            return value != nullptr && value->type == Type::Number ? value->number : fallback;
+        }
+        // element i of the array under key, null when either is missing
+        const JsonValue *element(const char *key, size_t index) const {
+            const JsonValue *array = this->find(key);
+            if(array == nullptr || array->type != Type::Array || index >= array->values.size()) return nullptr;
+            return &array->values[index];
+        }
+    };
+
+    class JsonParser {
+        public:
+            JsonParser(const char *begin, const char *end): cursor{begin}, end{end}{}
+
+            JsonValue parseDocument(){
+                JsonValue value = this->parseValue();
+                this->skipWhitespace();
+                if(this->cursor != this->end) this->fail();
+                return value;
+            }
+
+        private:
+            void fail(){
+                throw std::runtime_error("Malformed JSON");
+            }
+
+            void skipWhitespace(){
+                while(this->cursor != this->end && (*this->cursor == ' ' || *this->cursor == '\n' || *this->cursor == '\r' || *this->cursor == '\t')) this->cursor++;
+            }
+
+            void expect(char character){
+                this->skipWhitespace();
+                if(this->cursor == this->end || *this->cursor != character) this->fail();
+                this->cursor++;
+            }
+
+            // true when another member or element follows
+            bool consumeSeparator(){
+                this->skipWhitespace();
+                if(this->cursor == this->end || *this->cursor != ',') return false;
+                this->cursor++;
+                return true;
+            }
+
+            bool consumeLiteral(const char *literal){
+                size_t length = strlen(literal);
+                if(static_cast<size_t>(this->end - this->cursor) < length || strncmp(this->cursor, literal, length) != 0) return false;
+                this->cursor += length;
+                return true;
+            }
+
+            JsonValue parseValue(){
+                this->skipWhitespace();
+                if(this->cursor == this->end) this->fail();
+                JsonValue value;
+                char character = *this->cursor;
+                if(character == '{'){
+                    value.type = JsonValue::Type::Object;
+                    this->cursor++;
+                    this->skipWhitespace();
+                    if(this->cursor != this->end && *this->cursor == '}'){
+                        this->cursor++;
+                        return value;
+                    }
+                    for(;;){
+                        this->skipWhitespace();
+                        value.keys.push_back(this->parseString());
+                        this->expect(':');
+                        value.values.push_back(this->parseValue());
+                        if(!this->consumeSeparator()) break;
+                    }
+                    this->expect('}');
+                } else if(character == '['){
+                    value.type = JsonValue::Type::Array;
+                    this->cursor++;
+                    this->skipWhitespace();
+                    if(this->cursor != this->end && *this->cursor == ']'){
+                        this->cursor++;
+                        return value;
+                    }
+                    for(;;){
+                        value.values.push_back(this->parseValue());
+                        if(!this->consumeSeparator()) break;
+                    }
+                    this->expect(']');
+                } else if(character == '"'){
+                    value.type = JsonValue::Type::String;
+                    value.string = this->parseString();
+                } else if(this->consumeLiteral("true")){
+                    value.type = JsonValue::Type::Boolean;
+                    value.boolean = true;
+                } else if(this->consumeLiteral("false")){
+                    value.type = JsonValue::Type::Boolean;
+                } else if(this->consumeLiteral("null")){
+                    value.type = JsonValue::Type::Null;
+                } else {
+                    // strtod stops at the first character that is not part of the number, the
+                    // document is followed by at least the chunk padding or a terminator
+                    value.type = JsonValue::Type::Number;
+                    char *numberEnd;
+                    value.number = std::strtod(this->cursor, &numberEnd);
+                    if(numberEnd == this->cursor || numberEnd > this->end) this->fail();
+                    this->cursor = numberEnd;
+                }
+                return value;
+            }
+
+            std::string parseString(){
+                if(this->cursor == this->end || *this->cursor != '"') this->fail();
+                this->cursor++;
+                std::string string;
+                while(this->cursor != this->end && *this->cursor != '"'){
+                    char character = *this->cursor++;
+                    if(character != '\\'){
+                        string.push_back(character);
+                        continue;
+                    }
+                    if(this->cursor == this->end) this->fail();
+                    char escaped = *this->cursor++;
+                    switch(escaped){
+                        case 'n': string.push_back('\n'); break;
+                        case 't': string.push_back('\t'); break;
+                        case 'r': string.push_back('\r'); break;
+                        case 'b': string.push_back('\b'); break;
+                        case 'f': string.push_back('\f'); break;
+                        case 'u': {
+                            // glTF keys and URIs are ASCII, anything wider is kept as '?'
+                            if(this->end - this->cursor < 4) this->fail();
+                            unsigned long codePoint = std::strtoul(std::string(this->cursor, 4).c_str(), nullptr, 16);
+                            string.push_back(codePoint < 0x80 ? static_cast<char>(codePoint) : '?');
+                            this->cursor += 4;
+                            break;
+                        }
+                        default: string.push_back(escaped); break;
+                    }
+                }
+                if(this->cursor == this->end) this->fail();
+                this->cursor++;
+                return string;
+            }
+
+            const char *cursor;
+            const char *end;
+    };
+
+    static std::vector<char> decodeBase64(const std::string &text, size_t offset){
+        std::vector<char> bytes;
+        bytes.reserve((text.size() - offset) / 4 * 3);
+        uint32_t accumulator = 0;
+        int bitCount = 0;
+        for(size_t i = offset; i < text.size(); i++){
+            char character = text[i];
+            int value;
+            if(character >= 'A' && character <= 'Z') value = character - 'A';
+            else if(character >= 'a' && character <= 'z') value = character - 'a' + 26;
+            else if(character >= '0' && character <= '9') value = character - '0' + 52;
+            else if(character == '+') value = 62;
+            else if(character == '/') value = 63;
+            else if(character == '=') break;
+            else throw std::runtime_error("Malformed base64 buffer");
+            accumulator = accumulator << 6 | static_cast<uint32_t>(value);
+            bitCount += 6;
+            if(bitCount >= 8){
+                bitCount -= 8;
+                bytes.push_back(static_cast<char>(accumulator >> bitCount & 0xff));
+            }
+        }
+        return bytes;
+    }
+
+    // glTF componentType values
+    enum GltfComponentType : uint32_t {
+        GLTF_BYTE = 5120,
+        GLTF_UNSIGNED_BYTE = 5121,
+        GLTF_SHORT = 5122,
+        GLTF_UNSIGNED_SHORT = 5123,
+        GLTF_UNSIGNED_INT = 5125,
+        GLTF_FLOAT = 5126,
+    };
+    static constexpr uint32_t GLTF_MODE_TRIANGLES = 4;
+    static constexpr uint32_t GLB_MAGIC = 0x46546C67;
+    static constexpr uint32_t GLB_CHUNK_JSON = 0x4E4F534A;
+    static constexpr uint32_t GLB_CHUNK_BIN = 0x004E4942;
+
+    // An accessor resolved down to bytes inside a loaded buffer
+    struct GltfAccessor {
+        const uint8_t *data = nullptr;
+        uint32_t count = 0;
+        uint32_t componentCount = 0;
+        uint32_t componentType = 0;
+        size_t stride = 0;
+        bool isNormalized = false;
+
+        bool isValid() const {
+            return this->data != nullptr;
+        }
+
+        float readComponent(uint32_t index, uint32_t component) const {
+            const uint8_t *element = this->data + index * this->stride;
+            switch(this->componentType){
+                case GLTF_FLOAT: {
+                    float value;
+                    memcpy(&value, element + component * 4, sizeof(value));
+                    return value;
+                }
+                case GLTF_UNSIGNED_BYTE: {
+                    float value = element[component];
+                    return this->isNormalized ? value / 255.0f : value;
+                }
+                case GLTF_BYTE: {
+                    float value = static_cast<int8_t>(element[component]);
+                    return this->isNormalized ? std::max(value / 127.0f, -1.0f) : value;
+                }
+                case GLTF_UNSIGNED_SHORT: {
+                    uint16_t value;
+                    memcpy(&value, element + component * 2, sizeof(value));
+                    return this->isNormalized ? value / 65535.0f : value;
+                }
+                case GLTF_SHORT: {
+                    int16_t value;
+                    memcpy(&value, element + component * 2, sizeof(value));
+                    return this->isNormalized ? std::max(value / 32767.0f, -1.0f) : value;
+                }
+                default: {
+                    uint32_t value;
+                    memcpy(&value, element + component * 4, sizeof(value));
+                    return static_cast<float>(value);
+                }
+            }
+        }
+
+        uint32_t readIndex(uint32_t index) const {
+            const uint8_t *element = this->data + index * this->stride;
+            if(this->componentType == GLTF_UNSIGNED_BYTE) return element[0];
+            if(this->componentType == GLTF_UNSIGNED_SHORT){
+                uint16_t value;
+                memcpy(&value, element, sizeof(value));
+                return value;
+            }
+            uint32_t value;
+            memcpy(&value, element, sizeof(value));
+            return value;
+        }
+    };
+
+    // Triangles of one primitive decoded by one task, written from outputOffset on
+    struct GltfTask {
+        uint32_t primitiveIndex;
+        uint32_t firstTriangle;
+        uint32_t triangleCount;
+        size_t outputOffset;
+    };
+
+    struct GltfPrimitive {
+        GltfAccessor positions;
+        GltfAccessor colors;
+        GltfAccessor normals;
+        GltfAccessor indices;
+    };
+
+    static uint32_t componentSize(uint32_t componentType){
+        switch(componentType){
+            case GLTF_BYTE:
+            case GLTF_UNSIGNED_BYTE: return 1;
+            case GLTF_SHORT:
+            case GLTF_UNSIGNED_SHORT: return 2;
+            case GLTF_UNSIGNED_INT:
+            case GLTF_FLOAT: return 4;
+            default: throw std::runtime_error("Unsupported glTF component type");
+        }
+    }
+
+    static uint32_t componentCount(const std::string &type){
+        if(type == "SCALAR") return 1;
+        if(type == "VEC2") return 2;
+        if(type == "VEC3") return 3;
+        if(type == "VEC4") return 4;
+        throw std::runtime_error("Unsupported glTF accessor type: " + type);
+    }
+
+    static GltfAccessor resolveAccessor(const JsonValue &document, const std::vector<std::vector<char>> &buffers, const JsonValue *accessorIndex){
+        GltfAccessor accessor = {};
+        if(accessorIndex == nullptr) return accessor;
+        const JsonValue *json = document.element("accessors", static_cast<size_t>(accessorIndex->number));
+        if(json == nullptr) throw std::runtime_error("glTF accessor out of range");
+        if(json->find("sparse") != nullptr) throw std::runtime_error("Sparse glTF accessors are not supported");
+        const JsonValue *bufferViewIndex = json->find("bufferView");
+        if(bufferViewIndex == nullptr) throw std::runtime_error("glTF accessors without a buffer view are not supported");
+        const JsonValue *bufferView = document.element("bufferViews", static_cast<size_t>(bufferViewIndex->number));
+        if(bufferView == nullptr) throw std::runtime_error("glTF buffer view out of range");
+        size_t bufferIndex = static_cast<size_t>(bufferView->numberOr("buffer", 0.0));
+        if(bufferIndex >= buffers.size()) throw std::runtime_error("glTF buffer out of range");
+
+        const JsonValue *type = json->find("type");
+        accessor.componentType = static_cast<uint32_t>(json->numberOr("componentType", 0.0));
+        accessor.componentCount = componentCount(type != nullptr ? type->string : "");
+        accessor.count = static_cast<uint32_t>(json->numberOr("count", 0.0));
+        const JsonValue *normalized = json->find("normalized");
+        accessor.isNormalized = normalized != nullptr && normalized->boolean;
+        size_t elementSize = componentSize(accessor.componentType) * accessor.componentCount;
+        accessor.stride = static_cast<size_t>(bufferView->numberOr("byteStride", 0.0));
+        if(accessor.stride == 0) accessor.stride = elementSize;
+
+        // the last element has to end inside the view, and the view inside the buffer
+        size_t viewOffset = static_cast<size_t>(bufferView->numberOr("byteOffset", 0.0));
+        size_t viewLength = static_cast<size_t>(bufferView->numberOr("byteLength", 0.0));
+        size_t accessorOffset = static_cast<size_t>(json->numberOr("byteOffset", 0.0));
+        const std::vector<char> &buffer = buffers[bufferIndex];
+        bool isViewInBuffer = viewOffset + viewLength <= buffer.size();
+        bool isAccessorInView = accessor.count == 0 || accessorOffset + accessor.stride * (accessor.count - 1) + elementSize <= viewLength;
+        if(!isViewInBuffer || !isAccessorInView) throw std::runtime_error("glTF accessor reaches past its buffer");
+        accessor.data = reinterpret_cast<const uint8_t *>(buffer.data()) + viewOffset + accessorOffset;
+        return accessor;
+    }
+
+    // One OBJ block after tokenising. Indices are already 0-based, relative ones are counted from
+    // the start of the block and only become absolute once the blocks before it are known.
+    struct ObjCorner {
+        static constexpr int32_t NO_NORMAL = std::numeric_limits<int32_t>::min();
+        static constexpr uint8_t RELATIVE_POSITION = 1;
+        static constexpr uint8_t RELATIVE_NORMAL = 2;
+
+        int32_t position;
+        int32_t normal;
+        uint8_t flags;
+    };
+
+    struct ObjChunk {
+        std::vector<glm::vec3> positions;
+        // white for positions without one, empty when the block has no coloured vertex
+        std::vector<glm::vec3> colors;
+        std::vector<glm::vec3> normals;
+        std::vector<ObjCorner> corners;
+        std::vector<uint32_t> faceSizes;
+        uint64_t triangleCount = 0;
+        // prefix sums over the blocks before this one
+        size_t firstPosition = 0;
+        size_t firstNormal = 0;
+        size_t firstVertex = 0;
+    };
+
+    static const char *skipSpaces(const char *cursor){
+        while(*cursor == ' ' || *cursor == '\t') cursor++;
+        return cursor;
+    }
+
+    static const char *nextLine(const char *cursor){
+        while(*cursor != '\0' && *cursor != '\n') cursor++;
+        return *cursor == '\n' ? cursor + 1 : cursor;
+    }
+
+    // block is null terminated and ends after a newline, so strtof never reads into the next block
+    static void parseObjBlock(const std::string &block, ObjChunk &chunk){
+        const char *cursor = block.c_str();
+        while(*cursor != '\0'){
+            cursor = skipSpaces(cursor);
+            if(cursor[0] == 'v' && (cursor[1] == ' ' || cursor[1] == '\t')){
+                char *end;
+                glm::vec3 position;
+                position.x = std::strtof(cursor + 2, &end);
+                position.y = std::strtof(end, &end);
+                position.z = std::strtof(end, &end);
+                chunk.positions.push_back(position);
+                // the colour extension is exactly three more numbers on the line, a lone w is not one
+                float extra[4];
+                uint32_t extraCount = 0;
+                for(const char *rest = skipSpaces(end); extraCount < 4 && *rest != '\n' && *rest != '\r' && *rest != '\0'; rest = skipSpaces(end)){
+                    extra[extraCount] = std::strtof(rest, &end);
+                    if(end == rest) break;
+                    extraCount++;
+                }
+                if(extraCount == 3){
+                    if(chunk.colors.empty()) chunk.colors.resize(chunk.positions.size() - 1, WHITE);
+                    chunk.colors.push_back({extra[0], extra[1], extra[2]});
+                } else if(!chunk.colors.empty()) chunk.colors.push_back(WHITE);
+            } else if(cursor[0] == 'v' && cursor[1] == 'n'){
+                char *end;
+                glm::vec3 normal;
+                normal.x = std::strtof(cursor + 2, &end);
+                normal.y = std::strtof(end, &end);
+                normal.z = std::strtof(end, &end);
+                chunk.normals.push_back(normal);
+            } else if(cursor[0] == 'f' && (cursor[1] == ' ' || cursor[1] == '\t')){
+                // "p", "p/t", "p//n" or "p/t/n" per corner, texture coordinates are not kept
+                const char *corner = skipSpaces(cursor + 1);
+                uint32_t faceSize = 0;
+                while(*corner != '\n' && *corner != '\r' && *corner != '\0'){
+                    char *end;
+                    long position = std::strtol(corner, &end, 10);
+                    if(end == corner || position == 0) throw std::runtime_error("Malformed OBJ face");
+                    long normal = 0;
+                    if(*end == '/'){
+                        end++;
+                        if(*end != '/') std::strtol(end, &end, 10);
+                        if(*end == '/') normal = std::strtol(end + 1, &end, 10);
+                    }
+
+                    ObjCorner entry = {};
+                    int32_t localPositionCount = static_cast<int32_t>(chunk.positions.size());
+                    int32_t localNormalCount = static_cast<int32_t>(chunk.normals.size());
+                    entry.position = position > 0 ? static_cast<int32_t>(position - 1) : localPositionCount + static_cast<int32_t>(position);
+                    if(position < 0) entry.flags |= ObjCorner::RELATIVE_POSITION;
+                    entry.normal = ObjCorner::NO_NORMAL;
+                    if(normal > 0) entry.normal = static_cast<int32_t>(normal - 1);
+                    if(normal < 0){
+                        entry.normal = localNormalCount + static_cast<int32_t>(normal);
+                        entry.flags |= ObjCorner::RELATIVE_NORMAL;
+                    }
+                    chunk.corners.push_back(entry);
+                    faceSize++;
+                    corner = skipSpaces(end);
+                }
+                if(faceSize < 3) throw std::runtime_error("OBJ face with fewer than three corners");
+                chunk.faceSizes.push_back(faceSize);
+                chunk.triangleCount += faceSize - 2;
+            }
+            cursor = nextLine(cursor);
+        }
+    }
+
+    static void fitToUnitSquare(std::vector<EngineModel::Vertex> &vertices){
+        if(vertices.empty()) return;
+        glm::vec2 min = vertices[0].position;
+        glm::vec2 max = vertices[0].position;
+        for(const EngineModel::Vertex &vertex:vertices){
+            min = glm::min(min, vertex.position);
+            max = glm::max(max, vertex.position);
+        }
+        glm::vec2 centre = (min + max) * 0.5f;
+        float extent = std::max(max.x - min.x, max.y - min.y);
+        float scale = extent > 0.0f ? 1.0f / extent : 1.0f;
+        for(EngineModel::Vertex &vertex:vertices) vertex.position = (vertex.position - centre) * scale;
+    }
+
+    // Publics
+    EngineAssetImporter::EngineAssetImporter(EngineDevice &device, uint32_t threadCount): engineDevice{device}, workerPool{threadCount}{
+        ENGINE_LOG_INFO("EngineAssetImporter: Initialising with %u worker threads", threadCount);
+    }
+
+    std::vector<EngineModel::Vertex> EngineAssetImporter::importVertices(const std::string &filePath, const Options &options, ImportStatistics &statistics){
+        std::lock_guard<std::mutex> lock(this->importMutex);
+        auto start = std::chrono::steady_clock::now();
+        statistics = {};
+
+        std::vector<EngineModel::Vertex> vertices;
+        if(hasExtension(filePath, ".obj")) vertices = this->importObj(filePath, statistics);
+        else if(hasExtension(filePath, ".glb") || hasExtension(filePath, ".gltf")) vertices = this->importGltf(filePath, statistics);
+        else throw std::runtime_error("Unsupported model file: " + filePath);
+        if(vertices.size() < 3) throw std::runtime_error("Model has no triangles: " + filePath);
+
+        if(options.isFittedToUnitSquare) fitToUnitSquare(vertices);
+        statistics.triangleCount = vertices.size() / 3;
+        statistics.totalMs = millisecondsSince(start);
+        return vertices;
+    }
+
+    std::unique_ptr<EngineModel> EngineAssetImporter::importModel(const std::string &filePath, const Options &options, ImportStatistics &statistics){
+        std::vector<EngineModel::Vertex> vertices = this->importVertices(filePath, options, statistics);
+        auto uploadStart = std::chrono::steady_clock::now();
+        auto model = std::make_unique<EngineModel>(this->engineDevice, vertices);
+        statistics.uploadMs = millisecondsSince(uploadStart);
+        statistics.totalMs += statistics.uploadMs;
+        return model;
+    }
+
+    std::future<ImportedModel> EngineAssetImporter::importModelAsync(const std::string &filePath, const Options &options){
+        return std::async(std::launch::async, [this, filePath, options](){
+            ImportedModel imported;
+            imported.model = this->importModel(filePath, options, imported.statistics);
+            return imported;
+        });
+    }
+
+    // Privates
+    std::vector<EngineModel::Vertex> EngineAssetImporter::importObj(const std::string &filePath, ImportStatistics &statistics){
+        auto parseStart = std::chrono::steady_clock::now();
+        std::ifstream file{filePath, std::ios::binary};
+        if(!file.is_open()) throw std::runtime_error("Failed to open file: " + filePath);
+
+        // the file streams in a batch of blocks at a time, one block per thread, every block ends
+        // on a line break and what follows the last one is carried into the next block
+        uint32_t batchSize = this->workerPool.threadCount() + 1;
+        std::vector<std::string> batch(batchSize);
+        std::vector<ObjChunk> chunks;
+        std::string carry;
+        bool isEndOfFile = false;
+        while(!isEndOfFile){
+            uint32_t blockCount = 0;
+            while(blockCount < batchSize && !isEndOfFile){
+                std::string &block = batch[blockCount];
+                block.swap(carry);
+                size_t carried = block.size();
+                block.resize(carried + OBJ_BLOCK_SIZE);
+                file.read(&block[carried], OBJ_BLOCK_SIZE);
+                size_t readBytes = static_cast<size_t>(file.gcount());
+                statistics.fileBytes += readBytes;
+                block.resize(carried + readBytes);
+                isEndOfFile = readBytes < OBJ_BLOCK_SIZE;
+
+                size_t lineEnd = isEndOfFile ? block.size() : block.rfind('\n');
+                if(lineEnd == std::string::npos) lineEnd = block.size();
+                else if(!isEndOfFile) lineEnd++;
+                carry.assign(block, lineEnd, std::string::npos);
+                block.resize(lineEnd);
+                if(!block.empty()) blockCount++;
+            }
+
+            size_t firstChunk = chunks.size();
+            chunks.resize(firstChunk + blockCount);
+            this->workerPool.parallelFor(blockCount, [&](uint32_t taskIndex){
+                parseObjBlock(batch[taskIndex], chunks[firstChunk + taskIndex]);
+            });
+        }
+        statistics.parseMs = millisecondsSince(parseStart);
+
+        auto convertStart = std::chrono::steady_clock::now();
+        size_t positionCount = 0, normalCount = 0, vertexCount = 0;
+        bool hasColors = false;
+        for(ObjChunk &chunk:chunks){
+            chunk.firstPosition = positionCount;
+            chunk.firstNormal = normalCount;
+            chunk.firstVertex = vertexCount;
+            positionCount += chunk.positions.size();
+            normalCount += chunk.normals.size();
+            vertexCount += chunk.triangleCount * 3;
+            hasColors = hasColors || !chunk.colors.empty();
+        }
+
+        std::vector<glm::vec3> positions, colors, normals;
+        positions.reserve(positionCount);
+        normals.reserve(normalCount);
+        if(hasColors) colors.reserve(positionCount);
+        for(ObjChunk &chunk:chunks){
+            positions.insert(positions.end(), chunk.positions.begin(), chunk.positions.end());
+            normals.insert(normals.end(), chunk.normals.begin(), chunk.normals.end());
+            if(hasColors && chunk.colors.empty()) colors.resize(colors.size() + chunk.positions.size(), WHITE);
+            else colors.insert(colors.end(), chunk.colors.begin(), chunk.colors.end());
+        }
+
+        // every block knows where its triangles go, so they fill the output without any merging
+        std::vector<EngineModel::Vertex> vertices(vertexCount);
+        this->workerPool.parallelFor(static_cast<uint32_t>(chunks.size()), [&](uint32_t taskIndex){
+            const ObjChunk &chunk = chunks[taskIndex];
+            auto resolve = [&](const ObjCorner &corner){
+                int64_t position = corner.position;
+                if(corner.flags & ObjCorner::RELATIVE_POSITION) position += static_cast<int64_t>(chunk.firstPosition);
+                if(position < 0 || position >= static_cast<int64_t>(positions.size())) throw std::runtime_error("OBJ face index out of range");
+                EngineModel::Vertex vertex = {};
+                vertex.position = {positions[position].x, -positions[position].y};
+                vertex.color = hasColors ? colors[position] : WHITE;
+                if(!hasColors && corner.normal != ObjCorner::NO_NORMAL){
+                    int64_t normal = corner.normal;
+                    if(corner.flags & ObjCorner::RELATIVE_NORMAL) normal += static_cast<int64_t>(chunk.firstNormal);
+                    if(normal < 0 || normal >= static_cast<int64_t>(normals.size())) throw std::runtime_error("OBJ normal index out of range");
+                    vertex.color = glm::normalize(normals[normal]) * 0.5f + 0.5f;
+                }
+                return vertex;
+            };
+
+            // faces are fans around their first corner
+            EngineModel::Vertex *output = vertices.data() + chunk.firstVertex;
+            size_t firstCorner = 0;
+            for(uint32_t faceSize:chunk.faceSizes){
+                EngineModel::Vertex pivot = resolve(chunk.corners[firstCorner]);
+                EngineModel::Vertex previous = resolve(chunk.corners[firstCorner + 1]);
+                for(uint32_t i = 2; i < faceSize; i++){
+                    EngineModel::Vertex current = resolve(chunk.corners[firstCorner + i]);
+                    *output++ = pivot;
+                    *output++ = previous;
+                    *output++ = current;
+                    previous = current;
+                }
+                firstCorner += faceSize;
+            }
+        });
+        statistics.convertMs = millisecondsSince(convertStart);
+        return vertices;
+    }
+
+    std::vector<EngineModel::Vertex> EngineAssetImporter::importGltf(const std::string &filePath, ImportStatistics &statistics){
+        auto parseStart = std::chrono::steady_clock::now();
+        std::vector<char> fileBytes = readFileBytes(filePath);
+        statistics.fileBytes = fileBytes.size();
+
+        // a GLB is a header, the JSON chunk and an optional binary chunk standing in for buffer 0
+        const char *jsonBegin = fileBytes.data();
+        const char *jsonEnd = fileBytes.data() + fileBytes.size();
+        std::vector<char> binaryChunk;
+        bool isBinary = false;
+        if(fileBytes.size() >= 12){
+            uint32_t magic;
+            memcpy(&magic, fileBytes.data(), sizeof(magic));
+            isBinary = magic == GLB_MAGIC;
+        }
+        if(isBinary){
+            size_t offset = 12;
+            bool hasJson = false;
+            while(offset + 8 <= fileBytes.size()){
+                uint32_t chunkLength, chunkType;
+                memcpy(&chunkLength, fileBytes.data() + offset, sizeof(chunkLength));
+                memcpy(&chunkType, fileBytes.data() + offset + 4, sizeof(chunkType));
+                const char *chunkData = fileBytes.data() + offset + 8;
+                if(offset + 8 + chunkLength > fileBytes.size()) throw std::runtime_error("Truncated GLB chunk: " + filePath);
+                if(chunkType == GLB_CHUNK_JSON){
+                    jsonBegin = chunkData;
+                    jsonEnd = chunkData + chunkLength;
+                    hasJson = true;
+                } else if(chunkType == GLB_CHUNK_BIN && binaryChunk.empty()){
+                    binaryChunk.assign(chunkData, chunkData + chunkLength);
+                }
+                offset += 8 + chunkLength;
+            }
+            if(!hasJson) throw std::runtime_error("GLB without a JSON chunk: " + filePath);
+        }
+        // numbers are parsed with strtod, which needs a terminator after the document
+        std::string jsonText{jsonBegin, jsonEnd};
+        JsonValue document = JsonParser{jsonText.c_str(), jsonText.c_str() + jsonText.size()}.parseDocument();
+
+        std::vector<std::vector<char>> buffers;
+        const JsonValue *bufferArray = document.find("buffers");
+        size_t bufferCount = bufferArray != nullptr ? bufferArray->values.size() : 0;
+        std::string directory = filePath.substr(0, filePath.find_last_of("/\\") + 1);
+        for(size_t i = 0; i < bufferCount; i++){
+            const JsonValue *uri = bufferArray->values[i].find("uri");
+            if(uri == nullptr){
+                if(!isBinary || i != 0) throw std::runtime_error("glTF buffer without a URI: " + filePath);
+                buffers.push_back(std::move(binaryChunk));
+                continue;
+            }
+            if(uri->string.compare(0, 5, "data:") == 0){
+                size_t comma = uri->string.find(";base64,");
+                if(comma == std::string::npos) throw std::runtime_error("Unsupported glTF data URI: " + filePath);
+                buffers.push_back(decodeBase64(uri->string, comma + 8));
+                continue;
+            }
+            buffers.push_back(readFileBytes(directory + uri->string));
+            statistics.fileBytes += buffers.back().size();
+        }
+
+        std::vector<GltfPrimitive> primitives;
+        const JsonValue *meshes = document.find("meshes");
+        size_t meshCount = meshes != nullptr ? meshes->values.size() : 0;
+        for(size_t m = 0; m < meshCount; m++){
+            const JsonValue *primitiveArray = meshes->values[m].find("primitives");
+            size_t primitiveCount = primitiveArray != nullptr ? primitiveArray->values.size() : 0;
+            for(size_t p = 0; p < primitiveCount; p++){
+                const JsonValue &json = primitiveArray->values[p];
+                uint32_t mode = static_cast<uint32_t>(json.numberOr("mode", GLTF_MODE_TRIANGLES));
+                const JsonValue *attributes = json.find("attributes");
+                if(mode != GLTF_MODE_TRIANGLES || attributes == nullptr){
+                    ENGINE_LOG_WARNING("EngineAssetImporter: Skipping a primitive that is not a triangle list in %s", filePath.c_str());
+                    continue;
+                }
+                GltfPrimitive primitive = {};
+                primitive.positions = resolveAccessor(document, buffers, attributes->find("POSITION"));
+                primitive.colors = resolveAccessor(document, buffers, attributes->find("COLOR_0"));
+                primitive.normals = resolveAccessor(document, buffers, attributes->find("NORMAL"));
+                primitive.indices = resolveAccessor(document, buffers, json.find("indices"));
+                if(!primitive.positions.isValid() || primitive.positions.componentCount < 2) throw std::runtime_error("glTF primitive without positions: " + filePath);
+                if(primitive.indices.isValid() && primitive.indices.componentType != GLTF_UNSIGNED_BYTE && primitive.indices.componentType != GLTF_UNSIGNED_SHORT && primitive.indices.componentType != GLTF_UNSIGNED_INT){
+                    throw std::runtime_error("Unsupported glTF index type: " + filePath);
+                }
+                primitives.push_back(primitive);
+            }
+        }
+        statistics.parseMs = millisecondsSince(parseStart);
+
+        // large primitives are split so every worker gets a share
+        auto convertStart = std::chrono::steady_clock::now();
+        std::vector<GltfTask> tasks;
+        size_t vertexCount = 0;
+        for(uint32_t p = 0; p < primitives.size(); p++){
+            const GltfPrimitive &primitive = primitives[p];
+            uint32_t triangleCount = (primitive.indices.isValid() ? primitive.indices.count : primitive.positions.count) / 3;
+            for(uint32_t first = 0; first < triangleCount; first += TRIANGLES_PER_TASK){
+                GltfTask task = {p, first, std::min(triangleCount - first, TRIANGLES_PER_TASK), vertexCount};
+                tasks.push_back(task);
+                vertexCount += task.triangleCount * 3;
+            }
+        }
+
+        std::vector<EngineModel::Vertex> vertices(vertexCount);
+        this->workerPool.parallelFor(static_cast<uint32_t>(tasks.size()), [&](uint32_t taskIndex){
+            const GltfTask &task = tasks[taskIndex];
+            const GltfPrimitive &primitive = primitives[task.primitiveIndex];
+            EngineModel::Vertex *output = vertices.data() + task.outputOffset;
+            uint32_t firstCorner = task.firstTriangle * 3;
+            for(uint32_t corner = firstCorner; corner < firstCorner + task.triangleCount * 3; corner++){
+                uint32_t index = primitive.indices.isValid() ? primitive.indices.readIndex(corner) : corner;
+                if(index >= primitive.positions.count) throw std::runtime_error("glTF index out of range");
+
+                EngineModel::Vertex vertex = {};
+                vertex.position = {primitive.positions.readComponent(index, 0), -primitive.positions.readComponent(index, 1)};
+                vertex.color = WHITE;
+                if(primitive.colors.isValid() && index < primitive.colors.count && primitive.colors.componentCount >= 3){
+                    vertex.color = {primitive.colors.readComponent(index, 0), primitive.colors.readComponent(index, 1), primitive.colors.readComponent(index, 2)};
+                } else if(primitive.normals.isValid() && index < primitive.normals.count && primitive.normals.componentCount == 3){
+                    glm::vec3 normal = {primitive.normals.readComponent(index, 0), primitive.normals.readComponent(index, 1), primitive.normals.readComponent(index, 2)};
+                    vertex.color = glm::normalize(normal) * 0.5f + 0.5f;
+                }
+                *output++ = vertex;
+            }
+        });
+        statistics.convertMs = millisecondsSince(convertStart);
+        return vertices;
+    }
+}
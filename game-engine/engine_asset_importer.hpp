@@ -0,0 +1,87 @@
+#pragma once
+#include "engine_device.hpp"
+#include "engine_model.hpp"
+#include "engine_worker_pool.hpp"
+
+// std
+#include <algorithm>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace engine {
+    struct ImportStatistics {
+        uint64_t fileBytes = 0;
+        uint64_t triangleCount = 0;
+        // reading and tokenising the file, OBJ parses every block as it arrives
+        double parseMs = 0.0;
+        // building engine vertices from the parsed data on every worker
+        double convertMs = 0.0;
+        // copy into the host visible vertex buffer, see EngineModel
+        double uploadMs = 0.0;
+        double totalMs = 0.0;
+
+        double megabytesPerSecond() const {
+            return this->totalMs > 0.0 ? this->fileBytes / (1024.0 * 1024.0) / (this->totalMs / 1000.0) : 0.0;
+        }
+        double trianglesPerSecond() const {
+            return this->totalMs > 0.0 ? this->triangleCount / (this->totalMs / 1000.0) : 0.0;
+        }
+    };
+
+    struct ImportedModel {
+        std::unique_ptr<EngineModel> model;
+        ImportStatistics statistics;
+    };
+
+    // Turns glTF 2.0 (.glb or .gltf with external or embedded buffers) and Wavefront OBJ files
+    // into EngineModels. Both end up as one flat triangle list in the engine vertex format:
+    //  - the position keeps x and y with y flipped, since both formats are y up and the engine's
+    //    normalised device space is y down, z is dropped
+    //  - the colour is COLOR_0 (or the OBJ "v x y z r g b" extension) when present, otherwise the
+    //    normal mapped to [0, 1], otherwise white
+    // Every mesh of a glTF file is merged in its own space, node transforms are not applied.
+    //
+    // OBJ is read in blocks that are tokenised in parallel while the file streams in, then the
+    // faces of every block are triangulated in parallel into their final place in the output.
+    // glTF primitives are split into ranges of triangles that are decoded in parallel the same way.
+    // The importer has its own workers, so it never competes with the render thread's pool; one
+    // import runs at a time and the rest wait.
+    class EngineAssetImporter {
+        public:
+            // bytes of OBJ text handed to one worker
+            static constexpr size_t OBJ_BLOCK_SIZE = 4 * 1024 * 1024;
+            // glTF triangles decoded by one task
+            static constexpr uint32_t TRIANGLES_PER_TASK = 65536;
+
+            struct Options {
+                // scale and centre the positions into [-0.5, 0.5], the size of the Sierpinski model
+                bool isFittedToUnitSquare = false;
+            };
+
+            EngineAssetImporter(EngineDevice &device, uint32_t threadCount = std::max(std::thread::hardware_concurrency(), 2u) - 1);
+
+            EngineAssetImporter(const EngineAssetImporter &) = delete;
+            EngineAssetImporter &operator = (const EngineAssetImporter &) = delete;
+
+            // Parses and converts the file on the calling thread and the importer's workers, throws on malformed files
+            std::vector<EngineModel::Vertex> importVertices(const std::string &filePath, const Options &options, ImportStatistics &statistics);
+            // importVertices followed by the upload
+            std::unique_ptr<EngineModel> importModel(const std::string &filePath, const Options &options, ImportStatistics &statistics);
+            // importModel on a background thread, the model may be drawn once the future is ready
+            std::future<ImportedModel> importModelAsync(const std::string &filePath, const Options &options);
+
+        private:
+            std::vector<EngineModel::Vertex> importObj(const std::string &filePath, ImportStatistics &statistics);
+            std::vector<EngineModel::Vertex> importGltf(const std::string &filePath, ImportStatistics &statistics);
+
+            EngineDevice &engineDevice;
+            EngineWorkerPool workerPool;
+            // parallelFor allows one caller at a time
+            std::mutex importMutex;
+    };
+}
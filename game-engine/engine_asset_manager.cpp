@@ -0,0 +1,221 @@
+#include "engine_asset_manager.hpp"
+#include "engine_log.hpp"
+#include "engine_hash.hpp"
+
+// std
+#include <utility>
+
+namespace engine {
+    static double millisecondsSince(std::chrono::steady_clock::time_point start){
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Publics
+    EngineAssetManager::EngineAssetManager(EngineDevice &device, EngineDeletionQueue &deletionQueue): engineDevice{device}, deletionQueue{deletionQueue}, importer{device}{
+        ENGINE_LOG_INFO("EngineAssetManager: Initialising");
+        this->createPlaceholder();
+        this->ioThread = std::thread(&EngineAssetManager::ioLoop, this);
+        this->uploadThread = std::thread(&EngineAssetManager::uploadLoop, this);
+    }
+
+    EngineAssetManager::~EngineAssetManager(){
+        {
+            std::lock_guard<std::mutex> lock{this->queueMutex};
+            this->isStopping = true;
+        }
+        this->loadCondition.notify_all();
+        this->uploadCondition.notify_all();
+        this->ioThread.join();
+        this->uploadThread.join();
+    }
+
+    ModelHandle EngineAssetManager::loadModel(const std::string &filePath, const EngineAssetImporter::Options &options){
+        uint64_t pathHash = hashString(filePath);
+        auto found = this->slotsByPath.find(pathHash);
+        if(found != this->slotsByPath.end() && this->slots[found->second].filePath == filePath){
+            Slot &slot = this->slots[found->second];
+            slot.referenceCount++;
+            return ModelHandle{found->second, slot.generation};
+        }
+
+        uint32_t index;
+        if(!this->freeSlots.empty()){
+            index = this->freeSlots.back();
+            this->freeSlots.pop_back();
+        } else {
+            index = static_cast<uint32_t>(this->slots.size());
+            this->slots.emplace_back();
+        }
+        Slot &slot = this->slots[index];
+        slot.filePath = filePath;
+        slot.pathHash = pathHash;
+        slot.referenceCount = 1;
+        slot.state = AssetState::Loading;
+        slot.requestTime = std::chrono::steady_clock::now();
+        // a colliding path keeps its slot, only the newest one is found by path
+        this->slotsByPath[pathHash] = index;
+
+        {
+            std::lock_guard<std::mutex> lock{this->queueMutex};
+            this->loadJobs.push_back(LoadJob{index, slot.generation, filePath, options});
+        }
+        this->loadCondition.notify_one();
+        return ModelHandle{index, slot.generation};
+    }
+
+    void EngineAssetManager::retain(ModelHandle handle){
+        Slot *slot = this->resolve(handle);
+        if(slot != nullptr) slot->referenceCount++;
+    }
+
+    void EngineAssetManager::release(ModelHandle handle){
+        Slot *slot = this->resolve(handle);
+        if(slot == nullptr || --slot->referenceCount > 0) return;
+
+        if(slot->model != nullptr){
+            this->deletionQueue.retire(this->producedFrameCount, std::move(slot->model));
+        }
+        auto found = this->slotsByPath.find(slot->pathHash);
+        if(found != this->slotsByPath.end() && found->second == handle.index) this->slotsByPath.erase(found);
+
+        // a load still in flight finds the generation changed and is dropped in finishLoad
+        slot->filePath.clear();
+        slot->generation++;
+        this->freeSlots.push_back(handle.index);
+    }
+
+    EngineModel *EngineAssetManager::getModel(ModelHandle handle){
+        Slot *slot = this->resolve(handle);
+        if(slot == nullptr || slot->state != AssetState::Ready) return this->placeholderModel.get();
+        return slot->model.get();
+    }
+
+    AssetState EngineAssetManager::getState(ModelHandle handle){
+        Slot *slot = this->resolve(handle);
+        return slot != nullptr ? slot->state : AssetState::Failed;
+    }
+
+    void EngineAssetManager::update(uint64_t producedFrameCount){
+        this->producedFrameCount = producedFrameCount;
+
+        std::vector<FinishedLoad> finished;
+        {
+            std::lock_guard<std::mutex> lock{this->queueMutex};
+            finished.swap(this->finishedLoads);
+        }
+        for(FinishedLoad &load:finished){
+            this->finishLoad(std::move(load));
+        }
+    }
+
+    AssetStatistics EngineAssetManager::getStatistics(){
+        AssetStatistics statistics;
+        for(const Slot &slot:this->slots){
+            if(slot.referenceCount == 0) continue;
+            switch(slot.state){
+                case AssetState::Loading: statistics.loadingCount++; break;
+                case AssetState::Ready: statistics.readyCount++; break;
+                case AssetState::Failed: statistics.failedCount++; break;
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock{this->queueMutex};
+            statistics.queuedLoads = static_cast<uint32_t>(this->loadJobs.size());
+            statistics.queuedUploads = static_cast<uint32_t>(this->uploadJobs.size());
+        }
+        statistics.loadedBytes = this->loadedBytes;
+        return statistics;
+    }
+
+    // Privates
+    void EngineAssetManager::ioLoop(){
+        while(true){
+            LoadJob job;
+            {
+                std::unique_lock<std::mutex> lock{this->queueMutex};
+                this->loadCondition.wait(lock, [this]{ return this->isStopping || !this->loadJobs.empty(); });
+                if(this->isStopping) return;
+                job = std::move(this->loadJobs.front());
+                this->loadJobs.pop_front();
+            }
+
+            UploadJob upload{job.index, job.generation, {}, {}};
+            try {
+                upload.vertices = this->importer.importVertices(job.filePath, job.options, upload.statistics);
+            } catch(const std::exception &error){
+                std::lock_guard<std::mutex> lock{this->queueMutex};
+                this->finishedLoads.push_back(FinishedLoad{job.index, job.generation, nullptr, upload.statistics, error.what()});
+                continue;
+            }
+            {
+                std::lock_guard<std::mutex> lock{this->queueMutex};
+                this->uploadJobs.push_back(std::move(upload));
+            }
+            this->uploadCondition.notify_one();
+        }
+    }
+
+    void EngineAssetManager::uploadLoop(){
+        while(true){
+            UploadJob job;
+            {
+                std::unique_lock<std::mutex> lock{this->queueMutex};
+                this->uploadCondition.wait(lock, [this]{ return this->isStopping || !this->uploadJobs.empty(); });
+                if(this->isStopping) return;
+                job = std::move(this->uploadJobs.front());
+                this->uploadJobs.pop_front();
+            }
+
+            FinishedLoad finished{job.index, job.generation, nullptr, job.statistics, {}};
+            try {
+                auto uploadStart = std::chrono::steady_clock::now();
+                finished.model = std::make_unique<EngineModel>(this->engineDevice, job.vertices);
+                finished.statistics.uploadMs = millisecondsSince(uploadStart);
+                finished.statistics.totalMs += finished.statistics.uploadMs;
+            } catch(const std::exception &error){
+                finished.error = error.what();
+            }
+            std::lock_guard<std::mutex> lock{this->queueMutex};
+            this->finishedLoads.push_back(std::move(finished));
+        }
+    }
+
+    void EngineAssetManager::finishLoad(FinishedLoad &&finished){
+        Slot &slot = this->slots[finished.index];
+        // released while loading, the slot may already belong to another path
+        if(slot.generation != finished.generation || slot.referenceCount == 0) return;
+
+        if(!finished.error.empty()){
+            slot.state = AssetState::Failed;
+            ENGINE_LOG_WARNING("EngineAssetManager: Failed to load %s: %s", slot.filePath.c_str(), finished.error.c_str());
+            return;
+        }
+        slot.model = std::move(finished.model);
+        slot.state = AssetState::Ready;
+        this->loadedBytes += finished.statistics.fileBytes;
+        ENGINE_LOG_INFO("EngineAssetManager: Loaded %s, %llu triangles in %.1f ms (%.1f ms after the request, %.1f MB/s)",
+            slot.filePath.c_str(), static_cast<unsigned long long>(finished.statistics.triangleCount),
+            finished.statistics.totalMs, millisecondsSince(slot.requestTime), finished.statistics.megabytesPerSecond());
+    }
+
+    EngineAssetManager::Slot *EngineAssetManager::resolve(ModelHandle handle){
+        if(handle.index >= this->slots.size()) return nullptr;
+        Slot &slot = this->slots[handle.index];
+        if(slot.generation != handle.generation || slot.referenceCount == 0) return nullptr;
+        return &slot;
+    }
+
+    void EngineAssetManager::createPlaceholder(){
+        // a magenta quad the size of a fitted model, hard to mistake for real content
+        const glm::vec3 magenta = {1.0f, 0.0f, 1.0f};
+        std::vector<EngineModel::Vertex> vertices = {
+            {{-0.5f, -0.5f}, magenta},
+            {{0.5f, -0.5f}, magenta},
+            {{0.5f, 0.5f}, magenta},
+            {{-0.5f, -0.5f}, magenta},
+            {{0.5f, 0.5f}, magenta},
+            {{-0.5f, 0.5f}, magenta},
+        };
+        this->placeholderModel = std::make_unique<EngineModel>(this->engineDevice, vertices);
+    }
+}
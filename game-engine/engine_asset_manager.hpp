@@ -0,0 +1,155 @@
+#pragma once
+#include "engine_device.hpp"
+#include "engine_model.hpp"
+#include "engine_asset_importer.hpp"
+#include "engine_deletion_queue.hpp"
+
+// std
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace engine {
+    // Refers to one load of an asset. The generation changes every time a slot is reused, so a
+    // handle kept past its last release resolves to nothing instead of to whatever took its place.
+    template<typename T>
+    struct AssetHandle {
+        static constexpr uint32_t INVALID_INDEX = ~0u;
+
+        uint32_t index = INVALID_INDEX;
+        uint32_t generation = 0;
+
+        bool isValid() const {
+            return this->index != INVALID_INDEX;
+        }
+        bool operator == (const AssetHandle &other) const {
+            return this->index == other.index && this->generation == other.generation;
+        }
+    };
+    using ModelHandle = AssetHandle<EngineModel>;
+
+    enum class AssetState : uint8_t {
+        // in either background stage, or finished and waiting for update
+        Loading,
+        Ready,
+        // the placeholder stands in for good
+        Failed,
+    };
+
+    struct AssetStatistics {
+        uint32_t loadingCount = 0;
+        // jobs waiting in front of each stage, part of loadingCount
+        uint32_t queuedLoads = 0;
+        uint32_t queuedUploads = 0;
+        uint32_t readyCount = 0;
+        uint32_t failedCount = 0;
+        uint64_t loadedBytes = 0;
+    };
+
+    // Owns the models loaded from files and hands out reference counted handles to them. Loading
+    // the same path again returns the existing handle with one more reference. Every load goes
+    // through two background stages so the calling thread never waits on disk or the GPU:
+    //  1. the I/O thread reads and decodes the file into vertices with the asset importer
+    //  2. the upload thread copies the vertices into a host visible vertex buffer, which needs no
+    //     submission on the graphics queue the render thread owns
+    // update publishes finished loads on the owning thread, until then, or for good when the load
+    // failed, getModel returns a placeholder quad so frames can be built right away.
+    //
+    // Every method except the background stages runs on the thread that owns the manager, so the
+    // slots themselves need no lock: the stages only see copies of what they need.
+    class EngineAssetManager {
+        public:
+            // Released models go to the deletion queue, which has to outlive the manager
+            EngineAssetManager(EngineDevice &device, EngineDeletionQueue &deletionQueue);
+            ~EngineAssetManager();
+
+            EngineAssetManager(const EngineAssetManager &) = delete;
+            EngineAssetManager &operator = (const EngineAssetManager &) = delete;
+
+            // Starts loading a glTF or OBJ model, or adds a reference to the one already loaded or
+            // loading from this path. Every call has to be paired with a release.
+            ModelHandle loadModel(const std::string &filePath, const EngineAssetImporter::Options &options = {});
+            void retain(ModelHandle handle);
+            // The last release frees the model once the frames that may have drawn it have completed
+            void release(ModelHandle handle);
+
+            // The model, or the placeholder while it is loading, after it failed or for stale handles
+            EngineModel *getModel(ModelHandle handle);
+            AssetState getState(ModelHandle handle);
+
+            // Call once per frame on the owning thread. Publishes finished loads. producedFrameCount is
+            // the number of the next frame packet, the last that might see a model released now.
+            void update(uint64_t producedFrameCount);
+
+            AssetStatistics getStatistics();
+
+        private:
+            struct Slot {
+                std::string filePath;
+                uint64_t pathHash = 0;
+                uint32_t generation = 0;
+                uint32_t referenceCount = 0;
+                AssetState state = AssetState::Loading;
+                std::unique_ptr<EngineModel> model;
+                std::chrono::steady_clock::time_point requestTime;
+            };
+
+            struct LoadJob {
+                uint32_t index;
+                uint32_t generation;
+                std::string filePath;
+                EngineAssetImporter::Options options;
+            };
+
+            struct UploadJob {
+                uint32_t index;
+                uint32_t generation;
+                std::vector<EngineModel::Vertex> vertices;
+                ImportStatistics statistics;
+            };
+
+            struct FinishedLoad {
+                uint32_t index;
+                uint32_t generation;
+                std::unique_ptr<EngineModel> model;
+                ImportStatistics statistics;
+                // empty when the load succeeded
+                std::string error;
+            };
+
+            void ioLoop();
+            void uploadLoop();
+            void finishLoad(FinishedLoad &&finished);
+            Slot *resolve(ModelHandle handle);
+            void createPlaceholder();
+
+            EngineDevice &engineDevice;
+            EngineDeletionQueue &deletionQueue;
+            EngineAssetImporter importer;
+            std::unique_ptr<EngineModel> placeholderModel;
+
+            std::vector<Slot> slots;
+            std::vector<uint32_t> freeSlots;
+            // path hash to slot, the path itself is compared on a hit
+            std::unordered_map<uint64_t, uint32_t> slotsByPath;
+            uint64_t producedFrameCount = 0;
+            uint64_t loadedBytes = 0;
+
+            std::mutex queueMutex;
+            std::condition_variable loadCondition;
+            std::condition_variable uploadCondition;
+            std::deque<LoadJob> loadJobs;
+            std::deque<UploadJob> uploadJobs;
+            std::vector<FinishedLoad> finishedLoads;
+            bool isStopping = false;
+            std::thread ioThread;
+            std::thread uploadThread;
+    };
+}
@@ -0,0 +1,175 @@
+#include "engine_bindless_table.hpp"
+#include "engine_log.hpp"
+
+// std
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <stdexcept>
+
+namespace engine {
+    uint32_t BindlessIndexAllocator::allocate(){
+        if(!this->freeIndices.empty()){
+            uint32_t index = this->freeIndices.back();
+            this->freeIndices.pop_back();
+            return index;
+        }
+        if(this->nextIndex >= this->capacity) throw std::runtime_error("Bindless table is full!");
+        return this->nextIndex++;
+    }
+
+    void BindlessIndexAllocator::release(uint32_t index){
+        assert(index < this->nextIndex && "Releasing a bindless index that was never allocated");
+        this->freeIndices.push_back(index);
+    }
+
+    // Publics
+    EngineBindlessTable::EngineBindlessTable(EngineDevice &device):
+        engineDevice{device},
+        maxTextures{std::min({
+            MAX_TEXTURES,
+            device.descriptorIndexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+            device.descriptorIndexingProperties.maxPerStageDescriptorUpdateAfterBindSamplers
+        })},
+        maxStorageBuffers{std::min(MAX_STORAGE_BUFFERS, device.descriptorIndexingProperties.maxPerStageDescriptorUpdateAfterBindStorageBuffers)},
+        textureIndices{maxTextures},
+        storageBufferIndices{maxStorageBuffers} {
+        ENGINE_LOG_INFO("EngineBindlessTable: Initialising bindless table");
+        this->createDescriptorSetLayout();
+        this->createDescriptorPool();
+        this->allocateDescriptorSet();
+        ENGINE_LOG_INFO("EngineBindlessTable: Successfully initialise bindless table => %u textures, %u storage buffers", this->maxTextures, this->maxStorageBuffers);
+    }
+
+    EngineBindlessTable::~EngineBindlessTable(){
+        // the set is freed together with its pool
+        vkDestroyDescriptorPool(this->engineDevice.device(), this->descriptorPool, nullptr);
+        vkDestroyDescriptorSetLayout(this->engineDevice.device(), this->descriptorSetLayout, nullptr);
+    }
+
+    uint32_t EngineBindlessTable::registerTexture(VkImageView imageView, VkSampler sampler, VkImageLayout imageLayout){
+        uint32_t index = this->textureIndices.allocate();
+        this->updateTexture(index, imageView, sampler, imageLayout);
+        return index;
+    }
+
+    void EngineBindlessTable::updateTexture(uint32_t index, VkImageView imageView, VkSampler sampler, VkImageLayout imageLayout){
+        VkDescriptorImageInfo imageInfo = {};
+        imageInfo.imageView = imageView;
+        imageInfo.sampler = sampler;
+        imageInfo.imageLayout = imageLayout;
+
+        VkWriteDescriptorSet write = this->buildWriteDescriptorSet(TEXTURE_BINDING, index, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+        write.pImageInfo = &imageInfo;
+        vkUpdateDescriptorSets(this->engineDevice.device(), 1, &write, 0, nullptr);
+    }
+
+    void EngineBindlessTable::releaseTexture(uint32_t index){
+        // the stale descriptor stays in place, partially bound arrays allow it as long as nothing samples it
+        this->textureIndices.release(index);
+    }
+
+    uint32_t EngineBindlessTable::registerStorageBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range){
+        uint32_t index = this->storageBufferIndices.allocate();
+        this->updateStorageBuffer(index, buffer, offset, range);
+        return index;
+    }
+
+    void EngineBindlessTable::updateStorageBuffer(uint32_t index, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range){
+        VkDescriptorBufferInfo bufferInfo = {};
+        bufferInfo.buffer = buffer;
+        bufferInfo.offset = offset;
+        bufferInfo.range = range;
+
+        VkWriteDescriptorSet write = this->buildWriteDescriptorSet(STORAGE_BUFFER_BINDING, index, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+        write.pBufferInfo = &bufferInfo;
+        vkUpdateDescriptorSets(this->engineDevice.device(), 1, &write, 0, nullptr);
+    }
+
+    void EngineBindlessTable::releaseStorageBuffer(uint32_t index){
+        this->storageBufferIndices.release(index);
+    }
+
+    void EngineBindlessTable::bind(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, VkPipelineBindPoint bindPoint){
+        vkCmdBindDescriptorSets(commandBuffer, bindPoint, pipelineLayout, 0, 1, &this->descriptorSet, 0, nullptr);
+    }
+
+    void EngineBindlessTable::bind(EngineCommandEncoder &encoder, VkPipelineLayout pipelineLayout, VkPipelineBindPoint bindPoint){
+        encoder.bindDescriptorSet(pipelineLayout, 0, this->descriptorSet, bindPoint);
+    }
+
+    // Privates
+    void EngineBindlessTable::createDescriptorSetLayout(){
+        std::array<VkDescriptorSetLayoutBinding, 2> bindings{};
+        bindings[0].binding = TEXTURE_BINDING;
+        bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        bindings[0].descriptorCount = this->maxTextures;
+        bindings[0].stageFlags = VK_SHADER_STAGE_ALL;
+
+        bindings[1].binding = STORAGE_BUFFER_BINDING;
+        bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[1].descriptorCount = this->maxStorageBuffers;
+        bindings[1].stageFlags = VK_SHADER_STAGE_ALL;
+
+        // slots are written while the set is bound and most of them stay empty
+        VkDescriptorBindingFlagsEXT bindlessFlags = VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT
+            | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT
+            | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT;
+        std::array<VkDescriptorBindingFlagsEXT, 2> bindingFlags = {bindlessFlags, bindlessFlags};
+
+        VkDescriptorSetLayoutBindingFlagsCreateInfoEXT bindingFlagsCreateInfo = {};
+        bindingFlagsCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+        bindingFlagsCreateInfo.bindingCount = static_cast<uint32_t>(bindingFlags.size());
+        bindingFlagsCreateInfo.pBindingFlags = bindingFlags.data();
+
+        VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo = {};
+        descriptorSetLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        descriptorSetLayoutCreateInfo.pNext = &bindingFlagsCreateInfo;
+        descriptorSetLayoutCreateInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+        descriptorSetLayoutCreateInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+        descriptorSetLayoutCreateInfo.pBindings = bindings.data();
+
+        bool isCreateDescriptorSetLayoutSuccess = vkCreateDescriptorSetLayout(this->engineDevice.device(), &descriptorSetLayoutCreateInfo, nullptr, &this->descriptorSetLayout) == VK_SUCCESS;
+        if(!isCreateDescriptorSetLayoutSuccess) throw std::runtime_error("Failed to create bindless descriptor set layout!");
+    }
+
+    void EngineBindlessTable::createDescriptorPool(){
+        std::array<VkDescriptorPoolSize, 2> poolSizes{};
+        poolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        poolSizes[0].descriptorCount = this->maxTextures;
+        poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        poolSizes[1].descriptorCount = this->maxStorageBuffers;
+
+        VkDescriptorPoolCreateInfo descriptorPoolCreateInfo = {};
+        descriptorPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        descriptorPoolCreateInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+        descriptorPoolCreateInfo.maxSets = 1;
+        descriptorPoolCreateInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+        descriptorPoolCreateInfo.pPoolSizes = poolSizes.data();
+
+        bool isCreateDescriptorPoolSuccess = vkCreateDescriptorPool(this->engineDevice.device(), &descriptorPoolCreateInfo, nullptr, &this->descriptorPool) == VK_SUCCESS;
+        if(!isCreateDescriptorPoolSuccess) throw std::runtime_error("Failed to create bindless descriptor pool!");
+    }
+
+    void EngineBindlessTable::allocateDescriptorSet(){
+        VkDescriptorSetAllocateInfo descriptorSetAllocateInfo = {};
+        descriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        descriptorSetAllocateInfo.descriptorPool = this->descriptorPool;
+        descriptorSetAllocateInfo.descriptorSetCount = 1;
+        descriptorSetAllocateInfo.pSetLayouts = &this->descriptorSetLayout;
+
+        bool isAllocateDescriptorSetSuccess = vkAllocateDescriptorSets(this->engineDevice.device(), &descriptorSetAllocateInfo, &this->descriptorSet) == VK_SUCCESS;
+        if(!isAllocateDescriptorSetSuccess) throw std::runtime_error("Failed to allocate bindless descriptor set!");
+    }
+
+    VkWriteDescriptorSet EngineBindlessTable::buildWriteDescriptorSet(uint32_t binding, uint32_t arrayElement, VkDescriptorType descriptorType){
+        VkWriteDescriptorSet write = {};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = this->descriptorSet;
+        write.dstBinding = binding;
+        write.dstArrayElement = arrayElement;
+        write.descriptorCount = 1;
+        write.descriptorType = descriptorType;
+        return write;
+    }
+}
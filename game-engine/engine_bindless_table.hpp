@@ -0,0 +1,88 @@
+#pragma once
+#include "engine_device.hpp"
+#include "engine_command_encoder.hpp"
+
+// std
+#include <vector>
+
+namespace engine {
+    // Hands out stable slots in a bindless array, recycling released slots before growing
+    class BindlessIndexAllocator {
+        public:
+            explicit BindlessIndexAllocator(uint32_t capacity): capacity{capacity} {}
+
+            uint32_t allocate();
+            void release(uint32_t index);
+
+            uint32_t size() const {
+                return this->nextIndex - static_cast<uint32_t>(this->freeIndices.size());
+            }
+
+        private:
+            uint32_t capacity;
+            uint32_t nextIndex = 0;
+            std::vector<uint32_t> freeIndices;
+    };
+
+    // One descriptor set holding every sampled image and storage buffer the renderer knows about.
+    // The set is bound once per command buffer and resources are addressed by integer index,
+    // typically passed through push constants, so a single pipeline can draw any material.
+    class EngineBindlessTable {
+        public:
+            static constexpr uint32_t INVALID_INDEX = ~0u;
+            static constexpr uint32_t TEXTURE_BINDING = 0;
+            static constexpr uint32_t STORAGE_BUFFER_BINDING = 1;
+            static constexpr uint32_t MAX_TEXTURES = 4096;
+            static constexpr uint32_t MAX_STORAGE_BUFFERS = 1024;
+
+            EngineBindlessTable(EngineDevice &device);
+            ~EngineBindlessTable();
+
+            EngineBindlessTable(const EngineBindlessTable &) = delete;
+            EngineBindlessTable &operator = (const EngineBindlessTable &) = delete;
+
+            VkDescriptorSetLayout getDescriptorSetLayout(){
+                return this->descriptorSetLayout;
+            }
+            VkDescriptorSet getDescriptorSet(){
+                return this->descriptorSet;
+            }
+            uint32_t textureCount() const {
+                return this->textureIndices.size();
+            }
+            uint32_t storageBufferCount() const {
+                return this->storageBufferIndices.size();
+            }
+
+            // Slots may be written while the set is bound in a pending command buffer,
+            // as long as the shader does not read the slot being replaced
+            uint32_t registerTexture(VkImageView imageView, VkSampler sampler, VkImageLayout imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+            void updateTexture(uint32_t index, VkImageView imageView, VkSampler sampler, VkImageLayout imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+            void releaseTexture(uint32_t index);
+
+            uint32_t registerStorageBuffer(VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+            void updateStorageBuffer(uint32_t index, VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+            void releaseStorageBuffer(uint32_t index);
+
+            void bind(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, VkPipelineBindPoint bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS);
+            void bind(EngineCommandEncoder &encoder, VkPipelineLayout pipelineLayout, VkPipelineBindPoint bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS);
+
+        private:
+            void createDescriptorSetLayout();
+            void createDescriptorPool();
+            void allocateDescriptorSet();
+
+            VkWriteDescriptorSet buildWriteDescriptorSet(uint32_t binding, uint32_t arrayElement, VkDescriptorType descriptorType);
+
+            EngineDevice &engineDevice;
+            uint32_t maxTextures;
+            uint32_t maxStorageBuffers;
+
+            VkDescriptorSetLayout descriptorSetLayout;
+            VkDescriptorPool descriptorPool;
+            VkDescriptorSet descriptorSet;
+
+            BindlessIndexAllocator textureIndices;
+            BindlessIndexAllocator storageBufferIndices;
+    };
+}
@@ -0,0 +1,98 @@
+#include "engine_command_encoder.hpp"
+
+// std
+#include <cassert>
+#include <cstring>
+
+namespace engine {
+    EngineCommandEncoder::EngineCommandEncoder(VkCommandBuffer commandBuffer){
+        this->begin(commandBuffer);
+    }
+
+    // Publics
+    void EngineCommandEncoder::begin(VkCommandBuffer commandBuffer){
+        this->commandBuffer = commandBuffer;
+        this->statistics = {};
+        this->invalidate();
+    }
+
+    void EngineCommandEncoder::invalidate(){
+        this->pipelines.fill(VK_NULL_HANDLE);
+        for(auto &sets:this->descriptorSets) sets.fill(DescriptorSetState{VK_NULL_HANDLE, VK_NULL_HANDLE});
+        this->vertexBuffers.fill(VertexBufferState{VK_NULL_HANDLE, 0});
+        this->indexBuffer = VK_NULL_HANDLE;
+        this->indexOffset = 0;
+        this->indexType = VK_INDEX_TYPE_UINT16;
+        this->pushConstantLayout = VK_NULL_HANDLE;
+        this->pushConstantStages.fill(0);
+    }
+
+    void EngineCommandEncoder::bindPipeline(VkPipeline pipeline, VkPipelineBindPoint bindPoint){
+        VkPipeline &bound = this->pipelines[bindPointIndex(bindPoint)];
+        if(this->isRedundant(bound == pipeline)) return;
+        vkCmdBindPipeline(this->commandBuffer, bindPoint, pipeline);
+        bound = pipeline;
+    }
+
+    void EngineCommandEncoder::bindDescriptorSet(VkPipelineLayout pipelineLayout, uint32_t set, VkDescriptorSet descriptorSet, VkPipelineBindPoint bindPoint){
+        assert(set < MAX_DESCRIPTOR_SETS && "Descriptor set index out of range");
+        DescriptorSetState &bound = this->descriptorSets[bindPointIndex(bindPoint)][set];
+        if(this->isRedundant(bound.pipelineLayout == pipelineLayout && bound.descriptorSet == descriptorSet)) return;
+        vkCmdBindDescriptorSets(this->commandBuffer, bindPoint, pipelineLayout, set, 1, &descriptorSet, 0, nullptr);
+        bound = {pipelineLayout, descriptorSet};
+    }
+
+    void EngineCommandEncoder::bindVertexBuffer(uint32_t binding, VkBuffer buffer, VkDeviceSize offset){
+        assert(binding < MAX_VERTEX_BINDINGS && "Vertex binding out of range");
+        VertexBufferState &bound = this->vertexBuffers[binding];
+        if(this->isRedundant(bound.buffer == buffer && bound.offset == offset)) return;
+        vkCmdBindVertexBuffers(this->commandBuffer, binding, 1, &buffer, &offset);
+        bound = {buffer, offset};
+    }
+
+    void EngineCommandEncoder::bindIndexBuffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType){
+        bool isSame = this->indexBuffer == buffer && this->indexOffset == offset && this->indexType == indexType;
+        if(this->isRedundant(isSame)) return;
+        vkCmdBindIndexBuffer(this->commandBuffer, buffer, offset, indexType);
+        this->indexBuffer = buffer;
+        this->indexOffset = offset;
+        this->indexType = indexType;
+    }
+
+    void EngineCommandEncoder::pushConstants(VkPipelineLayout pipelineLayout, VkShaderStageFlags stageFlags, uint32_t offset, uint32_t size, const void *values){
+        assert(offset + size <= MAX_PUSH_CONSTANT_SIZE && "Push constant range out of range");
+        // a different layout leaves nothing known about the values
+        if(this->pushConstantLayout != pipelineLayout){
+            this->pushConstantStages.fill(0);
+            this->pushConstantLayout = pipelineLayout;
+        }
+
+        const uint8_t *bytes = static_cast<const uint8_t *>(values);
+        bool isSame = memcmp(this->pushConstantData.data() + offset, bytes, size) == 0;
+        for(uint32_t i = offset; i < offset + size && isSame; i++) isSame = this->pushConstantStages[i] == stageFlags;
+        if(this->isRedundant(isSame)) return;
+
+        vkCmdPushConstants(this->commandBuffer, pipelineLayout, stageFlags, offset, size, values);
+        memcpy(this->pushConstantData.data() + offset, bytes, size);
+        for(uint32_t i = offset; i < offset + size; i++) this->pushConstantStages[i] = stageFlags;
+    }
+
+    void EngineCommandEncoder::draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance){
+        vkCmdDraw(this->commandBuffer, vertexCount, instanceCount, firstVertex, firstInstance);
+    }
+
+    void EngineCommandEncoder::drawIndirect(VkBuffer buffer, VkDeviceSize offset, uint32_t drawCount, uint32_t stride){
+        vkCmdDrawIndirect(this->commandBuffer, buffer, offset, drawCount, stride);
+    }
+
+    // Privates
+    uint32_t EngineCommandEncoder::bindPointIndex(VkPipelineBindPoint bindPoint){
+        return bindPoint == VK_PIPELINE_BIND_POINT_COMPUTE ? 1 : 0;
+    }
+
+    bool EngineCommandEncoder::isRedundant(bool isSame){
+        if(isSame) this->statistics.eliminatedBinds++;
+        else this->statistics.issuedBinds++;
+        return isSame;
+    }
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include "engine_device.hpp"
+
+// std
+#include <array>
+#include <cstdint>
+
+namespace engine {
+    struct CommandEncoderStatistics {
+        // pipelines, descriptor sets, vertex and index buffers and push constants recorded
+        uint32_t issuedBinds = 0;
+        // dropped because the command buffer already had exactly that state
+        uint32_t eliminatedBinds = 0;
+    };
+
+    // Records state changes into a command buffer only when they change something. The pipelines,
+    // descriptor sets, vertex and index buffers and push constants bound through the encoder are
+    // remembered, and binding the same state again records nothing, so callers can bind everything
+    // a draw needs before every draw and leave it to the encoder to drop what is already bound.
+    //
+    // The encoder only knows what went through it. Anything recorded into the command buffer
+    // directly, a compute dispatch or another subsystem's draws, has to be followed by invalidate.
+    // Pipelines bound through it are expected to share the pipeline layouts the descriptor sets and
+    // push constants were recorded with, as the bindless pipelines all do.
+    //
+    // One encoder per command buffer, it is not thread safe.
+    class EngineCommandEncoder {
+        public:
+            static constexpr uint32_t MAX_VERTEX_BINDINGS = 4;
+            static constexpr uint32_t MAX_DESCRIPTOR_SETS = 4;
+            // the smallest maxPushConstantsSize the spec allows
+            static constexpr uint32_t MAX_PUSH_CONSTANT_SIZE = 128;
+
+            explicit EngineCommandEncoder(VkCommandBuffer commandBuffer = VK_NULL_HANDLE);
+
+            EngineCommandEncoder(const EngineCommandEncoder &) = delete;
+            EngineCommandEncoder &operator = (const EngineCommandEncoder &) = delete;
+
+            // Starts tracking a freshly begun command buffer and resets the statistics
+            void begin(VkCommandBuffer commandBuffer);
+            // Forgets every bound state, the next bind of each kind is recorded whatever it is
+            void invalidate();
+
+            void bindPipeline(VkPipeline pipeline, VkPipelineBindPoint bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS);
+            void bindDescriptorSet(VkPipelineLayout pipelineLayout, uint32_t set, VkDescriptorSet descriptorSet, VkPipelineBindPoint bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS);
+            void bindVertexBuffer(uint32_t binding, VkBuffer buffer, VkDeviceSize offset = 0);
+            void bindIndexBuffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType);
+            // Compared byte for byte with what the same range last received
+            void pushConstants(VkPipelineLayout pipelineLayout, VkShaderStageFlags stageFlags, uint32_t offset, uint32_t size, const void *values);
+
+            void draw(uint32_t vertexCount, uint32_t instanceCount = 1, uint32_t firstVertex = 0, uint32_t firstInstance = 0);
+            void drawIndirect(VkBuffer buffer, VkDeviceSize offset, uint32_t drawCount = 1, uint32_t stride = sizeof(VkDrawIndirectCommand));
+
+            VkCommandBuffer getCommandBuffer() const {
+                return this->commandBuffer;
+            }
+            // Since begin
+            const CommandEncoderStatistics &getStatistics() const {
+                return this->statistics;
+            }
+
+        private:
+            struct DescriptorSetState {
+                VkPipelineLayout pipelineLayout;
+                VkDescriptorSet descriptorSet;
+            };
+
+            struct VertexBufferState {
+                VkBuffer buffer;
+                VkDeviceSize offset;
+            };
+
+            // graphics and compute keep separate pipelines and descriptor sets
+            static uint32_t bindPointIndex(VkPipelineBindPoint bindPoint);
+            // counts the bind and returns whether it can be dropped
+            bool isRedundant(bool isSame);
+
+            VkCommandBuffer commandBuffer;
+            std::array<VkPipeline, 2> pipelines;
+            std::array<std::array<DescriptorSetState, MAX_DESCRIPTOR_SETS>, 2> descriptorSets;
+            std::array<VertexBufferState, MAX_VERTEX_BINDINGS> vertexBuffers;
+            VkBuffer indexBuffer;
+            VkDeviceSize indexOffset;
+            VkIndexType indexType;
+
+            // what was last pushed into every byte of the push constant range, per byte so partial
+            // updates of different stages and offsets are compared correctly
+            VkPipelineLayout pushConstantLayout;
+            std::array<uint8_t, MAX_PUSH_CONSTANT_SIZE> pushConstantData{};
+            std::array<VkShaderStageFlags, MAX_PUSH_CONSTANT_SIZE> pushConstantStages;
+
+            CommandEncoderStatistics statistics;
+    };
+}
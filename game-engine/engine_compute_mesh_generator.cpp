@@ -0,0 +1,206 @@
+#include "engine_compute_mesh_generator.hpp"
+#include "engine_log.hpp"
+#include "engine_pipeline.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+namespace engine {
+    // Publics
+    EngineComputeMeshGenerator::EngineComputeMeshGenerator(EngineDevice &device, const std::string &computeFilePath, uint32_t parametersSize, uint32_t frameCount):
+        engineDevice{device}, parametersSize{parametersSize}, frameCount{frameCount}, submittedRequests(frameCount){
+        assert(parametersSize <= MAX_PARAMETERS_SIZE && "Generator parameters do not fit in push constants");
+        ENGINE_LOG_INFO("EngineComputeMeshGenerator: Initialising %s...", computeFilePath.c_str());
+        this->createDescriptorSetLayout();
+        this->createDescriptorSets();
+        this->createPipelineLayout();
+        this->createPipeline(computeFilePath);
+        this->createTimestampQueryPool();
+    }
+
+    EngineComputeMeshGenerator::~EngineComputeMeshGenerator(){
+        if(this->timestampQueryPool != VK_NULL_HANDLE) vkDestroyQueryPool(this->engineDevice.device(), this->timestampQueryPool, nullptr);
+        vkDestroyPipeline(this->engineDevice.device(), this->pipeline, nullptr);
+        vkDestroyPipelineLayout(this->engineDevice.device(), this->pipelineLayout, nullptr);
+        vkDestroyDescriptorPool(this->engineDevice.device(), this->descriptorPool, nullptr);
+        vkDestroyDescriptorSetLayout(this->engineDevice.device(), this->descriptorSetLayout, nullptr);
+    }
+
+    double EngineComputeMeshGenerator::generateNow(EngineModel &model, const void *parameters, uint32_t invocationCount){
+        Request request = {&model, {}, invocationCount, {}};
+        memcpy(request.parameters.data(), parameters, this->parametersSize);
+
+        VkCommandBuffer commandBuffer = this->engineDevice.beginSingleTimeCommands();
+        if(this->timestampQueryPool != VK_NULL_HANDLE){
+            vkCmdResetQueryPool(commandBuffer, this->timestampQueryPool, 0, 2);
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, this->timestampQueryPool, 0);
+        }
+        this->recordDispatch(commandBuffer, this->descriptorSets.back(), request);
+        if(this->timestampQueryPool != VK_NULL_HANDLE){
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, this->timestampQueryPool, 1);
+        }
+        this->engineDevice.endSingleTimeCommands(commandBuffer);
+
+        if(this->timestampQueryPool == VK_NULL_HANDLE) return -1.0;
+        uint64_t timestamps[2];
+        bool isGetQueryResultsSuccess = vkGetQueryPoolResults(
+            this->engineDevice.device(),
+            this->timestampQueryPool,
+            0,
+            2,
+            sizeof(timestamps),
+            timestamps,
+            sizeof(uint64_t),
+            VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT
+        ) == VK_SUCCESS;
+        if(!isGetQueryResultsSuccess) return -1.0;
+        double nanoseconds = static_cast<double>(timestamps[1] - timestamps[0]) * this->engineDevice.properties.limits.timestampPeriod;
+        return nanoseconds / 1000000.0;
+    }
+
+    std::future<void> EngineComputeMeshGenerator::request(EngineModel &model, const void *parameters, uint32_t invocationCount){
+        Request request = {&model, {}, invocationCount, {}};
+        memcpy(request.parameters.data(), parameters, this->parametersSize);
+        std::future<void> completion = request.completion.get_future();
+
+        std::lock_guard<std::mutex> lock(this->requestsMutex);
+        this->pendingRequests.push_back(std::move(request));
+        return completion;
+    }
+
+    void EngineComputeMeshGenerator::recordRequests(VkCommandBuffer commandBuffer, size_t frameIndex){
+        std::vector<Request> &submitted = this->submittedRequests[frameIndex];
+        for(Request &request:submitted) request.completion.set_value();
+        submitted.clear();
+
+        {
+            std::lock_guard<std::mutex> lock(this->requestsMutex);
+            if(this->pendingRequests.empty()) return;
+            // the rest waits for the next frame, the descriptor sets of this slot are all taken
+            size_t count = std::min<size_t>(this->pendingRequests.size(), MAX_REQUESTS_PER_FRAME);
+            std::move(this->pendingRequests.begin(), this->pendingRequests.begin() + count, std::back_inserter(submitted));
+            this->pendingRequests.erase(this->pendingRequests.begin(), this->pendingRequests.begin() + count);
+        }
+
+        for(size_t i = 0; i < submitted.size(); i++){
+            this->recordDispatch(commandBuffer, this->descriptorSets[frameIndex * MAX_REQUESTS_PER_FRAME + i], submitted[i]);
+        }
+    }
+
+    // Privates
+    void EngineComputeMeshGenerator::createDescriptorSetLayout(){
+        std::array<VkDescriptorSetLayoutBinding, 2> bindings = {};
+        for(uint32_t i = 0; i < bindings.size(); i++){
+            bindings[i].binding = i;
+            bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            bindings[i].descriptorCount = 1;
+            bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        }
+
+        VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo = {};
+        descriptorSetLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        descriptorSetLayoutCreateInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+        descriptorSetLayoutCreateInfo.pBindings = bindings.data();
+        bool isCreateDescriptorSetLayoutSuccess = vkCreateDescriptorSetLayout(this->engineDevice.device(), &descriptorSetLayoutCreateInfo, nullptr, &this->descriptorSetLayout) == VK_SUCCESS;
+        if(!isCreateDescriptorSetLayoutSuccess) throw std::runtime_error("Failed to create mesh generator descriptor set layout!");
+    }
+
+    void EngineComputeMeshGenerator::createDescriptorSets(){
+        uint32_t setCount = this->frameCount * MAX_REQUESTS_PER_FRAME + 1;
+
+        VkDescriptorPoolSize poolSize = {};
+        poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        poolSize.descriptorCount = setCount * 2;
+
+        VkDescriptorPoolCreateInfo descriptorPoolCreateInfo = {};
+        descriptorPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        descriptorPoolCreateInfo.maxSets = setCount;
+        descriptorPoolCreateInfo.poolSizeCount = 1;
+        descriptorPoolCreateInfo.pPoolSizes = &poolSize;
+        bool isCreateDescriptorPoolSuccess = vkCreateDescriptorPool(this->engineDevice.device(), &descriptorPoolCreateInfo, nullptr, &this->descriptorPool) == VK_SUCCESS;
+        if(!isCreateDescriptorPoolSuccess) throw std::runtime_error("Failed to create mesh generator descriptor pool!");
+
+        std::vector<VkDescriptorSetLayout> layouts(setCount, this->descriptorSetLayout);
+        VkDescriptorSetAllocateInfo descriptorSetAllocateInfo = {};
+        descriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        descriptorSetAllocateInfo.descriptorPool = this->descriptorPool;
+        descriptorSetAllocateInfo.descriptorSetCount = setCount;
+        descriptorSetAllocateInfo.pSetLayouts = layouts.data();
+        this->descriptorSets.resize(setCount);
+        bool isAllocateDescriptorSetsSuccess = vkAllocateDescriptorSets(this->engineDevice.device(), &descriptorSetAllocateInfo, this->descriptorSets.data()) == VK_SUCCESS;
+        if(!isAllocateDescriptorSetsSuccess) throw std::runtime_error("Failed to allocate mesh generator descriptor sets!");
+    }
+
+    void EngineComputeMeshGenerator::createPipelineLayout(){
+        VkPushConstantRange pushConstantRange = {};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = this->parametersSize;
+
+        VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
+        pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutCreateInfo.setLayoutCount = 1;
+        pipelineLayoutCreateInfo.pSetLayouts = &this->descriptorSetLayout;
+        pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+        pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+        bool isCreatePipelineLayoutSuccess = vkCreatePipelineLayout(this->engineDevice.device(), &pipelineLayoutCreateInfo, nullptr, &this->pipelineLayout) == VK_SUCCESS;
+        if(!isCreatePipelineLayoutSuccess) throw std::runtime_error("Failed to create mesh generator pipeline layout!");
+    }
+
+    void EngineComputeMeshGenerator::createPipeline(const std::string &computeFilePath){
+        this->pipeline = EnginePipeline::createComputePipeline(this->engineDevice, computeFilePath, this->pipelineLayout);
+    }
+
+    void EngineComputeMeshGenerator::createTimestampQueryPool(){
+        if(!this->engineDevice.properties.limits.timestampComputeAndGraphics) return;
+
+        VkQueryPoolCreateInfo queryPoolCreateInfo = {};
+        queryPoolCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryPoolCreateInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        queryPoolCreateInfo.queryCount = 2;
+        bool isCreateQueryPoolSuccess = vkCreateQueryPool(this->engineDevice.device(), &queryPoolCreateInfo, nullptr, &this->timestampQueryPool) == VK_SUCCESS;
+        if(!isCreateQueryPoolSuccess) throw std::runtime_error("Failed to create mesh generator timestamp query pool!");
+    }
+
+    void EngineComputeMeshGenerator::recordDispatch(VkCommandBuffer commandBuffer, VkDescriptorSet descriptorSet, const Request &request){
+        // the set's previous dispatch has completed, so it can be rewritten at record time
+        VkDescriptorBufferInfo vertexBufferInfo = {request.model->getVertexBuffer(), 0, VK_WHOLE_SIZE};
+        VkDescriptorBufferInfo indirectBufferInfo = {request.model->getIndirectBuffer(), 0, VK_WHOLE_SIZE};
+        std::array<VkWriteDescriptorSet, 2> writes = {};
+        for(uint32_t i = 0; i < writes.size(); i++){
+            writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[i].dstSet = descriptorSet;
+            writes[i].dstBinding = i;
+            writes[i].descriptorCount = 1;
+            writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        }
+        writes[0].pBufferInfo = &vertexBufferInfo;
+        writes[1].pBufferInfo = &indirectBufferInfo;
+        vkUpdateDescriptorSets(this->engineDevice.device(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, this->pipeline);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, this->pipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+        vkCmdPushConstants(commandBuffer, this->pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, this->parametersSize, request.parameters.data());
+        // at least one group, invocation 0 writes the indirect command
+        uint32_t groupCount = std::max((request.invocationCount + LOCAL_SIZE - 1) / LOCAL_SIZE, 1u);
+        vkCmdDispatch(commandBuffer, groupCount, 1, 1);
+
+        VkMemoryBarrier memoryBarrier = {};
+        memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        memoryBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+            0,
+            1, &memoryBarrier,
+            0, nullptr,
+            0, nullptr
+        );
+    }
+}
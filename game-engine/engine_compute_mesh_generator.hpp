@@ -0,0 +1,75 @@
+#pragma once
+#include "engine_device.hpp"
+#include "engine_model.hpp"
+
+// std
+#include <array>
+#include <cstdint>
+#include <future>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace engine {
+    // Runs a compute shader that writes a mesh straight into the device local buffers of a generated
+    // EngineModel, without the vertices ever existing on the CPU. The shader gets the vertex buffer
+    // at binding 0, the model's VkDrawIndirectCommand at binding 1 and its parameters as push
+    // constants, and is dispatched with one invocation per primitive in groups of LOCAL_SIZE.
+    class EngineComputeMeshGenerator {
+        public:
+            static constexpr uint32_t LOCAL_SIZE = 64;
+            // the smallest maxPushConstantsSize the spec guarantees
+            static constexpr uint32_t MAX_PARAMETERS_SIZE = 128;
+            static constexpr uint32_t MAX_REQUESTS_PER_FRAME = 4;
+
+            EngineComputeMeshGenerator(EngineDevice &device, const std::string &computeFilePath, uint32_t parametersSize, uint32_t frameCount);
+            ~EngineComputeMeshGenerator();
+
+            EngineComputeMeshGenerator(const EngineComputeMeshGenerator &) = delete;
+            EngineComputeMeshGenerator &operator = (const EngineComputeMeshGenerator &) = delete;
+
+            // Generates and waits on the graphics queue, only while nothing else submits to it.
+            // Returns the GPU time of the dispatch in milliseconds, negative without timestamp support.
+            double generateNow(EngineModel &model, const void *parameters, uint32_t invocationCount);
+
+            // From any thread, the dispatch is recorded by the next recordRequests and the future is
+            // ready once it has completed on the GPU. Destroying the generator breaks pending futures.
+            std::future<void> request(EngineModel &model, const void *parameters, uint32_t invocationCount);
+
+            // Records up to MAX_REQUESTS_PER_FRAME requests outside of a render pass. The previous
+            // submission of this frame slot must have completed, its requests are resolved here.
+            void recordRequests(VkCommandBuffer commandBuffer, size_t frameIndex);
+
+        private:
+            struct Request {
+                EngineModel *model;
+                std::array<unsigned char, MAX_PARAMETERS_SIZE> parameters;
+                uint32_t invocationCount;
+                std::promise<void> completion;
+            };
+
+            void createDescriptorSetLayout();
+            void createDescriptorSets();
+            void createPipelineLayout();
+            void createPipeline(const std::string &computeFilePath);
+            void createTimestampQueryPool();
+            void recordDispatch(VkCommandBuffer commandBuffer, VkDescriptorSet descriptorSet, const Request &request);
+
+            EngineDevice &engineDevice;
+            uint32_t parametersSize;
+            uint32_t frameCount;
+
+            VkDescriptorSetLayout descriptorSetLayout;
+            VkDescriptorPool descriptorPool;
+            // MAX_REQUESTS_PER_FRAME per frame slot, then one for generateNow
+            std::vector<VkDescriptorSet> descriptorSets;
+            VkPipelineLayout pipelineLayout;
+            VkPipeline pipeline;
+            VkQueryPool timestampQueryPool = VK_NULL_HANDLE;
+
+            std::mutex requestsMutex;
+            std::vector<Request> pendingRequests;
+            // recorded into each frame slot's last submission, resolved when the slot comes round again
+            std::vector<std::vector<Request>> submittedRequests;
+    };
+}
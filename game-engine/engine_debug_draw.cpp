@@ -0,0 +1,378 @@
+#include "engine_debug_draw.hpp"
+
+#if ENGINE_DEBUG_DRAW
+#include "engine_log.hpp"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+
+namespace engine {
+    // one row per byte, the highest of the five bits is the leftmost pixel
+    struct Glyph {
+        char character;
+        uint8_t rows[EngineDebugDraw::GLYPH_HEIGHT];
+    };
+
+    static const Glyph FONT[] = {
+        {'0', {0b01110, 0b10001, 0b10011, 0b10101, 0b11001, 0b10001, 0b01110}},
+        {'1', {0b00100, 0b01100, 0b00100, 0b00100, 0b00100, 0b00100, 0b01110}},
+        {'2', {0b01110, 0b10001, 0b00001, 0b00010, 0b00100, 0b01000, 0b11111}},
+        {'3', {0b11111, 0b00010, 0b00100, 0b00010, 0b00001, 0b10001, 0b01110}},
+        {'4', {0b00010, 0b00110, 0b01010, 0b10010, 0b11111, 0b00010, 0b00010}},
+        {'5', {0b11111, 0b10000, 0b11110, 0b00001, 0b00001, 0b10001, 0b01110}},
+        {'6', {0b00110, 0b01000, 0b10000, 0b11110, 0b10001, 0b10001, 0b01110}},
+        {'7', {0b11111, 0b00001, 0b00010, 0b00100, 0b01000, 0b01000, 0b01000}},
+        {'8', {0b01110, 0b10001, 0b10001, 0b01110, 0b10001, 0b10001, 0b01110}},
+        {'9', {0b01110, 0b10001, 0b10001, 0b01111, 0b00001, 0b00010, 0b01100}},
+        {'A', {0b01110, 0b10001, 0b10001, 0b11111, 0b10001, 0b10001, 0b10001}},
+        {'B', {0b11110, 0b10001, 0b10001, 0b11110, 0b10001, 0b10001, 0b11110}},
+        {'C', {0b01110, 0b10001, 0b10000, 0b10000, 0b10000, 0b10001, 0b01110}},
+        {'D', {0b11100, 0b10010, 0b10001, 0b10001, 0b10001, 0b10010, 0b11100}},
+        {'E', {0b11111, 0b10000, 0b10000, 0b11110, 0b10000, 0b10000, 0b11111}},
+        {'F', {0b11111, 0b10000, 0b10000, 0b11110, 0b10000, 0b10000, 0b10000}},
+        {'G', {0b01110, 0b10001, 0b10000, 0b10111, 0b10001, 0b10001, 0b01111}},
+        {'H', {0b10001, 0b10001, 0b10001, 0b11111, 0b10001, 0b10001, 0b10001}},
+        {'I', {0b01110, 0b00100, 0b00100, 0b00100, 0b00100, 0b00100, 0b01110}},
+        {'J', {0b00111, 0b00010, 0b00010, 0b00010, 0b00010, 0b10010, 0b01100}},
+        {'K', {0b10001, 0b10010, 0b10100, 0b11000, 0b10100, 0b10010, 0b10001}},
+        {'L', {0b10000, 0b10000, 0b10000, 0b10000, 0b10000, 0b10000, 0b11111}},
+        {'M', {0b10001, 0b11011, 0b10101, 0b10101, 0b10001, 0b10001, 0b10001}},
+        {'N', {0b10001, 0b10001, 0b11001, 0b10101, 0b10011, 0b10001, 0b10001}},
+        {'O', {0b01110, 0b10001, 0b10001, 0b10001, 0b10001, 0b10001, 0b01110}},
+        {'P', {0b11110, 0b10001, 0b10001, 0b11110, 0b10000, 0b10000, 0b10000}},
+        {'Q', {0b01110, 0b10001, 0b10001, 0b10001, 0b10101, 0b10010, 0b01101}},
+        {'R', {0b11110, 0b10001, 0b10001, 0b11110, 0b10100, 0b10010, 0b10001}},
+        {'S', {0b01111, 0b10000, 0b10000, 0b01110, 0b00001, 0b00001, 0b11110}},
+        {'T', {0b11111, 0b00100, 0b00100, 0b00100, 0b00100, 0b00100, 0b00100}},
+        {'U', {0b10001, 0b10001, 0b10001, 0b10001, 0b10001, 0b10001, 0b01110}},
+        {'V', {0b10001, 0b10001, 0b10001, 0b10001, 0b10001, 0b01010, 0b00100}},
+        {'W', {0b10001, 0b10001, 0b10001, 0b10101, 0b10101, 0b10101, 0b01010}},
+        {'X', {0b10001, 0b10001, 0b01010, 0b00100, 0b01010, 0b10001, 0b10001}},
+        {'Y', {0b10001, 0b10001, 0b10001, 0b01010, 0b00100, 0b00100, 0b00100}},
+        {'Z', {0b11111, 0b00001, 0b00010, 0b00100, 0b01000, 0b10000, 0b11111}},
+        {'.', {0b00000, 0b00000, 0b00000, 0b00000, 0b00000, 0b01100, 0b01100}},
+        {',', {0b00000, 0b00000, 0b00000, 0b00000, 0b01100, 0b00100, 0b01000}},
+        {':', {0b00000, 0b01100, 0b01100, 0b00000, 0b01100, 0b01100, 0b00000}},
+        {'-', {0b00000, 0b00000, 0b00000, 0b11111, 0b00000, 0b00000, 0b00000}},
+        {'+', {0b00000, 0b00100, 0b00100, 0b11111, 0b00100, 0b00100, 0b00000}},
+        {'=', {0b00000, 0b00000, 0b11111, 0b00000, 0b11111, 0b00000, 0b00000}},
+        {'_', {0b00000, 0b00000, 0b00000, 0b00000, 0b00000, 0b00000, 0b11111}},
+        {'/', {0b00000, 0b00001, 0b00010, 0b00100, 0b01000, 0b10000, 0b00000}},
+        {'%', {0b11000, 0b11001, 0b00010, 0b00100, 0b01000, 0b10011, 0b00011}},
+        {'(', {0b00010, 0b00100, 0b01000, 0b01000, 0b01000, 0b00100, 0b00010}},
+        {')', {0b01000, 0b00100, 0b00010, 0b00010, 0b00010, 0b00100, 0b01000}},
+        {'|', {0b00100, 0b00100, 0b00100, 0b00100, 0b00100, 0b00100, 0b00100}},
+    };
+
+    // printable ASCII from space to DEL, which is the solid cell
+    static constexpr uint32_t FIRST_CHARACTER = 32;
+    static constexpr uint32_t SOLID_CHARACTER = 127;
+    static constexpr uint32_t ATLAS_COLUMNS = 16;
+    static constexpr uint32_t ATLAS_ROWS = 6;
+    static constexpr uint32_t CELL_WIDTH = EngineDebugDraw::GLYPH_ADVANCE;
+    static constexpr uint32_t CELL_HEIGHT = EngineDebugDraw::LINE_ADVANCE;
+    static constexpr uint32_t ATLAS_WIDTH = ATLAS_COLUMNS * CELL_WIDTH;
+    static constexpr uint32_t ATLAS_HEIGHT = ATLAS_ROWS * CELL_HEIGHT;
+
+    // Utilities
+    static uint32_t packColor(const glm::vec4 &color){
+        uint32_t packed = 0;
+        for(int i = 0; i < 4; i++){
+            float channel = std::min(std::max(color[i], 0.0f), 1.0f);
+            packed |= static_cast<uint32_t>(std::lround(channel * 255.0f)) << (8 * i);
+        }
+        return packed;
+    }
+
+    static glm::vec2 cellOrigin(uint32_t character){
+        uint32_t cell = character - FIRST_CHARACTER;
+        return {static_cast<float>(cell % ATLAS_COLUMNS * CELL_WIDTH), static_cast<float>(cell / ATLAS_COLUMNS * CELL_HEIGHT)};
+    }
+
+    // Publics
+    EngineDebugDraw::EngineDebugDraw(EngineDevice &device, EngineBindlessTable &bindlessTable, EnginePipelineCache &pipelineCache, EngineSwapChain &swapChain, uint32_t frameCount):
+        engineDevice{device},
+        bindlessTable{bindlessTable},
+        pipelineCache{pipelineCache},
+        engineSwapChain{swapChain},
+        vertexStream{device, MAX_VERTICES * sizeof(Vertex), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, frameCount}{
+        ENGINE_LOG_INFO("EngineDebugDraw: Initialising room for %u vertices per frame", MAX_VERTICES);
+        this->lineVertices.reserve(MAX_VERTICES);
+        this->triangleVertices.reserve(MAX_VERTICES);
+        this->createAtlas();
+        this->createPipelineLayout();
+        this->createPipelines();
+    }
+
+    EngineDebugDraw::~EngineDebugDraw(){
+        vkDestroyPipelineLayout(this->engineDevice.device(), this->pipelineLayout, nullptr);
+        this->bindlessTable.releaseTexture(this->atlasIndex);
+        vkDestroySampler(this->engineDevice.device(), this->atlasSampler, nullptr);
+        vkDestroyImageView(this->engineDevice.device(), this->atlasImageView, nullptr);
+        vkDestroyImage(this->engineDevice.device(), this->atlasImage, nullptr);
+        vkFreeMemory(this->engineDevice.device(), this->atlasImageMemory, nullptr);
+    }
+
+    void EngineDebugDraw::createPipelines(){
+        // the sprite state already blends over the scene without depth, only the topology differs
+        PipelineConfigInfo pipelineConfig = EnginePipeline::spritePipelineConfig(this->engineSwapChain.width(), this->engineSwapChain.height());
+        pipelineConfig.renderPass = this->engineSwapChain.getRenderPass();
+        pipelineConfig.pipelineLayout = this->pipelineLayout;
+        pipelineConfig.pipelineMultiSampleStateCreateInfo.rasterizationSamples = this->engineSwapChain.getSampleCount();
+        pipelineConfig.bindingDescriptions = getBindingDescriptions();
+        pipelineConfig.attributeDescriptions = getAttributeDescriptions();
+        this->trianglePipeline = &this->pipelineCache.getPipeline(VERTEX_SHADER_PATH, FRAGMENT_SHADER_PATH, pipelineConfig);
+        pipelineConfig.pipelineInputAssemblyStateCreateInfo.topology = VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
+        this->linePipeline = &this->pipelineCache.getPipeline(VERTEX_SHADER_PATH, FRAGMENT_SHADER_PATH, pipelineConfig);
+    }
+
+    void EngineDebugDraw::begin(size_t frameIndex){
+        this->lineVertices.clear();
+        this->triangleVertices.clear();
+        this->vertexStream.beginFrame(static_cast<uint32_t>(frameIndex));
+    }
+
+    void EngineDebugDraw::line(glm::vec2 from, glm::vec2 to, glm::vec4 color){
+        if(this->lineVertices.size() + this->triangleVertices.size() + 2 > MAX_VERTICES) return;
+        uint32_t packed = packColor(color);
+        this->lineVertices.push_back({from, this->solidUv, packed});
+        this->lineVertices.push_back({to, this->solidUv, packed});
+    }
+
+    void EngineDebugDraw::box(glm::vec2 min, glm::vec2 max, glm::vec4 color){
+        this->line(min, {max.x, min.y}, color);
+        this->line({max.x, min.y}, max, color);
+        this->line(max, {min.x, max.y}, color);
+        this->line({min.x, max.y}, min, color);
+    }
+
+    void EngineDebugDraw::filledBox(glm::vec2 min, glm::vec2 max, glm::vec4 color){
+        this->quad(min, max, this->solidUv, this->solidUv, packColor(color));
+    }
+
+    void EngineDebugDraw::bounds(const EngineModel::Bounds &bounds, const glm::mat2 &transform, glm::vec2 translation, const glm::mat2 &camera, glm::vec4 color){
+        glm::vec2 extent{static_cast<float>(this->engineSwapChain.width()), static_cast<float>(this->engineSwapChain.height())};
+        glm::vec2 corners[4] = {bounds.min, {bounds.max.x, bounds.min.y}, bounds.max, {bounds.min.x, bounds.max.y}};
+        for(glm::vec2 &corner:corners){
+            glm::vec2 position = camera * (transform * corner + translation);
+            corner = (position * 0.5f + 0.5f) * extent;
+        }
+        for(uint32_t i = 0; i < 4; i++) this->line(corners[i], corners[(i + 1) % 4], color);
+    }
+
+    void EngineDebugDraw::text(glm::vec2 position, const char *string, glm::vec4 color, float scale){
+        uint32_t packed = packColor(color);
+        glm::vec2 atlasSize{static_cast<float>(ATLAS_WIDTH), static_cast<float>(ATLAS_HEIGHT)};
+        glm::vec2 glyphSize = glm::vec2{static_cast<float>(GLYPH_WIDTH), static_cast<float>(GLYPH_HEIGHT)};
+        glm::vec2 cursor = position;
+        for(const char *character = string; *character != '\0'; character++){
+            uint32_t code = static_cast<unsigned char>(*character);
+            if(code == '\n'){
+                cursor = {position.x, cursor.y + LINE_ADVANCE * scale};
+                continue;
+            }
+            // spaces and characters outside the atlas only advance
+            if(code > FIRST_CHARACTER && code < SOLID_CHARACTER){
+                glm::vec2 uvMin = cellOrigin(code) / atlasSize;
+                this->quad(cursor, cursor + glyphSize * scale, uvMin, uvMin + glyphSize / atlasSize, packed);
+            }
+            cursor.x += GLYPH_ADVANCE * scale;
+        }
+    }
+
+    uint32_t EngineDebugDraw::flush(VkCommandBuffer commandBuffer){
+        uint32_t lineVertexCount = static_cast<uint32_t>(this->lineVertices.size());
+        uint32_t triangleVertexCount = static_cast<uint32_t>(this->triangleVertices.size());
+        if(lineVertexCount + triangleVertexCount == 0) return 0;
+
+        // both lists in one allocation, the triangle draw starts where the lines end
+        VkDeviceSize vertexOffset;
+        Vertex *vertices = this->vertexStream.allocateArray<Vertex>(lineVertexCount + triangleVertexCount, vertexOffset);
+        memcpy(vertices, this->lineVertices.data(), lineVertexCount * sizeof(Vertex));
+        memcpy(vertices + lineVertexCount, this->triangleVertices.data(), triangleVertexCount * sizeof(Vertex));
+        this->vertexStream.flush();
+
+        DebugDrawPush push = {};
+        push.scale = {2.0f / this->engineSwapChain.width(), 2.0f / this->engineSwapChain.height()};
+        push.offset = {-1.0f, -1.0f};
+        push.atlasIndex = this->atlasIndex;
+
+        // both pipelines share the layout, so the set, the push constants and the vertex buffer survive the switch
+        VkBuffer vertexBuffer = this->vertexStream.getBuffer();
+        vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer, &vertexOffset);
+        this->bindlessTable.bind(commandBuffer, this->pipelineLayout);
+        vkCmdPushConstants(commandBuffer, this->pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(DebugDrawPush), &push);
+
+        uint32_t drawCount = 0;
+        if(lineVertexCount > 0){
+            this->linePipeline->bind(commandBuffer);
+            vkCmdDraw(commandBuffer, lineVertexCount, 1, 0, 0);
+            drawCount++;
+        }
+        if(triangleVertexCount > 0){
+            this->trianglePipeline->bind(commandBuffer);
+            vkCmdDraw(commandBuffer, triangleVertexCount, 1, lineVertexCount, 0);
+            drawCount++;
+        }
+        return drawCount;
+    }
+
+    // Privates
+    void EngineDebugDraw::createAtlas(){
+        std::vector<uint8_t> texels(ATLAS_WIDTH * ATLAS_HEIGHT, 0);
+        auto writeGlyph = [&texels](uint32_t character, const uint8_t *rows){
+            glm::vec2 origin = cellOrigin(character);
+            for(uint32_t y = 0; y < GLYPH_HEIGHT; y++){
+                for(uint32_t x = 0; x < GLYPH_WIDTH; x++){
+                    bool isSet = rows[y] & (1u << (GLYPH_WIDTH - 1 - x));
+                    texels[(static_cast<uint32_t>(origin.y) + y) * ATLAS_WIDTH + static_cast<uint32_t>(origin.x) + x] = isSet ? 0xff : 0x00;
+                }
+            }
+        };
+        for(const Glyph &glyph:FONT){
+            writeGlyph(static_cast<uint32_t>(glyph.character), glyph.rows);
+            // lower case shares the upper case shapes
+            if(glyph.character >= 'A' && glyph.character <= 'Z') writeGlyph(static_cast<uint32_t>(glyph.character - 'A' + 'a'), glyph.rows);
+        }
+        glm::vec2 solidOrigin = cellOrigin(SOLID_CHARACTER);
+        for(uint32_t y = 0; y < CELL_HEIGHT; y++){
+            uint8_t *row = texels.data() + (static_cast<uint32_t>(solidOrigin.y) + y) * ATLAS_WIDTH + static_cast<uint32_t>(solidOrigin.x);
+            memset(row, 0xff, CELL_WIDTH);
+        }
+        this->solidUv = (solidOrigin + glm::vec2{CELL_WIDTH * 0.5f, CELL_HEIGHT * 0.5f}) / glm::vec2{static_cast<float>(ATLAS_WIDTH), static_cast<float>(ATLAS_HEIGHT)};
+
+        VkDeviceSize atlasSize = texels.size();
+        VkBuffer stagingBuffer;
+        VkDeviceMemory stagingBufferMemory;
+        this->engineDevice.createBuffer(
+            atlasSize,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            stagingBuffer,
+            stagingBufferMemory
+        );
+        void *data;
+        vkMapMemory(this->engineDevice.device(), stagingBufferMemory, 0, atlasSize, 0, &data);
+        memcpy(data, texels.data(), static_cast<size_t>(atlasSize));
+        vkUnmapMemory(this->engineDevice.device(), stagingBufferMemory);
+
+        VkImageCreateInfo imageCreateInfo = {};
+        imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageCreateInfo.extent = {ATLAS_WIDTH, ATLAS_HEIGHT, 1};
+        imageCreateInfo.mipLevels = 1;
+        imageCreateInfo.arrayLayers = 1;
+        imageCreateInfo.format = VK_FORMAT_R8_UNORM;
+        imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageCreateInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+        imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        this->engineDevice.createImageWithInfo(imageCreateInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, this->atlasImage, this->atlasImageMemory);
+
+        VkImageMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = this->atlasImage;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.levelCount = 1;
+        barrier.subresourceRange.layerCount = 1;
+
+        VkBufferImageCopy region = {};
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.layerCount = 1;
+        region.imageExtent = {ATLAS_WIDTH, ATLAS_HEIGHT, 1};
+
+        VkCommandBuffer commandBuffer = this->engineDevice.beginSingleTimeCommands();
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+        vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, this->atlasImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+        this->engineDevice.endSingleTimeCommands(commandBuffer);
+
+        vkDestroyBuffer(this->engineDevice.device(), stagingBuffer, nullptr);
+        vkFreeMemory(this->engineDevice.device(), stagingBufferMemory, nullptr);
+
+        VkImageViewCreateInfo imageViewCreateInfo = {};
+        imageViewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        imageViewCreateInfo.image = this->atlasImage;
+        imageViewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        imageViewCreateInfo.format = VK_FORMAT_R8_UNORM;
+        imageViewCreateInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        imageViewCreateInfo.subresourceRange.levelCount = 1;
+        imageViewCreateInfo.subresourceRange.layerCount = 1;
+        bool isCreateImageViewSuccess = vkCreateImageView(this->engineDevice.device(), &imageViewCreateInfo, nullptr, &this->atlasImageView) == VK_SUCCESS;
+        if(!isCreateImageViewSuccess) throw std::runtime_error("Failed to create glyph atlas image view!");
+
+        // nearest keeps the glyphs crisp at integer scales
+        VkSamplerCreateInfo samplerCreateInfo = {};
+        samplerCreateInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        samplerCreateInfo.magFilter = VK_FILTER_NEAREST;
+        samplerCreateInfo.minFilter = VK_FILTER_NEAREST;
+        samplerCreateInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        samplerCreateInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerCreateInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerCreateInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerCreateInfo.maxLod = 0.0f;
+        bool isCreateSamplerSuccess = vkCreateSampler(this->engineDevice.device(), &samplerCreateInfo, nullptr, &this->atlasSampler) == VK_SUCCESS;
+        if(!isCreateSamplerSuccess) throw std::runtime_error("Failed to create glyph atlas sampler!");
+
+        this->atlasIndex = this->bindlessTable.registerTexture(this->atlasImageView, this->atlasSampler);
+    }
+
+    void EngineDebugDraw::createPipelineLayout(){
+        VkPushConstantRange pushConstantRange = {};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(DebugDrawPush);
+
+        VkDescriptorSetLayout descriptorSetLayout = this->bindlessTable.getDescriptorSetLayout();
+        VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
+        pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutCreateInfo.setLayoutCount = 1;
+        pipelineLayoutCreateInfo.pSetLayouts = &descriptorSetLayout;
+        pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+        pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+        bool isCreatePipelineLayoutSuccess = vkCreatePipelineLayout(this->engineDevice.device(), &pipelineLayoutCreateInfo, nullptr, &this->pipelineLayout) == VK_SUCCESS;
+        if(!isCreatePipelineLayoutSuccess) throw std::runtime_error("Failed to create debug draw pipeline layout!");
+    }
+
+    std::vector<VkVertexInputBindingDescription> EngineDebugDraw::getBindingDescriptions(){
+        std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
+        bindingDescriptions[0].binding = 0;
+        bindingDescriptions[0].stride = sizeof(Vertex);
+        bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+        return bindingDescriptions;
+    }
+
+    std::vector<VkVertexInputAttributeDescription> EngineDebugDraw::getAttributeDescriptions(){
+        std::vector<VkVertexInputAttributeDescription> attributeDescriptions(3);
+        attributeDescriptions[0] = {0, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, position)};
+        attributeDescriptions[1] = {1, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, uv)};
+        attributeDescriptions[2] = {2, 0, VK_FORMAT_R8G8B8A8_UNORM, offsetof(Vertex, color)};
+        return attributeDescriptions;
+    }
+
+    void EngineDebugDraw::quad(glm::vec2 min, glm::vec2 max, glm::vec2 uvMin, glm::vec2 uvMax, uint32_t color){
+        if(this->lineVertices.size() + this->triangleVertices.size() + 6 > MAX_VERTICES) return;
+        Vertex topLeft = {min, uvMin, color};
+        Vertex topRight = {{max.x, min.y}, {uvMax.x, uvMin.y}, color};
+        Vertex bottomRight = {max, uvMax, color};
+        Vertex bottomLeft = {{min.x, max.y}, {uvMin.x, uvMax.y}, color};
+        Vertex corners[6] = {topLeft, topRight, bottomRight, bottomRight, bottomLeft, topLeft};
+        this->triangleVertices.insert(this->triangleVertices.end(), corners, corners + 6);
+    }
+}
+#endif
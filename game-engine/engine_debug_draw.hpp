@@ -0,0 +1,117 @@
+#pragma once
+
+// 1 compiles the debug-draw layer in, 0 leaves out the class and every call site guarded by
+// #if ENGINE_DEBUG_DRAW. The Makefile sets it per build, release builds go without.
+#ifndef ENGINE_DEBUG_DRAW
+    #ifdef NDEBUG
+        #define ENGINE_DEBUG_DRAW 0
+    #else
+        #define ENGINE_DEBUG_DRAW 1
+    #endif
+#endif
+
+#if ENGINE_DEBUG_DRAW
+#include "engine_device.hpp"
+#include "engine_bindless_table.hpp"
+#include "engine_dynamic_buffer.hpp"
+#include "engine_model.hpp"
+#include "engine_pipeline.hpp"
+#include "engine_pipeline_cache.hpp"
+#include "engine_swap_chain.hpp"
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace engine {
+    // Immediate-mode lines, boxes and text drawn over the frame. Calls between begin and flush are
+    // queued on the CPU, then flush copies the whole frame into one allocation of a persistently
+    // mapped stream, lines first and triangles after, and draws it with at most two draws: one
+    // line list and one triangle list for filled rectangles and glyphs. Text comes from a built-in
+    // 5x7 bitmap font in a small R8 atlas registered in the bindless table.
+    //
+    // Positions are in pixels from the top left corner of the swap chain.
+    class EngineDebugDraw {
+        public:
+            static constexpr const char *VERTEX_SHADER_PATH = "shaders/debug_draw.vert.spv";
+            static constexpr const char *FRAGMENT_SHADER_PATH = "shaders/debug_draw.frag.spv";
+            // lines and triangles together, primitives past it in a frame are dropped
+            static constexpr uint32_t MAX_VERTICES = 65536;
+            // pixels of a glyph at scale 1, the advance leaves one column and one row of spacing
+            static constexpr uint32_t GLYPH_WIDTH = 5;
+            static constexpr uint32_t GLYPH_HEIGHT = 7;
+            static constexpr uint32_t GLYPH_ADVANCE = GLYPH_WIDTH + 1;
+            static constexpr uint32_t LINE_ADVANCE = GLYPH_HEIGHT + 1;
+
+            EngineDebugDraw(EngineDevice &device, EngineBindlessTable &bindlessTable, EnginePipelineCache &pipelineCache, EngineSwapChain &swapChain, uint32_t frameCount);
+            ~EngineDebugDraw();
+
+            EngineDebugDraw(const EngineDebugDraw &) = delete;
+            EngineDebugDraw &operator = (const EngineDebugDraw &) = delete;
+
+            // Builds both pipelines for the swap chain's render pass, or picks up the rebuilt ones after a shader reload
+            void createPipelines();
+
+            // Starts queueing the primitives of a frame, the GPU must be done with the slot's previous vertices
+            void begin(size_t frameIndex);
+            void line(glm::vec2 from, glm::vec2 to, glm::vec4 color);
+            // Outline of an axis aligned rectangle
+            void box(glm::vec2 min, glm::vec2 max, glm::vec4 color);
+            void filledBox(glm::vec2 min, glm::vec2 max, glm::vec4 color);
+            // Outline of model bounds placed like a FrameInstance and viewed through camera
+            void bounds(const EngineModel::Bounds &bounds, const glm::mat2 &transform, glm::vec2 translation, const glm::mat2 &camera, glm::vec4 color);
+            // Top left corner of the first glyph, '\n' starts a new line. Lower case is drawn as
+            // upper case and characters the font lacks are left blank.
+            void text(glm::vec2 position, const char *string, glm::vec4 color, float scale = 1.0f);
+            // Inside a render pass compatible with the swap chain's. Draws everything queued since
+            // begin and returns the number of draw calls it took.
+            uint32_t flush(VkCommandBuffer commandBuffer);
+
+        private:
+            // debug_draw.vert's inputs
+            struct Vertex {
+                glm::vec2 position;
+                glm::vec2 uv;
+                // RGBA8
+                uint32_t color;
+            };
+
+            struct DebugDrawPush {
+                // pixels to normalised device coordinates
+                glm::vec2 scale;
+                glm::vec2 offset;
+                uint32_t atlasIndex;
+            };
+
+            void createAtlas();
+            void createPipelineLayout();
+            static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
+            static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+            void quad(glm::vec2 min, glm::vec2 max, glm::vec2 uvMin, glm::vec2 uvMax, uint32_t color);
+
+            EngineDevice &engineDevice;
+            EngineBindlessTable &bindlessTable;
+            EnginePipelineCache &pipelineCache;
+            EngineSwapChain &engineSwapChain;
+
+            EngineDynamicBuffer vertexStream;
+            // reserved up front so queueing never allocates
+            std::vector<Vertex> lineVertices;
+            std::vector<Vertex> triangleVertices;
+
+            // one cell per printable ASCII character
+            VkImage atlasImage;
+            VkDeviceMemory atlasImageMemory;
+            VkImageView atlasImageView;
+            VkSampler atlasSampler;
+            uint32_t atlasIndex = EngineBindlessTable::INVALID_INDEX;
+            // centre of the solid cell, lines and filled boxes sample it to keep their colour
+            glm::vec2 solidUv;
+
+            VkPipelineLayout pipelineLayout;
+            // owned by the cache
+            EnginePipeline *linePipeline = nullptr;
+            EnginePipeline *trianglePipeline = nullptr;
+    };
+}
+#endif
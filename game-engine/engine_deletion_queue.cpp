@@ -0,0 +1,55 @@
+#include "engine_deletion_queue.hpp"
+
+// std
+#include <utility>
+
+namespace engine {
+    EngineDeletionQueue::~EngineDeletionQueue(){
+        this->flush();
+    }
+
+    // Publics
+    void EngineDeletionQueue::enqueue(uint64_t lastFrameNumber, Deleter deleter){
+        std::lock_guard<std::mutex> lock{this->entriesMutex};
+        this->entries.push_back(Entry{lastFrameNumber, std::move(deleter)});
+    }
+
+    size_t EngineDeletionQueue::collect(uint64_t completedFrameCount){
+        {
+            std::lock_guard<std::mutex> lock{this->entriesMutex};
+            // entries from different threads are not sorted by frame, the ones still waiting are
+            // moved down in place so their order is kept
+            size_t keptCount = 0;
+            for(size_t i = 0; i < this->entries.size(); i++){
+                Entry &entry = this->entries[i];
+                if(entry.lastFrameNumber < completedFrameCount){
+                    this->readyDeleters.push_back(std::move(entry.deleter));
+                } else {
+                    if(keptCount != i) this->entries[keptCount] = std::move(entry);
+                    keptCount++;
+                }
+            }
+            this->entries.resize(keptCount);
+        }
+
+        // outside of the lock, deleters may take a while and other threads keep queueing
+        size_t deletedCount = this->readyDeleters.size();
+        for(Deleter &deleter:this->readyDeleters) deleter();
+        this->readyDeleters.clear();
+        return deletedCount;
+    }
+
+    void EngineDeletionQueue::flush(){
+        std::vector<Entry> remaining;
+        {
+            std::lock_guard<std::mutex> lock{this->entriesMutex};
+            remaining.swap(this->entries);
+        }
+        for(Entry &entry:remaining) entry.deleter();
+    }
+
+    size_t EngineDeletionQueue::size(){
+        std::lock_guard<std::mutex> lock{this->entriesMutex};
+        return this->entries.size();
+    }
+}
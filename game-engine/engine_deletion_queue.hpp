@@ -0,0 +1,60 @@
+#pragma once
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace engine {
+    // Frees Vulkan objects once the GPU can no longer be using them, instead of waiting for the
+    // device to go idle. Every object is queued with the number of the last frame packet that may
+    // reference it, and collect runs its deleter once the owner reports that frame as completed,
+    // so models and pipelines can be replaced while frames are in flight without a stall.
+    //
+    // Objects may be queued from any thread. collect and flush are called by one thread only.
+    class EngineDeletionQueue {
+        public:
+            using Deleter = std::function<void()>;
+
+            EngineDeletionQueue() = default;
+            // Runs whatever is left, the device has to be idle by then
+            ~EngineDeletionQueue();
+
+            EngineDeletionQueue(const EngineDeletionQueue &) = delete;
+            EngineDeletionQueue &operator = (const EngineDeletionQueue &) = delete;
+
+            // Runs the deleter once every frame up to and including lastFrameNumber has completed
+            void enqueue(uint64_t lastFrameNumber, Deleter deleter);
+
+            // Destroys the object once every frame up to and including lastFrameNumber has completed
+            template<typename T>
+            void retire(uint64_t lastFrameNumber, std::unique_ptr<T> object){
+                if(object == nullptr) return;
+                // std::function has to be copyable, the shared pointer stands in for the unique one
+                std::shared_ptr<T> retired = std::move(object);
+                this->enqueue(lastFrameNumber, [retired]() mutable { retired.reset(); });
+            }
+
+            // Runs the deleters of everything only frames below completedFrameCount may reference,
+            // in the order they were queued. Returns how many ran.
+            size_t collect(uint64_t completedFrameCount);
+            // Runs every deleter left, only once the device is idle
+            void flush();
+
+            size_t size();
+
+        private:
+            struct Entry {
+                uint64_t lastFrameNumber;
+                Deleter deleter;
+            };
+
+            std::mutex entriesMutex;
+            std::vector<Entry> entries;
+            // collect's, kept so collecting allocates nothing once it has grown
+            std::vector<Deleter> readyDeleters;
+    };
+}
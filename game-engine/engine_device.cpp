@@ -1,10 +1,16 @@
 #include "engine_device.hpp"
+#include "engine_log.hpp"
 
 // std
 #include <iostream>
 #include <stdexcept>
 #include <unordered_set>
 #include <set>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <cctype>
+#include <fstream>
 
 namespace engine {
     // Utilities
@@ -25,16 +31,63 @@ namespace engine {
         func(instance, debugMessenger, pAllocator);
     }
 
+    static std::string toLower(std::string text){
+        std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c){ return static_cast<char>(std::tolower(c)); });
+        return text;
+    }
+
+    static std::string trim(const std::string &text){
+        size_t first = text.find_first_not_of(" \t\r\n");
+        if(first == std::string::npos) return "";
+        size_t last = text.find_last_not_of(" \t\r\n");
+        return text.substr(first, last - first + 1);
+    }
+
+    // the environment wins over the config file, empty when neither picks a device
+    static std::string readDeviceOverride(const char *environmentVariable, const char *configPath){
+        const char *environmentValue = std::getenv(environmentVariable);
+        if(environmentValue != nullptr && *environmentValue != '\0') return trim(environmentValue);
+
+        std::ifstream config{configPath};
+        std::string line;
+        while(std::getline(config, line)){
+            size_t separator = line.find('=');
+            if(line.empty() || line[0] == '#' || separator == std::string::npos) continue;
+            if(trim(line.substr(0, separator)) == "device") return trim(line.substr(separator + 1));
+        }
+        return "";
+    }
+
+    static const char *deviceTypeName(VkPhysicalDeviceType type){
+        switch(type){
+            case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: return "discrete";
+            case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: return "integrated";
+            case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU: return "virtual";
+            case VK_PHYSICAL_DEVICE_TYPE_CPU: return "cpu";
+            default: return "other";
+        }
+    }
+
+    // the device type dominates, a software rasteriser must never beat real hardware on its other numbers
+    static uint64_t deviceTypeScore(VkPhysicalDeviceType type){
+        switch(type){
+            case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: return 1000000;
+            case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: return 100000;
+            case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU: return 10000;
+            default: return 0;
+        }
+    }
+
     // Publics
-    EngineDevice::EngineDevice(EngineWindow &window): window{window}{
-        std::cout << "EngineDevice: Initialising engine device" << std::endl;
+    EngineDevice::EngineDevice(EngineWindow &window, bool isValidationEnabled): enableValidationLayers{isValidationEnabled}, window{window}{
+        ENGINE_LOG_INFO("EngineDevice: Initialising engine device");
         this->createInstance();
         this->setupDebugMessenger();
         this->createSurface();
         this->pickPhysicalDevice();
         this->createLogicalDevice();
         this->createCommandPool();
-        std::cout << "EngineDevice: Successfully initialise engine device" << std::endl;
+        ENGINE_LOG_INFO("EngineDevice: Successfully initialise engine device");
     }
 
     EngineDevice::~EngineDevice(){
@@ -59,6 +112,31 @@ namespace engine {
         throw std::runtime_error("Failed to find suitable memory type");
     }
 
+    bool EngineDevice::hasMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties){
+        VkPhysicalDeviceMemoryProperties memoryProperties;
+        vkGetPhysicalDeviceMemoryProperties(this->physicalDevice, &memoryProperties);
+        for(uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++){
+            bool matchedBit = typeFilter & (1 << i);
+            bool matchedMemoryTypeProperties = (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties;
+            if(matchedBit && matchedMemoryTypeProperties) return true;
+        }
+        return false;
+    }
+
+    VkMemoryPropertyFlags EngineDevice::getMemoryTypeProperties(uint32_t memoryTypeIndex){
+        VkPhysicalDeviceMemoryProperties memoryProperties;
+        vkGetPhysicalDeviceMemoryProperties(this->physicalDevice, &memoryProperties);
+        return memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags;
+    }
+
+    VkSampleCountFlagBits EngineDevice::getMaxUsableSampleCount(){
+        VkSampleCountFlags counts = this->properties.limits.framebufferColorSampleCounts & this->properties.limits.framebufferDepthSampleCounts;
+        for(VkSampleCountFlagBits count:{VK_SAMPLE_COUNT_8_BIT, VK_SAMPLE_COUNT_4_BIT, VK_SAMPLE_COUNT_2_BIT}){
+            if(counts & count) return count;
+        }
+        return VK_SAMPLE_COUNT_1_BIT;
+    }
+
     VkFormat EngineDevice::findSupportedFormat(const std::vector<VkFormat> &candidates, VkImageTiling tiling, VkFormatFeatureFlags features){
         for(VkFormat candidate:candidates){
             VkFormatProperties properties;
@@ -162,7 +240,7 @@ namespace engine {
 
     // Privates
     void EngineDevice::createInstance(){
-        std::cout << "\t -> createInstance(): Creating instance" << std::endl;
+        ENGINE_LOG_DEBUG("\t -> createInstance(): Creating instance");
 
         if(this->enableValidationLayers && !this->checkValidationLayerSupport()) throw std::runtime_error("Validation layers requested, but not available");
 
@@ -190,11 +268,11 @@ namespace engine {
 
         if(!isCreateInstanceSuccess) throw std::runtime_error("Failed to create instance");
         this->validateGLfwRequiredInstanceExtensions();
-        std::cout << "\t -> createInstance(): Successfully create instance" << std::endl;
+        ENGINE_LOG_DEBUG("\t -> createInstance(): Successfully create instance");
     }
 
     void EngineDevice::setupDebugMessenger(){
-        std::cout << "\t -> setupDebugMessenger(): Setting up debug messenger" << std::endl;
+        ENGINE_LOG_DEBUG("\t -> setupDebugMessenger(): Setting up debug messenger");
 
         if(!this->enableValidationLayers) return;
         VkDebugUtilsMessengerCreateInfoEXT createInfo;
@@ -202,37 +280,67 @@ namespace engine {
         bool isSuccess = CreateDebugUtilsMessengerEXT(this->instance, &createInfo, nullptr, &this->debugMessenger) == VK_SUCCESS;
         if(!isSuccess) throw std::runtime_error("Failed to setup debugger messenger!");
 
-        std::cout << "\t -> setupDebugMessenger(): Successfully set up debug messenger" << std::endl;
+        ENGINE_LOG_DEBUG("\t -> setupDebugMessenger(): Successfully set up debug messenger");
     }
 
     void EngineDevice::createSurface(){
-        std::cout << "\t -> createSurface(): Creating surface" << std::endl;
+        ENGINE_LOG_DEBUG("\t -> createSurface(): Creating surface");
         window.createWindowSurface(this->instance, &this->surface_);
-        std::cout << "\t -> createSurface(): Successfully create surface" << std::endl;
+        ENGINE_LOG_DEBUG("\t -> createSurface(): Successfully create surface");
     }
 
     void EngineDevice::pickPhysicalDevice(){
-        std::cout << "\t -> pickPhysicalDevice(): Picking physical device" << std::endl;
+        ENGINE_LOG_DEBUG("\t -> pickPhysicalDevice(): Picking physical device");
         uint32_t deviceCount =0;
         vkEnumeratePhysicalDevices(this->instance, &deviceCount, nullptr);
         if(deviceCount ==0) throw std::runtime_error("Failed to find GPU with Vulkan support!");
-        std::cout << "\t\t -> Total GPU devices available -> " << deviceCount << std::endl;
+        ENGINE_LOG_DEBUG("\t\t -> Total GPU devices available -> %u", deviceCount);
         std::vector<VkPhysicalDevice> devices(deviceCount);
         vkEnumeratePhysicalDevices(this->instance, &deviceCount, devices.data());
         
-        for(const VkPhysicalDevice &device:devices){
-            if(this->isDeviceSuitable(device)){
-                this->physicalDevice=device;
-                break;
+        std::vector<PhysicalDeviceCandidate> candidates;
+        for(uint32_t i = 0; i < deviceCount; i++) candidates.push_back(this->rateDevice(devices[i], i));
+
+        const PhysicalDeviceCandidate *picked = nullptr;
+        std::string deviceOverride = readDeviceOverride(DEVICE_OVERRIDE_ENVIRONMENT_VARIABLE, DEVICE_CONFIG_PATH);
+        if(!deviceOverride.empty()){
+            bool isIndex = std::all_of(deviceOverride.begin(), deviceOverride.end(), [](unsigned char c){ return std::isdigit(c); });
+            for(const PhysicalDeviceCandidate &candidate:candidates){
+                bool isMatch = isIndex
+                    ? std::to_string(candidate.index) == deviceOverride
+                    : toLower(candidate.properties.deviceName).find(toLower(deviceOverride)) != std::string::npos;
+                if(isMatch && candidate.isSuitable){
+                    picked = &candidate;
+                    break;
+                }
             }
+            if(picked == nullptr) ENGINE_LOG_WARNING("EngineDevice: No suitable device matches override \"%s\", falling back to scoring", deviceOverride.c_str());
+        }
+        for(const PhysicalDeviceCandidate &candidate:candidates){
+            if(picked != nullptr) break;
+            if(!candidate.isSuitable) continue;
+            // ties keep the enumeration order
+            bool isBetter = picked == nullptr || candidate.score > picked->score;
+            if(isBetter) picked = &candidate;
         }
-        if(this->physicalDevice==VK_NULL_HANDLE) throw std::runtime_error("Failed to find suitable GPU");
+        if(picked == nullptr) throw std::runtime_error("Failed to find suitable GPU");
+        this->physicalDevice = picked->device;
+        this->printCapabilitiesReport(candidates, *picked);
         vkGetPhysicalDeviceProperties(this->physicalDevice, &this->properties);
-        std::cout << "\t -> pickPhysicalDevice(): Successfully pick physical device => " << this->properties.deviceName << std::endl;
+        vkGetPhysicalDeviceFeatures(this->physicalDevice, &this->supportedFeatures);
+
+        // limits of the update-after-bind descriptor arrays used by the bindless table
+        this->descriptorIndexingProperties = {};
+        this->descriptorIndexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+        VkPhysicalDeviceProperties2 properties2 = {};
+        properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        properties2.pNext = &this->descriptorIndexingProperties;
+        vkGetPhysicalDeviceProperties2(this->physicalDevice, &properties2);
+        ENGINE_LOG_DEBUG("\t -> pickPhysicalDevice(): Successfully pick physical device => %s", this->properties.deviceName);
     }
 
     void EngineDevice::createLogicalDevice(){
-        std::cout << "\t -> createLogicalDevice(): Creating logical device" << std::endl;
+        ENGINE_LOG_DEBUG("\t -> createLogicalDevice(): Creating logical device");
         QueueFamilyIndices indices = this->findQueueFamilies(this->physicalDevice);
         std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
         std::set<uint32_t> uniqueFamilyIndices = {indices.graphicsFamily, indices.presentFamily};
@@ -241,8 +349,10 @@ namespace engine {
             queueCreateInfos.push_back(this->buildQueueCreateInfo(queueFamily, &queuePriority));
         }
         VkPhysicalDeviceFeatures deviceFeatures = this->buildDeviceFeatures();
+        VkPhysicalDeviceDescriptorIndexingFeaturesEXT descriptorIndexingFeatures = this->buildDescriptorIndexingFeatures();
 
         VkDeviceCreateInfo createInfo = this->buildBaseDeviceCreateInfo(static_cast<uint32_t>(queueCreateInfos.size()), queueCreateInfos.data(), &deviceFeatures, static_cast<uint32_t>(this->deviceExtensions.size()), this->deviceExtensions.data());
+        createInfo.pNext = &descriptorIndexingFeatures;
         if(this->enableValidationLayers){
             createInfo.enabledLayerCount = static_cast<uint32_t>(this->validationLayers.size());
             createInfo.ppEnabledLayerNames = this->validationLayers.data();
@@ -255,17 +365,17 @@ namespace engine {
         
         vkGetDeviceQueue(this->device_, indices.graphicsFamily, 0, &this->graphicsQueue_);
         vkGetDeviceQueue(this->device_, indices.presentFamily, 0, &this->presentQueue_);
-        std::cout << "\t -> createLogicalDevice(): Successfully create logical device" << std::endl;
+        ENGINE_LOG_DEBUG("\t -> createLogicalDevice(): Successfully create logical device");
     }
 
     void EngineDevice::createCommandPool(){
-        std::cout << "\t -> createCommandPool(): Creating command pool" << std::endl;
+        ENGINE_LOG_DEBUG("\t -> createCommandPool(): Creating command pool");
 
         QueueFamilyIndices queueFamilyIndices = this->findPhysicalQueueFamilies();
         VkCommandPoolCreateInfo poolInfo = this->buildCommandPoolCreateInfo(queueFamilyIndices.graphicsFamily);
         bool isCreateCommandPoolSuccess = vkCreateCommandPool(this->device_, &poolInfo, nullptr, &this->commandPool) == VK_SUCCESS;
         if(!isCreateCommandPoolSuccess) throw std::runtime_error("Failed to create command pool!");
-        std::cout << "\t -> createCommandPool(): Successfully create command pool" << std::endl;
+        ENGINE_LOG_DEBUG("\t -> createCommandPool(): Successfully create command pool");
     }
 
     VkSubmitInfo EngineDevice::buildSubmitInfo(uint32_t commandBufferCount, const VkCommandBuffer* pCommandBuffer){
@@ -332,16 +442,37 @@ namespace engine {
         info.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
         info.pEngineName = "No Engine";
         info.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-        info.apiVersion = VK_API_VERSION_1_0;
+        // 1.1 for vkGetPhysicalDeviceFeatures2 and maintenance3, both required by descriptor indexing
+        info.apiVersion = VK_API_VERSION_1_1;
         return info;
     }
 
     VkPhysicalDeviceFeatures EngineDevice::buildDeviceFeatures(){
         VkPhysicalDeviceFeatures deviceFeatures = {};
         deviceFeatures.samplerAnisotropy = VK_TRUE;
+        deviceFeatures.shaderSampledImageArrayDynamicIndexing = VK_TRUE;
+        deviceFeatures.shaderStorageBufferArrayDynamicIndexing = VK_TRUE;
+
+        // optional, streamed textures in BC formats are rejected when it is missing
+        deviceFeatures.textureCompressionBC = this->supportedFeatures.textureCompressionBC;
+        // optional, only used when MSAA sample shading is requested
+        deviceFeatures.sampleRateShading = this->supportedFeatures.sampleRateShading;
         return deviceFeatures;
     }
 
+    VkPhysicalDeviceDescriptorIndexingFeaturesEXT EngineDevice::buildDescriptorIndexingFeatures(){
+        VkPhysicalDeviceDescriptorIndexingFeaturesEXT features = {};
+        features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+        features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+        features.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
+        features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+        features.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+        features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+        features.descriptorBindingPartiallyBound = VK_TRUE;
+        features.runtimeDescriptorArray = VK_TRUE;
+        return features;
+    }
+
     VkDeviceCreateInfo EngineDevice::buildBaseDeviceCreateInfo(uint32_t queueCreateInfoCount, const VkDeviceQueueCreateInfo *pQueueCreateInfos, const VkPhysicalDeviceFeatures *enabledFeatures, uint32_t enabledExtensionCount, const char *const *ppEnabledExtensionNames){
         VkDeviceCreateInfo createInfo = {};
         createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -364,7 +495,7 @@ namespace engine {
     }
                                                 
     bool EngineDevice::isDeviceSuitable(VkPhysicalDevice device){
-        std::cout << "\t\t -> Attempting to check if device is suitable" << std::endl;
+        ENGINE_LOG_DEBUG("\t\t -> Attempting to check if device is suitable");
         QueueFamilyIndices indices = this->findQueueFamilies(device);
         bool isExtensionSupported = this->checkDeviceExtensionSupport(device);
         bool isSwapChainAdequate = false;
@@ -374,15 +505,80 @@ namespace engine {
         }
         VkPhysicalDeviceFeatures supportedFeatures;
         vkGetPhysicalDeviceFeatures(device, &supportedFeatures);
-        std::cout << "\t\t -> Indices Completed -> " << indices.isComplete() << std::endl;
-        std::cout << "\t\t -> Extension is supported -> " << isExtensionSupported << std::endl;
-        std::cout << "\t\t -> Swap chain is adequate -> " << isSwapChainAdequate << std::endl;
-        std::cout << "\t\t -> Sampler Anisotropy -> " << supportedFeatures.samplerAnisotropy << std::endl;
-        bool isSuitable = indices.isComplete() && isExtensionSupported && isSwapChainAdequate && supportedFeatures.samplerAnisotropy;
-        std::cout << "\t\t -> Is Device Suitable -> " << isSuitable << std::endl;
+        bool isDescriptorIndexingSupported = isExtensionSupported && this->checkDescriptorIndexingSupport(device);
+        ENGINE_LOG_DEBUG("\t\t -> Indices Completed -> %d", indices.isComplete());
+        ENGINE_LOG_DEBUG("\t\t -> Extension is supported -> %d", isExtensionSupported);
+        ENGINE_LOG_DEBUG("\t\t -> Swap chain is adequate -> %d", isSwapChainAdequate);
+        ENGINE_LOG_DEBUG("\t\t -> Sampler Anisotropy -> %u", supportedFeatures.samplerAnisotropy);
+        ENGINE_LOG_DEBUG("\t\t -> Descriptor Indexing -> %d", isDescriptorIndexingSupported);
+        bool isSuitable = indices.isComplete() && isExtensionSupported && isSwapChainAdequate && supportedFeatures.samplerAnisotropy && isDescriptorIndexingSupported;
+        ENGINE_LOG_DEBUG("\t\t -> Is Device Suitable -> %d", isSuitable);
         return isSuitable;
     }
 
+    PhysicalDeviceCandidate EngineDevice::rateDevice(VkPhysicalDevice device, uint32_t index){
+        PhysicalDeviceCandidate candidate = {};
+        candidate.device = device;
+        candidate.index = index;
+        vkGetPhysicalDeviceProperties(device, &candidate.properties);
+        ENGINE_LOG_DEBUG("\t\t -> Device %u -> %s", index, candidate.properties.deviceName);
+        candidate.isSuitable = this->isDeviceSuitable(device);
+
+        VkPhysicalDeviceMemoryProperties memoryProperties;
+        vkGetPhysicalDeviceMemoryProperties(device, &memoryProperties);
+        for(uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++){
+            if(memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) candidate.deviceLocalMemory += memoryProperties.memoryHeaps[i].size;
+        }
+
+        vkGetPhysicalDeviceQueueFamilyProperties(device, &candidate.queueFamilyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> queueFamilies(candidate.queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(device, &candidate.queueFamilyCount, queueFamilies.data());
+        for(const VkQueueFamilyProperties &queueFamily:queueFamilies){
+            bool isGraphics = queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT;
+            bool isCompute = queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT;
+            bool isTransfer = queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT;
+            if(isCompute && !isGraphics) candidate.hasAsyncComputeQueue = true;
+            if(isTransfer && !isGraphics && !isCompute) candidate.hasTransferQueue = true;
+        }
+
+        const VkPhysicalDeviceLimits &limits = candidate.properties.limits;
+        candidate.score = deviceTypeScore(candidate.properties.deviceType);
+        // 100 per GiB, capped so memory size can not lift a device over the next type
+        candidate.score += std::min<uint64_t>(candidate.deviceLocalMemory >> 30, 64) * 100;
+        candidate.score += limits.maxImageDimension2D / 1024 * 10;
+        candidate.score += limits.maxComputeSharedMemorySize / 1024;
+        if(candidate.hasAsyncComputeQueue) candidate.score += 500;
+        if(candidate.hasTransferQueue) candidate.score += 500;
+        if(limits.timestampComputeAndGraphics) candidate.score += 100;
+        return candidate;
+    }
+
+    void EngineDevice::printCapabilitiesReport(const std::vector<PhysicalDeviceCandidate> &candidates, const PhysicalDeviceCandidate &picked){
+        ENGINE_LOG_INFO("EngineDevice: Capabilities report");
+        for(const PhysicalDeviceCandidate &candidate:candidates){
+            const VkPhysicalDeviceProperties &properties = candidate.properties;
+            ENGINE_LOG_INFO(
+                "%s%u: %s (%s), vulkan %u.%u.%u, vendor 0x%x device 0x%x, %llu MiB device local, %u queue families%s%s, max image %u, score %llu%s",
+                candidate.device == picked.device ? "\t * " : "\t   ",
+                candidate.index,
+                properties.deviceName,
+                deviceTypeName(properties.deviceType),
+                VK_VERSION_MAJOR(properties.apiVersion), VK_VERSION_MINOR(properties.apiVersion), VK_VERSION_PATCH(properties.apiVersion),
+                properties.vendorID, properties.deviceID,
+                static_cast<unsigned long long>(candidate.deviceLocalMemory >> 20),
+                candidate.queueFamilyCount,
+                candidate.hasAsyncComputeQueue ? " + async compute" : "",
+                candidate.hasTransferQueue ? " + transfer" : "",
+                properties.limits.maxImageDimension2D,
+                static_cast<unsigned long long>(candidate.score),
+                candidate.isSuitable ? "" : ", unsuitable"
+            );
+        }
+        if(picked.properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU){
+            ENGINE_LOG_WARNING("EngineDevice: Running on a software rasteriser, set %s to pick another device", DEVICE_OVERRIDE_ENVIRONMENT_VARIABLE);
+        }
+    }
+
     QueueFamilyIndices EngineDevice::findQueueFamilies(VkPhysicalDevice device){
         QueueFamilyIndices indices;
         uint32_t queueFamilyCount = 0;
@@ -426,6 +622,30 @@ namespace engine {
         return requiredExtension.empty();
     }
 
+    bool EngineDevice::checkDescriptorIndexingSupport(VkPhysicalDevice device){
+        VkPhysicalDeviceProperties deviceProperties;
+        vkGetPhysicalDeviceProperties(device, &deviceProperties);
+        if(deviceProperties.apiVersion < VK_API_VERSION_1_1) return false;
+
+        VkPhysicalDeviceDescriptorIndexingFeaturesEXT supported = {};
+        supported.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+        VkPhysicalDeviceFeatures2 features2 = {};
+        features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features2.pNext = &supported;
+        vkGetPhysicalDeviceFeatures2(device, &features2);
+
+        // every feature requested by buildDeviceFeatures and buildDescriptorIndexingFeatures must be available
+        return features2.features.shaderSampledImageArrayDynamicIndexing
+            && features2.features.shaderStorageBufferArrayDynamicIndexing
+            && supported.shaderSampledImageArrayNonUniformIndexing
+            && supported.shaderStorageBufferArrayNonUniformIndexing
+            && supported.descriptorBindingSampledImageUpdateAfterBind
+            && supported.descriptorBindingStorageBufferUpdateAfterBind
+            && supported.descriptorBindingUpdateUnusedWhilePending
+            && supported.descriptorBindingPartiallyBound
+            && supported.runtimeDescriptorArray;
+    }
+
     SwapChainSupportDetails EngineDevice::querySwapChainSupport(VkPhysicalDevice device){
         SwapChainSupportDetails details;
         vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, this->surface_, &details.capabilities);
@@ -456,17 +676,17 @@ namespace engine {
         vkEnumerateInstanceExtensionProperties(nullptr, &count, extensions.data());
         std::unordered_set<std::string> availableExtensions;
         
-        std::cout << "\t\tAvailable extensions:" << std::endl;
+        ENGINE_LOG_DEBUG("\t\tAvailable extensions:");
         for(const auto &extension: extensions){
-            std::cout << "\t\t\t-> " << extension.extensionName << std::endl;
+            ENGINE_LOG_DEBUG("\t\t\t-> %s", extension.extensionName);
             availableExtensions.insert(extension.extensionName);
         }
         
         std::vector<const char *> requiredExtensions = this->getRequiredExtensions();
         
-        std::cout << "\t\tRequired extensions:" << std::endl;
+        ENGINE_LOG_DEBUG("\t\tRequired extensions:");
         for(const auto &requiredExtension:requiredExtensions){
-            std::cout << "\t\t\t-> "<< requiredExtension << std::endl;
+            ENGINE_LOG_DEBUG("\t\t\t-> %s", requiredExtension);
             bool isRequiredExtensionFound = availableExtensions.find(requiredExtension) != availableExtensions.end();
             if(!isRequiredExtensionFound) throw std::runtime_error("Missing required GLFW extension");
         }
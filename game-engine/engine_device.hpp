@@ -23,15 +23,33 @@ namespace engine {
         }
     };
 
+    // What pickPhysicalDevice found out about one adapter, printed as the startup capabilities report
+    struct PhysicalDeviceCandidate {
+        VkPhysicalDevice device = VK_NULL_HANDLE;
+        uint32_t index = 0;
+        VkPhysicalDeviceProperties properties;
+        VkDeviceSize deviceLocalMemory = 0;
+        uint32_t queueFamilyCount = 0;
+        bool hasAsyncComputeQueue = false;
+        bool hasTransferQueue = false;
+        bool isSuitable = false;
+        uint64_t score = 0;
+    };
+
     class EngineDevice {
         public:
             #ifdef NDEBUG
-            const bool enableValidationLayers = false;
+            static constexpr bool DEFAULT_VALIDATION_ENABLED = false;
             #else
-            const bool enableValidationLayers = true;
+            static constexpr bool DEFAULT_VALIDATION_ENABLED = true;
             #endif
+            const bool enableValidationLayers;
+            // index or case-insensitive part of the device name, overrides the scoring
+            static constexpr const char *DEVICE_OVERRIDE_ENVIRONMENT_VARIABLE = "ENGINE_DEVICE";
+            // read when the environment variable is not set, a "device = <index or name>" line
+            static constexpr const char *DEVICE_CONFIG_PATH = "engine.cfg";
             
-            EngineDevice(EngineWindow &window);
+            EngineDevice(EngineWindow &window, bool isValidationEnabled = DEFAULT_VALIDATION_ENABLED);
             ~EngineDevice();
 
             // not copyable
@@ -69,6 +87,8 @@ namespace engine {
             }
 
             uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+            bool hasMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+            VkMemoryPropertyFlags getMemoryTypeProperties(uint32_t memoryTypeIndex);
         
             VkFormat findSupportedFormat(const std::vector<VkFormat> &candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 
@@ -79,7 +99,11 @@ namespace engine {
             void copyBuffer(VkBuffer sourceBuffer, VkBuffer destinationBuffer, VkDeviceSize size);
             void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount);
             void createImageWithInfo(const VkImageCreateInfo &imageInfo, VkMemoryPropertyFlags properties, VkImage &image, VkDeviceMemory &imageMemory);
+            // Highest sample count usable for both colour and depth attachments
+            VkSampleCountFlagBits getMaxUsableSampleCount();
             VkPhysicalDeviceProperties properties;
+            VkPhysicalDeviceFeatures supportedFeatures;
+            VkPhysicalDeviceDescriptorIndexingPropertiesEXT descriptorIndexingProperties;
 
         private:
             void createInstance();
@@ -93,6 +117,7 @@ namespace engine {
             VkInstanceCreateInfo buildInstanceCreateInfo(const VkApplicationInfo* appInfo);
             VkDeviceQueueCreateInfo buildQueueCreateInfo(uint32_t queueFamilyIndex, float* queuePriority);
             VkPhysicalDeviceFeatures buildDeviceFeatures();
+            VkPhysicalDeviceDescriptorIndexingFeaturesEXT buildDescriptorIndexingFeatures();
             VkDeviceCreateInfo buildBaseDeviceCreateInfo(uint32_t queueCreateInfoCount, const VkDeviceQueueCreateInfo* pQueueCreateInfos, const VkPhysicalDeviceFeatures* enabledFeatures, uint32_t enabledExtensionCount, const char* const* ppEnabledExtensionNames);
             VkCommandPoolCreateInfo buildCommandPoolCreateInfo(uint32_t queueFamilyIndex);
             VkBufferCreateInfo buildBufferCreateInfo(VkDeviceSize size, VkBufferUsageFlags usage);
@@ -103,12 +128,15 @@ namespace engine {
             
             // utility functions
             bool isDeviceSuitable(VkPhysicalDevice device);
+            PhysicalDeviceCandidate rateDevice(VkPhysicalDevice device, uint32_t index);
+            void printCapabilitiesReport(const std::vector<PhysicalDeviceCandidate> &candidates, const PhysicalDeviceCandidate &picked);
             std::vector<const char *> getRequiredExtensions();
             bool checkValidationLayerSupport();
             QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device);
             void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT &createInfo);
             void validateGLfwRequiredInstanceExtensions();
             bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+            bool checkDescriptorIndexingSupport(VkPhysicalDevice device);
             SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device);
 
             VkInstance instance;
@@ -123,6 +151,6 @@ namespace engine {
             VkQueue presentQueue_;
 
             const std::vector<const char *> validationLayers = {"VK_LAYER_KHRONOS_validation"};
-            const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME, "VK_KHR_portability_subset"};
+            const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME, "VK_KHR_portability_subset"};
     };
 }
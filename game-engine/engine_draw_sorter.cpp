@@ -0,0 +1,80 @@
+#include "engine_draw_sorter.hpp"
+
+// std
+#include <array>
+#include <cstring>
+#include <utility>
+
+namespace engine {
+    static constexpr uint32_t RADIX_BITS = 8;
+    static constexpr uint32_t RADIX_SIZE = 1 << RADIX_BITS;
+    static constexpr uint32_t PASS_COUNT = 64 / RADIX_BITS;
+
+    EngineDrawSorter::EngineDrawSorter(size_t capacity){
+        this->keys.reserve(capacity);
+        this->draws.reserve(capacity);
+        this->scratchKeys.reserve(capacity);
+        this->scratchDraws.reserve(capacity);
+    }
+
+    // Publics
+    uint64_t EngineDrawSorter::makeKey(uint32_t pipeline, uint32_t material, uint32_t mesh, float depth){
+        // flipping the sign bit of positive floats and every bit of negative ones makes their bits
+        // sort like the values themselves
+        uint32_t depthBits;
+        memcpy(&depthBits, &depth, sizeof(depthBits));
+        depthBits ^= (depthBits & 0x80000000u) ? 0xffffffffu : 0x80000000u;
+
+        return static_cast<uint64_t>(pipeline & 0xffu) << PIPELINE_SHIFT
+            | static_cast<uint64_t>(material & 0xffffu) << MATERIAL_SHIFT
+            | static_cast<uint64_t>(mesh & 0xffffu) << MESH_SHIFT
+            | static_cast<uint64_t>(depthBits >> (32 - DEPTH_BITS));
+    }
+
+    void EngineDrawSorter::clear(){
+        this->keys.clear();
+        this->draws.clear();
+    }
+
+    void EngineDrawSorter::add(uint64_t key, uint32_t draw){
+        this->keys.push_back(key);
+        this->draws.push_back(draw);
+    }
+
+    void EngineDrawSorter::sort(){
+        this->passCount = 0;
+        size_t count = this->keys.size();
+        if(count < 2) return;
+
+        // the histograms of every byte in one read of the keys
+        std::array<std::array<uint32_t, RADIX_SIZE>, PASS_COUNT> histograms{};
+        for(uint64_t key:this->keys){
+            for(uint32_t pass = 0; pass < PASS_COUNT; pass++) histograms[pass][(key >> (pass * RADIX_BITS)) & (RADIX_SIZE - 1)]++;
+        }
+
+        this->scratchKeys.resize(count);
+        this->scratchDraws.resize(count);
+        for(uint32_t pass = 0; pass < PASS_COUNT; pass++){
+            uint32_t shift = pass * RADIX_BITS;
+            std::array<uint32_t, RADIX_SIZE> &histogram = histograms[pass];
+            // every key has this byte, the pass would move nothing
+            if(histogram[(this->keys[0] >> shift) & (RADIX_SIZE - 1)] == count) continue;
+
+            // least significant byte first, each pass stable, so earlier bytes break the ties of later ones
+            uint32_t offset = 0;
+            for(uint32_t &bucket:histogram){
+                uint32_t bucketCount = bucket;
+                bucket = offset;
+                offset += bucketCount;
+            }
+            for(size_t i = 0; i < count; i++){
+                uint32_t destination = histogram[(this->keys[i] >> shift) & (RADIX_SIZE - 1)]++;
+                this->scratchKeys[destination] = this->keys[i];
+                this->scratchDraws[destination] = this->draws[i];
+            }
+            std::swap(this->keys, this->scratchKeys);
+            std::swap(this->draws, this->scratchDraws);
+            this->passCount++;
+        }
+    }
+}
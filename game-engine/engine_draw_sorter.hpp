@@ -0,0 +1,55 @@
+#pragma once
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace engine {
+    // Orders the draws of a frame so consecutive draws share as much state as possible. Every draw
+    // gets a 64 bit key, most significant first:
+    //  - 8 bits pipeline, the order the pipelines have to run in
+    //  - 16 bits material
+    //  - 16 bits mesh
+    //  - 24 bits depth, nearest first
+    // and the keys are radix sorted a byte at a time. Bytes every key has in common are skipped, so
+    // a frame with one pipeline and a handful of meshes only pays for the bytes that differ.
+    //
+    // Buffers are kept between frames, sorting allocates nothing once they have grown.
+    class EngineDrawSorter {
+        public:
+            static constexpr uint32_t PIPELINE_SHIFT = 56;
+            static constexpr uint32_t MATERIAL_SHIFT = 40;
+            static constexpr uint32_t MESH_SHIFT = 24;
+            static constexpr uint32_t DEPTH_BITS = 24;
+
+            explicit EngineDrawSorter(size_t capacity = 0);
+
+            EngineDrawSorter(const EngineDrawSorter &) = delete;
+            EngineDrawSorter &operator = (const EngineDrawSorter &) = delete;
+
+            // Values wider than their field are cut to it, which only costs sharing state
+            static uint64_t makeKey(uint32_t pipeline, uint32_t material, uint32_t mesh, float depth);
+
+            void clear();
+            // draw is the caller's, handed back in sorted order by getDraws
+            void add(uint64_t key, uint32_t draw);
+            // Stable, draws with equal keys keep the order they were added in
+            void sort();
+
+            const std::vector<uint32_t> &getDraws() const {
+                return this->draws;
+            }
+            // Of the eight a full 64 bit sort would take, for the last sort
+            uint32_t getPassCount() const {
+                return this->passCount;
+            }
+
+        private:
+            std::vector<uint64_t> keys;
+            std::vector<uint32_t> draws;
+            std::vector<uint64_t> scratchKeys;
+            std::vector<uint32_t> scratchDraws;
+            uint32_t passCount = 0;
+    };
+}
@@ -0,0 +1,102 @@
+#include "engine_dynamic_buffer.hpp"
+#include "engine_log.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace engine {
+    // Utilities
+    static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment){
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    // Publics
+    EngineDynamicBuffer::EngineDynamicBuffer(EngineDevice &device, VkDeviceSize frameSize, VkBufferUsageFlags usage, uint32_t frameCount):
+        engineDevice{device}, frameCount{frameCount}{
+        ENGINE_LOG_INFO("EngineDynamicBuffer: Initialising...");
+        const VkPhysicalDeviceLimits &limits = this->engineDevice.properties.limits;
+        // enough for any vertex attribute format
+        this->alignment = 16;
+        if(usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT) this->alignment = std::max(this->alignment, limits.minUniformBufferOffsetAlignment);
+        if(usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT) this->alignment = std::max(this->alignment, limits.minStorageBufferOffsetAlignment);
+        // every region starts and ends on an atom boundary, so flushing one never touches its neighbours
+        this->frameSize = alignUp(frameSize, std::max(this->alignment, limits.nonCoherentAtomSize));
+
+        this->createBuffer(usage);
+    }
+
+    EngineDynamicBuffer::~EngineDynamicBuffer(){
+        vkUnmapMemory(this->engineDevice.device(), this->bufferMemory);
+        vkDestroyBuffer(this->engineDevice.device(), this->buffer, nullptr);
+        vkFreeMemory(this->engineDevice.device(), this->bufferMemory, nullptr);
+    }
+
+    void EngineDynamicBuffer::beginFrame(uint32_t frameIndex){
+        assert(frameIndex < this->frameCount && "Frame index out of range");
+        this->frameOffset = this->frameSize * frameIndex;
+        this->cursor = this->frameOffset;
+        this->flushedUntil = this->frameOffset;
+    }
+
+    EngineDynamicBuffer::Allocation EngineDynamicBuffer::allocate(VkDeviceSize size){
+        VkDeviceSize offset = alignUp(this->cursor, this->alignment);
+        bool isFull = offset + size > this->frameOffset + this->frameSize;
+        if(isFull) throw std::runtime_error("Failed to allocate from dynamic buffer, the frame region is full!");
+        this->cursor = offset + size;
+        return Allocation{this->mappedData + offset, offset};
+    }
+
+    void EngineDynamicBuffer::flush(){
+        if(this->isHostCoherent || this->cursor == this->flushedUntil) return;
+
+        VkDeviceSize atomSize = this->engineDevice.properties.limits.nonCoherentAtomSize;
+        VkDeviceSize start = this->flushedUntil / atomSize * atomSize;
+        VkDeviceSize end = std::min(alignUp(this->cursor, atomSize), this->frameOffset + this->frameSize);
+
+        VkMappedMemoryRange mappedMemoryRange = {};
+        mappedMemoryRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+        mappedMemoryRange.memory = this->bufferMemory;
+        mappedMemoryRange.offset = start;
+        mappedMemoryRange.size = end - start;
+        bool isFlushSuccess = vkFlushMappedMemoryRanges(this->engineDevice.device(), 1, &mappedMemoryRange) == VK_SUCCESS;
+        if(!isFlushSuccess) throw std::runtime_error("Failed to flush dynamic buffer!");
+        this->flushedUntil = this->cursor;
+    }
+
+    // Privates
+    void EngineDynamicBuffer::createBuffer(VkBufferUsageFlags usage){
+        ENGINE_LOG_DEBUG("\t -> createBuffer(): Creating persistently mapped buffer...");
+        VkBufferCreateInfo bufferCreateInfo = {};
+        bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferCreateInfo.size = this->frameSize * this->frameCount;
+        bufferCreateInfo.usage = usage;
+        bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        bool isCreateBufferSuccess = vkCreateBuffer(this->engineDevice.device(), &bufferCreateInfo, nullptr, &this->buffer) == VK_SUCCESS;
+        if(!isCreateBufferSuccess) throw std::runtime_error("Failed to create dynamic buffer!");
+
+        // device local and host visible (resizable BAR, integrated GPUs) spares the GPU reads over the bus
+        VkMemoryRequirements memoryRequirements;
+        vkGetBufferMemoryRequirements(this->engineDevice.device(), this->buffer, &memoryRequirements);
+        VkMemoryPropertyFlags preferredProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+        bool hasPreferredMemory = this->engineDevice.hasMemoryType(memoryRequirements.memoryTypeBits, preferredProperties);
+        uint32_t memoryTypeIndex = this->engineDevice.findMemoryType(
+            memoryRequirements.memoryTypeBits,
+            hasPreferredMemory ? preferredProperties : static_cast<VkMemoryPropertyFlags>(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+        );
+        this->isHostCoherent = (this->engineDevice.getMemoryTypeProperties(memoryTypeIndex) & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+
+        VkMemoryAllocateInfo memoryAllocateInfo = {};
+        memoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        memoryAllocateInfo.allocationSize = memoryRequirements.size;
+        memoryAllocateInfo.memoryTypeIndex = memoryTypeIndex;
+        bool isAllocateMemorySuccess = vkAllocateMemory(this->engineDevice.device(), &memoryAllocateInfo, nullptr, &this->bufferMemory) == VK_SUCCESS;
+        if(!isAllocateMemorySuccess) throw std::runtime_error("Failed to allocate dynamic buffer memory!");
+        vkBindBufferMemory(this->engineDevice.device(), this->buffer, this->bufferMemory, 0);
+
+        // stays mapped until destruction, mapping is not free and the pointer never changes
+        bool isMapMemorySuccess = vkMapMemory(this->engineDevice.device(), this->bufferMemory, 0, VK_WHOLE_SIZE, 0, reinterpret_cast<void **>(&this->mappedData)) == VK_SUCCESS;
+        if(!isMapMemorySuccess) throw std::runtime_error("Failed to map dynamic buffer memory!");
+    }
+}
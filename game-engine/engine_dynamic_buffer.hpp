@@ -0,0 +1,67 @@
+#pragma once
+#include "engine_device.hpp"
+
+// std
+#include <cstdint>
+
+namespace engine {
+    // Host visible buffer mapped once for its whole lifetime, split into one region per frame in
+    // flight. Per-frame data (uniforms, instance data, dynamic vertices) is sub-allocated from the
+    // current frame's region by bumping an offset, so filling it is a plain stream of writes into
+    // mapped memory. On memory without HOST_COHERENT the written range of the frame is flushed with
+    // a single vkFlushMappedMemoryRanges call, rounded to nonCoherentAtomSize.
+    class EngineDynamicBuffer {
+        public:
+            struct Allocation {
+                void *data;
+                // from the start of the buffer, for vkCmdBindVertexBuffers and descriptor offsets
+                VkDeviceSize offset;
+            };
+
+            EngineDynamicBuffer(EngineDevice &device, VkDeviceSize frameSize, VkBufferUsageFlags usage, uint32_t frameCount);
+            ~EngineDynamicBuffer();
+
+            EngineDynamicBuffer(const EngineDynamicBuffer &) = delete;
+            EngineDynamicBuffer &operator = (const EngineDynamicBuffer &) = delete;
+
+            // Starts writing into this frame's region, the GPU must be done with its previous contents
+            void beginFrame(uint32_t frameIndex);
+
+            // The offset honours every alignment the usage flags require, throws when the region is full
+            Allocation allocate(VkDeviceSize size);
+
+            template<typename T>
+            T *allocateArray(uint32_t count, VkDeviceSize &offset){
+                Allocation allocation = this->allocate(sizeof(T) * count);
+                offset = allocation.offset;
+                return static_cast<T *>(allocation.data);
+            }
+
+            // Makes everything written since beginFrame visible to the device, call before submitting
+            void flush();
+
+            VkBuffer getBuffer(){
+                return this->buffer;
+            }
+            bool isCoherent(){
+                return this->isHostCoherent;
+            }
+
+        private:
+            void createBuffer(VkBufferUsageFlags usage);
+
+            EngineDevice &engineDevice;
+            VkDeviceSize frameSize;
+            uint32_t frameCount;
+            VkDeviceSize alignment;
+
+            VkBuffer buffer;
+            VkDeviceMemory bufferMemory;
+            unsigned char *mappedData = nullptr;
+            bool isHostCoherent = false;
+
+            VkDeviceSize frameOffset = 0;
+            VkDeviceSize cursor = 0;
+            VkDeviceSize flushedUntil = 0;
+    };
+}
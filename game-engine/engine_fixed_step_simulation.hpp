@@ -0,0 +1,127 @@
+#pragma once
+
+// std
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace engine {
+    struct SimulationTimings {
+        uint64_t tickCount = 0;
+        // ticks skipped by the catch-up clamp, simulated time lost to keep the loop responsive
+        uint64_t droppedTicks = 0;
+        double averageTickMs = 0.0;
+        double maxTickMs = 0.0;
+    };
+
+    // Steps a state at a fixed rate on its own thread, independent of how fast frames are presented,
+    // and keeps the two latest states so the renderer can interpolate between them. When ticks take
+    // longer than the step, at most MAX_TICKS_PER_UPDATE are run to catch up and the rest is dropped,
+    // otherwise the simulation falls further behind with every update (the spiral of death).
+    template<typename State>
+    class EngineFixedStepSimulation {
+        public:
+            using Clock = std::chrono::steady_clock;
+            using UpdateFunction = std::function<void(State &state, double deltaSeconds)>;
+            static constexpr uint32_t MAX_TICKS_PER_UPDATE = 5;
+
+            EngineFixedStepSimulation(const State &initialState, double tickSeconds, UpdateFunction update):
+                tickDuration{std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(tickSeconds))},
+                update{std::move(update)},
+                previousState{initialState},
+                currentState{initialState},
+                currentStateTime{Clock::now()} {
+                this->worker = std::thread(&EngineFixedStepSimulation::loop, this);
+            }
+
+            ~EngineFixedStepSimulation(){
+                this->isStopping = true;
+                this->worker.join();
+            }
+
+            EngineFixedStepSimulation(const EngineFixedStepSimulation &) = delete;
+            EngineFixedStepSimulation &operator = (const EngineFixedStepSimulation &) = delete;
+
+            // Latest two states and how far real time has moved from the first towards the second, in [0, 1]
+            void sample(State &previous, State &current, float &alpha){
+                std::lock_guard<std::mutex> lock(this->stateMutex);
+                previous = this->previousState;
+                current = this->currentState;
+                double elapsed = std::chrono::duration<double>(Clock::now() - this->currentStateTime).count();
+                alpha = static_cast<float>(std::min(elapsed / std::chrono::duration<double>(this->tickDuration).count(), 1.0));
+            }
+
+            // Timings since the previous call
+            SimulationTimings takeTimings(){
+                std::lock_guard<std::mutex> lock(this->stateMutex);
+                SimulationTimings timings = this->timings;
+                if(timings.tickCount > 0) timings.averageTickMs = this->tickMsTotal / timings.tickCount;
+                this->timings = {};
+                this->tickMsTotal = 0.0;
+                return timings;
+            }
+
+        private:
+            void loop(){
+                State state = this->currentState;
+                Clock::time_point previousTime = Clock::now();
+                Clock::duration accumulator = Clock::duration::zero();
+
+                while(!this->isStopping){
+                    Clock::time_point time = Clock::now();
+                    accumulator += time - previousTime;
+                    previousTime = time;
+
+                    State before = state;
+                    uint32_t ticks = 0;
+                    double tickMsTotal = 0.0;
+                    double tickMsMax = 0.0;
+                    double deltaSeconds = std::chrono::duration<double>(this->tickDuration).count();
+                    while(accumulator >= this->tickDuration && ticks < MAX_TICKS_PER_UPDATE){
+                        before = state;
+                        Clock::time_point tickStart = Clock::now();
+                        this->update(state, deltaSeconds);
+                        double tickMs = std::chrono::duration<double, std::milli>(Clock::now() - tickStart).count();
+                        tickMsTotal += tickMs;
+                        tickMsMax = std::max(tickMsMax, tickMs);
+                        accumulator -= this->tickDuration;
+                        ticks++;
+                    }
+                    uint64_t droppedTicks = 0;
+                    if(accumulator >= this->tickDuration){
+                        droppedTicks = accumulator / this->tickDuration;
+                        accumulator %= this->tickDuration;
+                    }
+
+                    if(ticks > 0){
+                        std::lock_guard<std::mutex> lock(this->stateMutex);
+                        this->previousState = before;
+                        this->currentState = state;
+                        this->currentStateTime = time;
+                        this->timings.tickCount += ticks;
+                        this->timings.droppedTicks += droppedTicks;
+                        this->tickMsTotal += tickMsTotal;
+                        this->timings.maxTickMs = std::max(this->timings.maxTickMs, tickMsMax);
+                    }
+                    std::this_thread::sleep_until(time + (this->tickDuration - accumulator));
+                }
+            }
+
+            Clock::duration tickDuration;
+            UpdateFunction update;
+
+            std::mutex stateMutex;
+            State previousState;
+            State currentState;
+            Clock::time_point currentStateTime;
+            SimulationTimings timings;
+            double tickMsTotal = 0.0;
+
+            std::thread worker;
+            std::atomic<bool> isStopping{false};
+    };
+}
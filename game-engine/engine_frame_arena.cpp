@@ -0,0 +1,97 @@
+#include "engine_frame_arena.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+
+namespace engine {
+    // distinguishes arenas in the thread-local cache, an address could be reused by a later arena
+    static std::atomic<uint64_t> nextArenaId{1};
+
+    struct ThreadChunksCache {
+        uint64_t arenaId = 0;
+        void *threadChunks = nullptr;
+    };
+    static thread_local ThreadChunksCache threadChunksCache;
+
+    // Publics
+    EngineFrameArena::EngineFrameArena(size_t frameCount, size_t chunkSize):
+        arenaId{nextArenaId++}, frameCount{frameCount}, chunkSize{chunkSize}{
+        for(size_t i = 0; i < frameCount; i++) this->resources.push_back(std::make_unique<Resource>(*this, i));
+    }
+
+    void *EngineFrameArena::allocate(size_t frameIndex, size_t size, size_t alignment){
+        assert(frameIndex < this->frameCount && "Frame index out of range");
+        assert((alignment & (alignment - 1)) == 0 && "Alignment must be a power of two");
+        Slot &slot = this->threadChunks().slots[frameIndex];
+
+        while(slot.chunkIndex < slot.chunks.size()){
+            Chunk &chunk = slot.chunks[slot.chunkIndex];
+            uintptr_t base = reinterpret_cast<uintptr_t>(chunk.data.get());
+            uintptr_t address = (base + slot.offset + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+            if(address + size <= base + chunk.size){
+                slot.offset = address + size - base;
+                slot.usedBytes += size;
+                return reinterpret_cast<void *>(address);
+            }
+            // the rest of this chunk is wasted until the slot is reset
+            slot.chunkIndex++;
+            slot.offset = 0;
+        }
+
+        // none of the retained chunks has room, this only happens while the working set grows
+        size_t chunkBytes = std::max(this->chunkSize, size + alignment);
+        slot.chunks.push_back(Chunk{std::make_unique<unsigned char[]>(chunkBytes), chunkBytes});
+        slot.chunkIndex = slot.chunks.size() - 1;
+        slot.offset = 0;
+        this->chunkCount++;
+        this->reservedBytes += chunkBytes;
+        return this->allocate(frameIndex, size, alignment);
+    }
+
+    void EngineFrameArena::resetFrame(size_t frameIndex){
+        assert(frameIndex < this->frameCount && "Frame index out of range");
+        std::lock_guard<std::mutex> lock(this->threadsMutex);
+        size_t frameBytes = 0;
+        for(auto &thread:this->threads){
+            Slot &slot = thread->slots[frameIndex];
+            frameBytes += slot.usedBytes;
+            slot.chunkIndex = 0;
+            slot.offset = 0;
+            slot.usedBytes = 0;
+        }
+        this->peakFrameBytes = std::max(this->peakFrameBytes, frameBytes);
+    }
+
+    FrameArenaStatistics EngineFrameArena::getStatistics(){
+        std::lock_guard<std::mutex> lock(this->threadsMutex);
+        FrameArenaStatistics statistics = {};
+        statistics.chunkCount = this->chunkCount;
+        statistics.reservedBytes = this->reservedBytes;
+        statistics.peakFrameBytes = this->peakFrameBytes;
+        return statistics;
+    }
+
+    // Privates
+    EngineFrameArena::ThreadChunks &EngineFrameArena::threadChunks(){
+        if(threadChunksCache.arenaId == this->arenaId) return *static_cast<ThreadChunks *>(threadChunksCache.threadChunks);
+
+        // first allocation of this thread, or it last used another arena
+        std::lock_guard<std::mutex> lock(this->threadsMutex);
+        std::thread::id threadId = std::this_thread::get_id();
+        auto found = std::find_if(this->threads.begin(), this->threads.end(), [threadId](const std::unique_ptr<ThreadChunks> &thread){
+            return thread->threadId == threadId;
+        });
+        ThreadChunks *chunks = nullptr;
+        if(found != this->threads.end()){
+            chunks = found->get();
+        }else{
+            this->threads.push_back(std::make_unique<ThreadChunks>());
+            chunks = this->threads.back().get();
+            chunks->threadId = threadId;
+            chunks->slots.resize(this->frameCount);
+        }
+        threadChunksCache = {this->arenaId, chunks};
+        return *chunks;
+    }
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+// std
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace engine {
+    struct FrameArenaStatistics {
+        uint32_t chunkCount = 0;
+        size_t reservedBytes = 0;
+        // most bytes handed out for one frame slot before it was reset
+        size_t peakFrameBytes = 0;
+    };
+
+    // Bump allocator for data that only lives until its frame slot retires. Every thread gets its
+    // own chunks per slot, so allocating never takes a lock once the thread is known, and chunks are
+    // kept across resets, so once the working set is reached frames allocate nothing from the heap.
+    // Individual frees are no-ops, everything in a slot is released at once by resetFrame.
+    class EngineFrameArena {
+        public:
+            static constexpr size_t DEFAULT_CHUNK_SIZE = 256 * 1024;
+
+            EngineFrameArena(size_t frameCount, size_t chunkSize = DEFAULT_CHUNK_SIZE);
+
+            EngineFrameArena(const EngineFrameArena &) = delete;
+            EngineFrameArena &operator = (const EngineFrameArena &) = delete;
+
+            // Allocates from the calling thread's chunks for this frame slot
+            void *allocate(size_t frameIndex, size_t size, size_t alignment = alignof(std::max_align_t));
+
+            template<typename T>
+            T *allocateArray(size_t frameIndex, size_t count){
+                return static_cast<T *>(this->allocate(frameIndex, sizeof(T) * count, alignof(T)));
+            }
+
+            // Releases every allocation of this slot on every thread, no thread may still be using
+            // them or allocating for this slot, call it once the slot's fence has been waited on
+            void resetFrame(size_t frameIndex);
+
+            // For pmr containers, valid for the arena's lifetime
+            std::pmr::memory_resource *resource(size_t frameIndex){
+                return this->resources[frameIndex].get();
+            }
+
+            FrameArenaStatistics getStatistics();
+
+        private:
+            class Resource : public std::pmr::memory_resource {
+                public:
+                    Resource(EngineFrameArena &arena, size_t frameIndex): arena{arena}, frameIndex{frameIndex}{}
+
+                private:
+                    void *do_allocate(size_t bytes, size_t alignment) override {
+                        return this->arena.allocate(this->frameIndex, bytes, alignment);
+                    }
+                    // released by resetFrame
+                    void do_deallocate(void *, size_t, size_t) override {}
+                    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+                        return this == &other;
+                    }
+
+                    EngineFrameArena &arena;
+                    size_t frameIndex;
+            };
+
+            struct Chunk {
+                std::unique_ptr<unsigned char[]> data;
+                size_t size;
+            };
+
+            struct Slot {
+                std::vector<Chunk> chunks;
+                size_t chunkIndex = 0;
+                size_t offset = 0;
+                size_t usedBytes = 0;
+            };
+
+            struct ThreadChunks {
+                std::thread::id threadId;
+                std::vector<Slot> slots;
+            };
+
+            ThreadChunks &threadChunks();
+
+            const uint64_t arenaId;
+            const size_t frameCount;
+            const size_t chunkSize;
+            std::vector<std::unique_ptr<Resource>> resources;
+
+            // guards the thread list, allocations only touch the calling thread's entry
+            std::mutex threadsMutex;
+            std::vector<std::unique_ptr<ThreadChunks>> threads;
+
+            std::atomic<uint32_t> chunkCount{0};
+            std::atomic<size_t> reservedBytes{0};
+            size_t peakFrameBytes = 0;
+    };
+}
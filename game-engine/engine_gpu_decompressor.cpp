@@ -0,0 +1,270 @@
+#include "engine_gpu_decompressor.hpp"
+#include "engine_log.hpp"
+#include "engine_pipeline.hpp"
+
+// std
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace engine {
+    static double millisecondsSince(std::chrono::steady_clock::time_point start){
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment){
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    // Publics
+    EngineGpuDecompressor::EngineGpuDecompressor(EngineDevice &device): engineDevice{device}{
+        ENGINE_LOG_INFO("EngineGpuDecompressor: Initialising");
+        this->createDescriptorSetLayout();
+        this->createDescriptorSet();
+        this->createPipelineLayout();
+        this->createPipeline();
+        this->createTimestampQueryPool();
+    }
+
+    EngineGpuDecompressor::~EngineGpuDecompressor(){
+        if(this->timestampQueryPool != VK_NULL_HANDLE) vkDestroyQueryPool(this->engineDevice.device(), this->timestampQueryPool, nullptr);
+        vkDestroyPipeline(this->engineDevice.device(), this->pipeline, nullptr);
+        vkDestroyPipelineLayout(this->engineDevice.device(), this->pipelineLayout, nullptr);
+        vkDestroyDescriptorPool(this->engineDevice.device(), this->descriptorPool, nullptr);
+        vkDestroyDescriptorSetLayout(this->engineDevice.device(), this->descriptorSetLayout, nullptr);
+    }
+
+    std::unique_ptr<EngineModel> EngineGpuDecompressor::decompressModel(const EngineArchive &archive, const std::string &path, const EngineModel::Bounds &bounds, GpuDecompressionStatistics &statistics){
+        const ArchiveEntry *entry = archive.find(path);
+        if(entry == nullptr) throw std::runtime_error("File not in archive: " + path);
+        uint64_t vertexCount = entry->size / sizeof(EngineModel::Vertex);
+        bool isVertexData = entry->size % sizeof(EngineModel::Vertex) == 0 && vertexCount >= 3 && vertexCount <= std::numeric_limits<uint32_t>::max();
+        if(!isVertexData) throw std::runtime_error("Archive entry does not hold vertices: " + path);
+
+        auto model = std::make_unique<EngineModel>(this->engineDevice, static_cast<uint32_t>(vertexCount), bounds);
+        VkDrawIndirectCommand drawCommand = {};
+        drawCommand.vertexCount = static_cast<uint32_t>(vertexCount);
+        drawCommand.instanceCount = 1;
+        this->decompress(archive, *entry, model->getVertexBuffer(), model->getIndirectBuffer(), drawCommand, statistics);
+        return model;
+    }
+
+    // Privates
+    void EngineGpuDecompressor::createDescriptorSetLayout(){
+        // compressed bytes, chunk table, destination
+        std::array<VkDescriptorSetLayoutBinding, 3> bindings = {};
+        for(uint32_t i = 0; i < bindings.size(); i++){
+            bindings[i].binding = i;
+            bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            bindings[i].descriptorCount = 1;
+            bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        }
+
+        VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo = {};
+        descriptorSetLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        descriptorSetLayoutCreateInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+        descriptorSetLayoutCreateInfo.pBindings = bindings.data();
+        bool isCreateDescriptorSetLayoutSuccess = vkCreateDescriptorSetLayout(this->engineDevice.device(), &descriptorSetLayoutCreateInfo, nullptr, &this->descriptorSetLayout) == VK_SUCCESS;
+        if(!isCreateDescriptorSetLayoutSuccess) throw std::runtime_error("Failed to create decompressor descriptor set layout!");
+    }
+
+    void EngineGpuDecompressor::createDescriptorSet(){
+        VkDescriptorPoolSize poolSize = {};
+        poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        poolSize.descriptorCount = 3;
+
+        VkDescriptorPoolCreateInfo descriptorPoolCreateInfo = {};
+        descriptorPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        descriptorPoolCreateInfo.maxSets = 1;
+        descriptorPoolCreateInfo.poolSizeCount = 1;
+        descriptorPoolCreateInfo.pPoolSizes = &poolSize;
+        bool isCreateDescriptorPoolSuccess = vkCreateDescriptorPool(this->engineDevice.device(), &descriptorPoolCreateInfo, nullptr, &this->descriptorPool) == VK_SUCCESS;
+        if(!isCreateDescriptorPoolSuccess) throw std::runtime_error("Failed to create decompressor descriptor pool!");
+
+        VkDescriptorSetAllocateInfo descriptorSetAllocateInfo = {};
+        descriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        descriptorSetAllocateInfo.descriptorPool = this->descriptorPool;
+        descriptorSetAllocateInfo.descriptorSetCount = 1;
+        descriptorSetAllocateInfo.pSetLayouts = &this->descriptorSetLayout;
+        bool isAllocateDescriptorSetSuccess = vkAllocateDescriptorSets(this->engineDevice.device(), &descriptorSetAllocateInfo, &this->descriptorSet) == VK_SUCCESS;
+        if(!isAllocateDescriptorSetSuccess) throw std::runtime_error("Failed to allocate decompressor descriptor set!");
+    }
+
+    void EngineGpuDecompressor::createPipelineLayout(){
+        VkPushConstantRange pushConstantRange = {};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(uint32_t);
+
+        VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
+        pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutCreateInfo.setLayoutCount = 1;
+        pipelineLayoutCreateInfo.pSetLayouts = &this->descriptorSetLayout;
+        pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+        pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+        bool isCreatePipelineLayoutSuccess = vkCreatePipelineLayout(this->engineDevice.device(), &pipelineLayoutCreateInfo, nullptr, &this->pipelineLayout) == VK_SUCCESS;
+        if(!isCreatePipelineLayoutSuccess) throw std::runtime_error("Failed to create decompressor pipeline layout!");
+    }
+
+    void EngineGpuDecompressor::createPipeline(){
+        this->pipeline = EnginePipeline::createComputePipeline(this->engineDevice, COMPUTE_SHADER_PATH, this->pipelineLayout);
+    }
+
+    void EngineGpuDecompressor::createTimestampQueryPool(){
+        if(!this->engineDevice.properties.limits.timestampComputeAndGraphics) return;
+
+        VkQueryPoolCreateInfo queryPoolCreateInfo = {};
+        queryPoolCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryPoolCreateInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        queryPoolCreateInfo.queryCount = 2;
+        bool isCreateQueryPoolSuccess = vkCreateQueryPool(this->engineDevice.device(), &queryPoolCreateInfo, nullptr, &this->timestampQueryPool) == VK_SUCCESS;
+        if(!isCreateQueryPoolSuccess) throw std::runtime_error("Failed to create decompressor timestamp query pool!");
+    }
+
+    void EngineGpuDecompressor::decompress(const EngineArchive &archive, const ArchiveEntry &entry, VkBuffer destination, VkBuffer drawCommandBuffer, const VkDrawIndirectCommand &drawCommand, GpuDecompressionStatistics &statistics){
+        // the shader stores whole words, so no two chunks may share one
+        bool isWordAligned = archive.getChunkSize() % sizeof(uint32_t) == 0;
+        if(!isWordAligned) throw std::runtime_error("Archive chunk size is not a multiple of 4 bytes");
+        if(entry.size > std::numeric_limits<uint32_t>::max()) throw std::runtime_error("Archive entry too large to decompress on the GPU");
+
+        std::vector<GpuChunk> chunks(entry.chunkCount);
+        uint64_t sourceBytes = 0;
+        for(uint32_t i = 0; i < entry.chunkCount; i++){
+            const ArchiveChunk &chunk = archive.getChunk(entry.firstChunk + i);
+            chunks[i] = {};
+            chunks[i].sourceOffset = static_cast<uint32_t>(sourceBytes);
+            chunks[i].compressedSize = chunk.compressedSize;
+            chunks[i].destinationOffset = i * archive.getChunkSize();
+            chunks[i].size = chunk.size;
+            chunks[i].compression = static_cast<uint32_t>(chunk.compression);
+            sourceBytes += chunk.compressedSize;
+        }
+        if(sourceBytes > std::numeric_limits<uint32_t>::max()) throw std::runtime_error("Archive entry too large to decompress on the GPU");
+        statistics.chunkCount = entry.chunkCount;
+        statistics.compressedBytes = sourceBytes;
+        statistics.uncompressedBytes = entry.size;
+
+        // the chunks first, then the table on the storage buffer offset alignment, in one buffer
+        VkDeviceSize tableOffset = alignUp(std::max<VkDeviceSize>(sourceBytes, sizeof(uint32_t)), this->engineDevice.properties.limits.minStorageBufferOffsetAlignment);
+        VkDeviceSize tableBytes = sizeof(GpuChunk) * chunks.size();
+        VkDeviceSize bufferSize = tableOffset + tableBytes;
+
+        VkBuffer stagingBuffer;
+        VkDeviceMemory stagingBufferMemory;
+        this->engineDevice.createBuffer(
+            bufferSize,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            stagingBuffer,
+            stagingBufferMemory
+        );
+        VkBuffer sourceBuffer;
+        VkDeviceMemory sourceBufferMemory;
+        this->engineDevice.createBuffer(
+            bufferSize,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            sourceBuffer,
+            sourceBufferMemory
+        );
+
+        auto stagingStart = std::chrono::steady_clock::now();
+        void *data;
+        vkMapMemory(this->engineDevice.device(), stagingBufferMemory, 0, bufferSize, 0, &data);
+        char *staging = static_cast<char *>(data);
+        for(uint32_t i = 0; i < entry.chunkCount; i++){
+            const ArchiveChunk &chunk = archive.getChunk(entry.firstChunk + i);
+            memcpy(staging + chunks[i].sourceOffset, archive.getChunkData(chunk), chunk.compressedSize);
+        }
+        memcpy(staging + tableOffset, chunks.data(), tableBytes);
+        vkUnmapMemory(this->engineDevice.device(), stagingBufferMemory);
+        statistics.stagingMs = millisecondsSince(stagingStart);
+
+        std::lock_guard<std::mutex> lock{this->decompressMutex};
+        auto submitStart = std::chrono::steady_clock::now();
+        VkDescriptorBufferInfo sourceBufferInfo = {sourceBuffer, 0, tableOffset};
+        VkDescriptorBufferInfo tableBufferInfo = {sourceBuffer, tableOffset, tableBytes};
+        VkDescriptorBufferInfo destinationBufferInfo = {destination, 0, VK_WHOLE_SIZE};
+        std::array<VkWriteDescriptorSet, 3> writes = {};
+        for(uint32_t i = 0; i < writes.size(); i++){
+            writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[i].dstSet = this->descriptorSet;
+            writes[i].dstBinding = i;
+            writes[i].descriptorCount = 1;
+            writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        }
+        writes[0].pBufferInfo = &sourceBufferInfo;
+        writes[1].pBufferInfo = &tableBufferInfo;
+        writes[2].pBufferInfo = &destinationBufferInfo;
+        vkUpdateDescriptorSets(this->engineDevice.device(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+        VkCommandBuffer commandBuffer = this->engineDevice.beginSingleTimeCommands();
+        VkBufferCopy copyRegion = {};
+        copyRegion.size = bufferSize;
+        vkCmdCopyBuffer(commandBuffer, stagingBuffer, sourceBuffer, 1, &copyRegion);
+
+        VkMemoryBarrier uploadBarrier = {};
+        uploadBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        uploadBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        uploadBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &uploadBarrier, 0, nullptr, 0, nullptr);
+
+        if(this->timestampQueryPool != VK_NULL_HANDLE){
+            vkCmdResetQueryPool(commandBuffer, this->timestampQueryPool, 0, 2);
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, this->timestampQueryPool, 0);
+        }
+        uint32_t chunkCount = entry.chunkCount;
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, this->pipeline);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, this->pipelineLayout, 0, 1, &this->descriptorSet, 0, nullptr);
+        vkCmdPushConstants(commandBuffer, this->pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(chunkCount), &chunkCount);
+        vkCmdDispatch(commandBuffer, (chunkCount + LOCAL_SIZE - 1) / LOCAL_SIZE, 1, 1);
+        if(this->timestampQueryPool != VK_NULL_HANDLE){
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, this->timestampQueryPool, 1);
+        }
+        if(drawCommandBuffer != VK_NULL_HANDLE){
+            vkCmdUpdateBuffer(commandBuffer, drawCommandBuffer, 0, sizeof(drawCommand), &drawCommand);
+        }
+
+        VkMemoryBarrier decodeBarrier = {};
+        decodeBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        decodeBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+        decodeBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            1, &decodeBarrier,
+            0, nullptr,
+            0, nullptr
+        );
+        this->engineDevice.endSingleTimeCommands(commandBuffer);
+        statistics.submitMs = millisecondsSince(submitStart);
+
+        vkDestroyBuffer(this->engineDevice.device(), sourceBuffer, nullptr);
+        vkFreeMemory(this->engineDevice.device(), sourceBufferMemory, nullptr);
+        vkDestroyBuffer(this->engineDevice.device(), stagingBuffer, nullptr);
+        vkFreeMemory(this->engineDevice.device(), stagingBufferMemory, nullptr);
+
+        statistics.decodeMs = 0.0;
+        if(this->timestampQueryPool == VK_NULL_HANDLE) return;
+        uint64_t timestamps[2];
+        bool isGetQueryResultsSuccess = vkGetQueryPoolResults(
+            this->engineDevice.device(),
+            this->timestampQueryPool,
+            0,
+            2,
+            sizeof(timestamps),
+            timestamps,
+            sizeof(uint64_t),
+            VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT
+        ) == VK_SUCCESS;
+        if(!isGetQueryResultsSuccess) return;
+        double nanoseconds = static_cast<double>(timestamps[1] - timestamps[0]) * this->engineDevice.properties.limits.timestampPeriod;
+        statistics.decodeMs = nanoseconds / 1000000.0;
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include "engine_device.hpp"
+#include "engine_archive.hpp"
+#include "engine_model.hpp"
+
+// std
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace engine {
+    struct GpuDecompressionStatistics {
+        uint32_t chunkCount = 0;
+        uint64_t compressedBytes = 0;
+        uint64_t uncompressedBytes = 0;
+        // copying the compressed chunks out of the mapped archive into the staging buffer
+        double stagingMs = 0.0;
+        // the decode dispatch from timestamps, zero when the queue does not support them
+        double decodeMs = 0.0;
+        // recording, submitting and waiting for the copy and the dispatch
+        double submitMs = 0.0;
+    };
+
+    // Decodes archive entries on the GPU so large assets skip CPU decompression. The compressed
+    // chunks are copied into a staging buffer and from there into device local memory, then a
+    // compute shader decodes every chunk with an invocation of its own straight into the buffers
+    // of a generated EngineModel. Only the compressed bytes cross the bus.
+    //
+    // Work is submitted to the graphics queue and waited on, only while nothing else submits to it.
+    class EngineGpuDecompressor {
+        public:
+            static constexpr const char *COMPUTE_SHADER_PATH = "shaders/lz4_decompress.comp.spv";
+            static constexpr uint32_t LOCAL_SIZE = 64;
+
+            EngineGpuDecompressor(EngineDevice &device);
+            ~EngineGpuDecompressor();
+
+            EngineGpuDecompressor(const EngineGpuDecompressor &) = delete;
+            EngineGpuDecompressor &operator = (const EngineGpuDecompressor &) = delete;
+
+            // A generated model filled from an entry of tightly packed EngineModel::Vertex, with
+            // the draw command written for every vertex. The bounds have to be known up front since
+            // the vertices never reach the CPU. Throws when the entry is missing or not vertices.
+            std::unique_ptr<EngineModel> decompressModel(const EngineArchive &archive, const std::string &path, const EngineModel::Bounds &bounds, GpuDecompressionStatistics &statistics);
+
+        private:
+            // lz4_decompress.comp's Chunk
+            struct GpuChunk {
+                uint32_t sourceOffset;
+                uint32_t compressedSize;
+                uint32_t destinationOffset;
+                uint32_t size;
+                uint32_t compression;
+                uint32_t padding[3];
+            };
+
+            void createDescriptorSetLayout();
+            void createDescriptorSet();
+            void createPipelineLayout();
+            void createPipeline();
+            void createTimestampQueryPool();
+            // Decodes every chunk of the entry into destination from offset 0, then writes drawCommand when it is not null
+            void decompress(const EngineArchive &archive, const ArchiveEntry &entry, VkBuffer destination, VkBuffer drawCommandBuffer, const VkDrawIndirectCommand &drawCommand, GpuDecompressionStatistics &statistics);
+
+            EngineDevice &engineDevice;
+
+            VkDescriptorSetLayout descriptorSetLayout;
+            VkDescriptorPool descriptorPool;
+            // rewritten by every decompress, which waits for the dispatch before returning
+            VkDescriptorSet descriptorSet;
+            VkPipelineLayout pipelineLayout;
+            VkPipeline pipeline;
+            VkQueryPool timestampQueryPool = VK_NULL_HANDLE;
+            std::mutex decompressMutex;
+    };
+}
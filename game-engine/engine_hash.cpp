@@ -0,0 +1,20 @@
+#include "engine_hash.hpp"
+
+namespace engine {
+    uint64_t hashBytes(const void *data, size_t size, uint64_t hash){
+        constexpr uint64_t FNV_PRIME = 0x100000001b3ull;
+        const unsigned char *bytes = static_cast<const unsigned char *>(data);
+        for(size_t i = 0; i < size; i++){
+            hash ^= bytes[i];
+            hash *= FNV_PRIME;
+        }
+        return hash;
+    }
+
+    uint64_t hashString(const std::string &value, uint64_t hash){
+        // the size separates consecutive strings, "ab" + "c" must not collide with "a" + "bc"
+        uint64_t size = value.size();
+        hash = hashBytes(&size, sizeof(size), hash);
+        return hashBytes(value.data(), value.size(), hash);
+    }
+}
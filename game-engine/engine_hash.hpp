@@ -0,0 +1,14 @@
+#pragma once
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace engine {
+    // 64-bit FNV-1a, used to key pipeline permutations, archive entries and imported assets.
+    // Free of any Vulkan or window dependency so tools outside the engine can link it.
+    constexpr uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ull;
+    uint64_t hashBytes(const void *data, size_t size, uint64_t hash = FNV_OFFSET_BASIS);
+    uint64_t hashString(const std::string &value, uint64_t hash = FNV_OFFSET_BASIS);
+}
@@ -0,0 +1,101 @@
+#include "engine_light_clusterer.hpp"
+#include "engine_log.hpp"
+#include "engine_pipeline.hpp"
+
+// std
+#include <algorithm>
+#include <stdexcept>
+
+namespace engine {
+    // Publics
+    EngineLightClusterer::EngineLightClusterer(EngineDevice &device, EngineBindlessTable &bindlessTable, uint32_t frameCount):
+        engineDevice{device}, bindlessTable{bindlessTable}, frames(frameCount){
+        ENGINE_LOG_INFO("EngineLightClusterer: Initialising %ux%ux%u clusters", CLUSTER_COUNT_X, CLUSTER_COUNT_Y, CLUSTER_COUNT_Z);
+        this->createFrameResources();
+        this->createPipelineLayout();
+        this->pipeline = EnginePipeline::createComputePipeline(this->engineDevice, CLUSTER_SHADER_PATH, this->pipelineLayout);
+    }
+
+    EngineLightClusterer::~EngineLightClusterer(){
+        VkDevice device = this->engineDevice.device();
+        vkDestroyPipeline(device, this->pipeline, nullptr);
+        vkDestroyPipelineLayout(device, this->pipelineLayout, nullptr);
+        for(FrameResources &frame:this->frames){
+            this->bindlessTable.releaseStorageBuffer(frame.parameters.lightBufferIndex);
+            this->bindlessTable.releaseStorageBuffer(frame.parameters.clusterBufferIndex);
+            vkUnmapMemory(device, frame.lightBufferMemory);
+            vkDestroyBuffer(device, frame.lightBuffer, nullptr);
+            vkFreeMemory(device, frame.lightBufferMemory, nullptr);
+            vkDestroyBuffer(device, frame.clusterBuffer, nullptr);
+            vkFreeMemory(device, frame.clusterBufferMemory, nullptr);
+        }
+    }
+
+    void EngineLightClusterer::recordClustering(VkCommandBuffer commandBuffer, size_t frameIndex, uint32_t lightCount, float aspect){
+        FrameResources &frame = this->frames[frameIndex];
+        frame.parameters.lightCount = std::min(lightCount, MAX_LIGHTS);
+        frame.parameters.aspect = aspect;
+
+        // the submission makes the mapped light writes visible, and the lists are per slot so
+        // nothing still in flight reads the ones overwritten here
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, this->pipeline);
+        this->bindlessTable.bind(commandBuffer, this->pipelineLayout, VK_PIPELINE_BIND_POINT_COMPUTE);
+        vkCmdPushConstants(commandBuffer, this->pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(Parameters), &frame.parameters);
+        // one workgroup per froxel, its invocations split the lights between them
+        vkCmdDispatch(commandBuffer, CLUSTER_COUNT_X, CLUSTER_COUNT_Y, CLUSTER_COUNT_Z);
+
+        VkMemoryBarrier memoryBarrier = {};
+        memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+    }
+
+    // Privates
+    void EngineLightClusterer::createFrameResources(){
+        VkDeviceSize lightBufferSize = MAX_LIGHTS * sizeof(Light);
+        VkDeviceSize clusterBufferSize = CLUSTER_COUNT * (1 + MAX_LIGHTS_PER_CLUSTER) * sizeof(uint32_t);
+        for(FrameResources &frame:this->frames){
+            // written by the render thread every frame and read once by the cluster pass
+            this->engineDevice.createBuffer(
+                lightBufferSize,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                frame.lightBuffer,
+                frame.lightBufferMemory
+            );
+            void *data;
+            vkMapMemory(this->engineDevice.device(), frame.lightBufferMemory, 0, lightBufferSize, 0, &data);
+            frame.mappedLights = static_cast<Light *>(data);
+
+            this->engineDevice.createBuffer(
+                clusterBufferSize,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                frame.clusterBuffer,
+                frame.clusterBufferMemory
+            );
+
+            frame.parameters = {};
+            frame.parameters.lightBufferIndex = this->bindlessTable.registerStorageBuffer(frame.lightBuffer);
+            frame.parameters.clusterBufferIndex = this->bindlessTable.registerStorageBuffer(frame.clusterBuffer);
+        }
+    }
+
+    void EngineLightClusterer::createPipelineLayout(){
+        VkPushConstantRange pushConstantRange = {};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(Parameters);
+
+        VkDescriptorSetLayout descriptorSetLayout = this->bindlessTable.getDescriptorSetLayout();
+        VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
+        pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutCreateInfo.setLayoutCount = 1;
+        pipelineLayoutCreateInfo.pSetLayouts = &descriptorSetLayout;
+        pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+        pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+        bool isCreatePipelineLayoutSuccess = vkCreatePipelineLayout(this->engineDevice.device(), &pipelineLayoutCreateInfo, nullptr, &this->pipelineLayout) == VK_SUCCESS;
+        if(!isCreatePipelineLayoutSuccess) throw std::runtime_error("Failed to create light cluster pipeline layout!");
+    }
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include "engine_device.hpp"
+#include "engine_bindless_table.hpp"
+#include "engine_model.hpp"
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace engine {
+    // Clustered forward lighting. The view volume is split into a CLUSTER_COUNT_X x Y x Z grid of
+    // froxels and a compute pass bins every light of the frame into the froxels its sphere touches,
+    // so the fragment shader only iterates the lights of its own froxel. Lights, the per-froxel
+    // counts and the index lists all live in storage buffers of the bindless table, the shaders
+    // find them through the indices in Parameters.
+    //
+    // Light space is normalised device space with x scaled by the aspect ratio so radii stay
+    // round on screen: x in [-aspect, aspect], y in [-1, 1] and z is depth in [0, 1].
+    class EngineLightClusterer {
+        public:
+            static constexpr const char *CLUSTER_SHADER_PATH = "shaders/light_cluster.comp.spv";
+            static constexpr uint32_t CLUSTER_COUNT_X = 16;
+            static constexpr uint32_t CLUSTER_COUNT_Y = 12;
+            static constexpr uint32_t CLUSTER_COUNT_Z = 16;
+            static constexpr uint32_t CLUSTER_COUNT = CLUSTER_COUNT_X * CLUSTER_COUNT_Y * CLUSTER_COUNT_Z;
+            // lights past this in one froxel are dropped
+            static constexpr uint32_t MAX_LIGHTS_PER_CLUSTER = 128;
+            static constexpr uint32_t MAX_LIGHTS = 16384;
+            static constexpr uint32_t LOCAL_SIZE = 64;
+
+            // std430 Light of light_cluster.comp and simple_shader.frag
+            struct Light {
+                // xyz in light space, w is the radius
+                glm::vec4 positionRadius;
+                // rgb, w is the intensity
+                glm::vec4 color;
+            };
+
+            // Push constants of the cluster pass, and part of the fragment shader's
+            struct Parameters {
+                uint32_t lightBufferIndex;
+                uint32_t clusterBufferIndex;
+                uint32_t lightCount;
+                float aspect;
+            };
+
+            EngineLightClusterer(EngineDevice &device, EngineBindlessTable &bindlessTable, uint32_t frameCount);
+            ~EngineLightClusterer();
+
+            EngineLightClusterer(const EngineLightClusterer &) = delete;
+            EngineLightClusterer &operator = (const EngineLightClusterer &) = delete;
+
+            // Room for MAX_LIGHTS in mapped memory, only once the previous submission of the slot has completed
+            Light *mapLights(size_t frameIndex){
+                return this->frames[frameIndex].mappedLights;
+            }
+
+            // Outside a render pass, bins the first lightCount lights written through mapLights and
+            // makes the lists visible to fragment shaders
+            void recordClustering(VkCommandBuffer commandBuffer, size_t frameIndex, uint32_t lightCount, float aspect);
+
+            // What recordClustering binned for this slot
+            const Parameters &getParameters(size_t frameIndex){
+                return this->frames[frameIndex].parameters;
+            }
+
+        private:
+            struct FrameResources {
+                VkBuffer lightBuffer;
+                VkDeviceMemory lightBufferMemory;
+                Light *mappedLights;
+                // counts of every froxel followed by their index lists
+                VkBuffer clusterBuffer;
+                VkDeviceMemory clusterBufferMemory;
+                Parameters parameters;
+            };
+
+            void createFrameResources();
+            void createPipelineLayout();
+
+            EngineDevice &engineDevice;
+            EngineBindlessTable &bindlessTable;
+
+            VkPipelineLayout pipelineLayout;
+            VkPipeline pipeline;
+
+            std::vector<FrameResources> frames;
+    };
+}
@@ -0,0 +1,139 @@
+#include "engine_log.hpp"
+
+// std
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+
+namespace engine {
+    static_assert((EngineLog::CAPACITY & (EngineLog::CAPACITY - 1)) == 0, "EngineLog capacity must be a power of two");
+
+    // how long the writer sleeps once the ring is empty
+    static constexpr std::chrono::milliseconds IDLE_INTERVAL{2};
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    // Bounded multi-producer ring with one consumer. Every slot carries a sequence number: it
+    // equals the position when the slot is free for that position, and position + 1 once a
+    // producer has filled it. Producers claim positions with a compare-exchange on the tail.
+    class AsyncLog {
+        public:
+            AsyncLog(){
+                for(size_t i = 0; i < EngineLog::CAPACITY; i++) this->slots[i].sequence.store(i, std::memory_order_relaxed);
+                this->writer = std::thread{&AsyncLog::writeLoop, this};
+            }
+
+            ~AsyncLog(){
+                this->isRunning = false;
+                this->writer.join();
+                uint64_t dropped = this->dropped.load();
+                if(dropped > 0) std::fprintf(stderr, "EngineLog: %llu messages dropped\n", static_cast<unsigned long long>(dropped));
+            }
+
+            AsyncLog(const AsyncLog &) = delete;
+            AsyncLog &operator = (const AsyncLog &) = delete;
+
+            void write(LogLevel level, const char *format, va_list arguments){
+                size_t position = this->tail.load(std::memory_order_relaxed);
+                Slot *slot;
+                for(;;){
+                    slot = &this->slots[position & (EngineLog::CAPACITY - 1)];
+                    size_t sequence = slot->sequence.load(std::memory_order_acquire);
+                    intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+                    if(difference == 0){
+                        if(this->tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+                    }
+                    else if(difference < 0){
+                        // the writer has not caught up with a whole ring of messages
+                        this->dropped.fetch_add(1, std::memory_order_relaxed);
+                        return;
+                    }
+                    else position = this->tail.load(std::memory_order_relaxed);
+                }
+
+                slot->level = level;
+                int length = std::vsnprintf(slot->text.data(), EngineLog::MESSAGE_SIZE, format, arguments);
+                slot->length = length < 0 ? 0 : std::min<size_t>(static_cast<size_t>(length), EngineLog::MESSAGE_SIZE - 1);
+                slot->sequence.store(position + 1, std::memory_order_release);
+            }
+
+            void flush(){
+                size_t target = this->tail.load(std::memory_order_acquire);
+                while(this->written.load(std::memory_order_acquire) < target) std::this_thread::yield();
+            }
+
+            uint64_t droppedCount(){
+                return this->dropped.load(std::memory_order_relaxed);
+            }
+
+        private:
+            struct Slot {
+                std::atomic<size_t> sequence;
+                LogLevel level;
+                size_t length;
+                std::array<char, EngineLog::MESSAGE_SIZE> text;
+            };
+
+            // drains whatever is published, returns false when the next slot is still empty
+            bool drain(){
+                bool hasWritten = false;
+                for(;;){
+                    size_t position = this->written.load(std::memory_order_relaxed);
+                    Slot &slot = this->slots[position & (EngineLog::CAPACITY - 1)];
+                    if(slot.sequence.load(std::memory_order_acquire) != position + 1) break;
+
+                    std::FILE *stream = slot.level <= LogLevel::Warning ? stderr : stdout;
+                    std::fwrite(slot.text.data(), 1, slot.length, stream);
+                    std::fputc('\n', stream);
+                    slot.sequence.store(position + EngineLog::CAPACITY, std::memory_order_release);
+                    this->written.store(position + 1, std::memory_order_release);
+                    hasWritten = true;
+                }
+                // one flush per batch instead of one per line
+                if(hasWritten) std::fflush(stdout);
+                return hasWritten;
+            }
+
+            void writeLoop(){
+                while(this->isRunning.load(std::memory_order_relaxed)){
+                    if(!this->drain()) std::this_thread::sleep_for(IDLE_INTERVAL);
+                }
+                // everything claimed before shutdown is published shortly after
+                while(this->written.load(std::memory_order_relaxed) < this->tail.load(std::memory_order_acquire)){
+                    if(!this->drain()) std::this_thread::yield();
+                }
+            }
+
+            std::array<Slot, EngineLog::CAPACITY> slots;
+            alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail{0};
+            alignas(CACHE_LINE_SIZE) std::atomic<size_t> written{0};
+            std::atomic<uint64_t> dropped{0};
+            std::atomic<bool> isRunning{true};
+            std::thread writer;
+    };
+
+    static AsyncLog &asyncLog(){
+        static AsyncLog log;
+        return log;
+    }
+
+    // Publics
+    void EngineLog::write(LogLevel level, const char *format, ...){
+        va_list arguments;
+        va_start(arguments, format);
+        asyncLog().write(level, format, arguments);
+        va_end(arguments);
+    }
+
+    void EngineLog::flush(){
+        asyncLog().flush();
+    }
+
+    uint64_t EngineLog::droppedCount(){
+        return asyncLog().droppedCount();
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+// std
+#include <cstddef>
+#include <cstdint>
+
+// 0 errors, 1 warnings, 2 info, 3 debug and -1 for nothing at all. Messages above the level are
+// removed by the preprocessor together with their arguments. The Makefile sets it per build.
+#ifndef ENGINE_LOG_LEVEL
+    #ifdef NDEBUG
+        #define ENGINE_LOG_LEVEL 2
+    #else
+        #define ENGINE_LOG_LEVEL 3
+    #endif
+#endif
+
+namespace engine {
+    enum class LogLevel : uint8_t {
+        Error = 0,
+        Warning = 1,
+        Info = 2,
+        Debug = 3,
+    };
+
+    // Asynchronous console log. Callers format straight into a slot of a fixed size lock-free
+    // ring that any number of threads may write to, and a background thread drains it to
+    // stdout (stderr for warnings and errors). Writing never blocks or allocates: when the
+    // ring is full the message is dropped and counted. Use the ENGINE_LOG_* macros below.
+    class EngineLog {
+        public:
+            // longer messages are truncated
+            static constexpr size_t MESSAGE_SIZE = 256;
+            static constexpr size_t CAPACITY = 1024;
+
+            // printf style, the newline is added
+            static void write(LogLevel level, const char *format, ...)
+                #if defined(__GNUC__) || defined(__clang__)
+                __attribute__((format(printf, 2, 3)))
+                #endif
+                ;
+
+            // Waits until everything written before the call is on the console
+            static void flush();
+
+            static uint64_t droppedCount();
+    };
+}
+
+#if ENGINE_LOG_LEVEL >= 0
+    #define ENGINE_LOG_ERROR(...) ::engine::EngineLog::write(::engine::LogLevel::Error, __VA_ARGS__)
+#else
+    #define ENGINE_LOG_ERROR(...) ((void)0)
+#endif
+
+#if ENGINE_LOG_LEVEL >= 1
+    #define ENGINE_LOG_WARNING(...) ::engine::EngineLog::write(::engine::LogLevel::Warning, __VA_ARGS__)
+#else
+    #define ENGINE_LOG_WARNING(...) ((void)0)
+#endif
+
+#if ENGINE_LOG_LEVEL >= 2
+    #define ENGINE_LOG_INFO(...) ::engine::EngineLog::write(::engine::LogLevel::Info, __VA_ARGS__)
+#else
+    #define ENGINE_LOG_INFO(...) ((void)0)
+#endif
+
+#if ENGINE_LOG_LEVEL >= 3
+    #define ENGINE_LOG_DEBUG(...) ::engine::EngineLog::write(::engine::LogLevel::Debug, __VA_ARGS__)
+#else
+    #define ENGINE_LOG_DEBUG(...) ((void)0)
+#endif
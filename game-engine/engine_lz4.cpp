@@ -0,0 +1,128 @@
+#include "engine_lz4.hpp"
+
+// std
+#include <cstring>
+#include <stdexcept>
+
+namespace engine {
+    // the last bytes of a block are always literals, and the last match starts before MATCH_SEARCH_LIMIT
+    static constexpr size_t LAST_LITERALS = 5;
+    static constexpr size_t MATCH_SEARCH_LIMIT = 12;
+    static constexpr uint32_t HASH_BITS = 12;
+
+    static uint32_t readU32(const char *bytes){
+        uint32_t value;
+        memcpy(&value, bytes, sizeof(value));
+        return value;
+    }
+
+    static uint32_t hashSequence(uint32_t sequence){
+        return (sequence * 2654435761u) >> (32 - HASH_BITS);
+    }
+
+    // lengths past the 4 bits of the token continue in bytes of 255 until a smaller one
+    static void writeLength(std::vector<char> &output, size_t length){
+        while(length >= 255){
+            output.push_back(static_cast<char>(255));
+            length -= 255;
+        }
+        output.push_back(static_cast<char>(length));
+    }
+
+    static size_t readLength(const unsigned char *source, size_t sourceSize, size_t &position){
+        size_t length = 0;
+        unsigned char byte;
+        do {
+            if(position >= sourceSize) throw std::runtime_error("Malformed LZ4 block: truncated length");
+            byte = source[position++];
+            length += byte;
+        } while(byte == 255);
+        return length;
+    }
+
+    static void writeSequence(std::vector<char> &output, const char *literals, size_t literalCount, size_t offset, size_t matchLength){
+        size_t matchCode = matchLength - LZ4_MIN_MATCH;
+        uint8_t token = static_cast<uint8_t>((literalCount < 15 ? literalCount : 15) << 4);
+        if(matchLength > 0) token |= static_cast<uint8_t>(matchCode < 15 ? matchCode : 15);
+        output.push_back(static_cast<char>(token));
+        if(literalCount >= 15) writeLength(output, literalCount - 15);
+        output.insert(output.end(), literals, literals + literalCount);
+        // the closing sequence of the block ends after its literals
+        if(matchLength == 0) return;
+        output.push_back(static_cast<char>(offset & 0xff));
+        output.push_back(static_cast<char>(offset >> 8));
+        if(matchCode >= 15) writeLength(output, matchCode - 15);
+    }
+
+    size_t lz4Compress(const char *source, size_t sourceSize, std::vector<char> &output){
+        size_t start = output.size();
+        output.reserve(start + lz4CompressBound(sourceSize));
+
+        size_t anchor = 0;
+        if(sourceSize > MATCH_SEARCH_LIMIT){
+            // position + 1 of the last sequence seen with each hash, 0 for none
+            std::vector<uint32_t> table(size_t{1} << HASH_BITS, 0);
+            size_t searchEnd = sourceSize - MATCH_SEARCH_LIMIT;
+            size_t matchEnd = sourceSize - LAST_LITERALS;
+            size_t position = 0;
+            while(position <= searchEnd){
+                uint32_t sequence = readU32(source + position);
+                uint32_t &entry = table[hashSequence(sequence)];
+                size_t candidate = entry;
+                entry = static_cast<uint32_t>(position + 1);
+
+                bool isMatch = candidate > 0 && position - (candidate - 1) <= LZ4_MAX_OFFSET && readU32(source + candidate - 1) == sequence;
+                if(!isMatch){
+                    // step faster through data that does not compress
+                    position += 1 + ((position - anchor) >> 6);
+                    continue;
+                }
+                size_t matchPosition = candidate - 1;
+                size_t matchLength = LZ4_MIN_MATCH;
+                while(position + matchLength < matchEnd && source[matchPosition + matchLength] == source[position + matchLength]) matchLength++;
+
+                writeSequence(output, source + anchor, position - anchor, position - matchPosition, matchLength);
+                position += matchLength;
+                anchor = position;
+            }
+        }
+        writeSequence(output, source + anchor, sourceSize - anchor, 0, 0);
+        return output.size() - start;
+    }
+
+    void lz4Decompress(const char *source, size_t sourceSize, char *destination, size_t destinationSize){
+        const unsigned char *bytes = reinterpret_cast<const unsigned char *>(source);
+        size_t in = 0;
+        size_t out = 0;
+        while(true){
+            if(in >= sourceSize) throw std::runtime_error("Malformed LZ4 block: missing token");
+            uint8_t token = bytes[in++];
+
+            size_t literalCount = token >> 4;
+            if(literalCount == 15) literalCount += readLength(bytes, sourceSize, in);
+            if(literalCount > sourceSize - in || literalCount > destinationSize - out) throw std::runtime_error("Malformed LZ4 block: literals out of range");
+            memcpy(destination + out, source + in, literalCount);
+            in += literalCount;
+            out += literalCount;
+            if(in == sourceSize) break;
+
+            if(sourceSize - in < 2) throw std::runtime_error("Malformed LZ4 block: truncated offset");
+            size_t offset = bytes[in] | (static_cast<size_t>(bytes[in + 1]) << 8);
+            in += 2;
+            if(offset == 0 || offset > out) throw std::runtime_error("Malformed LZ4 block: offset out of range");
+            size_t matchLength = (token & 15) + LZ4_MIN_MATCH;
+            if((token & 15) == 15) matchLength += readLength(bytes, sourceSize, in);
+            if(matchLength > destinationSize - out) throw std::runtime_error("Malformed LZ4 block: match out of range");
+
+            // a match may overlap the bytes it produces, which repeats the last offset bytes
+            const char *match = destination + out - offset;
+            if(offset >= matchLength){
+                memcpy(destination + out, match, matchLength);
+            } else {
+                for(size_t i = 0; i < matchLength; i++) destination[out + i] = match[i];
+            }
+            out += matchLength;
+        }
+        if(out != destinationSize) throw std::runtime_error("Malformed LZ4 block: decoded size mismatch");
+    }
+}
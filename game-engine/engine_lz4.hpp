@@ -0,0 +1,25 @@
+#pragma once
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace engine {
+    // LZ4 block format (no frame header or checksum), so chunks stay readable by the reference
+    // decoder. A block is a series of sequences, each one a token, literals copied as they are and a
+    // match copied from up to 64 KiB back in the output. The last sequence only has literals.
+    constexpr size_t LZ4_MIN_MATCH = 4;
+    constexpr size_t LZ4_MAX_OFFSET = 65535;
+
+    // Largest block lz4Compress can produce for size bytes, incompressible data grows a little
+    constexpr size_t lz4CompressBound(size_t size){
+        return size + size / 255 + 16;
+    }
+
+    // Greedy single pass compressor, appends the block to output and returns its size
+    size_t lz4Compress(const char *source, size_t sourceSize, std::vector<char> &output);
+    // Decodes a block into exactly destinationSize bytes, throws on blocks that are malformed or
+    // decode to any other size
+    void lz4Decompress(const char *source, size_t sourceSize, char *destination, size_t destinationSize);
+}
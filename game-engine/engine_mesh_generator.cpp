@@ -0,0 +1,78 @@
+#include "engine_mesh_generator.hpp"
+
+// std
+#include <algorithm>
+
+namespace engine {
+    // enough tasks per thread that one slow thread does not hold up the rest
+    static constexpr uint32_t TASKS_PER_THREAD = 4;
+
+    // Publics
+    size_t EngineMeshGenerator::sierpinskiVertexCount(uint32_t depth){
+        size_t count = 3;
+        for(uint32_t i = 0; i < depth; i++) count *= 3;
+        return count;
+    }
+
+    std::vector<EngineModel::Vertex> EngineMeshGenerator::sierpinski(uint32_t depth, Corner left, Corner top, Corner right, EngineWorkerPool &workerPool){
+        std::vector<EngineModel::Vertex> vertices(sierpinskiVertexCount(depth));
+        // the calling thread works too
+        uint32_t threadCount = workerPool.threadCount() + 1;
+
+        // unroll the top of the recursion until there are enough independent subtrees
+        std::vector<Triangle> tasks{{left, top, right}};
+        uint32_t taskDepth = 0;
+        while(taskDepth < depth && tasks.size() < threadCount * TASKS_PER_THREAD){
+            std::vector<Triangle> children;
+            children.reserve(tasks.size() * 3);
+            for(const Triangle &task:tasks){
+                Triangle subdivided[3];
+                subdivide(task, subdivided);
+                children.insert(children.end(), subdivided, subdivided + 3);
+            }
+            tasks.swap(children);
+            taskDepth++;
+        }
+
+        uint32_t subtreeDepth = depth - taskDepth;
+        size_t subtreeVertexCount = sierpinskiVertexCount(subtreeDepth);
+        workerPool.parallelFor(static_cast<uint32_t>(tasks.size()), [&](uint32_t task){
+            const Triangle &triangle = tasks[task];
+            sierpinski(vertices.data() + task * subtreeVertexCount, subtreeDepth, triangle.left, triangle.top, triangle.right);
+        });
+        return vertices;
+    }
+
+    // Privates
+    void EngineMeshGenerator::sierpinski(EngineModel::Vertex *vertices, uint32_t depth, const Corner &left, const Corner &top, const Corner &right){
+        if(depth == 0){
+            vertices[0] = {top.first, top.second};
+            vertices[1] = {right.first, right.second};
+            vertices[2] = {left.first, left.second};
+            return;
+        }
+        Triangle children[3];
+        subdivide({left, top, right}, children);
+
+        size_t childVertexCount = sierpinskiVertexCount(depth - 1);
+        for(uint32_t i = 0; i < 3; i++){
+            sierpinski(vertices + i * childVertexCount, depth - 1, children[i].left, children[i].top, children[i].right);
+        }
+    }
+
+    void EngineMeshGenerator::subdivide(const Triangle &triangle, Triangle (&children)[3]){
+        const Corner &left = triangle.left;
+        const Corner &top = triangle.top;
+        const Corner &right = triangle.right;
+        glm::vec2 leftTopMidVector = (left.first + top.first) / 2.0f;
+        glm::vec2 topRightMidVector = (top.first + right.first) / 2.0f;
+        glm::vec2 rightLeftMidVector = (right.first + left.first) / 2.0f;
+
+        // bottom left triangle
+        children[0] = {left, {leftTopMidVector, top.second}, {rightLeftMidVector, right.second}};
+        // top triangle
+        children[1] = {{leftTopMidVector, left.second}, top, {topRightMidVector, right.second}};
+        // bottom right triangle
+        children[2] = {{rightLeftMidVector, left.second}, {topRightMidVector, top.second}, right};
+    }
+}
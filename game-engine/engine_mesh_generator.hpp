@@ -0,0 +1,41 @@
+#pragma once
+#include "engine_model.hpp"
+#include "engine_worker_pool.hpp"
+
+// std
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace engine {
+    // Procedural meshes generated in parallel. The output size is known up front, so the
+    // vertex array is allocated once and every task fills its own disjoint range of it, with
+    // no locking and the same vertex order as a single threaded recursion. The tasks run on a
+    // worker pool, so no thread is started per call.
+    class EngineMeshGenerator {
+        public:
+            using Corner = std::pair<glm::vec2, glm::vec3>;
+
+            // 3 vertices per triangle, 3^depth triangles
+            static size_t sierpinskiVertexCount(uint32_t depth);
+
+            // The calling thread works too, nothing else may be running a job on workerPool meanwhile
+            static std::vector<EngineModel::Vertex> sierpinski(
+                uint32_t depth,
+                Corner left,
+                Corner top,
+                Corner right,
+                EngineWorkerPool &workerPool);
+
+        private:
+            struct Triangle {
+                Corner left;
+                Corner top;
+                Corner right;
+            };
+
+            // writes exactly sierpinskiVertexCount(depth) vertices starting at vertices
+            static void sierpinski(EngineModel::Vertex *vertices, uint32_t depth, const Corner &left, const Corner &top, const Corner &right);
+            static void subdivide(const Triangle &triangle, Triangle (&children)[3]);
+    };
+}
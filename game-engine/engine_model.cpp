@@ -11,9 +11,17 @@ namespace engine {
     this->createVertexBuffers(vertices);
   }
 
+  EngineModel::EngineModel(EngineDevice &device, uint32_t maxVertexCount, const Bounds &bounds): engineDevice{device}, bounds{bounds}{
+    this->createGeneratedBuffers(maxVertexCount);
+  }
+
   EngineModel::~EngineModel(){
     vkDestroyBuffer(this->engineDevice.device(), this->vertexBuffer, nullptr);
     vkFreeMemory(this->engineDevice.device(), this->vertexBufferMemory, nullptr);
+    if(this->indirectBuffer != VK_NULL_HANDLE){
+      vkDestroyBuffer(this->engineDevice.device(), this->indirectBuffer, nullptr);
+      vkFreeMemory(this->engineDevice.device(), this->indirectBufferMemory, nullptr);
+    }
   }
 
   void EngineModel::bind(VkCommandBuffer commandBuffer){
@@ -22,20 +30,40 @@ namespace engine {
     vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
   }
 
-  void EngineModel::draw(VkCommandBuffer commandBuffer){
-    vkCmdDraw(commandBuffer, this->vertexCount, 1, 0 ,0);
+  void EngineModel::draw(VkCommandBuffer commandBuffer, uint32_t instanceCount, uint32_t firstInstance){
+    if(this->isGenerated()){
+      vkCmdDrawIndirect(commandBuffer, this->indirectBuffer, 0, 1, sizeof(VkDrawIndirectCommand));
+      return;
+    }
+    vkCmdDraw(commandBuffer, this->vertexCount, instanceCount, 0, firstInstance);
+  }
+
+  void EngineModel::bind(EngineCommandEncoder &encoder){
+    encoder.bindVertexBuffer(0, this->vertexBuffer);
+  }
+
+  void EngineModel::draw(EngineCommandEncoder &encoder, uint32_t instanceCount, uint32_t firstInstance){
+    if(this->isGenerated()){
+      encoder.drawIndirect(this->indirectBuffer, 0);
+      return;
+    }
+    encoder.draw(this->vertexCount, instanceCount, 0, firstInstance);
   }
 
   std::vector<VkVertexInputBindingDescription> EngineModel::Vertex::getBindingDescriptions(){
-    std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
+    std::vector<VkVertexInputBindingDescription> bindingDescriptions(2);
     bindingDescriptions[0].binding = 0;
     bindingDescriptions[0].stride = sizeof(Vertex);
     bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+    bindingDescriptions[1].binding = INSTANCE_BINDING;
+    bindingDescriptions[1].stride = sizeof(Instance);
+    bindingDescriptions[1].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
     return bindingDescriptions;
   }
 
   std::vector<VkVertexInputAttributeDescription> EngineModel::Vertex::getAttributeDescriptions(){
-    std::vector<VkVertexInputAttributeDescription> attributeDescriptions(2);
+    std::vector<VkVertexInputAttributeDescription> attributeDescriptions(7);
     attributeDescriptions[0].binding = 0;
     attributeDescriptions[0].location = 0;
     attributeDescriptions[0].format = VK_FORMAT_R32G32_SFLOAT;
@@ -45,6 +73,32 @@ namespace engine {
     attributeDescriptions[1].location = 1;
     attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
     attributeDescriptions[1].offset = offsetof(Vertex, color);
+
+    // a mat2 takes one location per column
+    attributeDescriptions[2].binding = INSTANCE_BINDING;
+    attributeDescriptions[2].location = 2;
+    attributeDescriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
+    attributeDescriptions[2].offset = offsetof(Instance, transform);
+
+    attributeDescriptions[3].binding = INSTANCE_BINDING;
+    attributeDescriptions[3].location = 3;
+    attributeDescriptions[3].format = VK_FORMAT_R32G32_SFLOAT;
+    attributeDescriptions[3].offset = offsetof(Instance, transform) + sizeof(glm::vec2);
+
+    attributeDescriptions[4].binding = INSTANCE_BINDING;
+    attributeDescriptions[4].location = 4;
+    attributeDescriptions[4].format = VK_FORMAT_R32_UINT;
+    attributeDescriptions[4].offset = offsetof(Instance, materialIndex);
+
+    attributeDescriptions[5].binding = INSTANCE_BINDING;
+    attributeDescriptions[5].location = 5;
+    attributeDescriptions[5].format = VK_FORMAT_R32_SFLOAT;
+    attributeDescriptions[5].offset = offsetof(Instance, depth);
+
+    attributeDescriptions[6].binding = INSTANCE_BINDING;
+    attributeDescriptions[6].location = 6;
+    attributeDescriptions[6].format = VK_FORMAT_R32G32_SFLOAT;
+    attributeDescriptions[6].offset = offsetof(Instance, translation);
     return attributeDescriptions;
   }
 
@@ -54,7 +108,14 @@ namespace engine {
     this->vertexCount = static_cast<uint32_t>(vertices.size());
     assert(this->vertexCount >= 3 && "Vertex must contain atleast 3 vertices");
 
-    // Get the total number of bytes required for the vertex buffer to store all the vertices
+    this->bounds = {vertices[0].position, vertices[0].position};
+    for(const Vertex &vertex:vertices){
+      this->bounds.min = glm::min(this->bounds.min, vertex.position);
+      this->bounds.max = glm::max(this->bounds.max, vertex.position);
+    }
+
+    // Get the total number of bytes required for the vertex buffer to store all the vertices.
+    // Host visible, so models can be created on any thread without a submission to the graphics queue
     VkDeviceSize bufferSize = sizeof(vertices[0]) * this->vertexCount;
     this->engineDevice.createBuffer(
       bufferSize, 
@@ -69,4 +130,27 @@ namespace engine {
     memcpy(data, vertices.data(), static_cast<size_t>(bufferSize));
     vkUnmapMemory(this->engineDevice.device(), this->vertexBufferMemory);
   }
+
+  void EngineModel::createGeneratedBuffers(uint32_t maxVertexCount){
+    this->vertexCount = maxVertexCount;
+    assert(this->vertexCount >= 3 && "Vertex must contain atleast 3 vertices");
+
+    // never touched by the CPU, written by a compute shader and read as vertices, copies out are
+    // for checking what the shader wrote
+    this->engineDevice.createBuffer(
+      sizeof(Vertex) * this->vertexCount,
+      VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+      this->vertexBuffer,
+      this->vertexBufferMemory
+    );
+    this->engineDevice.createBuffer(
+      sizeof(VkDrawIndirectCommand),
+      // written by the generator's shader, or with vkCmdUpdateBuffer when the vertex count is known
+      VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+      this->indirectBuffer,
+      this->indirectBufferMemory
+    );
+  }
 }
\ No newline at end of file
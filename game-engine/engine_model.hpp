@@ -1,6 +1,7 @@
 #pragma once
 
 #include "engine_device.hpp"
+#include "engine_command_encoder.hpp"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -23,25 +24,71 @@ namespace engine {
         static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
       };
 
+      // Per-instance attributes, written every frame into a dynamic buffer bound at INSTANCE_BINDING
+      struct Instance {
+        glm::mat2 transform;
+        uint32_t materialIndex;
+        // written to gl_Position.z, lower is nearer
+        float depth;
+        // added after the transform, before the camera
+        glm::vec2 translation;
+      };
+      static constexpr uint32_t INSTANCE_BINDING = 1;
+
+      // Axis aligned box around the positions in model space
+      struct Bounds {
+        glm::vec2 min;
+        glm::vec2 max;
+      };
+
       EngineModel(EngineDevice &device, const std::vector<Vertex> &vertices);
+      // Device local buffers for a mesh written on the GPU, see EngineComputeMeshGenerator.
+      // The vertex count of the draw is read from the indirect command the generator writes,
+      // the bounds have to be known up front since the vertices never reach the CPU.
+      EngineModel(EngineDevice &device, uint32_t maxVertexCount, const Bounds &bounds);
       ~EngineModel();
 
       EngineModel(const EngineModel &) = delete;
       EngineModel &operator = (const EngineModel &) = delete;
 
       void bind(VkCommandBuffer comandBuffer);
-      void draw(VkCommandBuffer commandBuffer);
+      // firstInstance selects the entry of the bound instance buffer, generated models
+      // take both instance values from their indirect command
+      void draw(VkCommandBuffer commandBuffer, uint32_t instanceCount = 1, uint32_t firstInstance = 0);
+      // Same as above, binding the vertex buffer only when another one is bound
+      void bind(EngineCommandEncoder &encoder);
+      void draw(EngineCommandEncoder &encoder, uint32_t instanceCount = 1, uint32_t firstInstance = 0);
+
+      bool isGenerated(){
+        return this->indirectBuffer != VK_NULL_HANDLE;
+      }
+      uint32_t getVertexCount(){
+        return this->vertexCount;
+      }
+      VkBuffer getVertexBuffer(){
+        return this->vertexBuffer;
+      }
+      VkBuffer getIndirectBuffer(){
+        return this->indirectBuffer;
+      }
+      const Bounds &getBounds(){
+        return this->bounds;
+      }
 
     private:
       EngineDevice &engineDevice;
       uint32_t vertexCount;
+      Bounds bounds;
 
       // Buffer and the memory are separated to have full control in memory management
       // otherwise it is easy to hit the maxMemoryAllocationCount within VkDevice
       VkBuffer vertexBuffer;
       VkDeviceMemory vertexBufferMemory;
+      VkBuffer indirectBuffer = VK_NULL_HANDLE;
+      VkDeviceMemory indirectBufferMemory = VK_NULL_HANDLE;
 
       void createVertexBuffers(const std::vector<Vertex> &vertices);
+      void createGeneratedBuffers(uint32_t maxVertexCount);
 
   };
 }
\ No newline at end of file
@@ -0,0 +1,460 @@
+#include "engine_occlusion_culler.hpp"
+#include "engine_log.hpp"
+#include "engine_pipeline.hpp"
+
+// std
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <stdexcept>
+
+namespace engine {
+    // Utilities
+    static uint32_t groupCount(uint32_t invocationCount, uint32_t localSize){
+        return (invocationCount + localSize - 1) / localSize;
+    }
+
+    static void computeBarrier(VkCommandBuffer commandBuffer, VkPipelineStageFlags dstStageMask, VkAccessFlags dstAccessMask){
+        VkMemoryBarrier memoryBarrier = {};
+        memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        memoryBarrier.dstAccessMask = dstAccessMask;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, dstStageMask, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+    }
+
+    // Publics
+    EngineOcclusionCuller::EngineOcclusionCuller(EngineDevice &device, EngineSwapChain &swapChain, uint32_t frameCount):
+        engineDevice{device}, engineSwapChain{swapChain}, frameCount{frameCount}, frames(frameCount){
+        assert(swapChain.isDepthKept() && "Occlusion culling needs the swap chain to keep its depth");
+        ENGINE_LOG_INFO("EngineOcclusionCuller: Initialising occlusion culler");
+        // transitions of combined formats have to name both aspects
+        VkFormat depthFormat = swapChain.findDepthFormat();
+        this->depthAspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+        if(depthFormat != VK_FORMAT_D32_SFLOAT) this->depthAspect |= VK_IMAGE_ASPECT_STENCIL_BIT;
+
+        this->createPyramid();
+        this->createSampler();
+        this->createFrameResources();
+        this->createDescriptorSetLayouts();
+        this->createDescriptorSets();
+        this->createPipelines();
+        this->clearPyramid();
+        ENGINE_LOG_DEBUG("\t -> EngineOcclusionCuller(): %u pyramid levels from %ux%u", this->levelCount, swapChain.width(), swapChain.height());
+    }
+
+    EngineOcclusionCuller::~EngineOcclusionCuller(){
+        VkDevice device = this->engineDevice.device();
+        vkDestroyPipeline(device, this->cullPipeline, nullptr);
+        vkDestroyPipelineLayout(device, this->cullPipelineLayout, nullptr);
+        if(this->buildMultisampledPipeline != VK_NULL_HANDLE) vkDestroyPipeline(device, this->buildMultisampledPipeline, nullptr);
+        vkDestroyPipeline(device, this->buildPipeline, nullptr);
+        vkDestroyPipelineLayout(device, this->buildPipelineLayout, nullptr);
+        vkDestroyDescriptorPool(device, this->descriptorPool, nullptr);
+        vkDestroyDescriptorSetLayout(device, this->cullDescriptorSetLayout, nullptr);
+        vkDestroyDescriptorSetLayout(device, this->buildDescriptorSetLayout, nullptr);
+        for(FrameResources &frame:this->frames){
+            vkDestroyBuffer(device, frame.drawBuffer, nullptr);
+            vkFreeMemory(device, frame.drawBufferMemory, nullptr);
+            vkDestroyBuffer(device, frame.visibilityBuffer, nullptr);
+            vkFreeMemory(device, frame.visibilityBufferMemory, nullptr);
+            vkUnmapMemory(device, frame.statisticsBufferMemory);
+            vkDestroyBuffer(device, frame.statisticsBuffer, nullptr);
+            vkFreeMemory(device, frame.statisticsBufferMemory, nullptr);
+        }
+        vkDestroySampler(device, this->sampler, nullptr);
+        for(VkImageView levelView:this->pyramidLevelViews) vkDestroyImageView(device, levelView, nullptr);
+        vkDestroyImageView(device, this->pyramidView, nullptr);
+        vkDestroyImage(device, this->pyramidImage, nullptr);
+        vkFreeMemory(device, this->pyramidImageMemory, nullptr);
+    }
+
+    bool EngineOcclusionCuller::collectStatistics(size_t frameIndex, Statistics &statistics){
+        FrameResources &frame = this->frames[frameIndex];
+        if(!frame.hasStatistics) return false;
+        statistics = *frame.mappedStatistics;
+        return true;
+    }
+
+    void EngineOcclusionCuller::recordFirstPhase(VkCommandBuffer commandBuffer, size_t frameIndex, VkBuffer instanceBuffer, VkDeviceSize instanceOffset, uint32_t instanceCount){
+        assert(instanceCount <= MAX_INSTANCES && "Too many instances to cull");
+        FrameResources &frame = this->frames[frameIndex];
+        frame.instanceCount = instanceCount;
+        frame.hasStatistics = true;
+
+        // the slot's previous submission has completed, so its set can be pointed at this frame's instances
+        VkDescriptorBufferInfo instanceBufferInfo = {instanceBuffer, instanceOffset, std::max<VkDeviceSize>(instanceCount, 1) * sizeof(CullInstance)};
+        VkWriteDescriptorSet write = {};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = frame.cullDescriptorSet;
+        write.dstBinding = 1;
+        write.descriptorCount = 1;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        write.pBufferInfo = &instanceBufferInfo;
+        vkUpdateDescriptorSets(this->engineDevice.device(), 1, &write, 0, nullptr);
+
+        vkCmdFillBuffer(commandBuffer, frame.statisticsBuffer, 0, sizeof(Statistics), 0);
+        VkMemoryBarrier memoryBarrier = {};
+        memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+
+        this->recordCull(commandBuffer, frame, 0);
+        computeBarrier(commandBuffer, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+    }
+
+    void EngineOcclusionCuller::recordSecondPhase(VkCommandBuffer commandBuffer, size_t frameIndex, uint32_t imageIndex){
+        FrameResources &frame = this->frames[frameIndex];
+        VkImage depthImage = this->engineSwapChain.getDepthImage(imageIndex);
+
+        // the first pass' depth becomes readable, and the first phase's reads of the pyramid and its
+        // draw commands have to finish before both are overwritten
+        std::array<VkImageMemoryBarrier, 2> imageBarriers = {};
+        imageBarriers[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        imageBarriers[0].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        imageBarriers[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        imageBarriers[0].oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        imageBarriers[0].newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+        imageBarriers[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageBarriers[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageBarriers[0].image = depthImage;
+        imageBarriers[0].subresourceRange = {this->depthAspect, 0, 1, 0, 1};
+        imageBarriers[1].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        imageBarriers[1].srcAccessMask = 0;
+        imageBarriers[1].dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        imageBarriers[1].oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+        imageBarriers[1].newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        imageBarriers[1].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageBarriers[1].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageBarriers[1].image = this->pyramidImage;
+        imageBarriers[1].subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, this->levelCount, 0, 1};
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0,
+            0, nullptr,
+            0, nullptr,
+            static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data()
+        );
+
+        VkExtent2D depthExtent = this->engineSwapChain.getSwapChainExtent();
+        bool isMultisampled = this->engineSwapChain.isMultisampled();
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, isMultisampled ? this->buildMultisampledPipeline : this->buildPipeline);
+        for(uint32_t level = 0; level < this->levelCount; level++){
+            if(level == 1 && isMultisampled) vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, this->buildPipeline);
+
+            VkExtent2D sourceExtent = level == 0 ? depthExtent : this->levelExtent(level - 1);
+            VkExtent2D destinationExtent = this->levelExtent(level);
+            BuildPush push = {};
+            push.sourceSize[0] = static_cast<int32_t>(sourceExtent.width);
+            push.sourceSize[1] = static_cast<int32_t>(sourceExtent.height);
+            push.destinationSize[0] = static_cast<int32_t>(destinationExtent.width);
+            push.destinationSize[1] = static_cast<int32_t>(destinationExtent.height);
+            push.sampleCount = static_cast<int32_t>(this->engineSwapChain.getSampleCount());
+
+            VkDescriptorSet descriptorSet = level == 0 ? this->depthBuildDescriptorSets[imageIndex] : this->levelBuildDescriptorSets[level - 1];
+            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, this->buildPipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+            vkCmdPushConstants(commandBuffer, this->buildPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(BuildPush), &push);
+            vkCmdDispatch(commandBuffer, groupCount(destinationExtent.width, BUILD_LOCAL_SIZE), groupCount(destinationExtent.height, BUILD_LOCAL_SIZE), 1);
+            // each level reads the one below, the last one is read by the cull
+            computeBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+        }
+
+        // back to an attachment for the continue render pass
+        VkImageMemoryBarrier depthBarrier = imageBarriers[0];
+        depthBarrier.srcAccessMask = 0;
+        depthBarrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        depthBarrier.oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+        depthBarrier.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+            0,
+            0, nullptr,
+            0, nullptr,
+            1, &depthBarrier
+        );
+
+        this->recordCull(commandBuffer, frame, 1);
+        computeBarrier(commandBuffer, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_HOST_READ_BIT);
+    }
+
+    // Privates
+    void EngineOcclusionCuller::createPyramid(){
+        VkExtent2D baseExtent = this->levelExtent(0);
+        this->levelCount = 1;
+        for(uint32_t size = std::max(baseExtent.width, baseExtent.height); size > 1; size = (size + 1) / 2) this->levelCount++;
+
+        VkImageCreateInfo imageCreateInfo = {};
+        imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageCreateInfo.format = VK_FORMAT_R32_SFLOAT;
+        imageCreateInfo.extent = {baseExtent.width, baseExtent.height, 1};
+        imageCreateInfo.mipLevels = this->levelCount;
+        imageCreateInfo.arrayLayers = 1;
+        imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageCreateInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+        imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        this->engineDevice.createImageWithInfo(imageCreateInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, this->pyramidImage, this->pyramidImageMemory);
+
+        VkImageViewCreateInfo imageViewCreateInfo = {};
+        imageViewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        imageViewCreateInfo.image = this->pyramidImage;
+        imageViewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        imageViewCreateInfo.format = VK_FORMAT_R32_SFLOAT;
+        imageViewCreateInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, this->levelCount, 0, 1};
+        bool isCreateImageViewSuccess = vkCreateImageView(this->engineDevice.device(), &imageViewCreateInfo, nullptr, &this->pyramidView) == VK_SUCCESS;
+        if(!isCreateImageViewSuccess) throw std::runtime_error("Failed to create depth pyramid view!");
+
+        this->pyramidLevelViews.resize(this->levelCount);
+        for(uint32_t level = 0; level < this->levelCount; level++){
+            imageViewCreateInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, level, 1, 0, 1};
+            isCreateImageViewSuccess = vkCreateImageView(this->engineDevice.device(), &imageViewCreateInfo, nullptr, &this->pyramidLevelViews[level]) == VK_SUCCESS;
+            if(!isCreateImageViewSuccess) throw std::runtime_error("Failed to create depth pyramid level view!");
+        }
+    }
+
+    void EngineOcclusionCuller::createSampler(){
+        // only read with texelFetch, so filtering never applies
+        VkSamplerCreateInfo samplerCreateInfo = {};
+        samplerCreateInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        samplerCreateInfo.magFilter = VK_FILTER_NEAREST;
+        samplerCreateInfo.minFilter = VK_FILTER_NEAREST;
+        samplerCreateInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        samplerCreateInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerCreateInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerCreateInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerCreateInfo.maxLod = static_cast<float>(this->levelCount);
+        bool isCreateSamplerSuccess = vkCreateSampler(this->engineDevice.device(), &samplerCreateInfo, nullptr, &this->sampler) == VK_SUCCESS;
+        if(!isCreateSamplerSuccess) throw std::runtime_error("Failed to create depth pyramid sampler!");
+    }
+
+    void EngineOcclusionCuller::createFrameResources(){
+        for(FrameResources &frame:this->frames){
+            this->engineDevice.createBuffer(
+                MAX_INSTANCES * sizeof(VkDrawIndirectCommand),
+                VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                frame.drawBuffer,
+                frame.drawBufferMemory
+            );
+            this->engineDevice.createBuffer(
+                MAX_INSTANCES * sizeof(uint32_t),
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                frame.visibilityBuffer,
+                frame.visibilityBufferMemory
+            );
+            // read back by the CPU once the slot's fence has signalled
+            this->engineDevice.createBuffer(
+                sizeof(Statistics),
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                frame.statisticsBuffer,
+                frame.statisticsBufferMemory
+            );
+            void *data;
+            vkMapMemory(this->engineDevice.device(), frame.statisticsBufferMemory, 0, sizeof(Statistics), 0, &data);
+            frame.mappedStatistics = static_cast<Statistics *>(data);
+        }
+    }
+
+    void EngineOcclusionCuller::createDescriptorSetLayouts(){
+        std::array<VkDescriptorSetLayoutBinding, 2> buildBindings = {};
+        buildBindings[0].binding = 0;
+        buildBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        buildBindings[0].descriptorCount = 1;
+        buildBindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        buildBindings[1].binding = 1;
+        buildBindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        buildBindings[1].descriptorCount = 1;
+        buildBindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+        VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo = {};
+        descriptorSetLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        descriptorSetLayoutCreateInfo.bindingCount = static_cast<uint32_t>(buildBindings.size());
+        descriptorSetLayoutCreateInfo.pBindings = buildBindings.data();
+        bool isCreateDescriptorSetLayoutSuccess = vkCreateDescriptorSetLayout(this->engineDevice.device(), &descriptorSetLayoutCreateInfo, nullptr, &this->buildDescriptorSetLayout) == VK_SUCCESS;
+        if(!isCreateDescriptorSetLayoutSuccess) throw std::runtime_error("Failed to create depth pyramid descriptor set layout!");
+
+        // pyramid, instances, draws, visibility, statistics
+        std::array<VkDescriptorSetLayoutBinding, 5> cullBindings = {};
+        for(uint32_t i = 0; i < cullBindings.size(); i++){
+            cullBindings[i].binding = i;
+            cullBindings[i].descriptorType = i == 0 ? VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            cullBindings[i].descriptorCount = 1;
+            cullBindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        }
+        descriptorSetLayoutCreateInfo.bindingCount = static_cast<uint32_t>(cullBindings.size());
+        descriptorSetLayoutCreateInfo.pBindings = cullBindings.data();
+        isCreateDescriptorSetLayoutSuccess = vkCreateDescriptorSetLayout(this->engineDevice.device(), &descriptorSetLayoutCreateInfo, nullptr, &this->cullDescriptorSetLayout) == VK_SUCCESS;
+        if(!isCreateDescriptorSetLayoutSuccess) throw std::runtime_error("Failed to create occlusion cull descriptor set layout!");
+    }
+
+    void EngineOcclusionCuller::createDescriptorSets(){
+        uint32_t imageCount = static_cast<uint32_t>(this->engineSwapChain.imageCount());
+        uint32_t buildSetCount = imageCount + this->levelCount - 1;
+
+        std::array<VkDescriptorPoolSize, 3> poolSizes = {};
+        poolSizes[0] = {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, buildSetCount + this->frameCount};
+        poolSizes[1] = {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, buildSetCount};
+        poolSizes[2] = {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, this->frameCount * 4};
+        VkDescriptorPoolCreateInfo descriptorPoolCreateInfo = {};
+        descriptorPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        descriptorPoolCreateInfo.maxSets = buildSetCount + this->frameCount;
+        descriptorPoolCreateInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+        descriptorPoolCreateInfo.pPoolSizes = poolSizes.data();
+        bool isCreateDescriptorPoolSuccess = vkCreateDescriptorPool(this->engineDevice.device(), &descriptorPoolCreateInfo, nullptr, &this->descriptorPool) == VK_SUCCESS;
+        if(!isCreateDescriptorPoolSuccess) throw std::runtime_error("Failed to create occlusion culler descriptor pool!");
+
+        std::vector<VkDescriptorSet> buildSets(buildSetCount);
+        std::vector<VkDescriptorSetLayout> buildLayouts(buildSetCount, this->buildDescriptorSetLayout);
+        VkDescriptorSetAllocateInfo descriptorSetAllocateInfo = {};
+        descriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        descriptorSetAllocateInfo.descriptorPool = this->descriptorPool;
+        descriptorSetAllocateInfo.descriptorSetCount = buildSetCount;
+        descriptorSetAllocateInfo.pSetLayouts = buildLayouts.data();
+        bool isAllocateDescriptorSetsSuccess = vkAllocateDescriptorSets(this->engineDevice.device(), &descriptorSetAllocateInfo, buildSets.data()) == VK_SUCCESS;
+        if(!isAllocateDescriptorSetsSuccess) throw std::runtime_error("Failed to allocate depth pyramid descriptor sets!");
+        this->depthBuildDescriptorSets.assign(buildSets.begin(), buildSets.begin() + imageCount);
+        this->levelBuildDescriptorSets.assign(buildSets.begin() + imageCount, buildSets.end());
+
+        for(uint32_t i = 0; i < buildSetCount; i++){
+            bool isDepthSource = i < imageCount;
+            uint32_t level = isDepthSource ? 0 : i - imageCount + 1;
+            VkDescriptorImageInfo sourceInfo = {};
+            sourceInfo.sampler = this->sampler;
+            sourceInfo.imageView = isDepthSource ? this->engineSwapChain.getDepthImageView(i) : this->pyramidLevelViews[level - 1];
+            sourceInfo.imageLayout = isDepthSource ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL;
+            VkDescriptorImageInfo destinationInfo = {VK_NULL_HANDLE, this->pyramidLevelViews[level], VK_IMAGE_LAYOUT_GENERAL};
+
+            std::array<VkWriteDescriptorSet, 2> writes = {};
+            for(uint32_t j = 0; j < writes.size(); j++){
+                writes[j].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                writes[j].dstSet = buildSets[i];
+                writes[j].dstBinding = j;
+                writes[j].descriptorCount = 1;
+            }
+            writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            writes[0].pImageInfo = &sourceInfo;
+            writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+            writes[1].pImageInfo = &destinationInfo;
+            vkUpdateDescriptorSets(this->engineDevice.device(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+        }
+
+        std::vector<VkDescriptorSetLayout> cullLayouts(this->frameCount, this->cullDescriptorSetLayout);
+        std::vector<VkDescriptorSet> cullSets(this->frameCount);
+        descriptorSetAllocateInfo.descriptorSetCount = this->frameCount;
+        descriptorSetAllocateInfo.pSetLayouts = cullLayouts.data();
+        isAllocateDescriptorSetsSuccess = vkAllocateDescriptorSets(this->engineDevice.device(), &descriptorSetAllocateInfo, cullSets.data()) == VK_SUCCESS;
+        if(!isAllocateDescriptorSetsSuccess) throw std::runtime_error("Failed to allocate occlusion cull descriptor sets!");
+
+        // everything but the instances, which move through the dynamic buffer every frame
+        for(uint32_t i = 0; i < this->frameCount; i++){
+            FrameResources &frame = this->frames[i];
+            frame.cullDescriptorSet = cullSets[i];
+            VkDescriptorImageInfo pyramidInfo = {this->sampler, this->pyramidView, VK_IMAGE_LAYOUT_GENERAL};
+            std::array<VkDescriptorBufferInfo, 3> bufferInfos = {};
+            bufferInfos[0] = {frame.drawBuffer, 0, VK_WHOLE_SIZE};
+            bufferInfos[1] = {frame.visibilityBuffer, 0, VK_WHOLE_SIZE};
+            bufferInfos[2] = {frame.statisticsBuffer, 0, VK_WHOLE_SIZE};
+
+            std::array<VkWriteDescriptorSet, 4> writes = {};
+            for(uint32_t j = 0; j < writes.size(); j++){
+                writes[j].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                writes[j].dstSet = frame.cullDescriptorSet;
+                writes[j].descriptorCount = 1;
+                writes[j].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            }
+            writes[0].dstBinding = 0;
+            writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            writes[0].pImageInfo = &pyramidInfo;
+            for(uint32_t j = 1; j < writes.size(); j++){
+                writes[j].dstBinding = j + 1;
+                writes[j].pBufferInfo = &bufferInfos[j - 1];
+            }
+            vkUpdateDescriptorSets(this->engineDevice.device(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+        }
+    }
+
+    void EngineOcclusionCuller::createPipelines(){
+        VkPushConstantRange pushConstantRange = {};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(BuildPush);
+
+        VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
+        pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutCreateInfo.setLayoutCount = 1;
+        pipelineLayoutCreateInfo.pSetLayouts = &this->buildDescriptorSetLayout;
+        pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+        pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+        bool isCreatePipelineLayoutSuccess = vkCreatePipelineLayout(this->engineDevice.device(), &pipelineLayoutCreateInfo, nullptr, &this->buildPipelineLayout) == VK_SUCCESS;
+        if(!isCreatePipelineLayoutSuccess) throw std::runtime_error("Failed to create depth pyramid pipeline layout!");
+
+        pushConstantRange.size = sizeof(CullPush);
+        pipelineLayoutCreateInfo.pSetLayouts = &this->cullDescriptorSetLayout;
+        isCreatePipelineLayoutSuccess = vkCreatePipelineLayout(this->engineDevice.device(), &pipelineLayoutCreateInfo, nullptr, &this->cullPipelineLayout) == VK_SUCCESS;
+        if(!isCreatePipelineLayoutSuccess) throw std::runtime_error("Failed to create occlusion cull pipeline layout!");
+
+        this->buildPipeline = EnginePipeline::createComputePipeline(this->engineDevice, BUILD_SHADER_PATH, this->buildPipelineLayout);
+        if(this->engineSwapChain.isMultisampled()){
+            this->buildMultisampledPipeline = EnginePipeline::createComputePipeline(this->engineDevice, BUILD_MULTISAMPLED_SHADER_PATH, this->buildPipelineLayout);
+        }
+        this->cullPipeline = EnginePipeline::createComputePipeline(this->engineDevice, CULL_SHADER_PATH, this->cullPipelineLayout);
+    }
+
+    void EngineOcclusionCuller::clearPyramid(){
+        // the farthest depth everywhere, so the first frame culls nothing
+        VkCommandBuffer commandBuffer = this->engineDevice.beginSingleTimeCommands();
+        VkImageMemoryBarrier imageBarrier = {};
+        imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        imageBarrier.srcAccessMask = 0;
+        imageBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        imageBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageBarrier.image = this->pyramidImage;
+        imageBarrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, this->levelCount, 0, 1};
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageBarrier);
+
+        VkClearColorValue farthest = {};
+        farthest.float32[0] = 1.0f;
+        vkCmdClearColorImage(commandBuffer, this->pyramidImage, VK_IMAGE_LAYOUT_GENERAL, &farthest, 1, &imageBarrier.subresourceRange);
+
+        imageBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        imageBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        imageBarrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageBarrier);
+        this->engineDevice.endSingleTimeCommands(commandBuffer);
+    }
+
+    void EngineOcclusionCuller::recordCull(VkCommandBuffer commandBuffer, FrameResources &frame, uint32_t phase){
+        if(frame.instanceCount == 0) return;
+        VkExtent2D depthExtent = this->engineSwapChain.getSwapChainExtent();
+        CullPush push = {};
+        push.depthSize = {static_cast<float>(depthExtent.width), static_cast<float>(depthExtent.height)};
+        push.instanceCount = frame.instanceCount;
+        push.phase = phase;
+        push.levelCount = static_cast<int32_t>(this->levelCount);
+
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, this->cullPipeline);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, this->cullPipelineLayout, 0, 1, &frame.cullDescriptorSet, 0, nullptr);
+        vkCmdPushConstants(commandBuffer, this->cullPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullPush), &push);
+        vkCmdDispatch(commandBuffer, groupCount(frame.instanceCount, CULL_LOCAL_SIZE), 1, 1);
+    }
+
+    VkExtent2D EngineOcclusionCuller::levelExtent(uint32_t level){
+        VkExtent2D extent = this->engineSwapChain.getSwapChainExtent();
+        for(uint32_t i = 0; i <= level; i++){
+            extent.width = std::max((extent.width + 1) / 2, 1u);
+            extent.height = std::max((extent.height + 1) / 2, 1u);
+        }
+        return extent;
+    }
+}
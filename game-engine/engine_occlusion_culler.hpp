@@ -0,0 +1,130 @@
+#pragma once
+#include "engine_device.hpp"
+#include "engine_model.hpp"
+#include "engine_swap_chain.hpp"
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace engine {
+    // Two-phase GPU occlusion culling against a hierarchical depth pyramid. Every frame writes one
+    // VkDrawIndirectCommand per instance with an instance count of 0 or 1:
+    //  1. recordFirstPhase tests every instance against the pyramid of the previous frame and
+    //     writes the draws of the visible ones, which the first render pass draws.
+    //  2. recordSecondPhase rebuilds the pyramid from that depth attachment and re-tests only the
+    //     instances culled in the first phase, the continue render pass draws the ones now visible.
+    // The swap chain has to keep its depth (see EngineSwapChain::isDepthKept).
+    class EngineOcclusionCuller {
+        public:
+            static constexpr const char *BUILD_SHADER_PATH = "shaders/hiz_build.comp.spv";
+            static constexpr const char *BUILD_MULTISAMPLED_SHADER_PATH = "shaders/hiz_build_multisampled.comp.spv";
+            static constexpr const char *CULL_SHADER_PATH = "shaders/occlusion_cull.comp.spv";
+            static constexpr uint32_t MAX_INSTANCES = 1024;
+            static constexpr uint32_t CULL_LOCAL_SIZE = 64;
+            static constexpr uint32_t BUILD_LOCAL_SIZE = 8;
+
+            // std430 CullInstance of occlusion_cull.comp
+            struct CullInstance {
+                // min xy, max xy in normalised device coordinates
+                glm::vec4 bounds;
+                float depth;
+                uint32_t vertexCount;
+                uint32_t padding[2];
+            };
+
+            // every instance of a frame ends up in exactly one counter
+            struct Statistics {
+                uint32_t frustumCulled;
+                uint32_t firstPhaseDrawn;
+                uint32_t secondPhaseDrawn;
+                uint32_t occluded;
+            };
+
+            EngineOcclusionCuller(EngineDevice &device, EngineSwapChain &swapChain, uint32_t frameCount);
+            ~EngineOcclusionCuller();
+
+            EngineOcclusionCuller(const EngineOcclusionCuller &) = delete;
+            EngineOcclusionCuller &operator = (const EngineOcclusionCuller &) = delete;
+
+            // Counters of the previous submission of this slot, call once its fence has been waited on.
+            // Returns false when the slot has not culled anything yet.
+            bool collectStatistics(size_t frameIndex, Statistics &statistics);
+
+            // Outside a render pass, instances are CullInstance entries read from instanceBuffer
+            void recordFirstPhase(VkCommandBuffer commandBuffer, size_t frameIndex, VkBuffer instanceBuffer, VkDeviceSize instanceOffset, uint32_t instanceCount);
+            // Between the first render pass and the continue render pass drawing into imageIndex
+            void recordSecondPhase(VkCommandBuffer commandBuffer, size_t frameIndex, uint32_t imageIndex);
+
+            // The draw of instance i is at i * sizeof(VkDrawIndirectCommand)
+            VkBuffer getDrawBuffer(size_t frameIndex){
+                return this->frames[frameIndex].drawBuffer;
+            }
+
+        private:
+            struct CullPush {
+                glm::vec2 depthSize;
+                uint32_t instanceCount;
+                uint32_t phase;
+                int32_t levelCount;
+            };
+
+            struct BuildPush {
+                int32_t sourceSize[2];
+                int32_t destinationSize[2];
+                int32_t sampleCount;
+            };
+
+            struct FrameResources {
+                VkBuffer drawBuffer;
+                VkDeviceMemory drawBufferMemory;
+                VkBuffer visibilityBuffer;
+                VkDeviceMemory visibilityBufferMemory;
+                VkBuffer statisticsBuffer;
+                VkDeviceMemory statisticsBufferMemory;
+                Statistics *mappedStatistics;
+                VkDescriptorSet cullDescriptorSet;
+                uint32_t instanceCount = 0;
+                bool hasStatistics = false;
+            };
+
+            void createPyramid();
+            void createSampler();
+            void createFrameResources();
+            void createDescriptorSetLayouts();
+            void createDescriptorSets();
+            void createPipelines();
+            void clearPyramid();
+            void recordCull(VkCommandBuffer commandBuffer, FrameResources &frame, uint32_t phase);
+            VkExtent2D levelExtent(uint32_t level);
+
+            EngineDevice &engineDevice;
+            EngineSwapChain &engineSwapChain;
+            uint32_t frameCount;
+            VkImageAspectFlags depthAspect;
+
+            // R32 farthest depth, level 0 is half the depth attachment rounded up
+            VkImage pyramidImage;
+            VkDeviceMemory pyramidImageMemory;
+            // all levels for the cull shader, one per level as storage for the build
+            VkImageView pyramidView;
+            std::vector<VkImageView> pyramidLevelViews;
+            uint32_t levelCount;
+            VkSampler sampler;
+
+            VkDescriptorSetLayout buildDescriptorSetLayout;
+            VkDescriptorSetLayout cullDescriptorSetLayout;
+            VkDescriptorPool descriptorPool;
+            // level 0 from each swap chain image's depth, then level i from level i - 1
+            std::vector<VkDescriptorSet> depthBuildDescriptorSets;
+            std::vector<VkDescriptorSet> levelBuildDescriptorSets;
+
+            VkPipelineLayout buildPipelineLayout;
+            VkPipeline buildPipeline;
+            VkPipeline buildMultisampledPipeline = VK_NULL_HANDLE;
+            VkPipelineLayout cullPipelineLayout;
+            VkPipeline cullPipeline;
+
+            std::vector<FrameResources> frames;
+    };
+}
@@ -0,0 +1,247 @@
+#include "engine_particle_system.hpp"
+#include "engine_log.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+
+namespace engine {
+    // y points down the screen
+    static const glm::vec2 GRAVITY = {0.0f, 0.5f};
+
+    // Utilities
+    static uint32_t groupCount(uint32_t invocationCount, uint32_t localSize){
+        return (invocationCount + localSize - 1) / localSize;
+    }
+
+    static void computeBarrier(VkCommandBuffer commandBuffer, VkPipelineStageFlags dstStageMask, VkAccessFlags dstAccessMask){
+        VkMemoryBarrier memoryBarrier = {};
+        memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        memoryBarrier.dstAccessMask = dstAccessMask;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, dstStageMask, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+    }
+
+    // Publics
+    EngineParticleSystem::EngineParticleSystem(EngineDevice &device, EngineBindlessTable &bindlessTable, EnginePipelineCache &pipelineCache, EngineSwapChain &swapChain, uint32_t capacity, uint32_t frameCount):
+        engineDevice{device}, bindlessTable{bindlessTable}, pipelineCache{pipelineCache}, engineSwapChain{swapChain}, capacity{std::min(capacity, MAX_CAPACITY)}, frames(frameCount){
+        ENGINE_LOG_INFO("EngineParticleSystem: Initialising room for %u particles", this->capacity);
+        this->createStates();
+        this->createFrameResources();
+        this->createPipelineLayouts();
+        this->computePipeline = EnginePipeline::createComputePipeline(this->engineDevice, COMPUTE_SHADER_PATH, this->computePipelineLayout);
+        this->createPipeline();
+    }
+
+    EngineParticleSystem::~EngineParticleSystem(){
+        VkDevice device = this->engineDevice.device();
+        vkDestroyPipeline(device, this->computePipeline, nullptr);
+        vkDestroyPipelineLayout(device, this->computePipelineLayout, nullptr);
+        vkDestroyPipelineLayout(device, this->drawPipelineLayout, nullptr);
+        for(FrameResources &frame:this->frames){
+            this->bindlessTable.releaseStorageBuffer(frame.emitterBufferIndex);
+            this->bindlessTable.releaseStorageBuffer(frame.statisticsBufferIndex);
+            vkUnmapMemory(device, frame.emitterBufferMemory);
+            vkDestroyBuffer(device, frame.emitterBuffer, nullptr);
+            vkFreeMemory(device, frame.emitterBufferMemory, nullptr);
+            vkUnmapMemory(device, frame.statisticsBufferMemory);
+            vkDestroyBuffer(device, frame.statisticsBuffer, nullptr);
+            vkFreeMemory(device, frame.statisticsBufferMemory, nullptr);
+        }
+        for(uint32_t i = 0; i < 2; i++){
+            this->bindlessTable.releaseStorageBuffer(this->stateIndices[i]);
+            vkDestroyBuffer(device, this->stateBuffers[i], nullptr);
+            vkFreeMemory(device, this->stateBufferMemories[i], nullptr);
+        }
+    }
+
+    void EngineParticleSystem::createPipeline(){
+        PipelineConfigInfo pipelineConfig = EnginePipeline::particlePipelineConfig(this->engineSwapChain.width(), this->engineSwapChain.height());
+        pipelineConfig.renderPass = this->engineSwapChain.getRenderPass();
+        pipelineConfig.pipelineLayout = this->drawPipelineLayout;
+        pipelineConfig.pipelineMultiSampleStateCreateInfo.rasterizationSamples = this->engineSwapChain.getSampleCount();
+        this->drawPipeline = &this->pipelineCache.getPipeline(VERTEX_SHADER_PATH, FRAGMENT_SHADER_PATH, pipelineConfig);
+    }
+
+    bool EngineParticleSystem::collectStatistics(size_t frameIndex, Statistics &statistics){
+        FrameResources &frame = this->frames[frameIndex];
+        if(!frame.hasStatistics) return false;
+        statistics = *frame.mappedStatistics;
+        return true;
+    }
+
+    void EngineParticleSystem::recordSimulation(VkCommandBuffer commandBuffer, size_t frameIndex, const Emitter *emitters, uint32_t emitterCount, float deltaSeconds){
+        assert(emitterCount <= MAX_EMITTERS && "Too many particle emitters");
+        FrameResources &frame = this->frames[frameIndex];
+        uint32_t source = this->currentState;
+        uint32_t destination = 1 - source;
+
+        // whole particles only, the fractions carry over so low rates still emit
+        uint32_t emitCount = 0;
+        for(uint32_t i = 0; i < emitterCount; i++){
+            const Emitter &emitter = emitters[i];
+            float owed = this->emissionRemainders[i] + emitter.particlesPerSecond * deltaSeconds;
+            uint32_t particleCount = static_cast<uint32_t>(owed);
+            this->emissionRemainders[i] = owed - particleCount;
+            // more than the capacity would only be dropped by the shader
+            particleCount = std::min(particleCount, this->capacity - emitCount);
+
+            EmitterRecord &record = frame.mappedEmitters[i];
+            record.position = emitter.position;
+            record.velocity = emitter.velocity;
+            record.color = emitter.color;
+            record.depth = emitter.depth;
+            record.speedSpread = emitter.speedSpread;
+            record.lifeSeconds = emitter.lifeSeconds;
+            record.size = emitter.size;
+            record.firstParticle = emitCount;
+            record.particleCount = particleCount;
+            emitCount += particleCount;
+        }
+        frame.mappedStatistics->uploadedBytes = emitterCount * sizeof(EmitterRecord);
+
+        // last frame's draw and the simulation before it still read the destination
+        VkMemoryBarrier memoryBarrier = {};
+        memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        memoryBarrier.srcAccessMask = 0;
+        memoryBarrier.dstAccessMask = 0;
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0, 1, &memoryBarrier, 0, nullptr, 0, nullptr
+        );
+        // only the live count restarts, the rest of the header is rewritten by the finalize phase
+        vkCmdFillBuffer(commandBuffer, this->stateBuffers[destination], offsetof(VkDrawIndirectCommand, instanceCount), sizeof(uint32_t), 0);
+        memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+
+        SimulationPush push = {};
+        push.sourceIndex = this->stateIndices[source];
+        push.destinationIndex = this->stateIndices[destination];
+        push.emitterBufferIndex = frame.emitterBufferIndex;
+        push.statisticsBufferIndex = frame.statisticsBufferIndex;
+        push.emitterCount = emitterCount;
+        push.emitCount = emitCount;
+        push.capacity = this->capacity;
+        push.seed = this->seed++;
+        push.deltaSeconds = deltaSeconds;
+        push.gravity = GRAVITY;
+
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, this->computePipeline);
+        this->bindlessTable.bind(commandBuffer, this->computePipelineLayout, VK_PIPELINE_BIND_POINT_COMPUTE);
+
+        push.phase = PHASE_SIMULATE;
+        vkCmdPushConstants(commandBuffer, this->computePipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(SimulationPush), &push);
+        // sized by the previous finalize phase, the CPU never learns how many particles are alive
+        vkCmdDispatchIndirect(commandBuffer, this->stateBuffers[source], offsetof(StateHeader, dispatch));
+        computeBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+        if(emitCount > 0){
+            push.phase = PHASE_EMIT;
+            vkCmdPushConstants(commandBuffer, this->computePipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(SimulationPush), &push);
+            vkCmdDispatch(commandBuffer, groupCount(emitCount, LOCAL_SIZE), 1, 1);
+            computeBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+        }
+
+        push.phase = PHASE_FINALIZE;
+        vkCmdPushConstants(commandBuffer, this->computePipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(SimulationPush), &push);
+        vkCmdDispatch(commandBuffer, 1, 1, 1);
+        computeBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+            VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_HOST_READ_BIT
+        );
+
+        this->currentState = destination;
+        frame.hasStatistics = true;
+    }
+
+    void EngineParticleSystem::recordDraw(VkCommandBuffer commandBuffer, const glm::mat2 &camera){
+        DrawPush push = {};
+        push.camera = camera;
+        push.stateIndex = this->stateIndices[this->currentState];
+
+        this->drawPipeline->bind(commandBuffer);
+        this->bindlessTable.bind(commandBuffer, this->drawPipelineLayout);
+        vkCmdPushConstants(commandBuffer, this->drawPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(DrawPush), &push);
+        // six vertices per particle, one instance per live particle
+        vkCmdDrawIndirect(commandBuffer, this->stateBuffers[this->currentState], offsetof(StateHeader, draw), 1, sizeof(VkDrawIndirectCommand));
+    }
+
+    // Privates
+    void EngineParticleSystem::createStates(){
+        VkDeviceSize stateBufferSize = sizeof(StateHeader) + static_cast<VkDeviceSize>(this->capacity) * sizeof(Particle);
+        VkCommandBuffer commandBuffer = this->engineDevice.beginSingleTimeCommands();
+        for(uint32_t i = 0; i < 2; i++){
+            this->engineDevice.createBuffer(
+                stateBufferSize,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                this->stateBuffers[i],
+                this->stateBufferMemories[i]
+            );
+            this->stateIndices[i] = this->bindlessTable.registerStorageBuffer(this->stateBuffers[i]);
+            // no particles, which draws nothing and dispatches no simulation
+            vkCmdFillBuffer(commandBuffer, this->stateBuffers[i], 0, sizeof(StateHeader), 0);
+        }
+        this->engineDevice.endSingleTimeCommands(commandBuffer);
+    }
+
+    void EngineParticleSystem::createFrameResources(){
+        VkDeviceSize emitterBufferSize = MAX_EMITTERS * sizeof(EmitterRecord);
+        for(FrameResources &frame:this->frames){
+            // written by the render thread every frame and read once by the emit phase
+            this->engineDevice.createBuffer(
+                emitterBufferSize,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                frame.emitterBuffer,
+                frame.emitterBufferMemory
+            );
+            void *data;
+            vkMapMemory(this->engineDevice.device(), frame.emitterBufferMemory, 0, emitterBufferSize, 0, &data);
+            frame.mappedEmitters = static_cast<EmitterRecord *>(data);
+            frame.emitterBufferIndex = this->bindlessTable.registerStorageBuffer(frame.emitterBuffer);
+
+            // the finalize phase writes the live count here for the CPU to read once the fence has signalled
+            this->engineDevice.createBuffer(
+                sizeof(Statistics),
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                frame.statisticsBuffer,
+                frame.statisticsBufferMemory
+            );
+            vkMapMemory(this->engineDevice.device(), frame.statisticsBufferMemory, 0, sizeof(Statistics), 0, &data);
+            frame.mappedStatistics = static_cast<Statistics *>(data);
+            frame.statisticsBufferIndex = this->bindlessTable.registerStorageBuffer(frame.statisticsBuffer);
+        }
+    }
+
+    void EngineParticleSystem::createPipelineLayouts(){
+        VkDescriptorSetLayout descriptorSetLayout = this->bindlessTable.getDescriptorSetLayout();
+
+        VkPushConstantRange pushConstantRange = {};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(SimulationPush);
+
+        VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
+        pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutCreateInfo.setLayoutCount = 1;
+        pipelineLayoutCreateInfo.pSetLayouts = &descriptorSetLayout;
+        pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+        pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+        bool isCreatePipelineLayoutSuccess = vkCreatePipelineLayout(this->engineDevice.device(), &pipelineLayoutCreateInfo, nullptr, &this->computePipelineLayout) == VK_SUCCESS;
+        if(!isCreatePipelineLayoutSuccess) throw std::runtime_error("Failed to create particle simulation pipeline layout!");
+
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+        pushConstantRange.size = sizeof(DrawPush);
+        isCreatePipelineLayoutSuccess = vkCreatePipelineLayout(this->engineDevice.device(), &pipelineLayoutCreateInfo, nullptr, &this->drawPipelineLayout) == VK_SUCCESS;
+        if(!isCreatePipelineLayoutSuccess) throw std::runtime_error("Failed to create particle draw pipeline layout!");
+    }
+}
@@ -0,0 +1,176 @@
+#pragma once
+#include "engine_device.hpp"
+#include "engine_bindless_table.hpp"
+#include "engine_model.hpp"
+#include "engine_pipeline.hpp"
+#include "engine_pipeline_cache.hpp"
+#include "engine_swap_chain.hpp"
+
+// std
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace engine {
+    // Particles that live entirely on the GPU. The state is two device local storage buffers, each
+    // a header followed by the live particles, and every frame one compute shader reads the current
+    // state and writes the next one in three phases:
+    //  1. simulate integrates every live particle and appends the survivors, which compacts the
+    //     dead ones away, the dispatch size comes from the header of the current state
+    //  2. emit appends the particles of every emitter this frame, up to the capacity
+    //  3. finalize writes the header: the indirect draw with one instance per live particle and
+    //     the indirect dispatch of the next frame's simulation
+    // The particle pipeline then draws the new state with one indirect instanced draw, so the
+    // particle count never reaches the CPU. The only upload is the emitter records of the frame.
+    class EngineParticleSystem {
+        public:
+            static constexpr const char *COMPUTE_SHADER_PATH = "shaders/particles.comp.spv";
+            static constexpr const char *VERTEX_SHADER_PATH = "shaders/particle.vert.spv";
+            static constexpr const char *FRAGMENT_SHADER_PATH = "shaders/particle.frag.spv";
+            static constexpr uint32_t LOCAL_SIZE = 64;
+            static constexpr uint32_t MAX_EMITTERS = 64;
+            // keeps every dispatch within the 65535 workgroups all devices support
+            static constexpr uint32_t MAX_CAPACITY = 4000000;
+
+            // One source of particles, positions and velocities are in the space before the camera
+            struct Emitter {
+                glm::vec2 position{0.0f};
+                glm::vec2 velocity{0.0f};
+                glm::vec4 color{1.0f};
+                float depth = 0.5f;
+                // particles leave in a random direction at up to this speed on top of velocity
+                float speedSpread = 0.0f;
+                // particles live between half and all of it
+                float lifeSeconds = 1.0f;
+                // half the side of the quad in normalised device coordinates
+                float size = 0.01f;
+                float particlesPerSecond = 0.0f;
+            };
+
+            struct Statistics {
+                uint32_t aliveCount;
+                // emitter records written for the frame, all the CPU sends
+                uint32_t uploadedBytes;
+            };
+
+            EngineParticleSystem(EngineDevice &device, EngineBindlessTable &bindlessTable, EnginePipelineCache &pipelineCache, EngineSwapChain &swapChain, uint32_t capacity, uint32_t frameCount);
+            ~EngineParticleSystem();
+
+            EngineParticleSystem(const EngineParticleSystem &) = delete;
+            EngineParticleSystem &operator = (const EngineParticleSystem &) = delete;
+
+            // Builds the draw pipeline for the swap chain's render pass, or picks up the rebuilt one after a shader reload
+            void createPipeline();
+
+            // Counters of the previous submission of this slot, call once its fence has been waited on.
+            // Returns false when the slot has not simulated anything yet.
+            bool collectStatistics(size_t frameIndex, Statistics &statistics);
+
+            // Outside a render pass. Advances every particle by deltaSeconds and emits what the
+            // emitters produced meanwhile, the results are visible to the draw afterwards.
+            void recordSimulation(VkCommandBuffer commandBuffer, size_t frameIndex, const Emitter *emitters, uint32_t emitterCount, float deltaSeconds);
+            // Inside a render pass compatible with the swap chain's, after the opaque geometry
+            void recordDraw(VkCommandBuffer commandBuffer, const glm::mat2 &camera);
+
+            uint32_t getCapacity(){
+                return this->capacity;
+            }
+
+        private:
+            enum Phase : uint32_t {
+                PHASE_SIMULATE = 0,
+                PHASE_EMIT = 1,
+                PHASE_FINALIZE = 2,
+            };
+
+            // std430 Particle of particles.comp and particle.vert
+            struct Particle {
+                glm::vec2 position;
+                glm::vec2 velocity;
+                float depth;
+                float life;
+                float size;
+                // RGBA8
+                uint32_t color;
+            };
+
+            // the header in front of the particles of a state buffer
+            struct StateHeader {
+                VkDrawIndirectCommand draw;
+                VkDispatchIndirectCommand dispatch;
+                uint32_t padding;
+            };
+
+            // std430 Emitter of particles.comp, with the range of the frame's emission it owns
+            struct EmitterRecord {
+                glm::vec2 position;
+                glm::vec2 velocity;
+                glm::vec4 color;
+                float depth;
+                float speedSpread;
+                float lifeSeconds;
+                float size;
+                uint32_t firstParticle;
+                uint32_t particleCount;
+                uint32_t padding[2];
+            };
+
+            struct SimulationPush {
+                uint32_t sourceIndex;
+                uint32_t destinationIndex;
+                uint32_t emitterBufferIndex;
+                uint32_t statisticsBufferIndex;
+                uint32_t emitterCount;
+                uint32_t emitCount;
+                uint32_t capacity;
+                uint32_t seed;
+                uint32_t phase;
+                float deltaSeconds;
+                glm::vec2 gravity;
+            };
+
+            struct DrawPush {
+                glm::mat2 camera;
+                uint32_t stateIndex;
+            };
+
+            struct FrameResources {
+                VkBuffer emitterBuffer;
+                VkDeviceMemory emitterBufferMemory;
+                EmitterRecord *mappedEmitters;
+                uint32_t emitterBufferIndex;
+                VkBuffer statisticsBuffer;
+                VkDeviceMemory statisticsBufferMemory;
+                Statistics *mappedStatistics;
+                uint32_t statisticsBufferIndex;
+                bool hasStatistics = false;
+            };
+
+            void createStates();
+            void createFrameResources();
+            void createPipelineLayouts();
+
+            EngineDevice &engineDevice;
+            EngineBindlessTable &bindlessTable;
+            EnginePipelineCache &pipelineCache;
+            EngineSwapChain &engineSwapChain;
+            uint32_t capacity;
+
+            // the state drawn last, the next simulation reads it and writes the other one
+            std::array<VkBuffer, 2> stateBuffers;
+            std::array<VkDeviceMemory, 2> stateBufferMemories;
+            std::array<uint32_t, 2> stateIndices;
+            uint32_t currentState = 0;
+            uint32_t seed = 0;
+            // fractions of a particle every emitter still owes, carried between frames
+            std::array<float, MAX_EMITTERS> emissionRemainders{};
+
+            VkPipelineLayout computePipelineLayout;
+            VkPipeline computePipeline;
+            VkPipelineLayout drawPipelineLayout;
+            // owned by the cache
+            EnginePipeline *drawPipeline = nullptr;
+
+            std::vector<FrameResources> frames;
+    };
+}
@@ -9,6 +9,8 @@
 #include <cassert>
 
 namespace engine {
+    EngineArchive *EnginePipeline::shaderArchive = nullptr;
+
     // Publics
     EnginePipeline::EnginePipeline(EngineDevice &device, const std::string& vertexFilePath, const std::string& fragmentFilePath, const PipelineConfigInfo& configInfo): engineDevice{device} {
         this->createGraphicsPipeline(vertexFilePath, fragmentFilePath, configInfo);
@@ -25,6 +27,8 @@ namespace engine {
         pipelineConfigInfo.pipelineInputAssemblyStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
         pipelineConfigInfo.pipelineInputAssemblyStateCreateInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
         pipelineConfigInfo.pipelineInputAssemblyStateCreateInfo.primitiveRestartEnable = VK_FALSE;
+        pipelineConfigInfo.bindingDescriptions = EngineModel::Vertex::getBindingDescriptions();
+        pipelineConfigInfo.attributeDescriptions = EngineModel::Vertex::getAttributeDescriptions();
 
         // View ports
         pipelineConfigInfo.viewPort.x = 0.0f;
@@ -97,12 +101,84 @@ namespace engine {
         return pipelineConfigInfo;
     }
 
+    PipelineConfigInfo EnginePipeline::depthOnlyPipelineConfig(uint32_t width, uint32_t height){
+        PipelineConfigInfo pipelineConfigInfo = defaultPipelineConfig(width, height);
+        pipelineConfigInfo.pipelineColorBlendStateCreateInfo.attachmentCount = 0;
+        pipelineConfigInfo.pipelineRasterizationStateCreateInfo.depthBiasEnable = VK_TRUE;
+        pipelineConfigInfo.pipelineRasterizationStateCreateInfo.depthBiasConstantFactor = 1.25f;
+        pipelineConfigInfo.pipelineRasterizationStateCreateInfo.depthBiasSlopeFactor = 1.75f;
+        return pipelineConfigInfo;
+    }
+
+    PipelineConfigInfo EnginePipeline::particlePipelineConfig(uint32_t width, uint32_t height){
+        PipelineConfigInfo pipelineConfigInfo = defaultPipelineConfig(width, height);
+        pipelineConfigInfo.bindingDescriptions.clear();
+        pipelineConfigInfo.attributeDescriptions.clear();
+        // the fragment shader writes premultiplied colour, so overlapping particles need no sorting
+        pipelineConfigInfo.pipelineColorBlendAttachmentState.blendEnable = VK_TRUE;
+        pipelineConfigInfo.pipelineColorBlendAttachmentState.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+        pipelineConfigInfo.pipelineColorBlendAttachmentState.dstColorBlendFactor = VK_BLEND_FACTOR_ONE;
+        pipelineConfigInfo.pipelineColorBlendAttachmentState.srcAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+        pipelineConfigInfo.pipelineColorBlendAttachmentState.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+        // tested against the opaque geometry, but particles never hide each other
+        pipelineConfigInfo.pipelineDepthStencilStateCreateInfo.depthWriteEnable = VK_FALSE;
+        return pipelineConfigInfo;
+    }
+
+    PipelineConfigInfo EnginePipeline::spritePipelineConfig(uint32_t width, uint32_t height){
+        PipelineConfigInfo pipelineConfigInfo = defaultPipelineConfig(width, height);
+        pipelineConfigInfo.bindingDescriptions.clear();
+        pipelineConfigInfo.attributeDescriptions.clear();
+        pipelineConfigInfo.pipelineColorBlendAttachmentState.blendEnable = VK_TRUE;
+        pipelineConfigInfo.pipelineColorBlendAttachmentState.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+        pipelineConfigInfo.pipelineColorBlendAttachmentState.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+        pipelineConfigInfo.pipelineColorBlendAttachmentState.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+        pipelineConfigInfo.pipelineColorBlendAttachmentState.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+        // layers are ordered by drawing them in order
+        pipelineConfigInfo.pipelineDepthStencilStateCreateInfo.depthTestEnable = VK_FALSE;
+        pipelineConfigInfo.pipelineDepthStencilStateCreateInfo.depthWriteEnable = VK_FALSE;
+        return pipelineConfigInfo;
+    }
+
     void EnginePipeline::bind(VkCommandBuffer commandBuffer){
         vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, this->graphicsPipeline);
     }
+
+    void EnginePipeline::bind(EngineCommandEncoder &encoder){
+        encoder.bindPipeline(this->graphicsPipeline);
+    }
+
+    void EnginePipeline::setShaderArchive(EngineArchive *archive){
+        shaderArchive = archive;
+    }
     
+    VkPipeline EnginePipeline::createComputePipeline(EngineDevice &device, const std::string &computeFilePath, VkPipelineLayout pipelineLayout){
+        std::vector<char> computeCode = readFile(computeFilePath);
+        VkShaderModuleCreateInfo shaderModuleCreateInfo = {};
+        shaderModuleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        shaderModuleCreateInfo.codeSize = computeCode.size();
+        shaderModuleCreateInfo.pCode = reinterpret_cast<const uint32_t *>(computeCode.data());
+        VkShaderModule computeShaderModule;
+        bool isCreateShaderModuleSuccess = vkCreateShaderModule(device.device(), &shaderModuleCreateInfo, nullptr, &computeShaderModule) == VK_SUCCESS;
+        if(!isCreateShaderModuleSuccess) throw std::runtime_error("Failed to create shader module!");
+
+        VkComputePipelineCreateInfo computePipelineCreateInfo = {};
+        computePipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        computePipelineCreateInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        computePipelineCreateInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        computePipelineCreateInfo.stage.module = computeShaderModule;
+        computePipelineCreateInfo.stage.pName = "main";
+        computePipelineCreateInfo.layout = pipelineLayout;
+        VkPipeline pipeline;
+        bool isCreatePipelineSuccess = vkCreateComputePipelines(device.device(), VK_NULL_HANDLE, 1, &computePipelineCreateInfo, nullptr, &pipeline) == VK_SUCCESS;
+        vkDestroyShaderModule(device.device(), computeShaderModule, nullptr);
+        if(!isCreatePipelineSuccess) throw std::runtime_error("Failed to create compute pipeline: " + computeFilePath);
+        return pipeline;
+    }
+
     // Privates    
     std::vector<char> EnginePipeline::readFile(const std::string& filePath){
+        if(shaderArchive != nullptr && shaderArchive->contains(filePath)) return shaderArchive->read(filePath);
         
         // read file, and when open seeked the end immediately and read it as binary
         
@@ -132,11 +208,16 @@ namespace engine {
         assert(configInfo.renderPass != VK_NULL_HANDLE && "Cannot create graphics pipeline:: no renderPass provided in configInfo");
 
         auto vertexCode = this->readFile(vertexFilePath);
-        auto fragmentCode = this->readFile(fragmentFilePath);
-        
         this->createShaderModule(vertexCode, &this->vertexShaderModule);
-        this->createShaderModule(fragmentCode, &this->fragmentShadeModule);
+        // depth only pipelines have nothing to shade
+        bool hasFragmentStage = !fragmentFilePath.empty();
+        if(hasFragmentStage){
+            auto fragmentCode = this->readFile(fragmentFilePath);
+            this->createShaderModule(fragmentCode, &this->fragmentShadeModule);
+        }
         
+        ShaderSpecialization specialization(configInfo.permutation);
+
         VkPipelineShaderStageCreateInfo shaderStages[2];
         shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
         shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
@@ -144,7 +225,7 @@ namespace engine {
         shaderStages[0].pName = "main";
         shaderStages[0].flags = 0;
         shaderStages[0].pNext = nullptr;
-        shaderStages[0].pSpecializationInfo = nullptr;
+        shaderStages[0].pSpecializationInfo = &specialization.info;
 
 
         shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -153,17 +234,14 @@ namespace engine {
         shaderStages[1].pName = "main";
         shaderStages[1].flags = 0;
         shaderStages[1].pNext = nullptr;
-        shaderStages[1].pSpecializationInfo = nullptr;
-
-        auto bindingDescriptions = EngineModel::Vertex::getBindingDescriptions();
-        auto attributeDescriptions = EngineModel::Vertex::getAttributeDescriptions();
+        shaderStages[1].pSpecializationInfo = &specialization.info;
 
         VkPipelineVertexInputStateCreateInfo pipelineVertexInputStateCreateInfo = {};
         pipelineVertexInputStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-        pipelineVertexInputStateCreateInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
-        pipelineVertexInputStateCreateInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
-        pipelineVertexInputStateCreateInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size());
-        pipelineVertexInputStateCreateInfo.pVertexBindingDescriptions = bindingDescriptions.data();
+        pipelineVertexInputStateCreateInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(configInfo.attributeDescriptions.size());
+        pipelineVertexInputStateCreateInfo.pVertexAttributeDescriptions = configInfo.attributeDescriptions.data();
+        pipelineVertexInputStateCreateInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(configInfo.bindingDescriptions.size());
+        pipelineVertexInputStateCreateInfo.pVertexBindingDescriptions = configInfo.bindingDescriptions.data();
 
         VkPipelineViewportStateCreateInfo pipelineViewPortStateCreateInfo = {};
         pipelineViewPortStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
@@ -172,16 +250,20 @@ namespace engine {
         pipelineViewPortStateCreateInfo.scissorCount = 1;
         pipelineViewPortStateCreateInfo.pScissors = &configInfo.scissor;
 
+        // the config may have been copied since it was built, point the blend state at this copy's attachment
+        VkPipelineColorBlendStateCreateInfo pipelineColorBlendStateCreateInfo = configInfo.pipelineColorBlendStateCreateInfo;
+        pipelineColorBlendStateCreateInfo.pAttachments = &configInfo.pipelineColorBlendAttachmentState;
+
         VkGraphicsPipelineCreateInfo graphicsPipelineCreateInfo = {};
         graphicsPipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-        graphicsPipelineCreateInfo.stageCount = 2;
+        graphicsPipelineCreateInfo.stageCount = hasFragmentStage ? 2 : 1;
         graphicsPipelineCreateInfo.pStages = shaderStages;
         graphicsPipelineCreateInfo.pVertexInputState = &pipelineVertexInputStateCreateInfo;
         graphicsPipelineCreateInfo.pInputAssemblyState = &configInfo.pipelineInputAssemblyStateCreateInfo;
         graphicsPipelineCreateInfo.pViewportState = &pipelineViewPortStateCreateInfo;
         graphicsPipelineCreateInfo.pRasterizationState = &configInfo.pipelineRasterizationStateCreateInfo;
         graphicsPipelineCreateInfo.pMultisampleState = &configInfo.pipelineMultiSampleStateCreateInfo;
-        graphicsPipelineCreateInfo.pColorBlendState = &configInfo.pipelineColorBlendStateCreateInfo;
+        graphicsPipelineCreateInfo.pColorBlendState = &pipelineColorBlendStateCreateInfo;
         graphicsPipelineCreateInfo.pDepthStencilState = &configInfo.pipelineDepthStencilStateCreateInfo;
         graphicsPipelineCreateInfo.pDynamicState = nullptr;
 
@@ -192,7 +274,7 @@ namespace engine {
         graphicsPipelineCreateInfo.basePipelineIndex = -1;
         graphicsPipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-        bool isCreatGraphicsPipelineSuccessful = vkCreateGraphicsPipelines(this->engineDevice.device(), VK_NULL_HANDLE, 1, &graphicsPipelineCreateInfo, nullptr, &this->graphicsPipeline) == VK_SUCCESS;
+        bool isCreatGraphicsPipelineSuccessful = vkCreateGraphicsPipelines(this->engineDevice.device(), configInfo.pipelineCache, 1, &graphicsPipelineCreateInfo, nullptr, &this->graphicsPipeline) == VK_SUCCESS;
         if(!isCreatGraphicsPipelineSuccessful) throw std::runtime_error("Failed to create graphics pipeline!");
     }
 
@@ -1,5 +1,8 @@
 #pragma once
 #include "engine_device.hpp"
+#include "engine_archive.hpp"
+#include "engine_shader_permutation.hpp"
+#include "engine_command_encoder.hpp"
 
 // std
 #include <string>
@@ -18,6 +21,12 @@ namespace engine {
         VkPipelineLayout pipelineLayout = nullptr;
         VkRenderPass renderPass = nullptr;
         uint32_t subpass = 0;
+        // feature set baked into both stages through specialisation constants
+        ShaderPermutation permutation;
+        // EngineModel's bindings by default, empty for shaders that pull their vertices from storage buffers
+        std::vector<VkVertexInputBindingDescription> bindingDescriptions;
+        std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
+        VkPipelineCache pipelineCache = VK_NULL_HANDLE;
     };
 
     class EnginePipeline {
@@ -28,21 +37,40 @@ namespace engine {
             EnginePipeline(const EnginePipeline&) = delete;
             void operator = (const EnginePipeline&) = delete; 
             static PipelineConfigInfo defaultPipelineConfig(uint32_t width, uint32_t height);
+            // No colour attachments and a depth bias against acne, pass an empty fragment path to
+            // build the pipeline without a fragment stage
+            static PipelineConfigInfo depthOnlyPipelineConfig(uint32_t width, uint32_t height);
+            // Additive blending without depth writes and without vertex input, for billboards
+            // expanded in the vertex shader from gl_VertexIndex and gl_InstanceIndex
+            static PipelineConfigInfo particlePipelineConfig(uint32_t width, uint32_t height);
+            // Alpha blending without depth, for 2D layers drawn in order. The caller supplies the vertex input.
+            static PipelineConfigInfo spritePipelineConfig(uint32_t width, uint32_t height);
 
             void bind(VkCommandBuffer commandBuffer);
+            // Records nothing when the pipeline is already bound
+            void bind(EngineCommandEncoder &encoder);
+
+            // From the shader archive when one is set and holds the path, otherwise from the loose file
+            static std::vector<char> readFile(const std::string& filePath);
+            // Every pipeline created afterwards reads its shaders through the archive, null goes
+            // back to loose files. The archive must outlive the pipelines created from it.
+            static void setShaderArchive(EngineArchive *archive);
+            // The caller owns the returned pipeline, the shader module is only kept while it is created
+            static VkPipeline createComputePipeline(EngineDevice &device, const std::string &computeFilePath, VkPipelineLayout pipelineLayout);
             
         private:
-            static std::vector<char> readFile(const std::string& filePath);
             
             void createGraphicsPipeline(const std::string& vertexFilePath, const std::string& fragmentFilePath, const PipelineConfigInfo& configInfo);
             
             void createShaderModule(const std::vector<char>& codes, VkShaderModule* shaderModule);
 
+            static EngineArchive *shaderArchive;
+
             // Pipeline need device to exist, but this is an aggregation where it can exist independently from the parent
             EngineDevice& engineDevice;
             VkPipeline graphicsPipeline;
             VkShaderModule vertexShaderModule;
-            VkShaderModule fragmentShadeModule;
+            VkShaderModule fragmentShadeModule = VK_NULL_HANDLE;
 
     };
 }
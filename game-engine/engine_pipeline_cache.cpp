@@ -0,0 +1,118 @@
+#include "engine_pipeline_cache.hpp"
+#include "engine_log.hpp"
+#include "engine_hash.hpp"
+
+// std
+#include <cstring>
+#include <stdexcept>
+
+namespace engine {
+    // Publics
+    EnginePipelineCache::EnginePipelineCache(EngineDevice &device): engineDevice{device}{
+        VkPipelineCacheCreateInfo pipelineCacheCreateInfo = {};
+        pipelineCacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        bool isCreatePipelineCacheSuccess = vkCreatePipelineCache(this->engineDevice.device(), &pipelineCacheCreateInfo, nullptr, &this->pipelineCache) == VK_SUCCESS;
+        if(!isCreatePipelineCacheSuccess) throw std::runtime_error("Failed to create pipeline cache!");
+    }
+
+    EnginePipelineCache::~EnginePipelineCache(){
+        this->entries.clear();
+        vkDestroyPipelineCache(this->engineDevice.device(), this->pipelineCache, nullptr);
+    }
+
+    EnginePipeline &EnginePipelineCache::getPipeline(const std::string &vertexFilePath, const std::string &fragmentFilePath, const PipelineConfigInfo &configInfo){
+        uint64_t key = hashPipeline(vertexFilePath, fragmentFilePath, configInfo);
+        auto range = this->entries.equal_range(key);
+        for(auto found = range.first; found != range.second; found++){
+            if(isSamePipeline(found->second, vertexFilePath, fragmentFilePath, configInfo)) return *found->second.pipeline;
+        }
+
+        Entry entry = {vertexFilePath, fragmentFilePath, configInfo, nullptr};
+        entry.configInfo.pipelineCache = this->pipelineCache;
+        entry.pipeline = std::make_unique<EnginePipeline>(this->engineDevice, vertexFilePath, fragmentFilePath, entry.configInfo);
+        ENGINE_LOG_INFO("EnginePipelineCache: Created permutation %x of %s + %s", static_cast<unsigned>(configInfo.permutation.featureBits), vertexFilePath.c_str(), fragmentFilePath.c_str());
+        return *this->entries.emplace(key, std::move(entry))->second.pipeline;
+    }
+
+    bool EnginePipelineCache::usesShader(const std::string &spirvPath) const {
+        for(const auto &entry:this->entries){
+            if(entry.second.vertexFilePath == spirvPath || entry.second.fragmentFilePath == spirvPath) return true;
+        }
+        return false;
+    }
+
+    bool EnginePipelineCache::reloadShaders(const std::vector<std::string> &spirvPaths, EngineDeletionQueue &deletionQueue, uint64_t lastFrameNumber){
+        bool isReloadSuccess = true;
+        for(auto &keyAndEntry:this->entries){
+            Entry &entry = keyAndEntry.second;
+            bool isAffected = false;
+            for(const std::string &spirvPath:spirvPaths){
+                isAffected = isAffected || entry.vertexFilePath == spirvPath || entry.fragmentFilePath == spirvPath;
+            }
+            if(!isAffected) continue;
+
+            try {
+                std::unique_ptr<EnginePipeline> pipeline = std::make_unique<EnginePipeline>(this->engineDevice, entry.vertexFilePath, entry.fragmentFilePath, entry.configInfo);
+                deletionQueue.retire(lastFrameNumber, std::move(entry.pipeline));
+                entry.pipeline = std::move(pipeline);
+            } catch(const std::exception &e){
+                ENGINE_LOG_WARNING("EnginePipelineCache: Keeping previous pipeline, %s", e.what());
+                isReloadSuccess = false;
+            }
+        }
+        return isReloadSuccess;
+    }
+
+    // Privates
+    uint64_t EnginePipelineCache::hashPipeline(const std::string &vertexFilePath, const std::string &fragmentFilePath, const PipelineConfigInfo &configInfo){
+        uint64_t hash = hashString(vertexFilePath);
+        hash = hashString(fragmentFilePath, hash);
+        hash = hashBytes(&configInfo.permutation.featureBits, sizeof(configInfo.permutation.featureBits), hash);
+        hash = hashBytes(&configInfo.renderPass, sizeof(configInfo.renderPass), hash);
+        hash = hashBytes(&configInfo.pipelineLayout, sizeof(configInfo.pipelineLayout), hash);
+        hash = hashBytes(&configInfo.subpass, sizeof(configInfo.subpass), hash);
+        hash = hashBytes(&configInfo.viewPort, sizeof(configInfo.viewPort), hash);
+        hash = hashBytes(&configInfo.pipelineInputAssemblyStateCreateInfo.topology, sizeof(VkPrimitiveTopology), hash);
+        hash = hashBytes(&configInfo.pipelineMultiSampleStateCreateInfo.rasterizationSamples, sizeof(VkSampleCountFlagBits), hash);
+        hash = hashBytes(&configInfo.pipelineMultiSampleStateCreateInfo.sampleShadingEnable, sizeof(VkBool32), hash);
+        hash = hashBytes(&configInfo.pipelineMultiSampleStateCreateInfo.minSampleShading, sizeof(float), hash);
+        // a depth pre-pass and the shading after it only differ here
+        hash = hashBytes(&configInfo.pipelineDepthStencilStateCreateInfo.depthTestEnable, sizeof(VkBool32), hash);
+        hash = hashBytes(&configInfo.pipelineDepthStencilStateCreateInfo.depthWriteEnable, sizeof(VkBool32), hash);
+        hash = hashBytes(&configInfo.pipelineDepthStencilStateCreateInfo.depthCompareOp, sizeof(VkCompareOp), hash);
+        hash = hashBytes(&configInfo.pipelineRasterizationStateCreateInfo.depthBiasEnable, sizeof(VkBool32), hash);
+        hash = hashBytes(&configInfo.pipelineColorBlendAttachmentState.blendEnable, sizeof(VkBool32), hash);
+        hash = hashBytes(configInfo.bindingDescriptions.data(), configInfo.bindingDescriptions.size() * sizeof(VkVertexInputBindingDescription), hash);
+        hash = hashBytes(configInfo.attributeDescriptions.data(), configInfo.attributeDescriptions.size() * sizeof(VkVertexInputAttributeDescription), hash);
+        return hashBytes(&configInfo.pipelineColorBlendAttachmentState.colorWriteMask, sizeof(VkColorComponentFlags), hash);
+    }
+
+    bool EnginePipelineCache::isSamePipeline(const Entry &entry, const std::string &vertexFilePath, const std::string &fragmentFilePath, const PipelineConfigInfo &configInfo){
+        const PipelineConfigInfo &stored = entry.configInfo;
+        auto isSameBytes = [](const auto &a, const auto &b){
+            return memcmp(&a, &b, sizeof(a)) == 0;
+        };
+        auto isSameArray = [](const auto &a, const auto &b){
+            return a.size() == b.size() && memcmp(a.data(), b.data(), a.size() * sizeof(a[0])) == 0;
+        };
+        return entry.vertexFilePath == vertexFilePath
+            && entry.fragmentFilePath == fragmentFilePath
+            && stored.permutation.featureBits == configInfo.permutation.featureBits
+            && stored.renderPass == configInfo.renderPass
+            && stored.pipelineLayout == configInfo.pipelineLayout
+            && stored.subpass == configInfo.subpass
+            && isSameBytes(stored.viewPort, configInfo.viewPort)
+            && stored.pipelineInputAssemblyStateCreateInfo.topology == configInfo.pipelineInputAssemblyStateCreateInfo.topology
+            && stored.pipelineMultiSampleStateCreateInfo.rasterizationSamples == configInfo.pipelineMultiSampleStateCreateInfo.rasterizationSamples
+            && stored.pipelineMultiSampleStateCreateInfo.sampleShadingEnable == configInfo.pipelineMultiSampleStateCreateInfo.sampleShadingEnable
+            && isSameBytes(stored.pipelineMultiSampleStateCreateInfo.minSampleShading, configInfo.pipelineMultiSampleStateCreateInfo.minSampleShading)
+            && stored.pipelineDepthStencilStateCreateInfo.depthTestEnable == configInfo.pipelineDepthStencilStateCreateInfo.depthTestEnable
+            && stored.pipelineDepthStencilStateCreateInfo.depthWriteEnable == configInfo.pipelineDepthStencilStateCreateInfo.depthWriteEnable
+            && stored.pipelineDepthStencilStateCreateInfo.depthCompareOp == configInfo.pipelineDepthStencilStateCreateInfo.depthCompareOp
+            && stored.pipelineRasterizationStateCreateInfo.depthBiasEnable == configInfo.pipelineRasterizationStateCreateInfo.depthBiasEnable
+            && stored.pipelineColorBlendAttachmentState.blendEnable == configInfo.pipelineColorBlendAttachmentState.blendEnable
+            && isSameArray(stored.bindingDescriptions, configInfo.bindingDescriptions)
+            && isSameArray(stored.attributeDescriptions, configInfo.attributeDescriptions)
+            && stored.pipelineColorBlendAttachmentState.colorWriteMask == configInfo.pipelineColorBlendAttachmentState.colorWriteMask;
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include "engine_device.hpp"
+#include "engine_pipeline.hpp"
+#include "engine_deletion_queue.hpp"
+
+// std
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace engine {
+    // Owns every pipeline permutation, keyed by a hash of the shader files, the permutation's
+    // feature bits and the config state that changes the compiled pipeline. Permutations are
+    // only created the first time they are asked for, and a VkPipelineCache shared between
+    // them lets the driver reuse compiled shader code across permutations.
+    class EnginePipelineCache {
+        public:
+            EnginePipelineCache(EngineDevice &device);
+            ~EnginePipelineCache();
+
+            EnginePipelineCache(const EnginePipelineCache &) = delete;
+            EnginePipelineCache &operator = (const EnginePipelineCache &) = delete;
+
+            // The reference stays valid until the pipeline is reloaded, frames recorded before that keep
+            // drawing with it until they complete
+            EnginePipeline &getPipeline(const std::string &vertexFilePath, const std::string &fragmentFilePath, const PipelineConfigInfo &configInfo);
+
+            bool usesShader(const std::string &spirvPath) const;
+            // Recreates the pipelines built from any of these files. The replaced pipelines go to the
+            // deletion queue as used by frames up to lastFrameNumber, so frames in flight are not waited on.
+            // Pipelines that fail to build keep their previous version, returns false if any did.
+            bool reloadShaders(const std::vector<std::string> &spirvPaths, EngineDeletionQueue &deletionQueue, uint64_t lastFrameNumber);
+
+            size_t size() const {
+                return this->entries.size();
+            }
+
+        private:
+            struct Entry {
+                std::string vertexFilePath;
+                std::string fragmentFilePath;
+                PipelineConfigInfo configInfo;
+                std::unique_ptr<EnginePipeline> pipeline;
+            };
+
+            static uint64_t hashPipeline(const std::string &vertexFilePath, const std::string &fragmentFilePath, const PipelineConfigInfo &configInfo);
+            // Compares exactly what hashPipeline hashes, so colliding hashes never share a pipeline
+            static bool isSamePipeline(const Entry &entry, const std::string &vertexFilePath, const std::string &fragmentFilePath, const PipelineConfigInfo &configInfo);
+
+            EngineDevice &engineDevice;
+            VkPipelineCache pipelineCache;
+            // colliding hashes are kept side by side under the same key
+            std::unordered_multimap<uint64_t, Entry> entries;
+    };
+}
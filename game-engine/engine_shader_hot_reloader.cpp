@@ -0,0 +1,160 @@
+#include "engine_shader_hot_reloader.hpp"
+#include "engine_log.hpp"
+
+// libs
+#include <shaderc/shaderc.hpp>
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace engine {
+    // Publics
+    EngineShaderHotReloader::EngineShaderHotReloader(const std::string &shaderDirectory): shaderDirectory{shaderDirectory}{
+        ENGINE_LOG_INFO("EngineShaderHotReloader: Watching %s", shaderDirectory.c_str());
+#ifdef __linux__
+        this->inotifyDescriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if(this->inotifyDescriptor < 0) throw std::runtime_error("Failed to initialise inotify!");
+        // editors either rewrite the file in place or move a temporary file over it
+        bool isAddWatchSuccess = inotify_add_watch(this->inotifyDescriptor, shaderDirectory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) >= 0;
+        if(!isAddWatchSuccess) throw std::runtime_error("Failed to watch shader directory: " + shaderDirectory);
+#else
+        for(const auto &entry:std::filesystem::directory_iterator(shaderDirectory)){
+            if(isShaderSource(entry.path())) this->lastWriteTimes[entry.path().string()] = entry.last_write_time();
+        }
+#endif
+        this->watcher = std::thread(&EngineShaderHotReloader::watchLoop, this);
+    }
+
+    EngineShaderHotReloader::~EngineShaderHotReloader(){
+        this->isStopping = true;
+        this->watcher.join();
+#ifdef __linux__
+        close(this->inotifyDescriptor);
+#endif
+    }
+
+    std::vector<std::string> EngineShaderHotReloader::takeReloadedShaders(){
+        std::lock_guard<std::mutex> lock(this->reloadedMutex);
+        std::vector<std::string> shaders;
+        shaders.swap(this->reloadedShaders);
+        return shaders;
+    }
+
+    std::vector<uint32_t> EngineShaderHotReloader::compileShader(const std::string &sourcePath){
+        std::filesystem::path path(sourcePath);
+        shaderc_shader_kind kind;
+        if(path.extension() == ".vert") kind = shaderc_glsl_vertex_shader;
+        else if(path.extension() == ".frag") kind = shaderc_glsl_fragment_shader;
+        else if(path.extension() == ".comp") kind = shaderc_glsl_compute_shader;
+        else throw std::runtime_error("Unknown shader stage: " + sourcePath);
+
+        std::ifstream file(sourcePath);
+        if(!file.is_open()) throw std::runtime_error("Failed to open file: " + sourcePath);
+        std::stringstream source;
+        source << file.rdbuf();
+
+        shaderc::Compiler compiler;
+        shaderc::CompileOptions options;
+        options.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_1);
+        options.SetOptimizationLevel(shaderc_optimization_level_performance);
+
+        shaderc::SpvCompilationResult result = compiler.CompileGlslToSpv(source.str(), kind, sourcePath.c_str(), options);
+        bool isCompileSuccess = result.GetCompilationStatus() == shaderc_compilation_status_success;
+        if(!isCompileSuccess) throw std::runtime_error("Failed to compile " + sourcePath + ":\n" + result.GetErrorMessage());
+        return std::vector<uint32_t>(result.cbegin(), result.cend());
+    }
+
+    // Privates
+    void EngineShaderHotReloader::watchLoop(){
+        while(!this->isStopping){
+            std::vector<std::string> changedSources;
+            this->waitForChanges(changedSources);
+            if(changedSources.empty()) continue;
+
+            std::sort(changedSources.begin(), changedSources.end());
+            changedSources.erase(std::unique(changedSources.begin(), changedSources.end()), changedSources.end());
+            this->recompile(changedSources);
+        }
+    }
+
+#ifdef __linux__
+    void EngineShaderHotReloader::waitForChanges(std::vector<std::string> &changedSources){
+        // wake up regularly so the destructor does not wait on a quiet directory
+        pollfd descriptor = {this->inotifyDescriptor, POLLIN, 0};
+        int timeout = 100;
+        while(poll(&descriptor, 1, timeout) > 0){
+            alignas(inotify_event) char buffer[4096];
+            ssize_t length;
+            while((length = read(this->inotifyDescriptor, buffer, sizeof(buffer))) > 0){
+                for(char *pointer = buffer; pointer < buffer + length;){
+                    const inotify_event *event = reinterpret_cast<const inotify_event *>(pointer);
+                    std::filesystem::path path = std::filesystem::path(this->shaderDirectory) / event->name;
+                    if(event->len > 0 && isShaderSource(path)) changedSources.push_back(path.string());
+                    pointer += sizeof(inotify_event) + event->len;
+                }
+            }
+            timeout = DEBOUNCE_MILLISECONDS;
+        }
+    }
+#else
+    void EngineShaderHotReloader::waitForChanges(std::vector<std::string> &changedSources){
+        // no inotify, compare modification times instead
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+        for(const auto &entry:std::filesystem::directory_iterator(this->shaderDirectory)){
+            if(!isShaderSource(entry.path())) continue;
+            std::string path = entry.path().string();
+            std::filesystem::file_time_type lastWriteTime = entry.last_write_time();
+            auto previous = this->lastWriteTimes.find(path);
+            if(previous != this->lastWriteTimes.end() && previous->second == lastWriteTime) continue;
+            this->lastWriteTimes[path] = lastWriteTime;
+            changedSources.push_back(path);
+        }
+        if(!changedSources.empty()) std::this_thread::sleep_for(std::chrono::milliseconds(DEBOUNCE_MILLISECONDS));
+    }
+#endif
+
+    void EngineShaderHotReloader::recompile(const std::vector<std::string> &changedSources){
+        std::vector<std::string> compiled;
+        for(const std::string &sourcePath:changedSources){
+            auto start = std::chrono::steady_clock::now();
+            try {
+                std::vector<uint32_t> spirv = compileShader(sourcePath);
+                // write to a temporary file first so a pipeline never reads half written code
+                std::string spirvPath = sourcePath + ".spv";
+                std::string temporaryPath = spirvPath + ".tmp";
+                {
+                    std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+                    file.write(reinterpret_cast<const char *>(spirv.data()), static_cast<std::streamsize>(spirv.size() * sizeof(uint32_t)));
+                    if(!file) throw std::runtime_error("Failed to write file: " + temporaryPath);
+                }
+                std::filesystem::rename(temporaryPath, spirvPath);
+                compiled.push_back(spirvPath);
+
+                double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                ENGINE_LOG_INFO("EngineShaderHotReloader: Recompiled %s in %.1f ms", sourcePath.c_str(), milliseconds);
+            } catch(const std::exception &e){
+                // keep running with the previous code until the source compiles again
+                ENGINE_LOG_ERROR("EngineShaderHotReloader: %s", e.what());
+            }
+        }
+        if(compiled.empty()) return;
+
+        std::lock_guard<std::mutex> lock(this->reloadedMutex);
+        this->reloadedShaders.insert(this->reloadedShaders.end(), compiled.begin(), compiled.end());
+    }
+
+    bool EngineShaderHotReloader::isShaderSource(const std::filesystem::path &path){
+        std::filesystem::path extension = path.extension();
+        return extension == ".vert" || extension == ".frag" || extension == ".comp";
+    }
+}
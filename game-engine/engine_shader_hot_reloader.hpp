@@ -0,0 +1,54 @@
+#pragma once
+
+// std
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace engine {
+    // Watches the shader directory and recompiles edited GLSL sources to SPIR-V on a background thread.
+    // The compiled code is written next to the source as <source>.spv, the same place the Makefile
+    // puts it, so pipelines are rebuilt from disk and the next launch starts from the new code.
+    class EngineShaderHotReloader {
+        public:
+            // gives editors time to finish writing before the source is read
+            static constexpr int DEBOUNCE_MILLISECONDS = 50;
+
+            EngineShaderHotReloader(const std::string &shaderDirectory);
+            ~EngineShaderHotReloader();
+
+            EngineShaderHotReloader(const EngineShaderHotReloader &) = delete;
+            EngineShaderHotReloader &operator = (const EngineShaderHotReloader &) = delete;
+
+            // SPIR-V paths recompiled successfully since the last call
+            std::vector<std::string> takeReloadedShaders();
+
+            // Compiles a single .vert, .frag or .comp file, throws with the compiler log on failure
+            static std::vector<uint32_t> compileShader(const std::string &sourcePath);
+
+        private:
+            void watchLoop();
+            void waitForChanges(std::vector<std::string> &changedSources);
+            void recompile(const std::vector<std::string> &changedSources);
+
+            static bool isShaderSource(const std::filesystem::path &path);
+
+            std::string shaderDirectory;
+            std::thread watcher;
+            std::atomic<bool> isStopping{false};
+
+            std::mutex reloadedMutex;
+            std::vector<std::string> reloadedShaders;
+
+#ifdef __linux__
+            int inotifyDescriptor = -1;
+#else
+            std::unordered_map<std::string, std::filesystem::file_time_type> lastWriteTimes;
+#endif
+    };
+}
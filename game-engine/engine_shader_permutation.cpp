@@ -0,0 +1,16 @@
+#include "engine_shader_permutation.hpp"
+
+namespace engine {
+    ShaderSpecialization::ShaderSpecialization(ShaderPermutation permutation){
+        for(uint32_t i = 0; i < SHADER_FEATURE_COUNT; i++){
+            this->values[i] = permutation.has(static_cast<ShaderFeature>(i)) ? VK_TRUE : VK_FALSE;
+            this->mapEntries[i].constantID = i;
+            this->mapEntries[i].offset = i * sizeof(VkBool32);
+            this->mapEntries[i].size = sizeof(VkBool32);
+        }
+        this->info.mapEntryCount = SHADER_FEATURE_COUNT;
+        this->info.pMapEntries = this->mapEntries.data();
+        this->info.dataSize = sizeof(this->values);
+        this->info.pData = this->values.data();
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include "engine_device.hpp"
+#include "engine_hash.hpp"
+
+// std
+#include <array>
+#include <cstdint>
+#include <string>
+
+namespace engine {
+    // Compile-time shader features, each one is a bool specialisation constant whose constant_id
+    // is the enum value, so the driver removes the branches of disabled features when the
+    // pipeline is created. Shaders that do not declare a constant simply ignore it.
+    enum class ShaderFeature : uint32_t {
+        VERTEX_COLOR = 0,
+        TEXTURE = 1,
+        MULTISAMPLING = 2,
+        CLUSTERED_LIGHTING = 3,
+        SHADOWS = 4,
+    };
+    static constexpr uint32_t SHADER_FEATURE_COUNT = 5;
+
+    struct ShaderPermutation {
+        uint32_t featureBits = 0;
+
+        constexpr ShaderPermutation with(ShaderFeature feature, bool isEnabled = true) const {
+            uint32_t bit = 1u << static_cast<uint32_t>(feature);
+            return ShaderPermutation{isEnabled ? (this->featureBits | bit) : (this->featureBits & ~bit)};
+        }
+        constexpr bool has(ShaderFeature feature) const {
+            return (this->featureBits >> static_cast<uint32_t>(feature)) & 1u;
+        }
+        constexpr bool operator == (const ShaderPermutation &other) const {
+            return this->featureBits == other.featureBits;
+        }
+    };
+
+    // Specialisation data for one permutation, must outlive the pipeline creation call
+    struct ShaderSpecialization {
+        std::array<VkBool32, SHADER_FEATURE_COUNT> values;
+        std::array<VkSpecializationMapEntry, SHADER_FEATURE_COUNT> mapEntries;
+        VkSpecializationInfo info;
+
+        explicit ShaderSpecialization(ShaderPermutation permutation);
+        ShaderSpecialization(const ShaderSpecialization &) = delete;
+        ShaderSpecialization &operator = (const ShaderSpecialization &) = delete;
+    };
+}
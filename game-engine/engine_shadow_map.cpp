@@ -0,0 +1,341 @@
+#include "engine_shadow_map.hpp"
+#include "engine_log.hpp"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace engine {
+    // how far behind each slice the light sits, so casters in front of it still land in the map
+    static constexpr float CASTER_DISTANCE = 2.0f;
+    // cascade radii are rounded up to this, a radius that changes every frame would shimmer too
+    static constexpr float RADIUS_QUANTUM = 1.0f / 16.0f;
+
+    // Publics
+    EngineShadowMap::EngineShadowMap(EngineDevice &device, EngineBindlessTable &bindlessTable, EnginePipelineCache &pipelineCache, EngineWorkerPool &workerPool, uint32_t frameCount):
+        engineDevice{device}, bindlessTable{bindlessTable}, pipelineCache{pipelineCache}, workerPool{workerPool}, frames(frameCount){
+        ENGINE_LOG_INFO("EngineShadowMap: Initialising %u cascades of %ux%u", CASCADE_COUNT, RESOLUTION, RESOLUTION);
+        this->createImage();
+        this->createSampler();
+        this->createRenderPass();
+        this->createFramebuffers();
+        this->createFrameResources();
+        this->createPipelineLayout();
+        this->createPipeline();
+        this->textureIndex = this->bindlessTable.registerTexture(this->arrayView, this->sampler, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL);
+    }
+
+    EngineShadowMap::~EngineShadowMap(){
+        VkDevice device = this->engineDevice.device();
+        this->bindlessTable.releaseTexture(this->textureIndex);
+        vkDestroyPipelineLayout(device, this->pipelineLayout, nullptr);
+        for(FrameResources &frame:this->frames){
+            this->bindlessTable.releaseStorageBuffer(frame.dataIndex);
+            vkUnmapMemory(device, frame.dataBufferMemory);
+            vkDestroyBuffer(device, frame.dataBuffer, nullptr);
+            vkFreeMemory(device, frame.dataBufferMemory, nullptr);
+            // frees the command buffers too
+            for(VkCommandPool commandPool:frame.commandPools) vkDestroyCommandPool(device, commandPool, nullptr);
+        }
+        for(VkFramebuffer framebuffer:this->framebuffers) vkDestroyFramebuffer(device, framebuffer, nullptr);
+        vkDestroyRenderPass(device, this->renderPass, nullptr);
+        vkDestroySampler(device, this->sampler, nullptr);
+        for(VkImageView layerView:this->layerViews) vkDestroyImageView(device, layerView, nullptr);
+        vkDestroyImageView(device, this->arrayView, nullptr);
+        vkDestroyImage(device, this->image, nullptr);
+        vkFreeMemory(device, this->imageMemory, nullptr);
+    }
+
+    void EngineShadowMap::createPipeline(){
+        PipelineConfigInfo pipelineConfig = EnginePipeline::depthOnlyPipelineConfig(RESOLUTION, RESOLUTION);
+        pipelineConfig.renderPass = this->renderPass;
+        pipelineConfig.pipelineLayout = this->pipelineLayout;
+        this->pipeline = &this->pipelineCache.getPipeline(VERTEX_SHADER_PATH, "", pipelineConfig);
+    }
+
+    void EngineShadowMap::update(size_t frameIndex, const glm::mat2 &camera, glm::vec3 lightDirection){
+        FrameResources &frame = this->frames[frameIndex];
+        ShadowData data = {};
+        data.textureIndex = this->textureIndex;
+        data.texelSize = 1.0f / RESOLUTION;
+
+        // the screen's corners in world space, each slice spans them between two depths
+        glm::mat2 inverseCamera = glm::inverse(camera);
+        std::array<glm::vec2, 4> screenCorners = {
+            inverseCamera * glm::vec2{-1.0f, -1.0f}, inverseCamera * glm::vec2{1.0f, -1.0f},
+            inverseCamera * glm::vec2{-1.0f, 1.0f}, inverseCamera * glm::vec2{1.0f, 1.0f},
+        };
+        glm::vec3 direction = glm::normalize(lightDirection);
+        glm::vec3 up = std::abs(direction.y) > 0.99f ? glm::vec3{1.0f, 0.0f, 0.0f} : glm::vec3{0.0f, 1.0f, 0.0f};
+
+        float nearSplit = 0.0f;
+        for(uint32_t cascade = 0; cascade < CASCADE_COUNT; cascade++){
+            // practical split scheme, logarithmic splits keep near cascades small
+            float fraction = static_cast<float>(cascade + 1) / CASCADE_COUNT;
+            float uniformSplit = NEAR_DEPTH + (1.0f - NEAR_DEPTH) * fraction;
+            float logarithmicSplit = NEAR_DEPTH * std::pow(1.0f / NEAR_DEPTH, fraction);
+            float farSplit = cascade + 1 == CASCADE_COUNT ? 1.0f : glm::mix(uniformSplit, logarithmicSplit, SPLIT_LAMBDA);
+
+            // a bounding sphere keeps the projection the same size whatever the camera's rotation
+            std::array<glm::vec3, 8> sliceCorners;
+            glm::vec3 center{0.0f};
+            for(uint32_t i = 0; i < 4; i++){
+                sliceCorners[i] = glm::vec3{screenCorners[i], nearSplit};
+                sliceCorners[i + 4] = glm::vec3{screenCorners[i], farSplit};
+                center += sliceCorners[i] + sliceCorners[i + 4];
+            }
+            center /= 8.0f;
+            float radius = 0.0f;
+            for(const glm::vec3 &corner:sliceCorners) radius = std::max(radius, glm::length(corner - center));
+            radius = std::ceil(radius / RADIUS_QUANTUM) * RADIUS_QUANTUM;
+
+            glm::vec3 eye = center - direction * (radius + CASTER_DISTANCE);
+            glm::mat4 view = glm::lookAt(eye, center, up);
+            glm::mat4 projection = glm::ortho(-radius, radius, -radius, radius, 0.0f, 2.0f * (radius + CASTER_DISTANCE));
+
+            // move the projection by less than a texel so the world origin sits on a texel corner
+            glm::vec4 origin = projection * view * glm::vec4{0.0f, 0.0f, 0.0f, 1.0f};
+            glm::vec2 originTexels = glm::vec2{origin.x, origin.y} * (RESOLUTION * 0.5f);
+            glm::vec2 offset = (glm::round(originTexels) - originTexels) * (2.0f / RESOLUTION);
+            projection[3][0] += offset.x;
+            projection[3][1] += offset.y;
+
+            frame.viewProjections[cascade] = projection * view;
+            data.viewProjections[cascade] = frame.viewProjections[cascade];
+            data.splitDepths[cascade] = farSplit;
+            nearSplit = farSplit;
+        }
+        // one write, the memory is write combined
+        *frame.mappedData = data;
+    }
+
+    bool EngineShadowMap::isInCascade(size_t frameIndex, uint32_t cascade, const glm::vec3 *corners, uint32_t cornerCount){
+        // the light sits far enough back that only x and y can miss
+        const glm::mat4 &viewProjection = this->frames[frameIndex].viewProjections[cascade];
+        glm::vec2 boxMin{std::numeric_limits<float>::max()};
+        glm::vec2 boxMax{std::numeric_limits<float>::lowest()};
+        for(uint32_t i = 0; i < cornerCount; i++){
+            glm::vec4 position = viewProjection * glm::vec4{corners[i], 1.0f};
+            boxMin = glm::min(boxMin, glm::vec2{position.x, position.y});
+            boxMax = glm::max(boxMax, glm::vec2{position.x, position.y});
+        }
+        return boxMax.x >= -1.0f && boxMin.x <= 1.0f && boxMax.y >= -1.0f && boxMin.y <= 1.0f;
+    }
+
+    void EngineShadowMap::record(VkCommandBuffer commandBuffer, size_t frameIndex, const RecordCascade &recordCascade){
+        FrameResources &frame = this->frames[frameIndex];
+        // a single reference capture fits std::function's inline storage, so nothing is allocated per frame
+        struct Job {
+            EngineShadowMap *shadowMap;
+            size_t frameIndex;
+            const RecordCascade *recordCascade;
+        } job = {this, frameIndex, &recordCascade};
+        this->workerPool.parallelFor(CASCADE_COUNT, [&job](uint32_t cascade){
+            job.shadowMap->recordCascade(job.frameIndex, cascade, *job.recordCascade);
+        });
+
+        VkClearValue clearValue = {};
+        clearValue.depthStencil = {1.0f, 0};
+        VkRenderPassBeginInfo renderPassBeginInfo = {};
+        renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassBeginInfo.renderPass = this->renderPass;
+        renderPassBeginInfo.renderArea.offset = {0, 0};
+        renderPassBeginInfo.renderArea.extent = {RESOLUTION, RESOLUTION};
+        renderPassBeginInfo.clearValueCount = 1;
+        renderPassBeginInfo.pClearValues = &clearValue;
+        for(uint32_t cascade = 0; cascade < CASCADE_COUNT; cascade++){
+            renderPassBeginInfo.framebuffer = this->framebuffers[cascade];
+            vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+            vkCmdExecuteCommands(commandBuffer, 1, &frame.commandBuffers[cascade]);
+            vkCmdEndRenderPass(commandBuffer);
+        }
+    }
+
+    // Privates
+    void EngineShadowMap::createImage(){
+        VkImageCreateInfo imageCreateInfo = {};
+        imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageCreateInfo.format = DEPTH_FORMAT;
+        imageCreateInfo.extent = {RESOLUTION, RESOLUTION, 1};
+        imageCreateInfo.mipLevels = 1;
+        imageCreateInfo.arrayLayers = CASCADE_COUNT;
+        imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageCreateInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        this->engineDevice.createImageWithInfo(imageCreateInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, this->image, this->imageMemory);
+
+        VkImageViewCreateInfo imageViewCreateInfo = {};
+        imageViewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        imageViewCreateInfo.image = this->image;
+        imageViewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+        imageViewCreateInfo.format = DEPTH_FORMAT;
+        imageViewCreateInfo.subresourceRange = {VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, CASCADE_COUNT};
+        bool isCreateImageViewSuccess = vkCreateImageView(this->engineDevice.device(), &imageViewCreateInfo, nullptr, &this->arrayView) == VK_SUCCESS;
+        if(!isCreateImageViewSuccess) throw std::runtime_error("Failed to create shadow map view!");
+
+        imageViewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        for(uint32_t cascade = 0; cascade < CASCADE_COUNT; cascade++){
+            imageViewCreateInfo.subresourceRange = {VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, cascade, 1};
+            isCreateImageViewSuccess = vkCreateImageView(this->engineDevice.device(), &imageViewCreateInfo, nullptr, &this->layerViews[cascade]) == VK_SUCCESS;
+            if(!isCreateImageViewSuccess) throw std::runtime_error("Failed to create shadow map cascade view!");
+        }
+    }
+
+    void EngineShadowMap::createSampler(){
+        // hardware comparison, linear filtering blends four comparisons into a soft edge
+        VkSamplerCreateInfo samplerCreateInfo = {};
+        samplerCreateInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        samplerCreateInfo.magFilter = VK_FILTER_LINEAR;
+        samplerCreateInfo.minFilter = VK_FILTER_LINEAR;
+        samplerCreateInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        // outside the map is lit
+        samplerCreateInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+        samplerCreateInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+        samplerCreateInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+        samplerCreateInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+        samplerCreateInfo.compareEnable = VK_TRUE;
+        samplerCreateInfo.compareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+        samplerCreateInfo.maxLod = 1.0f;
+        bool isCreateSamplerSuccess = vkCreateSampler(this->engineDevice.device(), &samplerCreateInfo, nullptr, &this->sampler) == VK_SUCCESS;
+        if(!isCreateSamplerSuccess) throw std::runtime_error("Failed to create shadow map sampler!");
+    }
+
+    void EngineShadowMap::createRenderPass(){
+        VkAttachmentDescription depthAttachment = {};
+        depthAttachment.format = DEPTH_FORMAT;
+        depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+        depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+
+        VkAttachmentReference depthAttachmentReference = {0, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+        VkSubpassDescription subpass = {};
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.pDepthStencilAttachment = &depthAttachmentReference;
+
+        // the previous frame's shading reads the map until this frame overwrites it, this frame's
+        // shading waits for the depth writes
+        std::array<VkSubpassDependency, 2> dependencies = {};
+        dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+        dependencies[0].dstSubpass = 0;
+        dependencies[0].srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+        dependencies[0].srcAccessMask = 0;
+        dependencies[0].dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+        dependencies[0].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        dependencies[1].srcSubpass = 0;
+        dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+        dependencies[1].srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+        dependencies[1].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        dependencies[1].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+        dependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+        VkRenderPassCreateInfo renderPassCreateInfo = {};
+        renderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+        renderPassCreateInfo.attachmentCount = 1;
+        renderPassCreateInfo.pAttachments = &depthAttachment;
+        renderPassCreateInfo.subpassCount = 1;
+        renderPassCreateInfo.pSubpasses = &subpass;
+        renderPassCreateInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+        renderPassCreateInfo.pDependencies = dependencies.data();
+        bool isCreateRenderPassSuccess = vkCreateRenderPass(this->engineDevice.device(), &renderPassCreateInfo, nullptr, &this->renderPass) == VK_SUCCESS;
+        if(!isCreateRenderPassSuccess) throw std::runtime_error("Failed to create shadow render pass!");
+    }
+
+    void EngineShadowMap::createFramebuffers(){
+        for(uint32_t cascade = 0; cascade < CASCADE_COUNT; cascade++){
+            VkFramebufferCreateInfo framebufferCreateInfo = {};
+            framebufferCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+            framebufferCreateInfo.renderPass = this->renderPass;
+            framebufferCreateInfo.attachmentCount = 1;
+            framebufferCreateInfo.pAttachments = &this->layerViews[cascade];
+            framebufferCreateInfo.width = RESOLUTION;
+            framebufferCreateInfo.height = RESOLUTION;
+            framebufferCreateInfo.layers = 1;
+            bool isCreateFramebufferSuccess = vkCreateFramebuffer(this->engineDevice.device(), &framebufferCreateInfo, nullptr, &this->framebuffers[cascade]) == VK_SUCCESS;
+            if(!isCreateFramebufferSuccess) throw std::runtime_error("Failed to create shadow framebuffer!");
+        }
+    }
+
+    void EngineShadowMap::createFrameResources(){
+        uint32_t graphicsFamily = this->engineDevice.findPhysicalQueueFamilies().graphicsFamily;
+        for(FrameResources &frame:this->frames){
+            this->engineDevice.createBuffer(
+                sizeof(ShadowData),
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                frame.dataBuffer,
+                frame.dataBufferMemory
+            );
+            void *data;
+            vkMapMemory(this->engineDevice.device(), frame.dataBufferMemory, 0, sizeof(ShadowData), 0, &data);
+            frame.mappedData = static_cast<ShadowData *>(data);
+            frame.dataIndex = this->bindlessTable.registerStorageBuffer(frame.dataBuffer);
+
+            for(uint32_t cascade = 0; cascade < CASCADE_COUNT; cascade++){
+                VkCommandPoolCreateInfo commandPoolCreateInfo = {};
+                commandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+                commandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+                commandPoolCreateInfo.queueFamilyIndex = graphicsFamily;
+                bool isCreateCommandPoolSuccess = vkCreateCommandPool(this->engineDevice.device(), &commandPoolCreateInfo, nullptr, &frame.commandPools[cascade]) == VK_SUCCESS;
+                if(!isCreateCommandPoolSuccess) throw std::runtime_error("Failed to create shadow command pool!");
+
+                VkCommandBufferAllocateInfo commandBufferAllocateInfo = {};
+                commandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+                commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+                commandBufferAllocateInfo.commandPool = frame.commandPools[cascade];
+                commandBufferAllocateInfo.commandBufferCount = 1;
+                bool isAllocateCommandBufferSuccess = vkAllocateCommandBuffers(this->engineDevice.device(), &commandBufferAllocateInfo, &frame.commandBuffers[cascade]) == VK_SUCCESS;
+                if(!isAllocateCommandBufferSuccess) throw std::runtime_error("Failed to allocate shadow command buffer!");
+            }
+        }
+    }
+
+    void EngineShadowMap::createPipelineLayout(){
+        VkPushConstantRange pushConstantRange = {};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(ShadowPush);
+
+        VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
+        pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+        pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+        bool isCreatePipelineLayoutSuccess = vkCreatePipelineLayout(this->engineDevice.device(), &pipelineLayoutCreateInfo, nullptr, &this->pipelineLayout) == VK_SUCCESS;
+        if(!isCreatePipelineLayoutSuccess) throw std::runtime_error("Failed to create shadow pipeline layout!");
+    }
+
+    void EngineShadowMap::recordCascade(size_t frameIndex, uint32_t cascade, const RecordCascade &recordCascade){
+        FrameResources &frame = this->frames[frameIndex];
+        VkCommandBuffer commandBuffer = frame.commandBuffers[cascade];
+        // the slot's previous submission has completed, recycling the pool is cheaper than resetting the buffer
+        vkResetCommandPool(this->engineDevice.device(), frame.commandPools[cascade], 0);
+
+        VkCommandBufferInheritanceInfo inheritanceInfo = {};
+        inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritanceInfo.renderPass = this->renderPass;
+        inheritanceInfo.subpass = 0;
+        inheritanceInfo.framebuffer = this->framebuffers[cascade];
+        VkCommandBufferBeginInfo commandBufferBeginInfo = {};
+        commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        commandBufferBeginInfo.pInheritanceInfo = &inheritanceInfo;
+        bool isBeginCommandBufferSuccess = vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo) == VK_SUCCESS;
+        if(!isBeginCommandBufferSuccess) throw std::runtime_error("Failed to begin recording shadow command buffer!");
+
+        this->pipeline->bind(commandBuffer);
+        ShadowPush push = {frame.viewProjections[cascade]};
+        vkCmdPushConstants(commandBuffer, this->pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(ShadowPush), &push);
+        recordCascade(commandBuffer, cascade);
+
+        bool isEndCommandBufferSuccess = vkEndCommandBuffer(commandBuffer) == VK_SUCCESS;
+        if(!isEndCommandBufferSuccess) throw std::runtime_error("Failed to record shadow command buffer!");
+    }
+}
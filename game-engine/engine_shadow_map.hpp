@@ -0,0 +1,122 @@
+#pragma once
+#include "engine_device.hpp"
+#include "engine_bindless_table.hpp"
+#include "engine_model.hpp"
+#include "engine_pipeline.hpp"
+#include "engine_pipeline_cache.hpp"
+#include "engine_worker_pool.hpp"
+
+// std
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace engine {
+    // Cascaded shadow maps for one directional light. World space is the 2D space instances are
+    // placed in before the camera, with their depth as z, and the view volume is split along depth
+    // into CASCADE_COUNT slices, each with its own orthographic light projection and layer of a
+    // depth array image.
+    //
+    // Cascades are fitted stably: each projection is sized to the bounding sphere of its slice, so
+    // it does not change size as the camera rotates, and its origin is snapped to whole shadow map
+    // texels, so the texels do not crawl as the camera moves. Each cascade is recorded into its own
+    // secondary command buffer on the worker pool, the primary only executes them.
+    class EngineShadowMap {
+        public:
+            static constexpr const char *VERTEX_SHADER_PATH = "shaders/shadow.vert.spv";
+            static constexpr uint32_t CASCADE_COUNT = 4;
+            static constexpr uint32_t RESOLUTION = 1024;
+            static constexpr VkFormat DEPTH_FORMAT = VK_FORMAT_D32_SFLOAT;
+            // blend between uniform (0) and logarithmic (1) splits
+            static constexpr float SPLIT_LAMBDA = 0.5f;
+            // depth of the nearest split, logarithmic splits cannot start at 0
+            static constexpr float NEAR_DEPTH = 0.01f;
+
+            // std430 ShadowData of simple_shader.frag, one per frame slot in the bindless table
+            struct ShadowData {
+                glm::mat4 viewProjections[CASCADE_COUNT];
+                // far depth of every cascade
+                glm::vec4 splitDepths;
+                uint32_t textureIndex;
+                float texelSize;
+                uint32_t padding[2];
+            };
+
+            // Records the casters of one cascade into a secondary command buffer the shadow pipeline
+            // and the cascade's push constants are already bound to. Called from worker threads,
+            // one cascade per call, so it may only read shared state.
+            using RecordCascade = std::function<void(VkCommandBuffer commandBuffer, uint32_t cascade)>;
+
+            EngineShadowMap(EngineDevice &device, EngineBindlessTable &bindlessTable, EnginePipelineCache &pipelineCache, EngineWorkerPool &workerPool, uint32_t frameCount);
+            ~EngineShadowMap();
+
+            EngineShadowMap(const EngineShadowMap &) = delete;
+            EngineShadowMap &operator = (const EngineShadowMap &) = delete;
+
+            // Builds the shadow pipeline, or picks up the rebuilt one after a shader reload
+            void createPipeline();
+
+            // Fits the cascades of this slot to the view volume of camera. The direction is in world
+            // space and points away from the light, its z has to be positive.
+            void update(size_t frameIndex, const glm::mat2 &camera, glm::vec3 lightDirection);
+
+            // True when any part of the box spanned by the corners falls inside the cascade
+            bool isInCascade(size_t frameIndex, uint32_t cascade, const glm::vec3 *corners, uint32_t cornerCount);
+
+            // Outside a render pass, after update. Records every cascade in parallel and leaves the
+            // shadow map ready to be sampled by fragment shaders.
+            void record(VkCommandBuffer commandBuffer, size_t frameIndex, const RecordCascade &recordCascade);
+
+            // Bindless storage buffer index of the slot's ShadowData
+            uint32_t getDataIndex(size_t frameIndex){
+                return this->frames[frameIndex].dataIndex;
+            }
+
+        private:
+            struct FrameResources {
+                VkBuffer dataBuffer;
+                VkDeviceMemory dataBufferMemory;
+                ShadowData *mappedData;
+                uint32_t dataIndex;
+                // what update wrote, mapped memory is slow to read back
+                std::array<glm::mat4, CASCADE_COUNT> viewProjections;
+                // a command pool per cascade so every worker records without locking
+                std::array<VkCommandPool, CASCADE_COUNT> commandPools;
+                std::array<VkCommandBuffer, CASCADE_COUNT> commandBuffers;
+            };
+
+            struct ShadowPush {
+                glm::mat4 viewProjection;
+            };
+
+            void createImage();
+            void createSampler();
+            void createRenderPass();
+            void createFramebuffers();
+            void createFrameResources();
+            void createPipelineLayout();
+            void recordCascade(size_t frameIndex, uint32_t cascade, const RecordCascade &recordCascade);
+
+            EngineDevice &engineDevice;
+            EngineBindlessTable &bindlessTable;
+            EnginePipelineCache &pipelineCache;
+            EngineWorkerPool &workerPool;
+
+            VkImage image;
+            VkDeviceMemory imageMemory;
+            // every cascade for sampling, one per cascade to render into
+            VkImageView arrayView;
+            std::array<VkImageView, CASCADE_COUNT> layerViews;
+            VkSampler sampler;
+            uint32_t textureIndex;
+
+            VkRenderPass renderPass;
+            std::array<VkFramebuffer, CASCADE_COUNT> framebuffers;
+            VkPipelineLayout pipelineLayout;
+            // owned by the cache
+            EnginePipeline *pipeline = nullptr;
+
+            std::vector<FrameResources> frames;
+    };
+}
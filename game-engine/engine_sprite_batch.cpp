@@ -0,0 +1,196 @@
+#include "engine_sprite_batch.hpp"
+#include "engine_log.hpp"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+
+namespace engine {
+    // Utilities
+    static uint32_t packColor(const glm::vec4 &color){
+        uint32_t packed = 0;
+        for(int i = 0; i < 4; i++){
+            float channel = std::min(std::max(color[i], 0.0f), 1.0f);
+            packed |= static_cast<uint32_t>(std::lround(channel * 255.0f)) << (8 * i);
+        }
+        return packed;
+    }
+
+    // Publics
+    EngineSpriteBatch::EngineSpriteBatch(EngineDevice &device, EngineBindlessTable &bindlessTable, EnginePipelineCache &pipelineCache, EngineSwapChain &swapChain, uint32_t frameCount):
+        engineDevice{device},
+        bindlessTable{bindlessTable},
+        pipelineCache{pipelineCache},
+        engineSwapChain{swapChain},
+        vertexStream{device, MAX_SPRITES * 4 * sizeof(Vertex), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, frameCount}{
+        ENGINE_LOG_INFO("EngineSpriteBatch: Initialising room for %u sprites per frame", MAX_SPRITES);
+        this->sprites.reserve(MAX_SPRITES);
+        this->sortKeys.reserve(MAX_SPRITES);
+        this->createIndexBuffer();
+        this->createPipelineLayout();
+        this->createPipeline();
+    }
+
+    EngineSpriteBatch::~EngineSpriteBatch(){
+        vkDestroyPipelineLayout(this->engineDevice.device(), this->pipelineLayout, nullptr);
+        vkDestroyBuffer(this->engineDevice.device(), this->indexBuffer, nullptr);
+        vkFreeMemory(this->engineDevice.device(), this->indexBufferMemory, nullptr);
+    }
+
+    void EngineSpriteBatch::createPipeline(){
+        PipelineConfigInfo pipelineConfig = EnginePipeline::spritePipelineConfig(this->engineSwapChain.width(), this->engineSwapChain.height());
+        pipelineConfig.renderPass = this->engineSwapChain.getRenderPass();
+        pipelineConfig.pipelineLayout = this->pipelineLayout;
+        pipelineConfig.pipelineMultiSampleStateCreateInfo.rasterizationSamples = this->engineSwapChain.getSampleCount();
+        pipelineConfig.bindingDescriptions = getBindingDescriptions();
+        pipelineConfig.attributeDescriptions = getAttributeDescriptions();
+        this->pipeline = &this->pipelineCache.getPipeline(VERTEX_SHADER_PATH, FRAGMENT_SHADER_PATH, pipelineConfig);
+    }
+
+    void EngineSpriteBatch::begin(size_t frameIndex){
+        this->sprites.clear();
+        this->vertexStream.beginFrame(static_cast<uint32_t>(frameIndex));
+    }
+
+    void EngineSpriteBatch::draw(const Sprite &sprite){
+        if(this->sprites.size() == MAX_SPRITES) return;
+        this->sprites.push_back(sprite);
+    }
+
+    void EngineSpriteBatch::drawQuad(glm::vec2 position, glm::vec2 size, glm::vec4 color, int16_t layer){
+        Sprite sprite = {};
+        sprite.position = position;
+        sprite.size = size;
+        sprite.color = color;
+        sprite.layer = layer;
+        this->draw(sprite);
+    }
+
+    uint32_t EngineSpriteBatch::flush(VkCommandBuffer commandBuffer){
+        uint32_t spriteCount = static_cast<uint32_t>(this->sprites.size());
+        if(spriteCount == 0) return 0;
+
+        // layer first so blending composes in order, then texture so neighbouring quads sample the
+        // same image, then submission order to keep the sort stable
+        this->sortKeys.clear();
+        for(uint32_t i = 0; i < spriteCount; i++){
+            const Sprite &sprite = this->sprites[i];
+            uint64_t layer = static_cast<uint16_t>(sprite.layer + 32768);
+            this->sortKeys.push_back(layer << 48 | static_cast<uint64_t>(sprite.textureIndex) << 16 | i);
+        }
+        std::sort(this->sortKeys.begin(), this->sortKeys.end());
+
+        VkDeviceSize vertexOffset;
+        Vertex *vertices = this->vertexStream.allocateArray<Vertex>(spriteCount * 4, vertexOffset);
+        for(uint64_t sortKey:this->sortKeys){
+            const Sprite &sprite = this->sprites[sortKey & 0xffff];
+            glm::vec2 halfSize = sprite.size * 0.5f;
+            float cosine = std::cos(sprite.rotation);
+            float sine = std::sin(sprite.rotation);
+            glm::vec2 axisX = glm::vec2{cosine, sine} * halfSize.x;
+            glm::vec2 axisY = glm::vec2{-sine, cosine} * halfSize.y;
+            uint32_t color = packColor(sprite.color);
+
+            // top left, top right, bottom right, bottom left
+            vertices[0] = {sprite.position - axisX - axisY, {sprite.uvRect.x, sprite.uvRect.y}, color, sprite.textureIndex};
+            vertices[1] = {sprite.position + axisX - axisY, {sprite.uvRect.z, sprite.uvRect.y}, color, sprite.textureIndex};
+            vertices[2] = {sprite.position + axisX + axisY, {sprite.uvRect.z, sprite.uvRect.w}, color, sprite.textureIndex};
+            vertices[3] = {sprite.position - axisX + axisY, {sprite.uvRect.x, sprite.uvRect.w}, color, sprite.textureIndex};
+            vertices += 4;
+        }
+        this->vertexStream.flush();
+
+        SpritePush push = {};
+        push.scale = {2.0f / this->engineSwapChain.width(), 2.0f / this->engineSwapChain.height()};
+        push.offset = {-1.0f, -1.0f};
+
+        this->pipeline->bind(commandBuffer);
+        this->bindlessTable.bind(commandBuffer, this->pipelineLayout);
+        vkCmdPushConstants(commandBuffer, this->pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(SpritePush), &push);
+        VkBuffer vertexBuffer = this->vertexStream.getBuffer();
+        vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer, &vertexOffset);
+        vkCmdBindIndexBuffer(commandBuffer, this->indexBuffer, 0, VK_INDEX_TYPE_UINT16);
+
+        // the vertex offset rebases the shared indices, so the whole stream stays bound
+        uint32_t drawCount = 0;
+        for(uint32_t firstSprite = 0; firstSprite < spriteCount; firstSprite += MAX_SPRITES_PER_DRAW){
+            uint32_t batchSpriteCount = std::min(spriteCount - firstSprite, MAX_SPRITES_PER_DRAW);
+            vkCmdDrawIndexed(commandBuffer, batchSpriteCount * 6, 1, 0, static_cast<int32_t>(firstSprite * 4), 0);
+            drawCount++;
+        }
+        return drawCount;
+    }
+
+    // Privates
+    void EngineSpriteBatch::createIndexBuffer(){
+        std::vector<uint16_t> indices(MAX_SPRITES_PER_DRAW * 6);
+        for(uint32_t i = 0; i < MAX_SPRITES_PER_DRAW; i++){
+            uint16_t first = static_cast<uint16_t>(i * 4);
+            uint16_t quad[6] = {first, static_cast<uint16_t>(first + 1), static_cast<uint16_t>(first + 2), static_cast<uint16_t>(first + 2), static_cast<uint16_t>(first + 3), first};
+            std::copy(quad, quad + 6, indices.begin() + i * 6);
+        }
+        VkDeviceSize bufferSize = indices.size() * sizeof(uint16_t);
+
+        VkBuffer stagingBuffer;
+        VkDeviceMemory stagingBufferMemory;
+        this->engineDevice.createBuffer(
+            bufferSize,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            stagingBuffer,
+            stagingBufferMemory
+        );
+        void *data;
+        vkMapMemory(this->engineDevice.device(), stagingBufferMemory, 0, bufferSize, 0, &data);
+        memcpy(data, indices.data(), static_cast<size_t>(bufferSize));
+        vkUnmapMemory(this->engineDevice.device(), stagingBufferMemory);
+
+        this->engineDevice.createBuffer(
+            bufferSize,
+            VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            this->indexBuffer,
+            this->indexBufferMemory
+        );
+        this->engineDevice.copyBuffer(stagingBuffer, this->indexBuffer, bufferSize);
+        vkDestroyBuffer(this->engineDevice.device(), stagingBuffer, nullptr);
+        vkFreeMemory(this->engineDevice.device(), stagingBufferMemory, nullptr);
+    }
+
+    void EngineSpriteBatch::createPipelineLayout(){
+        VkPushConstantRange pushConstantRange = {};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(SpritePush);
+
+        VkDescriptorSetLayout descriptorSetLayout = this->bindlessTable.getDescriptorSetLayout();
+        VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
+        pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutCreateInfo.setLayoutCount = 1;
+        pipelineLayoutCreateInfo.pSetLayouts = &descriptorSetLayout;
+        pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+        pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+        bool isCreatePipelineLayoutSuccess = vkCreatePipelineLayout(this->engineDevice.device(), &pipelineLayoutCreateInfo, nullptr, &this->pipelineLayout) == VK_SUCCESS;
+        if(!isCreatePipelineLayoutSuccess) throw std::runtime_error("Failed to create sprite pipeline layout!");
+    }
+
+    std::vector<VkVertexInputBindingDescription> EngineSpriteBatch::getBindingDescriptions(){
+        std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
+        bindingDescriptions[0].binding = 0;
+        bindingDescriptions[0].stride = sizeof(Vertex);
+        bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+        return bindingDescriptions;
+    }
+
+    std::vector<VkVertexInputAttributeDescription> EngineSpriteBatch::getAttributeDescriptions(){
+        std::vector<VkVertexInputAttributeDescription> attributeDescriptions(4);
+        attributeDescriptions[0] = {0, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, position)};
+        attributeDescriptions[1] = {1, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, uv)};
+        attributeDescriptions[2] = {2, 0, VK_FORMAT_R8G8B8A8_UNORM, offsetof(Vertex, color)};
+        attributeDescriptions[3] = {3, 0, VK_FORMAT_R32_UINT, offsetof(Vertex, textureIndex)};
+        return attributeDescriptions;
+    }
+}
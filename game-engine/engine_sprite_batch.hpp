@@ -0,0 +1,105 @@
+#pragma once
+#include "engine_device.hpp"
+#include "engine_bindless_table.hpp"
+#include "engine_dynamic_buffer.hpp"
+#include "engine_model.hpp"
+#include "engine_pipeline.hpp"
+#include "engine_pipeline_cache.hpp"
+#include "engine_swap_chain.hpp"
+
+// std
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace engine {
+    // Batches 2D sprites and flat coloured quads into as few draws as possible. Sprites are queued
+    // during the frame, then flush sorts them by layer and, within a layer, by texture, writes four
+    // vertices each into a persistently mapped stream and draws them with a shared 16-bit index
+    // buffer. The texture is a bindless index carried by every vertex, so changing textures never
+    // splits a draw: only the 16-bit index range does, every MAX_SPRITES_PER_DRAW sprites.
+    //
+    // Positions are in pixels from the top left corner of the swap chain.
+    class EngineSpriteBatch {
+        public:
+            static constexpr const char *VERTEX_SHADER_PATH = "shaders/sprite.vert.spv";
+            static constexpr const char *FRAGMENT_SHADER_PATH = "shaders/sprite.frag.spv";
+            // four vertices each fill the 65536 a 16-bit index can reach
+            static constexpr uint32_t MAX_SPRITES_PER_DRAW = 16384;
+            static constexpr uint32_t MAX_SPRITES = 65536;
+
+            struct Sprite {
+                // centre in pixels
+                glm::vec2 position{0.0f};
+                // full width and height in pixels
+                glm::vec2 size{1.0f};
+                // radians, around the centre
+                float rotation = 0.0f;
+                // min uv, max uv of the texture region
+                glm::vec4 uvRect{0.0f, 0.0f, 1.0f, 1.0f};
+                glm::vec4 color{1.0f};
+                // bindless texture, INVALID_INDEX draws a flat quad of color
+                uint32_t textureIndex = EngineBindlessTable::INVALID_INDEX;
+                // lower layers are drawn first, submission order decides within a layer and texture
+                int16_t layer = 0;
+            };
+
+            EngineSpriteBatch(EngineDevice &device, EngineBindlessTable &bindlessTable, EnginePipelineCache &pipelineCache, EngineSwapChain &swapChain, uint32_t frameCount);
+            ~EngineSpriteBatch();
+
+            EngineSpriteBatch(const EngineSpriteBatch &) = delete;
+            EngineSpriteBatch &operator = (const EngineSpriteBatch &) = delete;
+
+            // Builds the sprite pipeline for the swap chain's render pass, or picks up the rebuilt one after a shader reload
+            void createPipeline();
+
+            // Starts queueing the sprites of a frame, the GPU must be done with the slot's previous vertices
+            void begin(size_t frameIndex);
+            // Sprites past MAX_SPRITES in a frame are dropped
+            void draw(const Sprite &sprite);
+            void drawQuad(glm::vec2 position, glm::vec2 size, glm::vec4 color, int16_t layer = 0);
+            // Inside a render pass compatible with the swap chain's. Draws everything queued since
+            // begin and returns the number of draw calls it took.
+            uint32_t flush(VkCommandBuffer commandBuffer);
+
+        private:
+            // sprite.vert's inputs
+            struct Vertex {
+                glm::vec2 position;
+                glm::vec2 uv;
+                // RGBA8
+                uint32_t color;
+                uint32_t textureIndex;
+            };
+
+            struct SpritePush {
+                // pixels to normalised device coordinates
+                glm::vec2 scale;
+                glm::vec2 offset;
+            };
+
+            void createIndexBuffer();
+            void createPipelineLayout();
+            static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
+            static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+
+            EngineDevice &engineDevice;
+            EngineBindlessTable &bindlessTable;
+            EnginePipelineCache &pipelineCache;
+            EngineSwapChain &engineSwapChain;
+
+            EngineDynamicBuffer vertexStream;
+            // the same two triangles for every quad, device local
+            VkBuffer indexBuffer;
+            VkDeviceMemory indexBufferMemory;
+
+            // reserved up front so queueing never allocates
+            std::vector<Sprite> sprites;
+            // layer, texture and submission order, sorted once per flush
+            std::vector<uint64_t> sortKeys;
+
+            VkPipelineLayout pipelineLayout;
+            // owned by the cache
+            EnginePipeline *pipeline = nullptr;
+    };
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+// std
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace engine {
+    // Fixed size lock-free queue between exactly one producer thread and one consumer thread.
+    // Head and tail only ever grow, the slot is the index modulo the capacity, and each side
+    // publishes its index with release after touching the slot so the other side sees the data.
+    // A consumer with nothing to pop can sleep in waitPop, the producer only takes the lock to
+    // wake it when it is actually asleep.
+    template<typename T, size_t Capacity>
+    class EngineSpscRing {
+        static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "EngineSpscRing capacity must be a power of two");
+
+        public:
+            EngineSpscRing() = default;
+            EngineSpscRing(const EngineSpscRing &) = delete;
+            EngineSpscRing &operator = (const EngineSpscRing &) = delete;
+
+            // Producer only, returns false without copying when every slot is taken
+            bool tryPush(const T &value){
+                size_t tail = this->tail.load(std::memory_order_relaxed);
+                if(tail - this->head.load(std::memory_order_acquire) == Capacity) return false;
+                this->slots[tail & (Capacity - 1)] = value;
+                // sequentially consistent with the consumer's flag, so one of them always sees the other
+                this->tail.store(tail + 1, std::memory_order_seq_cst);
+                if(this->isConsumerWaiting.load(std::memory_order_seq_cst)) this->notifyConsumer();
+                return true;
+            }
+
+            // Consumer only, returns false when nothing has been pushed since the last pop
+            bool tryPop(T &value){
+                size_t head = this->head.load(std::memory_order_relaxed);
+                if(head == this->tail.load(std::memory_order_acquire)) return false;
+                value = this->slots[head & (Capacity - 1)];
+                this->head.store(head + 1, std::memory_order_release);
+                return true;
+            }
+
+            // Consumer only, spins for a moment and then sleeps until a value is pushed or wake is
+            // called. Returns false when woken with nothing to pop.
+            bool waitPop(T &value){
+                for(uint32_t i = 0; i < SPIN_COUNT; i++){
+                    if(this->tryPop(value)) return true;
+                }
+
+                {
+                    std::unique_lock<std::mutex> lock(this->waitMutex);
+                    this->isConsumerWaiting.store(true, std::memory_order_seq_cst);
+                    this->waitCondition.wait(lock, [this]{
+                        return this->isWakeRequested || this->head.load(std::memory_order_relaxed) != this->tail.load(std::memory_order_seq_cst);
+                    });
+                    this->isConsumerWaiting.store(false, std::memory_order_relaxed);
+                    this->isWakeRequested = false;
+                }
+                return this->tryPop(value);
+            }
+
+            // Any thread, returns a consumer sleeping in waitPop, or the next call to it, early
+            void wake(){
+                {
+                    std::lock_guard<std::mutex> lock(this->waitMutex);
+                    this->isWakeRequested = true;
+                }
+                this->waitCondition.notify_one();
+            }
+
+            // Exact from the producer, the consumer can only make room in the meantime
+            bool isFull() const {
+                return this->tail.load(std::memory_order_relaxed) - this->head.load(std::memory_order_acquire) == Capacity;
+            }
+
+        private:
+            // head and tail on separate cache lines, so the two threads do not invalidate each other's
+            static constexpr size_t CACHE_LINE_SIZE = 64;
+            // tryPop attempts before sleeping, a value due within a few hundred nanoseconds is not worth the wake up
+            static constexpr uint32_t SPIN_COUNT = 64;
+
+            void notifyConsumer(){
+                // taken so the notification cannot land between the consumer's check and its wait
+                { std::lock_guard<std::mutex> lock(this->waitMutex); }
+                this->waitCondition.notify_one();
+            }
+
+            std::array<T, Capacity> slots;
+            alignas(CACHE_LINE_SIZE) std::atomic<size_t> head{0};
+            alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail{0};
+
+            std::atomic<bool> isConsumerWaiting{false};
+            std::mutex waitMutex;
+            std::condition_variable waitCondition;
+            bool isWakeRequested = false;
+    };
+}
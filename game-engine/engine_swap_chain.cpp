@@ -1,21 +1,25 @@
 #include "engine_swap_chain.hpp"
+#include "engine_log.hpp"
 
 // std
-#include <iostream>
 #include <array>
-#include <iostream>
+#include <algorithm>
+#include <stdexcept>
 
 namespace engine {
   // Publics
-  EngineSwapChain::EngineSwapChain(EngineDevice &deviceReference, VkExtent2D windowExtent): device{deviceReference}, windowExtent{windowExtent}{
-    std::cout << "EngineSwapChain: Initialising engine swap chain" << std::endl;
+  EngineSwapChain::EngineSwapChain(EngineDevice &deviceReference, VkExtent2D windowExtent, VkSampleCountFlagBits requestedSampleCount, bool isDepthKept): isDepthKept_{isDepthKept}, device{deviceReference}, windowExtent{windowExtent}{
+    ENGINE_LOG_INFO("EngineSwapChain: Initialising engine swap chain");
+    this->sampleCount = std::min(requestedSampleCount, this->device.getMaxUsableSampleCount());
+    ENGINE_LOG_DEBUG("\t\t -> MSAA samples -> %d", static_cast<int>(this->sampleCount));
     this->createSwapChain();
     this->createImageViews();
     this->createRenderPass();
+    this->createColorResources();
     this->createDepthResources();
     this->createFramebuffers();
     this->createSyncObjects();
-    std::cout << "EngineSwapChain: Successfully initialise engine swap chain" << std::endl;
+    ENGINE_LOG_INFO("EngineSwapChain: Successfully initialise engine swap chain");
   }
 
   EngineSwapChain::~EngineSwapChain(){
@@ -28,6 +32,12 @@ namespace engine {
       this->swapChain = nullptr;
     }
 
+    for(int i = 0; i < this->colorImages.size(); i++){
+      vkDestroyImageView(this->device.device(), this->colorImageViews[i], nullptr);
+      vkDestroyImage(this->device.device(), this->colorImages[i], nullptr);
+      vkFreeMemory(this->device.device(), this->colorImageMemories[i], nullptr);
+    }
+
     for(int i = 0; i < this->depthImages.size(); i++){
       vkDestroyImageView(this->device.device(), this->depthImageViews[i], nullptr);
       vkDestroyImage(this->device.device(), this->depthImages[i], nullptr);
@@ -39,6 +49,7 @@ namespace engine {
     }
 
     vkDestroyRenderPass(this->device.device(), this->renderPass, nullptr);
+    if(this->continueRenderPass != VK_NULL_HANDLE) vkDestroyRenderPass(this->device.device(), this->continueRenderPass, nullptr);
 
     // clean up synchronisation objects
     for(size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++){
@@ -49,10 +60,12 @@ namespace engine {
   }
 
   VkFormat EngineSwapChain::findDepthFormat(){
+    VkFormatFeatureFlags features = VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    if(this->isDepthKept_) features |= VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
     return this->device.findSupportedFormat(
       {VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT},
       VK_IMAGE_TILING_OPTIMAL,
-      VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT
+      features
     );
   }
 
@@ -96,9 +109,19 @@ namespace engine {
       return result;
   }
 
+  void EngineSwapChain::waitForFramesInFlight(){
+    vkWaitForFences(
+      this->device.device(),
+      static_cast<uint32_t>(this->inFlightFences.size()),
+      this->inFlightFences.data(),
+      VK_TRUE,
+      std::numeric_limits<uint64_t>::max()
+    );
+  }
+
   //Privates
   void EngineSwapChain::createSwapChain(){
-    std::cout << "\t -> createSwapChain(): Creating swap chain" << std::endl;
+    ENGINE_LOG_DEBUG("\t -> createSwapChain(): Creating swap chain");
     
     SwapChainSupportDetails swapChainSupportDetails = this->device.getSwapChainSupportDetails();
     VkSurfaceFormatKHR surfaceFormat = this->chooseSwapSurfaceFormat(swapChainSupportDetails.formats);
@@ -145,22 +168,45 @@ namespace engine {
     this->swapChainImageFormat = surfaceFormat.format;
     this->swapChainExtent = extent;
 
-    std::cout << "\t -> createSwapChain(): Successfully create swap chain" << std::endl;
+    ENGINE_LOG_DEBUG("\t -> createSwapChain(): Successfully create swap chain");
   }
 
   void EngineSwapChain::createImageViews(){
-    std::cout << "\t -> createImageViews(): Creating image views" << std::endl;
+    ENGINE_LOG_DEBUG("\t -> createImageViews(): Creating image views");
     this->swapChainImageViews.resize(this->swapChainImages.size());
     for(size_t i = 0; i < this->swapChainImages.size(); i++){
       VkImageViewCreateInfo imageViewCreateInfo = this->buildImageViewCreateInfo(this->swapChainImages[i], this->swapChainImageFormat, VK_IMAGE_ASPECT_COLOR_BIT);
       bool isCreateImageViewSuccess = vkCreateImageView(this->device.device(), &imageViewCreateInfo, nullptr, &this->swapChainImageViews[i]) == VK_SUCCESS;
       if(!isCreateImageViewSuccess) throw std::runtime_error("Failed to create texture image view!");
     }
-    std::cout << "\t -> createImageViews(): Successfully create image views" << std::endl;
+    ENGINE_LOG_DEBUG("\t -> createImageViews(): Successfully create image views");
+  }
+
+  void EngineSwapChain::createColorResources(){
+    if(!this->isMultisampled()) return;
+    ENGINE_LOG_DEBUG("\t -> createColorResources(): Creating multisampled colour resources");
+
+    this->colorImages.resize(this->imageCount());
+    this->colorImageMemories.resize(this->imageCount());
+    this->colorImageViews.resize(this->imageCount());
+    for(int i = 0; i < this->colorImages.size(); i++){
+      // only the resolved image is kept, the samples never leave tile memory on GPUs that support it,
+      // unless a second render pass has to continue from them
+      VkImageUsageFlags usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+      if(!this->isDepthKept_) usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+      VkImageCreateInfo imageCreateInfo = this->buildImageCreateInfo(this->swapChainImageFormat, usage, this->sampleCount);
+      VkMemoryPropertyFlags memoryProperties = this->isDepthKept_ ? VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT : this->chooseTransientMemoryProperties();
+      this->device.createImageWithInfo(imageCreateInfo, memoryProperties, this->colorImages[i], this->colorImageMemories[i]);
+      VkImageViewCreateInfo imageViewCreateInfo = this->buildImageViewCreateInfo(this->colorImages[i], this->swapChainImageFormat, VK_IMAGE_ASPECT_COLOR_BIT);
+      bool isCreateImageViewSuccess = vkCreateImageView(this->device.device(), &imageViewCreateInfo, nullptr, &this->colorImageViews[i]) == VK_SUCCESS;
+      if(!isCreateImageViewSuccess) throw std::runtime_error("Failed to create image");
+    }
+
+    ENGINE_LOG_DEBUG("\t -> createColorResources(): Successfully create multisampled colour resources");
   }
 
   void EngineSwapChain::createDepthResources(){
-    std::cout << "\t -> createDepthResources(): Creating depth resources" << std::endl;
+    ENGINE_LOG_DEBUG("\t -> createDepthResources(): Creating depth resources");
 
     VkFormat depthFormat = this->findDepthFormat();
     VkExtent2D swapChainExtent = this->getSwapChainExtent();
@@ -169,27 +215,41 @@ namespace engine {
     this->depthImageMemories.resize(this->imageCount());
     this->depthImageViews.resize(this->imageCount());
     for(int i = 0; i < this->depthImages.size(); i++){
-      VkImageCreateInfo imageCreateInfo = this->buildImageCreateInfo(depthFormat);
-      this->device.createImageWithInfo(imageCreateInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, this->depthImages[i], this->depthImageMemories[i]);
+      // depth is only stored when it is read back, otherwise it is transient as well
+      VkImageUsageFlags usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+      usage |= this->isDepthKept_ ? VK_IMAGE_USAGE_SAMPLED_BIT : VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+      VkImageCreateInfo imageCreateInfo = this->buildImageCreateInfo(depthFormat, usage, this->sampleCount);
+      VkMemoryPropertyFlags memoryProperties = this->isDepthKept_ ? VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT : this->chooseTransientMemoryProperties();
+      this->device.createImageWithInfo(imageCreateInfo, memoryProperties, this->depthImages[i], this->depthImageMemories[i]);
       VkImageViewCreateInfo imageViewCreateInfo = this->buildImageViewCreateInfo(this->depthImages[i], depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
       bool isCreateImageViewSuccess = vkCreateImageView(this->device.device(), &imageViewCreateInfo, nullptr, &this->depthImageViews[i]) == VK_SUCCESS;
       if(!isCreateImageViewSuccess) throw std::runtime_error("Failed to create image");
     }
 
-    std::cout << "\t -> createDepthResources(): Successfully create depth resources" << std::endl;
+    ENGINE_LOG_DEBUG("\t -> createDepthResources(): Successfully create depth resources");
   }
 
   void EngineSwapChain::createRenderPass(){
-    std::cout << "\t -> createRenderPass(): Creating render pass" << std::endl;
+    ENGINE_LOG_DEBUG("\t -> createRenderPass(): Creating render pass");
+    this->renderPass = this->createRenderPass(false);
+    if(this->isDepthKept_) this->continueRenderPass = this->createRenderPass(true);
+    ENGINE_LOG_DEBUG("\t -> createRenderPass(): Successfully create render pass");
+  }
+
+  VkRenderPass EngineSwapChain::createRenderPass(bool isContinuation){
+    // a continuation starts from the layouts the first pass leaves its attachments in
+    VkAttachmentLoadOp loadOp = isContinuation ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR;
+    VkAttachmentStoreOp keptStoreOp = this->isDepthKept_ && !isContinuation ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    VkImageLayout colorFinalLayout = this->isMultisampled() ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
     VkAttachmentDescription depthAttachmentDescription = {};
     depthAttachmentDescription.format = this->findDepthFormat();
-    depthAttachmentDescription.samples = VK_SAMPLE_COUNT_1_BIT;
-    depthAttachmentDescription.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    depthAttachmentDescription.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depthAttachmentDescription.samples = this->sampleCount;
+    depthAttachmentDescription.loadOp = loadOp;
+    depthAttachmentDescription.storeOp = keptStoreOp;
     depthAttachmentDescription.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     depthAttachmentDescription.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    depthAttachmentDescription.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    depthAttachmentDescription.initialLayout = isContinuation ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED;
     depthAttachmentDescription.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
 
@@ -197,61 +257,82 @@ namespace engine {
     depthAttachmentReference.attachment = 1;
     depthAttachmentReference.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
+    // with MSAA the samples are discarded once resolved, otherwise the swap chain image is drawn to directly
     VkAttachmentDescription colorAttachmentDescription = {};
     colorAttachmentDescription.format = getSwapChainImageFormat();
-    colorAttachmentDescription.samples = VK_SAMPLE_COUNT_1_BIT;
-    colorAttachmentDescription.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    colorAttachmentDescription.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    colorAttachmentDescription.samples = this->sampleCount;
+    colorAttachmentDescription.loadOp = loadOp;
+    colorAttachmentDescription.storeOp = this->isMultisampled() ? keptStoreOp : VK_ATTACHMENT_STORE_OP_STORE;
     colorAttachmentDescription.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     colorAttachmentDescription.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    colorAttachmentDescription.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachmentDescription.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-
+    colorAttachmentDescription.initialLayout = isContinuation ? colorFinalLayout : VK_IMAGE_LAYOUT_UNDEFINED;
+    colorAttachmentDescription.finalLayout = colorFinalLayout;
 
     VkAttachmentReference colorAttachmentReference = {};
     colorAttachmentReference.attachment = 0;
     colorAttachmentReference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
+    VkAttachmentDescription resolveAttachmentDescription = {};
+    resolveAttachmentDescription.format = getSwapChainImageFormat();
+    resolveAttachmentDescription.samples = VK_SAMPLE_COUNT_1_BIT;
+    resolveAttachmentDescription.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    resolveAttachmentDescription.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    resolveAttachmentDescription.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    resolveAttachmentDescription.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    resolveAttachmentDescription.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    resolveAttachmentDescription.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+    VkAttachmentReference resolveAttachmentReference = {};
+    resolveAttachmentReference.attachment = 2;
+    resolveAttachmentReference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
     VkSubpassDescription subpassDescription = {};
     subpassDescription.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
     subpassDescription.colorAttachmentCount = 1;
     subpassDescription.pColorAttachments = &colorAttachmentReference;
     subpassDescription.pDepthStencilAttachment = &depthAttachmentReference;
+    subpassDescription.pResolveAttachments = this->isMultisampled() ? &resolveAttachmentReference : nullptr;
 
     VkSubpassDependency subpassDependency = {};
     subpassDependency.srcSubpass = VK_SUBPASS_EXTERNAL;
     subpassDependency.srcAccessMask = 0;
     subpassDependency.srcStageMask =
         VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+    if(isContinuation){
+      // the writes of the first pass have to land before they are loaded
+      subpassDependency.srcStageMask |= VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+      subpassDependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    }
     subpassDependency.dstSubpass = 0;
     subpassDependency.dstStageMask =
         VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
     subpassDependency.dstAccessMask =
         VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    if(isContinuation) subpassDependency.dstAccessMask |= VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
 
-    std::array<VkAttachmentDescription, 2> attachments = {colorAttachmentDescription, depthAttachmentDescription};
+    std::array<VkAttachmentDescription, 3> attachments = {colorAttachmentDescription, depthAttachmentDescription, resolveAttachmentDescription};
     VkRenderPassCreateInfo renderPassCreateInfo = {};
     renderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-    renderPassCreateInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+    renderPassCreateInfo.attachmentCount = this->isMultisampled() ? 3 : 2;
     renderPassCreateInfo.pAttachments = attachments.data();
     renderPassCreateInfo.subpassCount = 1;
     renderPassCreateInfo.pSubpasses = &subpassDescription;
     renderPassCreateInfo.dependencyCount = 1;
     renderPassCreateInfo.pDependencies = &subpassDependency;
 
-    bool isCreateRenderPassSuccess = vkCreateRenderPass(this->device.device(), &renderPassCreateInfo, nullptr, &this->renderPass) == VK_SUCCESS;
+    VkRenderPass renderPass;
+    bool isCreateRenderPassSuccess = vkCreateRenderPass(this->device.device(), &renderPassCreateInfo, nullptr, &renderPass) == VK_SUCCESS;
     if(!isCreateRenderPassSuccess) throw std::runtime_error("Failed to create render pass!");
-
-    std::cout << "\t -> createRenderPass(): Successfully create render pass" << std::endl;
+    return renderPass;
   }
 
   void EngineSwapChain::createFramebuffers(){
-    std::cout << "\t -> createFramebuffers(): Creating frame buffers" << std::endl;
+    ENGINE_LOG_DEBUG("\t -> createFramebuffers(): Creating frame buffers");
 
     this->swapChainFramebuffers.resize(this->imageCount());
     for(size_t i = 0; i < this->imageCount(); i ++){
-      std::array<VkImageView, 2> attachments = {this->swapChainImageViews[i], this->depthImageViews[i]};
+      std::vector<VkImageView> attachments = {this->swapChainImageViews[i], this->depthImageViews[i]};
+      if(this->isMultisampled()) attachments = {this->colorImageViews[i], this->depthImageViews[i], this->swapChainImageViews[i]};
       VkExtent2D swapChainExtent = this->getSwapChainExtent();
 
       VkFramebufferCreateInfo framebufferCreateInfo = this->buildFrameBufferCreateInfo(
@@ -266,11 +347,11 @@ namespace engine {
       if(!isCreateFrameBufferSuccess) throw std::runtime_error("Failed to create frame buffer!");
     }
 
-    std::cout << "\t -> createFramebuffers(): Successfully create frame buffers" << std::endl;
+    ENGINE_LOG_DEBUG("\t -> createFramebuffers(): Successfully create frame buffers");
   }
 
   void EngineSwapChain::createSyncObjects(){
-    std::cout << "\t -> createSyncObjects(): Creating sync objects" << std::endl;
+    ENGINE_LOG_DEBUG("\t -> createSyncObjects(): Creating sync objects");
 
     this->imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
     this->renderedImageSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
@@ -293,7 +374,7 @@ namespace engine {
         throw std::runtime_error("Failed to create synchronisation objects for a frame!");
     }
 
-    std::cout << "\t -> createSyncObjects(): Successfully create sync objects" << std::endl;
+    ENGINE_LOG_DEBUG("\t -> createSyncObjects(): Successfully create sync objects");
 
   }
 
@@ -338,7 +419,7 @@ namespace engine {
     return info;
   }
 
-  VkImageCreateInfo EngineSwapChain::buildImageCreateInfo(VkFormat format){
+  VkImageCreateInfo EngineSwapChain::buildImageCreateInfo(VkFormat format, VkImageUsageFlags usage, VkSampleCountFlagBits samples){
     VkImageCreateInfo info = {};
     info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
     info.imageType = VK_IMAGE_TYPE_2D;
@@ -350,8 +431,8 @@ namespace engine {
     info.format = format;
     info.tiling = VK_IMAGE_TILING_OPTIMAL;
     info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    info.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
-    info.samples = VK_SAMPLE_COUNT_1_BIT;
+    info.usage = usage;
+    info.samples = samples;
     info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
     info.flags = 0;
     return info;
@@ -397,17 +478,17 @@ namespace engine {
   VkPresentModeKHR EngineSwapChain::chooseSwapPresentMode(const std::vector<VkPresentModeKHR> &availablePresentModes){
     for(const auto &availablePresentMode: availablePresentModes){
       if(availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR){
-        std::cout << "\t\t -> Present mode: Mailbox" << std::endl;
+        ENGINE_LOG_DEBUG("\t\t -> Present mode: Mailbox");
         return availablePresentMode;
       }
 
       if (availablePresentMode == VK_PRESENT_MODE_IMMEDIATE_KHR) {
-        std::cout << "\t\t -> Present mode: Immediate" << std::endl;
+        ENGINE_LOG_DEBUG("\t\t -> Present mode: Immediate");
         return availablePresentMode;
       }
     }
 
-    std::cout << "\t\t -> Present mode: V-sync" << std::endl;
+    ENGINE_LOG_DEBUG("\t\t -> Present mode: V-sync");
     return VK_PRESENT_MODE_FIFO_KHR;
   }
 
@@ -424,4 +505,11 @@ namespace engine {
     );
     return actualExtent;
   }
-}           
\ No newline at end of file
+
+  VkMemoryPropertyFlags EngineSwapChain::chooseTransientMemoryProperties(){
+    // lazily allocated memory is only backed when the tiler spills, fall back to regular device memory elsewhere
+    VkMemoryPropertyFlags lazilyAllocated = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+    if(this->device.hasMemoryType(~0u, lazilyAllocated)) return lazilyAllocated;
+    return VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+  }
+}
@@ -3,6 +3,7 @@
 #include "engine_device.hpp"
 
 // std
+#include <limits>
 #include <string>
 #include <vector>
 
@@ -10,7 +11,10 @@ namespace engine {
   class EngineSwapChain {
     public: 
       static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
-      EngineSwapChain(EngineDevice &deviceReference, VkExtent2D windowExtent);
+      // the requested sample count is clamped to what the device supports for colour and depth.
+      // With isDepthKept the attachments are stored and the depth images can be sampled after the
+      // render pass, and getContinueRenderPass resumes drawing into them.
+      EngineSwapChain(EngineDevice &deviceReference, VkExtent2D windowExtent, VkSampleCountFlagBits requestedSampleCount = VK_SAMPLE_COUNT_1_BIT, bool isDepthKept = false);
       ~EngineSwapChain();
 
       EngineSwapChain(const EngineSwapChain &) = delete;
@@ -23,9 +27,27 @@ namespace engine {
       VkRenderPass getRenderPass(){
         return this->renderPass;
       }
+      // Compatible with getRenderPass but loads what it stored instead of clearing, only with isDepthKept
+      VkRenderPass getContinueRenderPass(){
+        return this->continueRenderPass;
+      }
+      bool isDepthKept(){
+        return this->isDepthKept_;
+      }
+      // Left in DEPTH_STENCIL_ATTACHMENT_OPTIMAL by both render passes
+      VkImage getDepthImage(int index){
+        return this->depthImages[index];
+      }
+      VkImageView getDepthImageView(int index){
+        return this->depthImageViews[index];
+      }
       VkImageView getImageView(int index){
         return this->swapChainImageViews[index];
       }
+      // Frame-in-flight slot used by the image acquired last, its previous submission has completed
+      size_t currentFrameIndex(){
+        return this->currentFrame;
+      }
       size_t imageCount(){
         return this->swapChainImages.size();
       }
@@ -35,6 +57,12 @@ namespace engine {
       VkExtent2D getSwapChainExtent(){
         return this->swapChainExtent;
       }
+      VkSampleCountFlagBits getSampleCount(){
+        return this->sampleCount;
+      }
+      bool isMultisampled(){
+        return this->sampleCount != VK_SAMPLE_COUNT_1_BIT;
+      }
       uint32_t width(){
         return this->swapChainExtent.width;
       }
@@ -48,11 +76,15 @@ namespace engine {
       VkFormat findDepthFormat();
       VkResult acquireNextImage(uint32_t *imageIndex);
       VkResult submitCommandBuffers(const VkCommandBuffer *buffers, uint32_t *imageIndex);
+      // Blocks until every submitted frame has finished executing on the GPU
+      void waitForFramesInFlight();
     private:
       void createSwapChain();
       void createImageViews();
+      void createColorResources();
       void createDepthResources();
       void createRenderPass();
+      VkRenderPass createRenderPass(bool isContinuation);
       void createFramebuffers();
       void createSyncObjects();
 
@@ -61,19 +93,27 @@ namespace engine {
       VkImageViewCreateInfo buildImageViewCreateInfo(VkImage image, VkFormat format, VkImageAspectFlags aspectMask);
       VkSubmitInfo buildSubmitInfo(const VkSemaphore* pWaitSemaphores, const VkPipelineStageFlags* pWaitDestStageMask, const VkCommandBuffer* commandBuffers,  const VkSemaphore* pSignalSemaphores);
       VkPresentInfoKHR buildPresentInfoKHR(const VkSemaphore* pWaitSemaphores, const VkSwapchainKHR* pSwapChains, const uint32_t* pImageIndices);
-      VkImageCreateInfo buildImageCreateInfo(VkFormat format);
+      VkImageCreateInfo buildImageCreateInfo(VkFormat format, VkImageUsageFlags usage, VkSampleCountFlagBits samples);
       VkFramebufferCreateInfo buildFrameBufferCreateInfo(VkRenderPass renderPass, uint32_t attachmentCount, const VkImageView* pAttachments, uint32_t width, uint32_t height);
       // Utilities
       VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR> &availableFormats);
       VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR> &availablePresentModes);
       VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR &capabilities);
+      VkMemoryPropertyFlags chooseTransientMemoryProperties();
 
       VkFormat swapChainImageFormat;
       VkExtent2D swapChainExtent;
+      VkSampleCountFlagBits sampleCount;
 
       std::vector<VkFramebuffer> swapChainFramebuffers;
       VkRenderPass renderPass;
+      VkRenderPass continueRenderPass = VK_NULL_HANDLE;
+      bool isDepthKept_;
 
+      // multisampled colour targets, resolved into the swap chain images at the end of the subpass
+      std::vector<VkImage> colorImages;
+      std::vector<VkDeviceMemory> colorImageMemories;
+      std::vector<VkImageView> colorImageViews;
       std::vector<VkImage> depthImages;
       std::vector<VkDeviceMemory> depthImageMemories;
       std::vector<VkImageView> depthImageViews;
@@ -0,0 +1,724 @@
+#include "engine_texture_streamer.hpp"
+#include "engine_log.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace engine {
+    // Utilities
+    static uint32_t readU32(const std::vector<char> &bytes, size_t offset){
+        uint32_t value;
+        memcpy(&value, bytes.data() + offset, sizeof(value));
+        return value;
+    }
+
+    static uint64_t readU64(const std::vector<char> &bytes, size_t offset){
+        uint64_t value;
+        memcpy(&value, bytes.data() + offset, sizeof(value));
+        return value;
+    }
+
+    static std::vector<char> readBytes(std::ifstream &file, uint64_t offset, uint64_t size){
+        std::vector<char> bytes(size);
+        file.seekg(static_cast<std::streamoff>(offset));
+        file.read(bytes.data(), static_cast<std::streamsize>(size));
+        if(!file) throw std::runtime_error("Failed to read texture data");
+        return bytes;
+    }
+
+    // Texel block dimension and its size in bytes
+    static void getFormatBlockInfo(VkFormat format, uint32_t &blockDimension, uint32_t &blockBytes){
+        switch(format){
+            case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+            case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+                blockDimension = 4; blockBytes = 8; return;
+            case VK_FORMAT_BC3_UNORM_BLOCK:
+            case VK_FORMAT_BC3_SRGB_BLOCK:
+            case VK_FORMAT_BC7_UNORM_BLOCK:
+            case VK_FORMAT_BC7_SRGB_BLOCK:
+                blockDimension = 4; blockBytes = 16; return;
+            case VK_FORMAT_R8G8B8A8_UNORM:
+            case VK_FORMAT_R8G8B8A8_SRGB:
+            case VK_FORMAT_B8G8R8A8_UNORM:
+            case VK_FORMAT_B8G8R8A8_SRGB:
+                blockDimension = 1; blockBytes = 4; return;
+            case VK_FORMAT_R16G16B16A16_SFLOAT:
+                blockDimension = 1; blockBytes = 8; return;
+            case VK_FORMAT_R32G32B32A32_SFLOAT:
+                blockDimension = 1; blockBytes = 16; return;
+            default:
+                throw std::runtime_error("Unsupported texture format: " + std::to_string(format));
+        }
+    }
+
+    static VkFormat getDxgiFormat(uint32_t dxgiFormat){
+        switch(dxgiFormat){
+            case 2: return VK_FORMAT_R32G32B32A32_SFLOAT;
+            case 10: return VK_FORMAT_R16G16B16A16_SFLOAT;
+            case 28: return VK_FORMAT_R8G8B8A8_UNORM;
+            case 29: return VK_FORMAT_R8G8B8A8_SRGB;
+            case 71: return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+            case 72: return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+            case 77: return VK_FORMAT_BC3_UNORM_BLOCK;
+            case 78: return VK_FORMAT_BC3_SRGB_BLOCK;
+            case 87: return VK_FORMAT_B8G8R8A8_UNORM;
+            case 91: return VK_FORMAT_B8G8R8A8_SRGB;
+            case 98: return VK_FORMAT_BC7_UNORM_BLOCK;
+            case 99: return VK_FORMAT_BC7_SRGB_BLOCK;
+            default: throw std::runtime_error("Unsupported DDS DXGI format: " + std::to_string(dxgiFormat));
+        }
+    }
+
+    static double nowInSeconds(){
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    TextureFileInfo TextureFileInfo::readKtx2(const std::string &filePath){
+        static const unsigned char identifier[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+        static constexpr size_t HEADER_SIZE = 80;
+        static constexpr size_t LEVEL_INDEX_ENTRY_SIZE = 24;
+
+        std::ifstream file(filePath, std::ios::binary);
+        if(!file.is_open()) throw std::runtime_error("Failed to open file: " + filePath);
+        std::vector<char> header = readBytes(file, 0, HEADER_SIZE);
+        if(memcmp(header.data(), identifier, sizeof(identifier)) != 0) throw std::runtime_error("Not a KTX2 file: " + filePath);
+
+        TextureFileInfo info = {};
+        info.format = static_cast<VkFormat>(readU32(header, 12));
+        info.width = readU32(header, 20);
+        info.height = std::max(readU32(header, 24), 1u);
+        uint32_t pixelDepth = readU32(header, 28);
+        uint32_t layerCount = readU32(header, 32);
+        uint32_t faceCount = readU32(header, 36);
+        uint32_t levelCount = std::max(readU32(header, 40), 1u);
+        uint32_t supercompressionScheme = readU32(header, 44);
+
+        // streaming works on plain 2D mip chains, the GPU must be able to consume the bytes as they are
+        if(info.format == VK_FORMAT_UNDEFINED) throw std::runtime_error("KTX2 Basis Universal textures are not supported: " + filePath);
+        if(supercompressionScheme != 0) throw std::runtime_error("KTX2 supercompression is not supported: " + filePath);
+        if(pixelDepth > 1 || layerCount > 1 || faceCount != 1) throw std::runtime_error("Only 2D KTX2 textures are supported: " + filePath);
+
+        std::vector<char> levelIndex = readBytes(file, HEADER_SIZE, LEVEL_INDEX_ENTRY_SIZE * levelCount);
+        for(uint32_t level = 0; level < levelCount; level++){
+            Level entry = {};
+            entry.offset = readU64(levelIndex, level * LEVEL_INDEX_ENTRY_SIZE);
+            entry.size = readU64(levelIndex, level * LEVEL_INDEX_ENTRY_SIZE + 8);
+            entry.width = std::max(info.width >> level, 1u);
+            entry.height = std::max(info.height >> level, 1u);
+            info.levels.push_back(entry);
+        }
+        return info;
+    }
+
+    TextureFileInfo TextureFileInfo::readDds(const std::string &filePath){
+        static constexpr uint32_t MAGIC = 0x20534444; // "DDS "
+        static constexpr uint32_t FOURCC_DXT1 = 0x31545844;
+        static constexpr uint32_t FOURCC_DXT5 = 0x35545844;
+        static constexpr uint32_t FOURCC_DX10 = 0x30315844;
+        static constexpr uint32_t PIXEL_FORMAT_FOURCC = 0x4;
+        static constexpr uint32_t PIXEL_FORMAT_RGB = 0x40;
+        static constexpr size_t HEADER_SIZE = 128;
+        static constexpr size_t DX10_HEADER_SIZE = 20;
+
+        std::ifstream file(filePath, std::ios::binary);
+        if(!file.is_open()) throw std::runtime_error("Failed to open file: " + filePath);
+        std::vector<char> header = readBytes(file, 0, HEADER_SIZE);
+        if(readU32(header, 0) != MAGIC) throw std::runtime_error("Not a DDS file: " + filePath);
+
+        TextureFileInfo info = {};
+        info.height = readU32(header, 12);
+        info.width = readU32(header, 16);
+        uint32_t levelCount = std::max(readU32(header, 28), 1u);
+        uint32_t pixelFormatFlags = readU32(header, 80);
+        uint32_t fourCC = readU32(header, 84);
+        uint64_t dataOffset = HEADER_SIZE;
+
+        if(pixelFormatFlags & PIXEL_FORMAT_FOURCC){
+            if(fourCC == FOURCC_DXT1) info.format = VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+            else if(fourCC == FOURCC_DXT5) info.format = VK_FORMAT_BC3_UNORM_BLOCK;
+            else if(fourCC == FOURCC_DX10){
+                std::vector<char> dx10Header = readBytes(file, HEADER_SIZE, DX10_HEADER_SIZE);
+                info.format = getDxgiFormat(readU32(dx10Header, 0));
+                dataOffset += DX10_HEADER_SIZE;
+            }
+            else throw std::runtime_error("Unsupported DDS FourCC: " + filePath);
+        } else if((pixelFormatFlags & PIXEL_FORMAT_RGB) && readU32(header, 88) == 32){
+            bool isRedInLowByte = readU32(header, 92) == 0x000000ff;
+            info.format = isRedInLowByte ? VK_FORMAT_R8G8B8A8_UNORM : VK_FORMAT_B8G8R8A8_UNORM;
+        } else {
+            throw std::runtime_error("Unsupported DDS pixel format: " + filePath);
+        }
+
+        // DDS stores the levels back to back, largest first
+        uint32_t blockDimension, blockBytes;
+        getFormatBlockInfo(info.format, blockDimension, blockBytes);
+        for(uint32_t level = 0; level < levelCount; level++){
+            Level entry = {};
+            entry.width = std::max(info.width >> level, 1u);
+            entry.height = std::max(info.height >> level, 1u);
+            uint64_t blocksWide = (entry.width + blockDimension - 1) / blockDimension;
+            uint64_t blocksHigh = (entry.height + blockDimension - 1) / blockDimension;
+            entry.offset = dataOffset;
+            entry.size = blocksWide * blocksHigh * blockBytes;
+            dataOffset += entry.size;
+            info.levels.push_back(entry);
+        }
+        return info;
+    }
+
+    // Publics
+    EngineTextureStreamer::EngineTextureStreamer(EngineDevice &device, EngineBindlessTable &bindlessTable, EngineDeletionQueue &deletionQueue, VkDeviceSize budget): engineDevice{device}, bindlessTable{bindlessTable}, deletionQueue{deletionQueue}, budgetBytes{budget}{
+        this->createSampler();
+        this->worker = std::thread(&EngineTextureStreamer::workerLoop, this);
+    }
+
+    EngineTextureStreamer::~EngineTextureStreamer(){
+        {
+            std::lock_guard<std::mutex> lock(this->queueMutex);
+            this->isStopping = true;
+        }
+        this->queueCondition.notify_all();
+        this->worker.join();
+
+        for(TailUpload &upload:this->tailUploads){
+            vkDestroyBuffer(this->engineDevice.device(), upload.stagingBuffer, nullptr);
+            vkFreeMemory(this->engineDevice.device(), upload.stagingBufferMemory, nullptr);
+        }
+        for(Texture &texture:this->textures){
+            if(!texture.isAlive) continue;
+            this->bindlessTable.releaseTexture(texture.bindlessIndex);
+            this->destroyTextureImage(texture.image, texture.imageMemory, texture.imageView);
+        }
+        vkDestroySampler(this->engineDevice.device(), this->sampler, nullptr);
+    }
+
+    EngineTextureStreamer::TextureHandle EngineTextureStreamer::loadTexture(const std::string &filePath){
+        bool isKtx2 = filePath.size() >= 5 && filePath.compare(filePath.size() - 5, 5, ".ktx2") == 0;
+        bool isDds = filePath.size() >= 4 && filePath.compare(filePath.size() - 4, 4, ".dds") == 0;
+        if(!isKtx2 && !isDds) throw std::runtime_error("Unsupported texture file: " + filePath);
+
+        Texture texture = {};
+        texture.filePath = filePath;
+        texture.info = isKtx2 ? TextureFileInfo::readKtx2(filePath) : TextureFileInfo::readDds(filePath);
+        this->engineDevice.findSupportedFormat({texture.info.format}, VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
+
+        uint32_t levelCount = static_cast<uint32_t>(texture.info.levels.size());
+        texture.tailMip = levelCount - 1;
+        for(uint32_t level = 0; level < levelCount; level++){
+            const TextureFileInfo::Level &entry = texture.info.levels[level];
+            if(std::max(entry.width, entry.height) <= MIP_TAIL_SIZE){
+                texture.tailMip = level;
+                break;
+            }
+        }
+        texture.residentMip = texture.tailMip;
+        texture.imageMip = texture.tailMip;
+        texture.desiredMip = texture.tailMip;
+
+        // the mip tail is small, read it right away so the texture is usable from the next frame
+        VkDeviceSize tailSize = this->residentSize(texture, texture.tailMip);
+        VkBuffer stagingBuffer;
+        VkDeviceMemory stagingBufferMemory;
+        this->engineDevice.createBuffer(
+            tailSize,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            stagingBuffer,
+            stagingBufferMemory
+        );
+
+        std::ifstream file(filePath, std::ios::binary);
+        char *data;
+        vkMapMemory(this->engineDevice.device(), stagingBufferMemory, 0, tailSize, 0, reinterpret_cast<void **>(&data));
+        TailUpload upload = {};
+        upload.handle = static_cast<TextureHandle>(this->textures.size());
+        upload.stagingBuffer = stagingBuffer;
+        upload.stagingBufferMemory = stagingBufferMemory;
+        VkDeviceSize stagingOffset = 0;
+        for(uint32_t level = texture.tailMip; level < levelCount; level++){
+            const TextureFileInfo::Level &entry = texture.info.levels[level];
+            std::vector<char> bytes = readBytes(file, entry.offset, entry.size);
+            memcpy(data + stagingOffset, bytes.data(), bytes.size());
+
+            VkBufferImageCopy region = {};
+            region.bufferOffset = stagingOffset;
+            region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            region.imageSubresource.mipLevel = level - texture.tailMip;
+            region.imageSubresource.layerCount = 1;
+            region.imageExtent = {entry.width, entry.height, 1};
+            upload.regions.push_back(region);
+            stagingOffset += entry.size;
+        }
+        vkUnmapMemory(this->engineDevice.device(), stagingBufferMemory);
+
+        this->createTextureImage(texture, texture.tailMip, texture.image, texture.imageMemory, texture.imageView);
+        this->tailUploads.push_back(std::move(upload));
+
+        // the slot is only sampled by frames recorded after the upload
+        texture.bindlessIndex = this->bindlessTable.registerTexture(texture.imageView, this->sampler);
+        this->residentBytes += tailSize;
+        this->uploadedBytes += tailSize;
+
+        this->textures.push_back(std::move(texture));
+        return static_cast<TextureHandle>(this->textures.size() - 1);
+    }
+
+    void EngineTextureStreamer::unloadTexture(TextureHandle handle){
+        Texture &texture = this->textures[handle];
+        assert(texture.isAlive && "Texture was already unloaded");
+
+        // frames in flight may still sample the image, a tail upload still waiting is dropped by update
+        this->retireTextureImage(texture.bindlessIndex, texture.image, texture.imageMemory, texture.imageView);
+        this->residentBytes -= this->residentSize(texture, texture.residentMip);
+        texture.isAlive = false;
+    }
+
+    void EngineTextureStreamer::reportScreenCoverage(TextureHandle handle, float screenPixels){
+        Texture &texture = this->textures[handle];
+        float texels = static_cast<float>(std::max(texture.info.width, texture.info.height));
+
+        // one texel per pixel is enough, every halving of the coverage drops a mip
+        uint32_t mip = 0;
+        if(screenPixels < texels){
+            mip = static_cast<uint32_t>(std::floor(std::log2(texels / std::max(screenPixels, 1.0f))));
+        }
+        mip = std::min(mip, texture.tailMip);
+
+        if(texture.lastUsedFrame != this->frameIndex){
+            texture.desiredMip = mip;
+            texture.lastUsedFrame = this->frameIndex;
+        } else {
+            texture.desiredMip = std::min(texture.desiredMip, mip);
+        }
+    }
+
+    void EngineTextureStreamer::update(VkCommandBuffer commandBuffer, uint64_t frameNumber, std::pmr::memory_resource *frameMemory){
+        this->frameNumber = frameNumber;
+        this->recordTailUploads(commandBuffer, frameMemory);
+
+        // moved out rather than swapped, results keeps its capacity for the workers
+        std::pmr::vector<LoadResult> finished{frameMemory};
+        {
+            std::lock_guard<std::mutex> lock(this->queueMutex);
+            finished.assign(std::make_move_iterator(this->results.begin()), std::make_move_iterator(this->results.end()));
+            this->results.clear();
+        }
+
+        // keep the copies of a single frame bounded, whatever does not fit waits for the next frame
+        std::pmr::vector<LoadResult> deferred{frameMemory};
+        VkDeviceSize frameUploadBytes = 0;
+        std::pmr::unordered_map<TextureHandle, const LoadResult *> arrivals{frameMemory};
+        for(LoadResult &result:finished){
+            Texture &texture = this->textures[result.handle];
+            VkDeviceSize levelSize = texture.info.levels[result.level].size;
+            if(frameUploadBytes > 0 && frameUploadBytes + levelSize > MAX_UPLOAD_BYTES_PER_FRAME){
+                deferred.push_back(std::move(result));
+                continue;
+            }
+
+            this->requestedBytes -= levelSize;
+            texture.hasPendingRequest = false;
+            // evicted while loading, or the read failed
+            bool isStale = !texture.isAlive || result.level + 1 != texture.residentMip || result.data.size() != levelSize;
+            if(isStale) continue;
+
+            texture.residentMip = result.level;
+            this->residentBytes += levelSize;
+            frameUploadBytes += levelSize;
+            arrivals[result.handle] = &result;
+        }
+        if(!deferred.empty()){
+            std::lock_guard<std::mutex> lock(this->queueMutex);
+            for(LoadResult &result:deferred) this->results.push_back(std::move(result));
+        }
+
+        this->scheduleRequests(frameMemory);
+        this->applyRebuilds(commandBuffer, arrivals, frameMemory);
+        this->frameIndex++;
+    }
+
+    TextureStreamingStatistics EngineTextureStreamer::getStatistics(){
+        TextureStreamingStatistics statistics = {};
+        for(const Texture &texture:this->textures){
+            if(!texture.isAlive) continue;
+            statistics.textureCount++;
+            if(texture.imageMip == 0) statistics.fullyResidentCount++;
+            if(texture.hasPendingRequest) statistics.pendingRequests++;
+        }
+        statistics.budgetBytes = this->budgetBytes;
+        statistics.residentBytes = this->residentBytes;
+        statistics.requestedBytes = this->requestedBytes;
+        statistics.uploadedBytes = this->uploadedBytes;
+        statistics.evictedBytes = this->evictedBytes;
+        statistics.evictedLevels = this->evictedLevels;
+
+        double now = nowInSeconds();
+        while(!this->uploadHistory.empty() && now - this->uploadHistory.front().first > 1.0) this->uploadHistory.pop_front();
+        for(const auto &upload:this->uploadHistory) statistics.uploadBandwidth += static_cast<double>(upload.second);
+        return statistics;
+    }
+
+    // Privates
+    void EngineTextureStreamer::workerLoop(){
+        while(true){
+            LoadRequest request;
+            {
+                std::unique_lock<std::mutex> lock(this->queueMutex);
+                this->queueCondition.wait(lock, [this]{ return this->isStopping || !this->requests.empty(); });
+                if(this->isStopping) return;
+                request = std::move(this->requests.front());
+                this->requests.pop_front();
+            }
+
+            LoadResult result = {};
+            result.handle = request.handle;
+            result.level = request.level;
+            std::ifstream file(request.filePath, std::ios::binary);
+            if(file.is_open()){
+                result.data.resize(request.size);
+                file.seekg(static_cast<std::streamoff>(request.offset));
+                file.read(result.data.data(), static_cast<std::streamsize>(request.size));
+                if(!file) result.data.clear();
+            }
+
+            std::lock_guard<std::mutex> lock(this->queueMutex);
+            this->results.push_back(std::move(result));
+        }
+    }
+
+    void EngineTextureStreamer::scheduleRequests(std::pmr::memory_resource *frameMemory){
+        std::pmr::vector<TextureHandle> candidates{frameMemory};
+        for(TextureHandle handle = 0; handle < this->textures.size(); handle++){
+            const Texture &texture = this->textures[handle];
+            if(!texture.isAlive || texture.hasPendingRequest) continue;
+            if(this->wantedMip(texture) < texture.residentMip) candidates.push_back(handle);
+        }
+
+        // most recently seen first, then the ones furthest from what they want
+        std::sort(candidates.begin(), candidates.end(), [this](TextureHandle a, TextureHandle b){
+            const Texture &textureA = this->textures[a];
+            const Texture &textureB = this->textures[b];
+            if(textureA.lastUsedFrame != textureB.lastUsedFrame) return textureA.lastUsedFrame > textureB.lastUsedFrame;
+            return textureA.residentMip - this->wantedMip(textureA) > textureB.residentMip - this->wantedMip(textureB);
+        });
+
+        std::pmr::vector<LoadRequest> newRequests{frameMemory};
+        for(TextureHandle handle:candidates){
+            Texture &texture = this->textures[handle];
+            // progressive, one level finer than what is resident
+            uint32_t level = texture.residentMip - 1;
+            const TextureFileInfo::Level &entry = texture.info.levels[level];
+            if(!this->reserveBudget(handle, entry.size, frameMemory)) continue;
+
+            this->requestedBytes += entry.size;
+            texture.hasPendingRequest = true;
+            newRequests.push_back({handle, level, texture.filePath, entry.offset, entry.size});
+        }
+        if(newRequests.empty()) return;
+
+        {
+            std::lock_guard<std::mutex> lock(this->queueMutex);
+            for(LoadRequest &request:newRequests) this->requests.push_back(std::move(request));
+        }
+        this->queueCondition.notify_one();
+    }
+
+    bool EngineTextureStreamer::reserveBudget(TextureHandle requester, VkDeviceSize bytes, std::pmr::memory_resource *frameMemory){
+        VkDeviceSize committed = this->residentBytes + this->requestedBytes + bytes;
+        if(committed <= this->budgetBytes) return true;
+        VkDeviceSize needed = committed - this->budgetBytes;
+
+        // textures holding more than they want go first, then the least recently used ones;
+        // textures seen as recently as the requester are left alone so they do not thrash each other
+        const Texture &requesterTexture = this->textures[requester];
+        std::pmr::vector<TextureHandle> victims{frameMemory};
+        for(TextureHandle handle = 0; handle < this->textures.size(); handle++){
+            const Texture &texture = this->textures[handle];
+            if(handle == requester || !texture.isAlive || texture.residentMip >= texture.tailMip) continue;
+            bool isOverResident = texture.residentMip < this->wantedMip(texture);
+            bool isOlder = texture.lastUsedFrame < requesterTexture.lastUsedFrame;
+            if(isOverResident || isOlder) victims.push_back(handle);
+        }
+        std::sort(victims.begin(), victims.end(), [this](TextureHandle a, TextureHandle b){
+            const Texture &textureA = this->textures[a];
+            const Texture &textureB = this->textures[b];
+            bool isOverResidentA = textureA.residentMip < this->wantedMip(textureA);
+            bool isOverResidentB = textureB.residentMip < this->wantedMip(textureB);
+            if(isOverResidentA != isOverResidentB) return isOverResidentA;
+            return textureA.lastUsedFrame < textureB.lastUsedFrame;
+        });
+
+        // plan first so nothing is evicted when the request cannot fit anyway
+        std::pmr::vector<std::pair<TextureHandle, uint32_t>> plan{frameMemory};
+        VkDeviceSize freed = 0;
+        for(TextureHandle handle:victims){
+            if(freed >= needed) break;
+            const Texture &texture = this->textures[handle];
+            bool isOverResident = texture.residentMip < this->wantedMip(texture);
+            uint32_t floorMip = isOverResident ? this->wantedMip(texture) : texture.tailMip;
+            uint32_t mip = texture.residentMip;
+            while(mip < floorMip && freed < needed){
+                freed += texture.info.levels[mip].size;
+                mip++;
+            }
+            plan.push_back({handle, mip});
+        }
+        if(freed < needed) return false;
+
+        for(const auto &eviction:plan){
+            Texture &texture = this->textures[eviction.first];
+            this->evictedLevels += eviction.second - texture.residentMip;
+            texture.residentMip = eviction.second;
+        }
+        this->residentBytes -= freed;
+        this->evictedBytes += freed;
+        return true;
+    }
+
+    void EngineTextureStreamer::recordTailUploads(VkCommandBuffer commandBuffer, std::pmr::memory_resource *frameMemory){
+        if(this->tailUploads.empty()) return;
+
+        std::pmr::vector<VkImageMemoryBarrier> preBarriers{frameMemory};
+        std::pmr::vector<VkImageMemoryBarrier> postBarriers{frameMemory};
+        for(const TailUpload &upload:this->tailUploads){
+            const Texture &texture = this->textures[upload.handle];
+            if(!texture.isAlive) continue;
+            uint32_t levelCount = static_cast<uint32_t>(upload.regions.size());
+            preBarriers.push_back(this->buildImageMemoryBarrier(texture.image, levelCount, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, VK_ACCESS_TRANSFER_WRITE_BIT));
+            postBarriers.push_back(this->buildImageMemoryBarrier(texture.image, levelCount, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT));
+        }
+
+        if(!preBarriers.empty()){
+            vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(preBarriers.size()), preBarriers.data());
+            for(const TailUpload &upload:this->tailUploads){
+                const Texture &texture = this->textures[upload.handle];
+                if(!texture.isAlive) continue;
+                vkCmdCopyBufferToImage(commandBuffer, upload.stagingBuffer, texture.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(upload.regions.size()), upload.regions.data());
+            }
+            vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(postBarriers.size()), postBarriers.data());
+        }
+
+        // the copies read the staging buffers until this frame completes
+        for(TailUpload &upload:this->tailUploads) this->retireBuffer(upload.stagingBuffer, upload.stagingBufferMemory);
+        this->tailUploads.clear();
+    }
+
+    void EngineTextureStreamer::applyRebuilds(VkCommandBuffer commandBuffer, const std::pmr::unordered_map<TextureHandle, const LoadResult *> &arrivals, std::pmr::memory_resource *frameMemory){
+        struct Rebuild {
+            TextureHandle handle;
+            // the new image, created once every staging size is known
+            VkImage image = VK_NULL_HANDLE;
+            VkDeviceMemory imageMemory = VK_NULL_HANDLE;
+            VkImageView imageView = VK_NULL_HANDLE;
+        };
+        std::pmr::vector<Rebuild> rebuilds{frameMemory};
+        VkDeviceSize stagingSize = 0;
+        for(TextureHandle handle = 0; handle < this->textures.size(); handle++){
+            const Texture &texture = this->textures[handle];
+            if(!texture.isAlive || texture.residentMip == texture.imageMip) continue;
+            rebuilds.push_back({handle, VK_NULL_HANDLE, VK_NULL_HANDLE, VK_NULL_HANDLE});
+            if(texture.residentMip < texture.imageMip) stagingSize += arrivals.at(handle)->data.size();
+        }
+        if(rebuilds.empty()) return;
+
+        VkBuffer stagingBuffer = VK_NULL_HANDLE;
+        VkDeviceMemory stagingBufferMemory = VK_NULL_HANDLE;
+        char *stagingData = nullptr;
+        if(stagingSize > 0){
+            this->engineDevice.createBuffer(
+                stagingSize,
+                VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                stagingBuffer,
+                stagingBufferMemory
+            );
+            vkMapMemory(this->engineDevice.device(), stagingBufferMemory, 0, stagingSize, 0, reinterpret_cast<void **>(&stagingData));
+        }
+
+        std::pmr::vector<VkImageMemoryBarrier> preBarriers{frameMemory};
+        std::pmr::vector<VkImageMemoryBarrier> postBarriers{frameMemory};
+        for(Rebuild &rebuild:rebuilds){
+            Texture &texture = this->textures[rebuild.handle];
+            uint32_t levelCount = static_cast<uint32_t>(texture.info.levels.size());
+            this->createTextureImage(texture, texture.residentMip, rebuild.image, rebuild.imageMemory, rebuild.imageView);
+            preBarriers.push_back(this->buildImageMemoryBarrier(rebuild.image, levelCount - texture.residentMip, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, VK_ACCESS_TRANSFER_WRITE_BIT));
+            preBarriers.push_back(this->buildImageMemoryBarrier(texture.image, levelCount - texture.imageMip, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_SHADER_READ_BIT, VK_ACCESS_TRANSFER_READ_BIT));
+            postBarriers.push_back(this->buildImageMemoryBarrier(rebuild.image, levelCount - texture.residentMip, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT));
+        }
+
+        // the fragment stage covers the earlier frames sampling the old images, the transfer stage a
+        // tail uploaded earlier in this frame
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(preBarriers.size()), preBarriers.data());
+
+        VkDeviceSize stagingOffset = 0;
+        for(Rebuild &rebuild:rebuilds){
+            Texture &texture = this->textures[rebuild.handle];
+            uint32_t levelCount = static_cast<uint32_t>(texture.info.levels.size());
+
+            // levels both images share are copied on the GPU, dropping mips never touches the disk
+            std::pmr::vector<VkImageCopy> imageCopies{frameMemory};
+            for(uint32_t level = std::max(texture.residentMip, texture.imageMip); level < levelCount; level++){
+                const TextureFileInfo::Level &entry = texture.info.levels[level];
+                VkImageCopy imageCopy = {};
+                imageCopy.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level - texture.imageMip, 0, 1};
+                imageCopy.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level - texture.residentMip, 0, 1};
+                imageCopy.extent = {entry.width, entry.height, 1};
+                imageCopies.push_back(imageCopy);
+            }
+            vkCmdCopyImage(commandBuffer, texture.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, rebuild.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(imageCopies.size()), imageCopies.data());
+
+            if(texture.residentMip < texture.imageMip){
+                const LoadResult *arrival = arrivals.at(rebuild.handle);
+                const TextureFileInfo::Level &entry = texture.info.levels[arrival->level];
+                memcpy(stagingData + stagingOffset, arrival->data.data(), arrival->data.size());
+
+                VkBufferImageCopy region = {};
+                region.bufferOffset = stagingOffset;
+                region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+                region.imageExtent = {entry.width, entry.height, 1};
+                vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, rebuild.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+                stagingOffset += arrival->data.size();
+            }
+        }
+
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(postBarriers.size()), postBarriers.data());
+
+        // earlier frames in flight still sample the old images through their slots, so the new
+        // images get slots of their own and the old ones go once this frame's copies are done
+        for(Rebuild &rebuild:rebuilds){
+            Texture &texture = this->textures[rebuild.handle];
+            this->retireTextureImage(texture.bindlessIndex, texture.image, texture.imageMemory, texture.imageView);
+            texture.image = rebuild.image;
+            texture.imageMemory = rebuild.imageMemory;
+            texture.imageView = rebuild.imageView;
+            texture.imageMip = texture.residentMip;
+            texture.bindlessIndex = this->bindlessTable.registerTexture(texture.imageView, this->sampler);
+        }
+
+        if(stagingBuffer != VK_NULL_HANDLE){
+            vkUnmapMemory(this->engineDevice.device(), stagingBufferMemory);
+            this->retireBuffer(stagingBuffer, stagingBufferMemory);
+            this->uploadedBytes += stagingSize;
+            this->uploadHistory.push_back({nowInSeconds(), stagingSize});
+        }
+    }
+
+    uint32_t EngineTextureStreamer::wantedMip(const Texture &texture) const {
+        bool isRecentlyUsed = this->frameIndex - texture.lastUsedFrame <= UNUSED_FRAME_THRESHOLD;
+        return isRecentlyUsed ? texture.desiredMip : texture.tailMip;
+    }
+
+    void EngineTextureStreamer::createTextureImage(Texture &texture, uint32_t residentMip, VkImage &image, VkDeviceMemory &imageMemory, VkImageView &imageView){
+        const TextureFileInfo::Level &top = texture.info.levels[residentMip];
+        uint32_t levelCount = static_cast<uint32_t>(texture.info.levels.size()) - residentMip;
+
+        VkImageCreateInfo imageCreateInfo = {};
+        imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageCreateInfo.extent = {top.width, top.height, 1};
+        imageCreateInfo.mipLevels = levelCount;
+        imageCreateInfo.arrayLayers = 1;
+        imageCreateInfo.format = texture.info.format;
+        imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        // transfer source so the next rebuild can copy the shared levels out of it
+        imageCreateInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        this->engineDevice.createImageWithInfo(imageCreateInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, imageMemory);
+
+        VkImageViewCreateInfo imageViewCreateInfo = {};
+        imageViewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        imageViewCreateInfo.image = image;
+        imageViewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        imageViewCreateInfo.format = texture.info.format;
+        imageViewCreateInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        imageViewCreateInfo.subresourceRange.baseMipLevel = 0;
+        imageViewCreateInfo.subresourceRange.levelCount = levelCount;
+        imageViewCreateInfo.subresourceRange.baseArrayLayer = 0;
+        imageViewCreateInfo.subresourceRange.layerCount = 1;
+        bool isCreateImageViewSuccess = vkCreateImageView(this->engineDevice.device(), &imageViewCreateInfo, nullptr, &imageView) == VK_SUCCESS;
+        if(!isCreateImageViewSuccess) throw std::runtime_error("Failed to create texture image view!");
+    }
+
+    void EngineTextureStreamer::destroyTextureImage(VkImage image, VkDeviceMemory imageMemory, VkImageView imageView){
+        vkDestroyImageView(this->engineDevice.device(), imageView, nullptr);
+        vkDestroyImage(this->engineDevice.device(), image, nullptr);
+        vkFreeMemory(this->engineDevice.device(), imageMemory, nullptr);
+    }
+
+    void EngineTextureStreamer::retireTextureImage(uint32_t bindlessIndex, VkImage image, VkDeviceMemory imageMemory, VkImageView imageView){
+        // the queue may outlive the streamer, so nothing of it is captured
+        VkDevice device = this->engineDevice.device();
+        EngineBindlessTable *bindlessTable = &this->bindlessTable;
+        this->deletionQueue.enqueue(this->frameNumber, [device, bindlessTable, bindlessIndex, image, imageMemory, imageView](){
+            bindlessTable->releaseTexture(bindlessIndex);
+            vkDestroyImageView(device, imageView, nullptr);
+            vkDestroyImage(device, image, nullptr);
+            vkFreeMemory(device, imageMemory, nullptr);
+        });
+    }
+
+    void EngineTextureStreamer::retireBuffer(VkBuffer buffer, VkDeviceMemory bufferMemory){
+        VkDevice device = this->engineDevice.device();
+        this->deletionQueue.enqueue(this->frameNumber, [device, buffer, bufferMemory](){
+            vkDestroyBuffer(device, buffer, nullptr);
+            vkFreeMemory(device, bufferMemory, nullptr);
+        });
+    }
+
+    void EngineTextureStreamer::createSampler(){
+        VkSamplerCreateInfo samplerCreateInfo = {};
+        samplerCreateInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        samplerCreateInfo.magFilter = VK_FILTER_LINEAR;
+        samplerCreateInfo.minFilter = VK_FILTER_LINEAR;
+        samplerCreateInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+        samplerCreateInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        samplerCreateInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        samplerCreateInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        samplerCreateInfo.anisotropyEnable = VK_TRUE;
+        samplerCreateInfo.maxAnisotropy = this->engineDevice.properties.limits.maxSamplerAnisotropy;
+        samplerCreateInfo.compareEnable = VK_FALSE;
+        samplerCreateInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+        samplerCreateInfo.minLod = 0.0f;
+        // resident levels always start at 0, the view decides how many there are
+        samplerCreateInfo.maxLod = VK_LOD_CLAMP_NONE;
+        samplerCreateInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+        samplerCreateInfo.unnormalizedCoordinates = VK_FALSE;
+
+        bool isCreateSamplerSuccess = vkCreateSampler(this->engineDevice.device(), &samplerCreateInfo, nullptr, &this->sampler) == VK_SUCCESS;
+        if(!isCreateSamplerSuccess) throw std::runtime_error("Failed to create texture sampler!");
+    }
+
+    VkDeviceSize EngineTextureStreamer::residentSize(const Texture &texture, uint32_t residentMip) const {
+        VkDeviceSize size = 0;
+        for(uint32_t level = residentMip; level < texture.info.levels.size(); level++) size += texture.info.levels[level].size;
+        return size;
+    }
+
+    VkImageMemoryBarrier EngineTextureStreamer::buildImageMemoryBarrier(VkImage image, uint32_t levelCount, VkImageLayout oldLayout, VkImageLayout newLayout, VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask){
+        VkImageMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.oldLayout = oldLayout;
+        barrier.newLayout = newLayout;
+        barrier.srcAccessMask = srcAccessMask;
+        barrier.dstAccessMask = dstAccessMask;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseMipLevel = 0;
+        barrier.subresourceRange.levelCount = levelCount;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = 1;
+        return barrier;
+    }
+}
@@ -0,0 +1,183 @@
+#pragma once
+#include "engine_device.hpp"
+#include "engine_bindless_table.hpp"
+#include "engine_deletion_queue.hpp"
+
+// std
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace engine {
+    // Mip chain layout of a KTX2 or DDS file, level 0 being the full resolution image
+    struct TextureFileInfo {
+        struct Level {
+            uint64_t offset;
+            uint64_t size;
+            uint32_t width;
+            uint32_t height;
+        };
+        VkFormat format;
+        uint32_t width;
+        uint32_t height;
+        std::vector<Level> levels;
+
+        static TextureFileInfo readKtx2(const std::string &filePath);
+        static TextureFileInfo readDds(const std::string &filePath);
+    };
+
+    struct TextureStreamingStatistics {
+        uint32_t textureCount = 0;
+        uint32_t fullyResidentCount = 0;
+        uint32_t pendingRequests = 0;
+        VkDeviceSize budgetBytes = 0;
+        VkDeviceSize residentBytes = 0;
+        VkDeviceSize requestedBytes = 0;
+        uint64_t uploadedBytes = 0;
+        uint64_t evictedBytes = 0;
+        uint64_t evictedLevels = 0;
+        double uploadBandwidth = 0.0; // bytes per second over the last second
+    };
+
+    // Keeps every texture's low resolution mip tail resident and streams the finer mips in on a
+    // background thread, one level at a time, based on how many screen pixels the texture covers.
+    // The sum of resident mips never exceeds the budget, the least recently used textures give up
+    // their top mips first when space is needed.
+    //
+    // Nothing waits on the GPU. Uploads and rebuilds are recorded into the frame's command buffer by
+    // update, and replaced images are retired through the deletion queue once the frames sampling
+    // them have completed.
+    class EngineTextureStreamer {
+        public:
+            using TextureHandle = uint32_t;
+            static constexpr TextureHandle INVALID_HANDLE = ~0u;
+            static constexpr VkDeviceSize DEFAULT_BUDGET = 256ull * 1024 * 1024;
+            // levels at or below this size are loaded with the texture and never evicted
+            static constexpr uint32_t MIP_TAIL_SIZE = 64;
+            // frames without a coverage report before a texture stops asking for detail
+            static constexpr uint64_t UNUSED_FRAME_THRESHOLD = 120;
+            // finished loads beyond this are applied on the following frames
+            static constexpr VkDeviceSize MAX_UPLOAD_BYTES_PER_FRAME = 16ull * 1024 * 1024;
+
+            EngineTextureStreamer(EngineDevice &device, EngineBindlessTable &bindlessTable, EngineDeletionQueue &deletionQueue, VkDeviceSize budget = DEFAULT_BUDGET);
+            ~EngineTextureStreamer();
+
+            EngineTextureStreamer(const EngineTextureStreamer &) = delete;
+            EngineTextureStreamer &operator = (const EngineTextureStreamer &) = delete;
+
+            // Accepts .ktx2 and .dds files, only the mip tail is read before returning. It is uploaded
+            // by the next update, the texture can be drawn from that frame on.
+            TextureHandle loadTexture(const std::string &filePath);
+            // The frames up to the last update may still sample it, it is freed once they complete
+            void unloadTexture(TextureHandle handle);
+
+            // Index of the texture in the bindless texture array. Every rebuild moves the texture to a
+            // new slot, since frames in flight still sample the old one, so read it after each update.
+            uint32_t bindlessIndex(TextureHandle handle) const {
+                return this->textures[handle].bindlessIndex;
+            }
+
+            // Report how many pixels along its larger axis the texture spans on screen this frame
+            void reportScreenCoverage(TextureHandle handle, float screenPixels);
+
+            // Call once per frame outside of a render pass, before any draw sampling the textures. Records
+            // the uploads of finished loads into commandBuffer and schedules new loads. frameNumber is
+            // the frame commandBuffer belongs to, what it replaces is retired with it. Scratch
+            // containers come from frameMemory, which must stay valid until update returns.
+            void update(VkCommandBuffer commandBuffer, uint64_t frameNumber, std::pmr::memory_resource *frameMemory = std::pmr::get_default_resource());
+
+            TextureStreamingStatistics getStatistics();
+
+        private:
+            struct Texture {
+                std::string filePath;
+                TextureFileInfo info;
+                bool isAlive = true;
+
+                uint32_t tailMip = 0;
+                // top level counted against the budget, the image catches up on the next rebuild
+                uint32_t residentMip = 0;
+                // top level actually present in the image
+                uint32_t imageMip = 0;
+                uint32_t desiredMip = 0;
+                bool hasPendingRequest = false;
+                uint64_t lastUsedFrame = 0;
+
+                VkImage image = VK_NULL_HANDLE;
+                VkDeviceMemory imageMemory = VK_NULL_HANDLE;
+                VkImageView imageView = VK_NULL_HANDLE;
+                uint32_t bindlessIndex = EngineBindlessTable::INVALID_INDEX;
+            };
+
+            // a mip tail read by loadTexture, waiting for the next update to record its copy
+            struct TailUpload {
+                TextureHandle handle;
+                VkBuffer stagingBuffer;
+                VkDeviceMemory stagingBufferMemory;
+                std::vector<VkBufferImageCopy> regions;
+            };
+
+            struct LoadRequest {
+                TextureHandle handle;
+                uint32_t level;
+                std::string filePath;
+                uint64_t offset;
+                uint64_t size;
+            };
+
+            struct LoadResult {
+                TextureHandle handle;
+                uint32_t level;
+                std::vector<char> data;
+            };
+
+            void workerLoop();
+            void scheduleRequests(std::pmr::memory_resource *frameMemory);
+            bool reserveBudget(TextureHandle requester, VkDeviceSize bytes, std::pmr::memory_resource *frameMemory);
+            void recordTailUploads(VkCommandBuffer commandBuffer, std::pmr::memory_resource *frameMemory);
+            void applyRebuilds(VkCommandBuffer commandBuffer, const std::pmr::unordered_map<TextureHandle, const LoadResult *> &arrivals, std::pmr::memory_resource *frameMemory);
+            uint32_t wantedMip(const Texture &texture) const;
+
+            void createTextureImage(Texture &texture, uint32_t residentMip, VkImage &image, VkDeviceMemory &imageMemory, VkImageView &imageView);
+            void destroyTextureImage(VkImage image, VkDeviceMemory imageMemory, VkImageView imageView);
+            // Frees the image and its bindless slot once the last update's frame has completed
+            void retireTextureImage(uint32_t bindlessIndex, VkImage image, VkDeviceMemory imageMemory, VkImageView imageView);
+            void retireBuffer(VkBuffer buffer, VkDeviceMemory bufferMemory);
+            void createSampler();
+
+            VkDeviceSize residentSize(const Texture &texture, uint32_t residentMip) const;
+            VkImageMemoryBarrier buildImageMemoryBarrier(VkImage image, uint32_t levelCount, VkImageLayout oldLayout, VkImageLayout newLayout, VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask);
+
+            EngineDevice &engineDevice;
+            EngineBindlessTable &bindlessTable;
+            EngineDeletionQueue &deletionQueue;
+            VkSampler sampler;
+
+            std::vector<Texture> textures;
+            std::vector<TailUpload> tailUploads;
+            uint64_t frameIndex = 0;
+            // of the last update, the last frame that may sample what is replaced now
+            uint64_t frameNumber = 0;
+
+            VkDeviceSize budgetBytes;
+            VkDeviceSize residentBytes = 0;
+            VkDeviceSize requestedBytes = 0;
+            uint64_t uploadedBytes = 0;
+            uint64_t evictedBytes = 0;
+            uint64_t evictedLevels = 0;
+            std::deque<std::pair<double, uint64_t>> uploadHistory;
+
+            std::thread worker;
+            std::mutex queueMutex;
+            std::condition_variable queueCondition;
+            std::deque<LoadRequest> requests;
+            std::vector<LoadResult> results;
+            bool isStopping = false;
+    };
+}
@@ -17,6 +17,9 @@ namespace engine {
             bool shouldClose(){
                 return glfwWindowShouldClose(window);
             }
+            bool isKeyPressed(int key){
+                return glfwGetKey(window, key) == GLFW_PRESS;
+            }
             VkExtent2D getExtent() {
                 return {
                     static_cast<uint32_t> (this->width),
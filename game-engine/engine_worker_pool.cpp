@@ -0,0 +1,75 @@
+#include "engine_worker_pool.hpp"
+
+namespace engine {
+    // Publics
+    EngineWorkerPool::EngineWorkerPool(uint32_t threadCount){
+        this->threads.reserve(threadCount);
+        for(uint32_t i = 0; i < threadCount; i++) this->threads.emplace_back(&EngineWorkerPool::workLoop, this);
+    }
+
+    EngineWorkerPool::~EngineWorkerPool(){
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->isStopping = true;
+        }
+        this->wakeCondition.notify_all();
+        for(std::thread &thread:this->threads) thread.join();
+    }
+
+    void EngineWorkerPool::parallelFor(uint32_t taskCount, const Task &task){
+        if(taskCount == 0) return;
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->task = &task;
+            this->taskCount = taskCount;
+            this->nextTask = 0;
+            this->finishedTaskCount = 0;
+            this->error = nullptr;
+            this->generation++;
+        }
+        // a single task is not worth waking anyone for
+        if(taskCount > 1) this->wakeCondition.notify_all();
+        this->runTasks();
+
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->doneCondition.wait(lock, [this](){
+            return this->finishedTaskCount == this->taskCount && this->activeWorkerCount == 0;
+        });
+        this->task = nullptr;
+        if(this->error) std::rethrow_exception(this->error);
+    }
+
+    // Privates
+    void EngineWorkerPool::workLoop(){
+        uint64_t seenGeneration = 0;
+        std::unique_lock<std::mutex> lock(this->mutex);
+        for(;;){
+            this->wakeCondition.wait(lock, [this, seenGeneration](){
+                return this->isStopping || (this->task != nullptr && this->generation != seenGeneration);
+            });
+            if(this->isStopping) return;
+            seenGeneration = this->generation;
+            // parallelFor cannot return and replace the job while this worker is counted
+            this->activeWorkerCount++;
+            lock.unlock();
+            this->runTasks();
+            lock.lock();
+            this->activeWorkerCount--;
+            if(this->activeWorkerCount == 0) this->doneCondition.notify_all();
+        }
+    }
+
+    void EngineWorkerPool::runTasks(){
+        for(uint32_t taskIndex = this->nextTask++; taskIndex < this->taskCount; taskIndex = this->nextTask++){
+            try {
+                (*this->task)(taskIndex);
+            } catch(...){
+                std::lock_guard<std::mutex> lock(this->mutex);
+                if(!this->error) this->error = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->finishedTaskCount++;
+            if(this->finishedTaskCount == this->taskCount) this->doneCondition.notify_all();
+        }
+    }
+}
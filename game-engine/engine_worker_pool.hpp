@@ -0,0 +1,59 @@
+#pragma once
+
+// std
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace engine {
+    // Threads that stay alive for the lifetime of the pool, for work split up every frame where
+    // starting threads each time would cost more than the work itself. One job runs at a time:
+    // parallelFor hands out task indices to the workers and the calling thread and returns once
+    // every task has finished.
+    class EngineWorkerPool {
+        public:
+            using Task = std::function<void(uint32_t taskIndex)>;
+
+            // the calling thread of parallelFor makes one more
+            explicit EngineWorkerPool(uint32_t threadCount = std::max(std::thread::hardware_concurrency(), 2u) - 1);
+            ~EngineWorkerPool();
+
+            EngineWorkerPool(const EngineWorkerPool &) = delete;
+            EngineWorkerPool &operator = (const EngineWorkerPool &) = delete;
+
+            // Runs task(i) for every i below taskCount. Only one thread may call it at a time, the
+            // first exception thrown by a task is rethrown once the others have finished.
+            void parallelFor(uint32_t taskCount, const Task &task);
+
+            uint32_t threadCount() const {
+                return static_cast<uint32_t>(this->threads.size());
+            }
+
+        private:
+            void workLoop();
+            // claims and runs tasks of the current job until none are left
+            void runTasks();
+
+            std::vector<std::thread> threads;
+            std::mutex mutex;
+            std::condition_variable wakeCondition;
+            std::condition_variable doneCondition;
+
+            // the current job, only replaced once no worker is inside it
+            const Task *task = nullptr;
+            uint32_t taskCount = 0;
+            std::atomic<uint32_t> nextTask{0};
+            uint64_t generation = 0;
+            // workers that joined the current job and have not left it yet
+            uint32_t activeWorkerCount = 0;
+            uint32_t finishedTaskCount = 0;
+            std::exception_ptr error;
+            bool isStopping = false;
+    };
+}
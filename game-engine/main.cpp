@@ -2,12 +2,309 @@
 
 // std
 #include <iostream>
+#include <iomanip>
 #include <cstdlib>
+#include <cstring>
 #include <stdexcept>
+#include <string>
 
-int main(){
-    engine::App app{};
+namespace {
+    constexpr uint32_t BENCHMARK_FRAMES = 2000;
+    constexpr uint32_t BENCHMARK_SIERPINSKI_DEPTH = 8;
+    constexpr uint32_t BENCHMARK_MESH_DEPTHS[] = {4, 6, 8, 10, 12};
+    constexpr uint32_t BENCHMARK_OCCLUSION_INSTANCES = 200;
+    constexpr uint32_t BENCHMARK_LIGHT_COUNTS[] = {10, 100, 1000, 10000};
+    // upper bound of FramePacket::MAX_INSTANCES, every cascade sees most of them
+    constexpr uint32_t BENCHMARK_SHADOW_INSTANCES = 255;
+    constexpr uint32_t BENCHMARK_PARTICLE_COUNTS[] = {10000, 100000, 1000000, 2000000};
+    // software rasterisers manage only a few frames a second with millions of particles
+    constexpr uint32_t BENCHMARK_PARTICLE_FRAMES = 300;
+    constexpr uint32_t BENCHMARK_SPRITE_COUNTS[] = {1000, 10000, 50000};
+    // the GPU decodes one chunk per invocation, smaller chunks keep more of it busy
+    constexpr uint32_t BENCHMARK_DECOMPRESSION_CHUNK_SIZES[] = {16 * 1024, 64 * 1024, 256 * 1024};
+
+    // Renders the same scene at every MSAA level, with and without sample shading
+    void runMultisampleBenchmark(){
+        std::cout << std::fixed << std::setprecision(3);
+        const VkSampleCountFlagBits sampleCounts[] = {VK_SAMPLE_COUNT_1_BIT, VK_SAMPLE_COUNT_2_BIT, VK_SAMPLE_COUNT_4_BIT, VK_SAMPLE_COUNT_8_BIT};
+        for(VkSampleCountFlagBits sampleCount:sampleCounts){
+            for(bool isSampleShadingEnabled:{false, true}){
+                if(sampleCount == VK_SAMPLE_COUNT_1_BIT && isSampleShadingEnabled) continue;
+
+                engine::AppSettings settings = {};
+                settings.sampleCount = sampleCount;
+                settings.isSampleShadingEnabled = isSampleShadingEnabled;
+                settings.sierpinskiDepth = BENCHMARK_SIERPINSKI_DEPTH;
+                settings.isShaderHotReloadEnabled = false;
+                engine::App app{settings};
+                if(app.sampleCount() != sampleCount){
+                    std::cout << "MSAA " << sampleCount << "x: not supported by the device" << std::endl;
+                    break;
+                }
+                if(isSampleShadingEnabled && !app.isSampleShadingEnabled()){
+                    std::cout << "MSAA " << sampleCount << "x + sample shading: not supported by the device" << std::endl;
+                    continue;
+                }
+
+                engine::FrameStatistics statistics = app.benchmark(BENCHMARK_FRAMES);
+                std::cout << "MSAA " << sampleCount << "x" << (isSampleShadingEnabled ? " + sample shading" : "")
+                    << ": " << statistics.frameCount << " frames, cpu " << statistics.averageCpuFrameMs << " ms/frame"
+                    << ", gpu " << statistics.averageGpuFrameMs << " ms/frame"
+                    << ", " << statistics.averageAllocationsPerFrame << " allocs/frame" << std::endl;
+            }
+        }
+    }
+
+    // Builds the Sierpinski mesh on the CPU and with the compute shader at increasing depths
+    void runMeshGenerationBenchmark(){
+        std::cout << std::fixed << std::setprecision(3);
+        engine::AppSettings settings = {};
+        settings.isShaderHotReloadEnabled = false;
+        engine::App app{settings};
+        for(uint32_t depth:BENCHMARK_MESH_DEPTHS){
+            engine::MeshGenerationStatistics statistics = app.benchmarkMeshGeneration(depth);
+            std::cout << "Sierpinski depth " << statistics.depth << ", " << statistics.vertexCount << " vertices"
+                << ": cpu " << statistics.cpuGenerateMs << " ms + upload " << statistics.cpuUploadMs << " ms"
+                << " (" << statistics.cpuUploadBytes << " bytes from the host)"
+                << ", gpu " << statistics.gpuGenerateMs << " ms, " << statistics.gpuSubmitMs << " ms submitted"
+                << " (" << statistics.gpuUploadBytes << " bytes from the host, "
+                << statistics.gpuWrittenBytes << " bytes written on the device)" << std::endl;
+        }
+    }
+
+    // Imports a glTF or OBJ file and reports how fast it went from disk to a host visible vertex buffer
+    void runImportBenchmark(const std::string &filePath){
+        std::cout << std::fixed << std::setprecision(3);
+        engine::AppSettings settings = {};
+        settings.isShaderHotReloadEnabled = false;
+        engine::App app{settings};
+        engine::ImportStatistics statistics = app.benchmarkImport(filePath);
+        std::cout << "Import " << filePath << ": " << statistics.fileBytes << " bytes, " << statistics.triangleCount << " triangles"
+            << ", parse " << statistics.parseMs << " ms, convert " << statistics.convertMs << " ms, upload " << statistics.uploadMs << " ms"
+            << ", " << statistics.megabytesPerSecond() << " MB/s, " << statistics.trianglesPerSecond() << " triangles/s" << std::endl;
+    }
+
+    // Decodes the vertices of a glTF or OBJ file from an archive on the CPU and on the GPU. Runs on
+    // lavapipe too (VK_ICD_FILENAMES pointing at its ICD), where the shader runs on CPU threads.
+    void runDecompressionBenchmark(const std::string &filePath){
+        std::cout << std::fixed << std::setprecision(3);
+        engine::AppSettings settings = {};
+        settings.isShaderHotReloadEnabled = false;
+        engine::App app{settings};
+        for(uint32_t chunkSize:BENCHMARK_DECOMPRESSION_CHUNK_SIZES){
+            engine::DecompressionStatistics statistics = app.benchmarkDecompression(filePath, chunkSize);
+            std::cout << "Decompress " << filePath << ", " << statistics.chunkSize / 1024 << " KiB chunks"
+                << ": " << statistics.gpu.compressedBytes << " -> " << statistics.gpu.uncompressedBytes << " bytes in " << statistics.gpu.chunkCount << " chunks"
+                << ", cpu decode " << statistics.cpuDecodeMs << " ms + upload " << statistics.cpuUploadMs << " ms"
+                << ", gpu staging " << statistics.gpu.stagingMs << " ms + decode " << statistics.gpu.decodeMs << " ms"
+                << ", " << statistics.gpuTotalMs << " ms in total"
+                << (statistics.isMatching ? "" : ", GPU OUTPUT DIFFERS") << std::endl;
+        }
+    }
+
+    // Renders the occlusion test scene with and without the depth pre-pass and occlusion culling
+    void runOcclusionBenchmark(){
+        std::cout << std::fixed << std::setprecision(3);
+        double baselineGpuMs = 0.0;
+        for(bool isOcclusionCullingEnabled:{false, true}){
+            for(bool isDepthPrePassEnabled:{false, true}){
+                engine::AppSettings settings = {};
+                settings.sierpinskiDepth = BENCHMARK_SIERPINSKI_DEPTH;
+                settings.isShaderHotReloadEnabled = false;
+                settings.isOcclusionCullingEnabled = isOcclusionCullingEnabled;
+                settings.isDepthPrePassEnabled = isDepthPrePassEnabled;
+                settings.occlusionTestInstanceCount = BENCHMARK_OCCLUSION_INSTANCES;
+                engine::App app{settings};
+
+                engine::FrameStatistics statistics = app.benchmark(BENCHMARK_FRAMES);
+                bool isBaseline = !isOcclusionCullingEnabled && !isDepthPrePassEnabled;
+                if(isBaseline) baselineGpuMs = statistics.averageGpuFrameMs;
+                std::cout << (isOcclusionCullingEnabled ? "Occlusion culling" : "No culling")
+                    << (isDepthPrePassEnabled ? " + depth pre-pass" : "")
+                    << ": " << statistics.frameCount << " frames, cpu " << statistics.averageCpuFrameMs << " ms/frame"
+                    << ", gpu " << statistics.averageGpuFrameMs << " ms/frame";
+                if(!isBaseline) std::cout << " (" << baselineGpuMs - statistics.averageGpuFrameMs << " ms saved)";
+                std::cout << ", binds " << statistics.averageIssuedBinds << " issued, " << statistics.averageEliminatedBinds << " eliminated";
+                if(isOcclusionCullingEnabled){
+                    std::cout << ", drawn " << statistics.averageFirstPhaseDrawn << " + " << statistics.averageSecondPhaseDrawn
+                        << ", occluded " << statistics.averageOccluded
+                        << ", outside the frustum " << statistics.averageFrustumCulled;
+                }
+                std::cout << std::endl;
+            }
+        }
+    }
+
+    // Lights the occlusion test scene, which spreads geometry over the whole depth range, with more and more lights
+    void runLightBenchmark(){
+        std::cout << std::fixed << std::setprecision(3);
+        for(uint32_t lightCount:BENCHMARK_LIGHT_COUNTS){
+            engine::AppSettings settings = {};
+            settings.sierpinskiDepth = BENCHMARK_SIERPINSKI_DEPTH;
+            settings.isShaderHotReloadEnabled = false;
+            settings.occlusionTestInstanceCount = BENCHMARK_OCCLUSION_INSTANCES;
+            settings.lightCount = lightCount;
+            engine::App app{settings};
+
+            engine::FrameStatistics statistics = app.benchmark(BENCHMARK_FRAMES);
+            std::cout << "Lights " << lightCount << ": " << statistics.frameCount << " frames"
+                << ", cpu " << statistics.averageCpuFrameMs << " ms/frame"
+                << ", gpu " << statistics.averageGpuFrameMs << " ms/frame" << std::endl;
+        }
+    }
+
+    // Renders the occlusion test scene without shadows, then with every cascade recorded on the
+    // render thread, then with the cascades recorded on the worker pool
+    void runShadowBenchmark(){
+        std::cout << std::fixed << std::setprecision(3);
+        struct Configuration {
+            const char *name;
+            bool isShadowEnabled;
+            bool isParallel;
+        };
+        const Configuration configurations[] = {{"No shadows", false, false}, {"Shadows, serial", true, false}, {"Shadows, parallel", true, true}};
+        for(const Configuration &configuration:configurations){
+            engine::AppSettings settings = {};
+            settings.sierpinskiDepth = BENCHMARK_SIERPINSKI_DEPTH;
+            settings.isShaderHotReloadEnabled = false;
+            settings.occlusionTestInstanceCount = BENCHMARK_SHADOW_INSTANCES;
+            settings.isShadowEnabled = configuration.isShadowEnabled;
+            if(!configuration.isParallel) settings.workerThreadCount = 0;
+            engine::App app{settings};
+
+            engine::FrameStatistics statistics = app.benchmark(BENCHMARK_FRAMES);
+            std::cout << configuration.name << ": " << statistics.frameCount << " frames"
+                << ", cpu " << statistics.averageCpuFrameMs << " ms/frame"
+                << ", record " << statistics.averageRecordMs << " ms/frame"
+                << ", gpu " << statistics.averageGpuFrameMs << " ms/frame"
+                << ", " << statistics.averageShadowDraws << " shadow draws/frame"
+                << ", binds " << statistics.averageIssuedBinds << " issued, " << statistics.averageEliminatedBinds << " eliminated" << std::endl;
+        }
+    }
+
+    // Renders the particle fountains at increasing particle counts, the live count only reaches
+    // the target once the first particles start dying
+    void runParticleBenchmark(){
+        std::cout << std::fixed << std::setprecision(3);
+        for(uint32_t particleCount:BENCHMARK_PARTICLE_COUNTS){
+            engine::AppSettings settings = {};
+            settings.isShaderHotReloadEnabled = false;
+            settings.particleCount = particleCount;
+            engine::App app{settings};
+
+            engine::FrameStatistics statistics = app.benchmark(BENCHMARK_PARTICLE_FRAMES);
+            std::cout << "Particles " << particleCount << ": " << statistics.frameCount << " frames"
+                << ", cpu " << statistics.averageCpuFrameMs << " ms/frame"
+                << ", gpu " << statistics.averageGpuFrameMs << " ms/frame"
+                << ", " << statistics.averageAliveParticles << " alive"
+                << ", " << statistics.averageParticleUploadBytes << " bytes uploaded/frame" << std::endl;
+        }
+    }
+
+    // Draws more and more sprites through the batch, the draw count only grows every 16384 sprites
+    void runSpriteBenchmark(){
+        std::cout << std::fixed << std::setprecision(3);
+        for(uint32_t spriteCount:BENCHMARK_SPRITE_COUNTS){
+            engine::AppSettings settings = {};
+            settings.isShaderHotReloadEnabled = false;
+            settings.spriteCount = spriteCount;
+            engine::App app{settings};
+
+            engine::FrameStatistics statistics = app.benchmark(BENCHMARK_FRAMES);
+            std::cout << "Sprites " << spriteCount << ": " << statistics.frameCount << " frames"
+                << ", cpu " << statistics.averageCpuFrameMs << " ms/frame"
+                << ", record " << statistics.averageRecordMs << " ms/frame"
+                << ", gpu " << statistics.averageGpuFrameMs << " ms/frame"
+                << ", " << statistics.averageSpriteDraws << " draws/frame" << std::endl;
+        }
+    }
+}
+
+int main(int argc, char **argv){
     try {
+        engine::AppSettings settings = {};
+        bool isBenchmark = false;
+        bool isMeshBenchmark = false;
+        bool isOcclusionBenchmark = false;
+        bool isLightBenchmark = false;
+        bool isShadowBenchmark = false;
+        bool isParticleBenchmark = false;
+        bool isSpriteBenchmark = false;
+        std::string importBenchmarkPath;
+        std::string decompressionBenchmarkPath;
+        for(int i = 1; i < argc; i++){
+            if(strcmp(argv[i], "--msaa") == 0 && i + 1 < argc){
+                int samples = std::stoi(argv[++i]);
+                bool isValidSampleCount = samples == 1 || samples == 2 || samples == 4 || samples == 8;
+                if(!isValidSampleCount) throw std::runtime_error("--msaa expects 1, 2, 4 or 8");
+                settings.sampleCount = static_cast<VkSampleCountFlagBits>(samples);
+            }
+            else if(strcmp(argv[i], "--sample-shading") == 0) settings.isSampleShadingEnabled = true;
+            else if(strcmp(argv[i], "--benchmark-msaa") == 0) isBenchmark = true;
+            else if(strcmp(argv[i], "--benchmark-mesh") == 0) isMeshBenchmark = true;
+            else if(strcmp(argv[i], "--benchmark-occlusion") == 0) isOcclusionBenchmark = true;
+            else if(strcmp(argv[i], "--benchmark-lights") == 0) isLightBenchmark = true;
+            else if(strcmp(argv[i], "--benchmark-shadows") == 0) isShadowBenchmark = true;
+            else if(strcmp(argv[i], "--benchmark-particles") == 0) isParticleBenchmark = true;
+            else if(strcmp(argv[i], "--particles") == 0 && i + 1 < argc) settings.particleCount = std::stoul(argv[++i]);
+            else if(strcmp(argv[i], "--benchmark-sprites") == 0) isSpriteBenchmark = true;
+            else if(strcmp(argv[i], "--sprites") == 0 && i + 1 < argc) settings.spriteCount = std::stoul(argv[++i]);
+            else if(strcmp(argv[i], "--hud") == 0) settings.isHudEnabled = true;
+            else if(strcmp(argv[i], "--model") == 0 && i + 1 < argc) settings.modelPath = argv[++i];
+            else if(strcmp(argv[i], "--texture") == 0 && i + 1 < argc) settings.texturePath = argv[++i];
+            else if(strcmp(argv[i], "--archive") == 0 && i + 1 < argc) settings.archivePath = argv[++i];
+            else if(strcmp(argv[i], "--benchmark-import") == 0 && i + 1 < argc) importBenchmarkPath = argv[++i];
+            else if(strcmp(argv[i], "--benchmark-decompression") == 0 && i + 1 < argc) decompressionBenchmarkPath = argv[++i];
+            else if(strcmp(argv[i], "--shadows") == 0) settings.isShadowEnabled = true;
+            else if(strcmp(argv[i], "--workers") == 0 && i + 1 < argc) settings.workerThreadCount = std::stoul(argv[++i]);
+            else if(strcmp(argv[i], "--lights") == 0 && i + 1 < argc) settings.lightCount = std::stoul(argv[++i]);
+            else if(strcmp(argv[i], "--gpu-mesh") == 0) settings.isGpuMeshGenerationEnabled = true;
+            else if(strcmp(argv[i], "--occlusion-culling") == 0) settings.isOcclusionCullingEnabled = true;
+            else if(strcmp(argv[i], "--depth-prepass") == 0) settings.isDepthPrePassEnabled = true;
+            else if(strcmp(argv[i], "--occlusion-test") == 0 && i + 1 < argc) settings.occlusionTestInstanceCount = std::stoul(argv[++i]);
+            else if(strcmp(argv[i], "--validation") == 0) settings.isValidationEnabled = true;
+            else if(strcmp(argv[i], "--no-validation") == 0) settings.isValidationEnabled = false;
+            else if(strcmp(argv[i], "--timings") == 0) settings.isTimingReportEnabled = true;
+            else if(strcmp(argv[i], "--simulation-load-ms") == 0 && i + 1 < argc) settings.simulationLoadMs = std::stod(argv[++i]);
+        }
+
+        if(isBenchmark){
+            runMultisampleBenchmark();
+            return EXIT_SUCCESS;
+        }
+        if(isMeshBenchmark){
+            runMeshGenerationBenchmark();
+            return EXIT_SUCCESS;
+        }
+        if(isOcclusionBenchmark){
+            runOcclusionBenchmark();
+            return EXIT_SUCCESS;
+        }
+        if(isLightBenchmark){
+            runLightBenchmark();
+            return EXIT_SUCCESS;
+        }
+        if(isShadowBenchmark){
+            runShadowBenchmark();
+            return EXIT_SUCCESS;
+        }
+        if(isParticleBenchmark){
+            runParticleBenchmark();
+            return EXIT_SUCCESS;
+        }
+        if(isSpriteBenchmark){
+            runSpriteBenchmark();
+            return EXIT_SUCCESS;
+        }
+        if(!importBenchmarkPath.empty()){
+            runImportBenchmark(importBenchmarkPath);
+            return EXIT_SUCCESS;
+        }
+        if(!decompressionBenchmarkPath.empty()){
+            runDecompressionBenchmark(decompressionBenchmarkPath);
+            return EXIT_SUCCESS;
+        }
+        engine::App app{settings};
         app.run();
     }catch(const std::exception &e){
         // only console log error if any
@@ -0,0 +1,21 @@
+#version 450
+
+layout (location = 0) out vec4 outColor;
+layout (location = 0) in vec2 fragmentUv;
+layout (location = 1) in vec4 fragmentColor;
+
+layout (push_constant) uniform Push {
+    vec2 scale;
+    vec2 offset;
+    // R8 glyph atlas, lines and filled boxes sample its solid cell
+    uint atlasIndex;
+} push;
+
+// bindless array, see EngineBindlessTable::TEXTURE_BINDING
+layout (set = 0, binding = 0) uniform sampler2D textures[];
+
+void main(){
+    float coverage = texture(textures[push.atlasIndex], fragmentUv).r;
+    if(coverage == 0.0) discard;
+    outColor = vec4(fragmentColor.rgb, fragmentColor.a * coverage);
+}
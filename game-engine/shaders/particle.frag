@@ -0,0 +1,12 @@
+#version 450
+
+layout (location = 0) out vec4 outColor;
+layout (location = 0) in vec4 fragmentColor;
+layout (location = 1) in vec2 fragmentOffset;
+
+void main(){
+    // a soft round dot, premultiplied for the additive blend of the particle pipeline
+    float falloff = max(1.0 - dot(fragmentOffset, fragmentOffset), 0.0);
+    float alpha = fragmentColor.a * falloff * falloff;
+    outColor = vec4(fragmentColor.rgb * alpha, alpha);
+}
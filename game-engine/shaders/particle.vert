@@ -0,0 +1,44 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+// One instance per live particle of EngineParticleSystem, expanded into a quad from gl_VertexIndex
+struct Particle {
+    vec2 position;
+    vec2 velocity;
+    float depth;
+    float life;
+    float size;
+    uint color;
+};
+
+// see particles.comp, only the particles are read here
+layout (std430, set = 0, binding = 1) readonly buffer ParticleState {
+    uint header[8];
+    Particle particles[];
+} states[];
+
+layout (location = 0) out vec4 fragmentColor;
+// [-1, 1] across the quad
+layout (location = 1) out vec2 fragmentOffset;
+
+layout (push_constant) uniform Push {
+    mat2 camera;
+    uint stateIndex;
+} push;
+
+const vec2 CORNERS[6] = vec2[](
+    vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(1.0, 1.0),
+    vec2(-1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, 1.0)
+);
+// seconds over which a particle fades out before it dies
+const float FADE_SECONDS = 0.5;
+
+void main(){
+    Particle particle = states[push.stateIndex].particles[gl_InstanceIndex];
+    vec2 corner = CORNERS[gl_VertexIndex];
+    // the quad faces the screen whatever the camera's rotation
+    gl_Position = vec4(push.camera * particle.position + corner * particle.size, particle.depth, 1.0);
+    fragmentColor = unpackUnorm4x8(particle.color);
+    fragmentColor.a *= clamp(particle.life / FADE_SECONDS, 0.0, 1.0);
+    fragmentOffset = corner;
+}
@@ -0,0 +1,20 @@
+#version 450
+
+// Depth only, renders one cascade of EngineShadowMap from the light
+layout(location = 0) in vec2 position;
+// per instance, see EngineModel::Instance
+layout(location = 2) in vec2 instanceTransformColumn0;
+layout(location = 3) in vec2 instanceTransformColumn1;
+layout(location = 5) in float instanceDepth;
+layout(location = 6) in vec2 instanceTranslation;
+
+layout (push_constant) uniform Push {
+    // world to the cascade's clip space
+    mat4 viewProjection;
+} push;
+
+void main(){
+    mat2 transform = mat2(instanceTransformColumn0, instanceTransformColumn1);
+    vec3 worldPosition = vec3(transform * position + instanceTranslation, instanceDepth);
+    gl_Position = push.viewProjection * vec4(worldPosition, 1.0);
+}
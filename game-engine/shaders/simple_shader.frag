@@ -1,9 +1,116 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : require
 
 layout (location = 0) out vec4 outColor;
 layout (location = 0) in vec3 fragmentColor;
+layout (location = 1) in vec2 fragmentUv;
+layout (location = 2) flat in uint fragmentMaterialIndex;
+layout (location = 3) in vec3 fragmentWorldPosition;
+
+// see ShaderFeature in engine_shader_permutation.hpp, disabled branches are removed when the pipeline is created
+layout (constant_id = 0) const bool VERTEX_COLOR = true;
+layout (constant_id = 1) const bool TEXTURE = false;
+layout (constant_id = 3) const bool CLUSTERED_LIGHTING = false;
+layout (constant_id = 4) const bool SHADOWS = false;
+
+// see EngineLightClusterer
+const uvec3 CLUSTER_COUNT = uvec3(16, 12, 16);
+const uint MAX_LIGHTS_PER_CLUSTER = 128;
+const vec3 AMBIENT = vec3(0.05);
+// see EngineShadowMap
+const uint CASCADE_COUNT = 4;
+// how much light a fully shadowed fragment keeps
+const float SHADOW_DARKNESS = 0.35;
+
+struct Material {
+    vec4 tint;
+    uint textureIndex;
+};
+
+// bindless arrays, see EngineBindlessTable::TEXTURE_BINDING and STORAGE_BUFFER_BINDING
+layout (set = 0, binding = 0) uniform sampler2D textures[];
+layout (set = 0, binding = 0) uniform sampler2DArrayShadow shadowTextures[];
+layout (set = 0, binding = 1) readonly buffer MaterialBuffer {
+    Material material;
+} materials[];
+
+struct Light {
+    // xyz in light space, w is the radius
+    vec4 positionRadius;
+    // rgb, w is the intensity
+    vec4 color;
+};
+layout (set = 0, binding = 1) readonly buffer LightBuffer {
+    Light lights[];
+} lightBuffers[];
+layout (set = 0, binding = 1) readonly buffer ClusterBuffer {
+    uint lightCounts[CLUSTER_COUNT.x * CLUSTER_COUNT.y * CLUSTER_COUNT.z];
+    uint lightIndices[];
+} clusterBuffers[];
+layout (set = 0, binding = 1) readonly buffer ShadowBuffer {
+    mat4 viewProjections[CASCADE_COUNT];
+    vec4 splitDepths;
+    uint textureIndex;
+    float texelSize;
+} shadowBuffers[];
+
+// see SimplePushConstantData, the lighting members are EngineLightClusterer::Parameters
+layout (push_constant) uniform Push {
+    mat2 camera;
+    uint lightBufferIndex;
+    uint clusterBufferIndex;
+    uint lightCount;
+    float aspect;
+    vec2 viewportSize;
+    uint shadowBufferIndex;
+} push;
+
+// only the lights binned into this fragment's froxel
+vec3 clusteredLighting(){
+    vec2 ndc = gl_FragCoord.xy / push.viewportSize * 2.0 - 1.0;
+    vec3 position = vec3(ndc.x * push.aspect, ndc.y, gl_FragCoord.z);
+    uvec3 cluster = min(uvec3(vec3(ndc * 0.5 + 0.5, gl_FragCoord.z) * vec3(CLUSTER_COUNT)), CLUSTER_COUNT - 1);
+    uint clusterIndex = cluster.x + CLUSTER_COUNT.x * (cluster.y + CLUSTER_COUNT.y * cluster.z);
+
+    uint lightCount = clusterBuffers[push.clusterBufferIndex].lightCounts[clusterIndex];
+    uint lightBase = clusterIndex * MAX_LIGHTS_PER_CLUSTER;
+    vec3 lighting = AMBIENT;
+    for(uint i = 0; i < lightCount; i++){
+        uint lightIndex = clusterBuffers[push.clusterBufferIndex].lightIndices[lightBase + i];
+        Light light = lightBuffers[push.lightBufferIndex].lights[lightIndex];
+        float falloff = max(1.0 - distance(position, light.positionRadius.xyz) / light.positionRadius.w, 0.0);
+        lighting += light.color.rgb * light.color.w * falloff * falloff;
+    }
+    return lighting;
+}
+
+// 0 in shadow, 1 lit, from a 3x3 filter of the nearest cascade covering the fragment
+float shadowFactor(){
+    uint cascade = 0;
+    while(cascade < CASCADE_COUNT - 1 && gl_FragCoord.z > shadowBuffers[push.shadowBufferIndex].splitDepths[cascade]) cascade++;
+
+    vec4 position = shadowBuffers[push.shadowBufferIndex].viewProjections[cascade] * vec4(fragmentWorldPosition, 1.0);
+    vec2 uv = position.xy * 0.5 + 0.5;
+    float texelSize = shadowBuffers[push.shadowBufferIndex].texelSize;
+    uint textureIndex = shadowBuffers[push.shadowBufferIndex].textureIndex;
+    float lit = 0.0;
+    for(int y = -1; y <= 1; y++){
+        for(int x = -1; x <= 1; x++){
+            vec2 offset = vec2(x, y) * texelSize;
+            lit += texture(shadowTextures[nonuniformEXT(textureIndex)], vec4(uv + offset, cascade, position.z));
+        }
+    }
+    return lit / 9.0;
+}
 
 void main(){
+    // instances drawn together may use different materials
+    Material material = materials[nonuniformEXT(fragmentMaterialIndex)].material;
     //    RGBA
-    outColor = vec4(fragmentColor, 1.0);
+    vec4 color = material.tint;
+    if(VERTEX_COLOR) color *= vec4(fragmentColor, 1.0);
+    if(TEXTURE) color *= texture(textures[nonuniformEXT(material.textureIndex)], fragmentUv);
+    if(CLUSTERED_LIGHTING) color.rgb *= clusteredLighting();
+    if(SHADOWS) color.rgb *= mix(SHADOW_DARKNESS, 1.0, shadowFactor());
+    outColor = color;
 }
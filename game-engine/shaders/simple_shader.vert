@@ -2,10 +2,36 @@
 
 layout(location = 0) in vec2 position; 
 layout(location = 1) in vec3 color;
+// per instance, see EngineModel::Instance
+layout(location = 2) in vec2 instanceTransformColumn0;
+layout(location = 3) in vec2 instanceTransformColumn1;
+layout(location = 4) in uint instanceMaterialIndex;
+layout(location = 5) in float instanceDepth;
+layout(location = 6) in vec2 instanceTranslation;
 
 layout(location = 0) out vec3 fragmentColor;
+layout(location = 1) out vec2 fragmentUv;
+layout(location = 2) flat out uint fragmentMaterialIndex;
+// before the camera, with the instance depth as z, for the shadow lookup
+layout(location = 3) out vec3 fragmentWorldPosition;
+
+// see ShaderFeature in engine_shader_permutation.hpp
+layout(constant_id = 0) const bool VERTEX_COLOR = true;
+
+// the depth pre-pass and the EQUAL tested shading pass have to compute the same depth
+invariant gl_Position;
+
+layout (push_constant) uniform Push {
+    mat2 camera;
+} push;
 
 void main(){
-    gl_Position = vec4(position, 0.0, 1.0);
-    fragmentColor = color;
+    mat2 transform = mat2(instanceTransformColumn0, instanceTransformColumn1);
+    vec2 worldPosition = transform * position + instanceTranslation;
+    gl_Position = vec4(push.camera * worldPosition, instanceDepth, 1.0);
+    fragmentColor = VERTEX_COLOR ? color : vec3(1.0);
+    // planar mapping of the model's [-1, 1] space
+    fragmentUv = position * 0.5 + 0.5;
+    fragmentMaterialIndex = instanceMaterialIndex;
+    fragmentWorldPosition = vec3(worldPosition, instanceDepth);
 }
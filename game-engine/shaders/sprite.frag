@@ -0,0 +1,20 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout (location = 0) out vec4 outColor;
+layout (location = 0) in vec2 fragmentUv;
+layout (location = 1) in vec4 fragmentColor;
+layout (location = 2) flat in uint fragmentTextureIndex;
+
+// see EngineBindlessTable::INVALID_INDEX, flat quads have no texture
+const uint INVALID_INDEX = 0xffffffffu;
+
+// bindless array, see EngineBindlessTable::TEXTURE_BINDING
+layout (set = 0, binding = 0) uniform sampler2D textures[];
+
+void main(){
+    vec4 color = fragmentColor;
+    // one draw mixes textures, the index differs between sprites of the same draw
+    if(fragmentTextureIndex != INVALID_INDEX) color *= texture(textures[nonuniformEXT(fragmentTextureIndex)], fragmentUv);
+    outColor = color;
+}
@@ -0,0 +1,24 @@
+#version 450
+
+// see EngineSpriteBatch::Vertex, positions are in pixels from the top left corner
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec2 uv;
+layout(location = 2) in vec4 color;
+layout(location = 3) in uint textureIndex;
+
+layout(location = 0) out vec2 fragmentUv;
+layout(location = 1) out vec4 fragmentColor;
+layout(location = 2) flat out uint fragmentTextureIndex;
+
+layout (push_constant) uniform Push {
+    // pixels to normalised device coordinates
+    vec2 scale;
+    vec2 offset;
+} push;
+
+void main(){
+    gl_Position = vec4(position * push.scale + push.offset, 0.0, 1.0);
+    fragmentUv = uv;
+    fragmentColor = color;
+    fragmentTextureIndex = textureIndex;
+}
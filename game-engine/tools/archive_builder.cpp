@@ -0,0 +1,77 @@
+// Packs directories into one archive for EngineArchive, see engine_archive.hpp. Every regular file
+// below the given directories is stored under its path as given on the command line, so run it from
+// the directory the engine runs in, e.g. from game-engine/:
+//   tools/archive_builder assets.pak shaders
+#include "engine_archive.hpp"
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static std::vector<char> readFileBytes(const std::filesystem::path &filePath){
+    std::ifstream file{filePath, std::ios::ate | std::ios::binary};
+    if(!file.is_open()) throw std::runtime_error("Failed to open file: " + filePath.string());
+    size_t fileSize = static_cast<size_t>(file.tellg());
+    std::vector<char> bytes(fileSize);
+    file.seekg(0);
+    file.read(bytes.data(), fileSize);
+    return bytes;
+}
+
+static void printUsage(){
+    std::cerr << "Usage: archive_builder [--store] [--chunk-size BYTES] OUTPUT DIRECTORY..." << std::endl;
+}
+
+int main(int argc, char **argv){
+    engine::ArchiveCompression compression = engine::ArchiveCompression::Lz4;
+    uint32_t chunkSize = engine::EngineArchiveWriter::DEFAULT_CHUNK_SIZE;
+    std::vector<std::string> arguments;
+    for(int i = 1; i < argc; i++){
+        if(strcmp(argv[i], "--store") == 0) compression = engine::ArchiveCompression::None;
+        else if(strcmp(argv[i], "--chunk-size") == 0 && i + 1 < argc) chunkSize = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else arguments.push_back(argv[i]);
+    }
+    if(arguments.size() < 2){
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    try {
+        auto start = std::chrono::steady_clock::now();
+        engine::EngineArchiveWriter writer{chunkSize};
+        uint32_t fileCount = 0;
+        for(size_t i = 1; i < arguments.size(); i++){
+            // sorted so the same tree always gives the same archive
+            std::vector<std::filesystem::path> filePaths;
+            for(const auto &entry:std::filesystem::recursive_directory_iterator(arguments[i])){
+                if(entry.is_regular_file()) filePaths.push_back(entry.path());
+            }
+            std::sort(filePaths.begin(), filePaths.end());
+            for(const std::filesystem::path &filePath:filePaths){
+                writer.add(filePath.lexically_normal().generic_string(), readFileBytes(filePath), compression);
+                fileCount++;
+            }
+        }
+        writer.write(arguments[0]);
+
+        double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        uint64_t uncompressedBytes = writer.getUncompressedBytes();
+        uint64_t compressedBytes = writer.getCompressedBytes();
+        std::cout << "archive_builder: " << arguments[0] << ", " << fileCount << " files"
+            << ", " << uncompressedBytes << " bytes packed into " << compressedBytes
+            << " (" << (uncompressedBytes > 0 ? 100.0 * compressedBytes / uncompressedBytes : 100.0) << "%)"
+            << " in " << elapsedMs << " ms" << std::endl;
+    } catch(const std::exception &e){
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}